@@ -273,10 +273,21 @@ enum elf_dynamic_tag {
 	DT_TEXTREL  = 22,
 	DT_JMPREL   = 23,
 	DT_BIND_NOW = 24,
+	DT_FLAGS    = 30,
+	DT_GNU_HASH = 0x6ffffef5,
 	DT_LOPROC   = 0x70000000,
 	DT_HIPROC   = 0x7fffffff,
 };
 
+/**
+ * Values of the DT_FLAGS dynamic array entry
+ */
+enum {
+	DF_SYMBOLIC = 0x2,
+	DF_TEXTREL  = 0x4,
+	DF_BIND_NOW = 0x8,
+};
+
 /**
  * Special section indexes
  */
@@ -47,6 +47,26 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	uint8_t *dp = (uint8_t *) dst;
 	const uint8_t *sp = (uint8_t *) src;
 
+	/* Copy whole words if both areas are equally aligned */
+	if ((((uintptr_t) dp ^ (uintptr_t) sp) & (sizeof(unsigned long) - 1)) == 0) {
+		while ((((uintptr_t) dp & (sizeof(unsigned long) - 1)) != 0) &&
+		    (cnt != 0)) {
+			*dp++ = *sp++;
+			cnt--;
+		}
+
+		unsigned long *dwp = (unsigned long *) dp;
+		const unsigned long *swp = (const unsigned long *) sp;
+
+		while (cnt >= sizeof(unsigned long)) {
+			*dwp++ = *swp++;
+			cnt -= sizeof(unsigned long);
+		}
+
+		dp = (uint8_t *) dwp;
+		sp = (const uint8_t *) swp;
+	}
+
 	while (cnt-- != 0)
 		*dp++ = *sp++;
 
@@ -68,6 +88,28 @@ void *memset(void *dst, int val, size_t cnt)
 {
 	uint8_t *dp = (uint8_t *) dst;
 
+	while ((((uintptr_t) dp & (sizeof(unsigned long) - 1)) != 0) &&
+	    (cnt != 0)) {
+		*dp++ = val;
+		cnt--;
+	}
+
+	/* Replicate the byte into all bytes of a word */
+	unsigned long word = (uint8_t) val;
+	word |= word << 8;
+	word |= word << 16;
+	if (sizeof(unsigned long) > 4)
+		word |= (word << 16) << 16;
+
+	unsigned long *dwp = (unsigned long *) dp;
+
+	while (cnt >= sizeof(unsigned long)) {
+		*dwp++ = word;
+		cnt -= sizeof(unsigned long);
+	}
+
+	dp = (uint8_t *) dwp;
+
 	while (cnt-- != 0)
 		*dp++ = val;
 
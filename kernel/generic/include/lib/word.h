@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic
+ * @{
+ */
+/** @file
+ * Word-at-a-time helpers for the memory and string functions.
+ */
+
+#ifndef KERN_LIB_WORD_H_
+#define KERN_LIB_WORD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Machine word used to process several bytes at once.
+ *
+ * The type may alias any other type, so that byte buffers can be accessed
+ * through it.
+ */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WORD_SIZE  sizeof(word_t)
+
+/** Word with all bytes set to 0x01 */
+#define WORD_ONES  ((word_t) -1 / 0xff)
+
+/** Word with all bytes set to 0x80 */
+#define WORD_HIGHS  (WORD_ONES * 0x80)
+
+/** Return true if @a ptr is aligned to the word size. */
+static inline bool word_aligned(const void *ptr)
+{
+	return ((uintptr_t) ptr & (WORD_SIZE - 1)) == 0;
+}
+
+/** Return word with all bytes set to @a b. */
+static inline word_t word_pattern(uint8_t b)
+{
+	return WORD_ONES * b;
+}
+
+/** Return true if any byte of @a w is zero. */
+static inline bool word_has_zero(word_t w)
+{
+	return ((w - WORD_ONES) & ~w & WORD_HIGHS) != 0;
+}
+
+/** Return true if all bytes of @a w are ASCII characters. */
+static inline bool word_is_ascii(word_t w)
+{
+	return (w & WORD_HIGHS) == 0;
+}
+
+#endif
+
+/** @}
+ */
@@ -40,6 +40,7 @@
  */
 
 #include <lib/memfnc.h>
+#include <lib/word.h>
 #include <typedefs.h>
 
 /** Fill block of memory.
@@ -57,6 +58,22 @@ void *memset(void *dst, int val, size_t cnt)
 {
 	uint8_t *dp = (uint8_t *) dst;
 
+	while (cnt != 0 && !word_aligned(dp)) {
+		*dp++ = val;
+		cnt--;
+	}
+
+	/* Fill the aligned part a word at a time. */
+	word_t pattern = word_pattern((uint8_t) val);
+	word_t *wp = (word_t *) dp;
+
+	while (cnt >= WORD_SIZE) {
+		*wp++ = pattern;
+		cnt -= WORD_SIZE;
+	}
+
+	dp = (uint8_t *) wp;
+
 	while (cnt-- != 0)
 		*dp++ = val;
 
@@ -80,6 +97,29 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	uint8_t *dp = (uint8_t *) dst;
 	const uint8_t *sp = (uint8_t *) src;
 
+	/*
+	 * Copy a word at a time if the source and destination addresses are
+	 * congruent modulo the word size.
+	 */
+	if (((uintptr_t) dp & (WORD_SIZE - 1)) ==
+	    ((uintptr_t) sp & (WORD_SIZE - 1))) {
+		while (cnt != 0 && !word_aligned(dp)) {
+			*dp++ = *sp++;
+			cnt--;
+		}
+
+		word_t *dwp = (word_t *) dp;
+		const word_t *swp = (const word_t *) sp;
+
+		while (cnt >= WORD_SIZE) {
+			*dwp++ = *swp++;
+			cnt -= WORD_SIZE;
+		}
+
+		dp = (uint8_t *) dwp;
+		sp = (const uint8_t *) swp;
+	}
+
 	while (cnt-- != 0)
 		*dp++ = *sp++;
 
@@ -103,6 +143,28 @@ int memcmp(const void *s1, const void *s2, size_t len)
 	uint8_t *u2 = (uint8_t *) s2;
 	size_t i;
 
+	/*
+	 * If both areas are aligned the same way, skip equal words and leave
+	 * only the word with the first difference to the byte loop.
+	 */
+	if (((uintptr_t) u1 & (WORD_SIZE - 1)) ==
+	    ((uintptr_t) u2 & (WORD_SIZE - 1))) {
+		while (len > 0 && !word_aligned(u1)) {
+			if (*u1 != *u2)
+				return (int)(*u1) - (int)(*u2);
+			++u1;
+			++u2;
+			--len;
+		}
+
+		while (len >= WORD_SIZE &&
+		    *(const word_t *) u1 == *(const word_t *) u2) {
+			u1 += WORD_SIZE;
+			u2 += WORD_SIZE;
+			len -= WORD_SIZE;
+		}
+	}
+
 	for (i = 0; i < len; i++) {
 		if (*u1 != *u2)
 			return (int)(*u1) - (int)(*u2);
@@ -39,6 +39,7 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/km.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -46,8 +47,11 @@
 #include <typedefs.h>
 #include <align.h>
 #include <assert.h>
+#include <barrier.h>
+#include <config.h>
 #include <errno.h>
 #include <log.h>
+#include <mem.h>
 #include <str.h>
 
 static bool user_create(as_area_t *);
@@ -95,6 +99,34 @@ bool user_is_shareable(as_area_t *area)
 	return false;
 }
 
+/** Map a frame returned by the pager into the kernel address space. */
+static uintptr_t user_frame_map(uintptr_t frame)
+{
+	if (frame < config.identity_size)
+		return PA2KA(frame);
+
+	return km_map(frame, PAGE_SIZE, PAGE_SIZE,
+	    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+}
+
+/** Unmap a frame mapped by user_frame_map(). */
+static void user_frame_unmap(uintptr_t frame, uintptr_t kpage)
+{
+	if (frame >= config.identity_size)
+		km_unmap(kpage, PAGE_SIZE);
+}
+
+/** Drop the reference to a frame returned by the pager. */
+static void user_frame_release(uintptr_t frame)
+{
+	pfn_t pfn = ADDR2PFN(frame);
+	if (find_zone(pfn, 1, 0) != (size_t) -1) {
+		frame_free(frame, 1);
+	} else {
+		/* Nothing to do */
+	}
+}
+
 /** Service a page fault in the user-paged address space area.
  *
  * The address space area and page tables must be already locked.
@@ -145,6 +177,35 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 */
 
 	uintptr_t frame = ipc_get_arg1(&data);
+
+	if (area->flags & AS_AREA_WRITE) {
+		/*
+		 * The pager may hand out the same frame to other areas, e.g.
+		 * from its page cache. Never let a writable area store to it,
+		 * give the area a private copy instead.
+		 */
+		uintptr_t copy;
+		uintptr_t kdst = km_temporary_page_get(&copy, 0);
+		uintptr_t ksrc = user_frame_map(frame);
+
+		memcpy((void *) kdst, (void *) ksrc, PAGE_SIZE);
+		if (area->flags & AS_AREA_EXEC)
+			smc_coherence((void *) kdst, PAGE_SIZE);
+
+		user_frame_unmap(frame, ksrc);
+		km_temporary_page_put(kdst);
+		user_frame_release(frame);
+		frame = copy;
+	} else if (area->flags & AS_AREA_EXEC) {
+		/*
+		 * The pager filled the frame using data stores, make sure that
+		 * instruction fetches will see the new contents.
+		 */
+		uintptr_t kpage = user_frame_map(frame);
+		smc_coherence((void *) kpage, PAGE_SIZE);
+		user_frame_unmap(frame, kpage);
+	}
+
 	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
 	if (!used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
@@ -165,13 +226,7 @@ void user_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
 	assert(page_table_locked(area->as));
 	assert(mutex_locked(&area->lock));
 
-	pfn_t pfn = ADDR2PFN(frame);
-	if (find_zone(pfn, 1, 0) != (size_t) -1) {
-		frame_free(frame, 1);
-	} else {
-		/* Nothing to do */
-	}
-
+	user_frame_release(frame);
 }
 
 /** @}
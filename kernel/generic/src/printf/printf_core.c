@@ -42,6 +42,7 @@
 #include <macros.h>
 #include <stddef.h>
 #include <str.h>
+#include <mem.h>
 #include <arch.h>
 
 /** show prefixes 0x or 0 */
@@ -110,8 +111,110 @@ typedef enum {
 static const char *nullstr = "(NULL)";
 static const char *digits_small = "0123456789abcdef";
 static const char *digits_big = "0123456789ABCDEF";
+
+/** Decimal digit pairs from 00 to 99 for converting two digits at a time */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
 static const char invalch = U_SPECIAL;
 
+/** Size of the buffer printf_core() collects its output in. */
+#define PRINTF_BUF_SIZE  128
+
+/** Output buffer of printf_core().
+ *
+ * The formatting functions write many short pieces of output such as
+ * padding, signs and prefixes. They are collected in the buffer and passed
+ * to the output methods of the caller in whole spans.
+ */
+typedef struct {
+	/** Output methods of the caller */
+	printf_spec_t *ps;
+	/** Number of characters printed by the output methods */
+	int counter;
+	/** Number of bytes in the buffer */
+	size_t used;
+	/** Buffered output */
+	char data[PRINTF_BUF_SIZE];
+} printf_buf_t;
+
+/** Pass the buffered output to the output method of the caller.
+ *
+ * @return Non-negative value on success, negative value on failure.
+ *
+ */
+static int printf_buf_flush(printf_buf_t *pb)
+{
+	if (pb->used == 0)
+		return 0;
+
+	int retval = pb->ps->str_write(pb->data, pb->used, pb->ps->data);
+	pb->used = 0;
+	if (retval < 0)
+		return retval;
+
+	pb->counter += retval;
+	return retval;
+}
+
+/** String output method collecting the output in printf_buf_t.
+ *
+ * Spans longer than the buffer are passed through unless they can be
+ * appended to the buffered data.
+ *
+ * @return Number of bytes accepted, negative value on failure.
+ *
+ */
+static int printf_buf_write(const char *str, size_t size, void *data)
+{
+	printf_buf_t *pb = (printf_buf_t *) data;
+
+	if (size > PRINTF_BUF_SIZE - pb->used) {
+		int retval = printf_buf_flush(pb);
+		if (retval < 0)
+			return retval;
+
+		if (size > PRINTF_BUF_SIZE) {
+			retval = pb->ps->str_write(str, size, pb->ps->data);
+			if (retval < 0)
+				return retval;
+
+			pb->counter += retval;
+			return (int) size;
+		}
+	}
+
+	memcpy(pb->data + pb->used, str, size);
+	pb->used += size;
+	return (int) size;
+}
+
+/** Wide string output method of printf_buf_t, not buffered. */
+static int printf_buf_wwrite(const wchar_t *str, size_t size, void *data)
+{
+	printf_buf_t *pb = (printf_buf_t *) data;
+
+	/* Keep the output in order. */
+	int retval = printf_buf_flush(pb);
+	if (retval < 0)
+		return retval;
+
+	retval = pb->ps->wstr_write(str, size, pb->ps->data);
+	if (retval < 0)
+		return retval;
+
+	pb->counter += retval;
+	return retval;
+}
+
 /** Print one or more characters without adding newline.
  *
  * @param buf  Buffer holding characters with size of
@@ -283,8 +386,19 @@ static int print_str(char *str, int width, unsigned int precision,
 	if (str == NULL)
 		return printf_putstr(nullstr, ps);
 
-	/* Print leading spaces. */
-	size_t strw = str_length(str);
+	/* Neither width nor precision - no need to count the characters. */
+	if ((width <= 0) && (precision == 0))
+		return printf_putnchars(str, str_size(str), ps);
+
+	/* ASCII strings have as many characters as bytes. */
+	size_t ascii = 0;
+	while ((str[ascii] != 0) && ascii_check(str[ascii]))
+		ascii++;
+
+	bool is_ascii = (str[ascii] == 0);
+	size_t strw = is_ascii ? ascii : str_length(str);
+
+	/* Precision unspecified - print everything. */
 	if ((precision == 0) || (precision > strw))
 		precision = strw;
 
@@ -300,7 +414,7 @@ static int print_str(char *str, int width, unsigned int precision,
 
 	/* Part of @a str fitting into the alloted space. */
 	int retval;
-	size_t size = str_lsize(str, precision);
+	size_t size = is_ascii ? precision : str_lsize(str, precision);
 	if ((retval = printf_putnchars(str, size, ps)) < 0)
 		return -counter;
 
@@ -363,6 +477,81 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	return ((int) counter);
 }
 
+/** Convert a number to digits stored backwards from @a end.
+ *
+ * Decimal numbers are converted two digits at a time and in 32-bit
+ * arithmetic as soon as they fit. Power-of-two bases use shifts instead of
+ * divisions.
+ *
+ * @param num    Number to convert.
+ * @param base   Base to convert the number to (must be between 2 and 16).
+ * @param digits Digits to use.
+ * @param end    Position just past the last digit.
+ *
+ * @return Pointer to the first digit.
+ *
+ */
+static char *number_to_str(uint64_t num, unsigned int base,
+    const char *digits, char *end)
+{
+	char *ptr = end;
+	unsigned int shift;
+	uint32_t num32;
+
+	switch (base) {
+	case 10:
+		while (num > UINT32_MAX) {
+			uint64_t quot = num / 100;
+			unsigned int rem = num - quot * 100;
+
+			ptr -= 2;
+			memcpy(ptr, &digit_pairs[2 * rem], 2);
+			num = quot;
+		}
+
+		num32 = (uint32_t) num;
+		while (num32 >= 100) {
+			uint32_t quot = num32 / 100;
+			unsigned int rem = num32 - quot * 100;
+
+			ptr -= 2;
+			memcpy(ptr, &digit_pairs[2 * rem], 2);
+			num32 = quot;
+		}
+
+		if (num32 >= 10) {
+			ptr -= 2;
+			memcpy(ptr, &digit_pairs[2 * num32], 2);
+		} else {
+			*--ptr = '0' + num32;
+		}
+
+		return ptr;
+	case 2:
+		shift = 1;
+		break;
+	case 8:
+		shift = 3;
+		break;
+	case 16:
+		shift = 4;
+		break;
+	default:
+		do {
+			*--ptr = digits[num % base];
+		} while (num /= base);
+
+		return ptr;
+	}
+
+	do {
+		*--ptr = digits[num & (base - 1)];
+		num >>= shift;
+	} while (num != 0);
+
+	return ptr;
+}
+
 /** Print a number in a given base.
  *
  * Print significant digits of a number in given base.
@@ -386,23 +575,11 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		digits = digits_small;
 
 	char data[PRINT_NUMBER_BUFFER_SIZE];
-	char *ptr = &data[PRINT_NUMBER_BUFFER_SIZE - 1];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE - 1];
+	char *ptr = number_to_str(num, base, digits, end);
 
 	/* Size of number with all prefixes and signs */
-	int size = 0;
-
-	/* Put zero at end of string */
-	*ptr-- = 0;
-
-	if (num == 0) {
-		*ptr-- = '0';
-		size++;
-	} else {
-		do {
-			*ptr-- = digits[num % base];
-			size++;
-		} while (num /= base);
-	}
+	int size = end - ptr;
 
 	/* Size of plain number */
 	int number_size = size;
@@ -516,7 +693,7 @@ static int print_number(uint64_t num, int width, int precision, int base,
 
 	/* Print the number itself */
 	int retval;
-	if ((retval = printf_putstr(++ptr, ps)) > 0)
+	if ((retval = printf_putnchars(ptr, number_size, ps)) > 0)
 		counter += retval;
 
 	/* Print trailing spaces */
@@ -529,6 +706,27 @@ static int print_number(uint64_t num, int width, int precision, int base,
 	return ((int) counter);
 }
 
+/** Decode the next character of a format string.
+ *
+ * ASCII characters are taken as they are. Unlike str_decode(), the offset
+ * is not advanced past the terminating zero.
+ *
+ */
+static inline wchar_t printf_decode(const char *fmt, size_t *nxt)
+{
+	uint8_t b = (uint8_t) fmt[*nxt];
+
+	if (b == 0)
+		return 0;
+
+	if (b < 0x80) {
+		(*nxt)++;
+		return b;
+	}
+
+	return str_decode(fmt, nxt, STR_NO_LIMIT);
+}
+
 /** Print formatted string.
  *
  * Print string formatted according to the fmt parameter and variadic arguments.
@@ -618,18 +816,39 @@ static int print_number(uint64_t num, int width, int precision, int base,
  * @return Number of characters printed, negative value on failure.
  *
  */
-int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
+int printf_core(const char *fmt, printf_spec_t *spec, va_list ap)
 {
+	/* Collect the output in a buffer and write it out in whole spans. */
+	printf_buf_t pb = {
+		.ps = spec,
+		.counter = 0,
+		.used = 0
+	};
+	printf_spec_t bps = {
+		printf_buf_write,
+		printf_buf_wwrite,
+		&pb
+	};
+	printf_spec_t *ps = &bps;
+
 	size_t i;        /* Index of the currently processed character from fmt */
 	size_t nxt = 0;  /* Index of the next character from fmt */
 	size_t j = 0;    /* Index to the first not printed nonformating character */
 
-	size_t counter = 0;   /* Number of characters printed */
 	int retval;           /* Return values from nested functions */
 
 	while (true) {
+		/*
+		 * Skip ordinary characters. Neither '%' nor the terminating
+		 * zero can be part of a multibyte UTF-8 sequence, so there is
+		 * no need to decode them.
+		 */
 		i = nxt;
-		wchar_t uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+		while ((fmt[i] != '%') && (fmt[i] != 0))
+			i++;
+
+		nxt = i;
+		wchar_t uc = printf_decode(fmt, &nxt);
 
 		if (uc == 0)
 			break;
@@ -640,10 +859,8 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			if (i > j) {
 				if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
 					/* Error */
-					counter = -counter;
-					goto out;
+					goto error;
 				}
-				counter += retval;
 			}
 
 			j = i;
@@ -654,7 +871,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 
 			do {
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				switch (uc) {
 				case '#':
 					flags |= __PRINTF_FLAG_PREFIX;
@@ -684,7 +901,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 					width += uc - '0';
 
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_decode(fmt, &nxt);
 					if (uc == 0)
 						break;
 					if (!isdigit(uc))
@@ -693,7 +910,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			} else if (uc == '*') {
 				/* Get width value from argument list */
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				width = (int) va_arg(ap, int);
 				if (width < 0) {
 					/* Negative width sets '-' flag */
@@ -706,14 +923,14 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			int precision = 0;
 			if (uc == '.') {
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				if (isdigit(uc)) {
 					while (true) {
 						precision *= 10;
 						precision += uc - '0';
 
 						i = nxt;
-						uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+						uc = printf_decode(fmt, &nxt);
 						if (uc == 0)
 							break;
 						if (!isdigit(uc))
@@ -722,7 +939,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				} else if (uc == '*') {
 					/* Get precision value from the argument list */
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_decode(fmt, &nxt);
 					precision = (int) va_arg(ap, int);
 					if (precision < 0) {
 						/* Ignore negative precision */
@@ -741,16 +958,16 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				else
 					qualifier = PrintfQualifierLongLong;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				break;
 			case 'h':
 				/* Char or short */
 				qualifier = PrintfQualifierShort;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				if (uc == 'h') {
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_decode(fmt, &nxt);
 					qualifier = PrintfQualifierByte;
 				}
 				break;
@@ -758,22 +975,22 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				/* Long or long long */
 				qualifier = PrintfQualifierLong;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				if (uc == 'l') {
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_decode(fmt, &nxt);
 					qualifier = PrintfQualifierLongLong;
 				}
 				break;
 			case 'z':
 				qualifier = PrintfQualifierSize;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				break;
 			case 'j':
 				qualifier = PrintfQualifierMax;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_decode(fmt, &nxt);
 				break;
 			default:
 				/* Default type */
@@ -792,12 +1009,9 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				else
 					retval = print_str(va_arg(ap, char *), width, precision, flags, ps);
 
-				if (retval < 0) {
-					counter = -counter;
-					goto out;
-				}
+				if (retval < 0)
+					goto error;
 
-				counter += retval;
 				j = nxt;
 				continue;
 			case 'c':
@@ -806,12 +1020,9 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				else
 					retval = print_char(va_arg(ap, unsigned int), width, flags, ps);
 
-				if (retval < 0) {
-					counter = -counter;
-					goto out;
-				}
+				if (retval < 0)
+					goto error;
 
-				counter += retval;
 				j = nxt;
 				continue;
 
@@ -903,17 +1114,14 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				break;
 			default:
 				/* Unknown qualifier */
-				counter = -counter;
-				goto out;
+				goto error;
 			}
 
 			if ((retval = print_number(number, width, precision,
 			    base, flags, ps)) < 0) {
-				counter = -counter;
-				goto out;
+				goto error;
 			}
 
-			counter += retval;
 			j = nxt;
 		}
 	}
@@ -921,14 +1129,18 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 	if (i > j) {
 		if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
 			/* Error */
-			counter = -counter;
-			goto out;
+			goto error;
 		}
-		counter += retval;
 	}
 
-out:
-	return ((int) counter);
+	if (printf_buf_flush(&pb) < 0)
+		return -pb.counter;
+
+	return pb.counter;
+
+error:
+	(void) printf_buf_flush(&pb);
+	return -pb.counter;
 }
 
 /** @}
@@ -26,6 +26,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <async.h>
 #include <errno.h>
 #include <str_error.h>
 #include <stdio.h>
@@ -387,15 +388,80 @@ exit:
 	return rc;
 }
 
+/** Copy contents of one file to another.
+ *
+ * The next chunk of the source file is read while the current one is
+ * being written, so that reading and writing overlap.
+ *
+ * @param fd1	Source file.
+ * @param fd2	Destination file.
+ * @param buff	Two buffers of @a blen bytes each.
+ * @param blen	Buffer size.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t copy_data(int fd1, int fd2, char *buff[2], size_t blen)
+{
+	async_group_t *group;
+	ipc_call_t ranswer, wanswer;
+	aid_t rreq, wreq;
+	aoff64_t posr = 0, posw = 0;
+	size_t rbytes, wbytes, nbytes;
+	unsigned int cur = 0;
+	errno_t rc, rrc;
+
+	group = async_group_create();
+	if (group == NULL)
+		return ENOMEM;
+
+	rc = vfs_read_send(fd1, posr, buff[cur], blen, &ranswer, &rreq);
+	if (rc == EOK)
+		async_wait_for(rreq, &rc);
+
+	while (rc == EOK && (rbytes = ipc_get_arg1(&ranswer)) > 0) {
+		posr += rbytes;
+
+		rc = vfs_write_send(fd2, posw, buff[cur], rbytes, &wanswer,
+		    &wreq);
+		if (rc != EOK)
+			break;
+		(void) async_group_add(group, wreq, NULL);
+
+		rrc = vfs_read_send(fd1, posr, buff[1 - cur], blen, &ranswer,
+		    &rreq);
+		if (rrc == EOK)
+			(void) async_group_add(group, rreq, NULL);
+
+		rc = async_group_wait_all(group);
+		if (rc == EOK)
+			rc = rrc;
+		if (rc != EOK)
+			break;
+
+		/* Finish a short write synchronously */
+		wbytes = ipc_get_arg1(&wanswer);
+		posw += wbytes;
+		if (wbytes < rbytes) {
+			rc = vfs_write(fd2, &posw, buff[cur] + wbytes,
+			    rbytes - wbytes, &nbytes);
+			if (rc != EOK)
+				break;
+		}
+
+		cur = 1 - cur;
+	}
+
+	async_group_destroy(group);
+	return rc;
+}
+
 static int copy_file(const char *src, const char *dest,
     size_t blen, int vb)
 {
 	int fd1, fd2;
-	size_t rbytes, wbytes;
 	errno_t rc;
 	off64_t total;
-	char *buff = NULL;
-	aoff64_t posr = 0, posw = 0;
+	char *buff[2] = { NULL, NULL };
 	vfs_stat_t st;
 
 	if (vb)
@@ -425,29 +491,36 @@ static int copy_file(const char *src, const char *dest,
 	if (vb)
 		printf("%" PRIu64 " bytes to copy\n", total);
 
-	if (NULL == (buff = (char *) malloc(blen))) {
+	/* Let VFS and the file systems copy the data without our help */
+	aoff64_t posr = 0, posw = 0, copied;
+	rc = vfs_copy_range(fd1, &posr, fd2, &posw, total, &copied);
+	if (rc != ENOTSUP) {
+		/* The source ended before its size said it would */
+		if (rc == EOK && copied < (aoff64_t) total)
+			rc = EIO;
+		if (rc != EOK)
+			printf("\nError copying %s: %s\n", src, str_error(rc));
+		goto out;
+	}
+
+	buff[0] = (char *) malloc(blen);
+	buff[1] = (char *) malloc(blen);
+	if (NULL == buff[0] || NULL == buff[1]) {
 		printf("Unable to allocate enough memory to read %s\n",
 		    src);
 		rc = ENOMEM;
 		goto out;
 	}
 
-	while ((rc = vfs_read(fd1, &posr, buff, blen, &rbytes)) == EOK &&
-	    rbytes > 0) {
-		if ((rc = vfs_write(fd2, &posw, buff, rbytes, &wbytes)) != EOK)
-			break;
-	}
-
-	if (rc != EOK) {
+	rc = copy_data(fd1, fd2, buff, blen);
+	if (rc != EOK)
 		printf("\nError copying %s: %s\n", src, str_error(rc));
-		return -1;
-	}
 
 out:
 	vfs_put(fd1);
 	vfs_put(fd2);
-	if (buff)
-		free(buff);
+	free(buff[0]);
+	free(buff[1]);
 	if (rc != EOK) {
 		return -1;
 	} else {
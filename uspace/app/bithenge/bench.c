@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup bithenge
+ * @{
+ */
+/**
+ * @file
+ * Decoding benchmark for the host (Linux) build of Bithenge. The script is
+ * applied to the source repeatedly and the resulting tree is walked in full,
+ * reading every blob, so that lazily decoded fields are really decoded.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <bithenge/blob.h>
+#include <bithenge/file.h>
+#include <bithenge/source.h>
+#include <bithenge/script.h>
+#include <bithenge/transform.h>
+#include <bithenge/tree.h>
+#include <bithenge/os.h>
+
+#define str_error strerror
+
+typedef struct {
+	uint64_t nodes;
+	uint64_t bytes;
+} walk_stats_t;
+
+static errno_t walk_node(bithenge_node_t *node, walk_stats_t *stats);
+
+static errno_t walk_pair(bithenge_node_t *key, bithenge_node_t *value,
+    void *data)
+{
+	walk_stats_t *stats = data;
+	errno_t rc = walk_node(key, stats);
+	if (rc == EOK)
+		rc = walk_node(value, stats);
+	bithenge_node_dec_ref(key);
+	bithenge_node_dec_ref(value);
+	return rc;
+}
+
+static errno_t walk_blob(bithenge_blob_t *blob, walk_stats_t *stats)
+{
+	char buffer[1024];
+	aoff64_t pos = 0;
+	aoff64_t size;
+	do {
+		size = sizeof(buffer);
+		errno_t rc = bithenge_blob_read(blob, pos, buffer, &size);
+		if (rc != EOK)
+			return rc;
+		pos += size;
+	} while (size == sizeof(buffer));
+	stats->bytes += pos;
+	return EOK;
+}
+
+static errno_t walk_node(bithenge_node_t *node, walk_stats_t *stats)
+{
+	stats->nodes++;
+	switch (bithenge_node_type(node)) {
+	case BITHENGE_NODE_INTERNAL:
+		return bithenge_node_for_each(node, walk_pair, stats);
+	case BITHENGE_NODE_BLOB:
+		return walk_blob(bithenge_node_as_blob(node), stats);
+	default:
+		return EOK;
+	}
+}
+
+static errno_t open_source(bithenge_node_t **out, const char *source,
+    bool raw)
+{
+	/* Plain filenames normally get a cache; skip it to compare. */
+	if (raw && !strchr(source, ':'))
+		return bithenge_new_file_blob(out, source);
+	return bithenge_node_from_source(out, source);
+}
+
+static errno_t run_once(const char *script, const char *source, bool raw,
+    walk_stats_t *stats)
+{
+	bithenge_scope_t *scope = NULL;
+	bithenge_transform_t *transform = NULL;
+	bithenge_node_t *node = NULL, *tree = NULL;
+
+	errno_t rc = bithenge_scope_new(&scope, NULL);
+	if (rc != EOK) {
+		fprintf(stderr, "Error creating scope: %s\n", str_error(rc));
+		return rc;
+	}
+
+	rc = bithenge_parse_script(script, &transform);
+	if (rc != EOK) {
+		fprintf(stderr, "Error parsing script: %s\n", str_error(rc));
+		goto out;
+	}
+
+	rc = open_source(&node, source, raw);
+	if (rc != EOK) {
+		fprintf(stderr, "Error creating node from source: %s\n",
+		    str_error(rc));
+		goto out;
+	}
+
+	rc = bithenge_transform_apply(transform, scope, node, &tree);
+	if (rc == EOK)
+		rc = walk_node(tree, stats);
+	if (rc != EOK) {
+		const char *message = bithenge_scope_get_error(scope);
+		fprintf(stderr, "Error decoding: %s\n",
+		    message ? message : str_error(rc));
+	}
+
+out:
+	bithenge_node_dec_ref(tree);
+	bithenge_node_dec_ref(node);
+	bithenge_transform_dec_ref(transform);
+	bithenge_scope_dec_ref(scope);
+	return rc;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n <iterations>] [-r] <script> <source>\n"
+	    "  -n  Number of times to decode the source (default 10)\n"
+	    "  -r  Read plain files without the blob cache\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 10;
+	bool raw = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:r")) != -1) {
+		switch (c) {
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		case 'r':
+			raw = true;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind != 2 || iterations <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	walk_stats_t stats = { 0, 0 };
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++) {
+		stats.nodes = 0;
+		stats.bytes = 0;
+		if (run_once(argv[optind], argv[optind + 1], raw, &stats) !=
+		    EOK)
+			return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	uint64_t usec = (end.tv_sec - start.tv_sec) * 1000000 +
+	    (end.tv_nsec - start.tv_nsec) / 1000;
+	printf("%d iterations, %" PRIu64 " us/iteration, %" PRIu64
+	    " nodes, %" PRIu64 " blob bytes\n", iterations,
+	    usec / iterations, stats.nodes, stats.bytes);
+	return 0;
+}
+
+/** @}
+ */
@@ -34,16 +34,30 @@
 
 #include <errno.h>
 #include <gzip.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/** Size of the buffer for decompressed data */
+#define BUFFER_SIZE 65536
+
+static errno_t gunzip_read(void *arg, void *buf, size_t size, size_t *nread)
+{
+	FILE *f = (FILE *) arg;
+
+	*nread = fread(buf, 1, size, f);
+	if ((*nread == 0) && ferror(f))
+		return EIO;
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
-	void *data, *ddata;
-	size_t size, dsize;
+	gzip_stream_t *stream;
+	void *buf;
 	size_t nread, nwr;
-	long len;
 	FILE *f, *wf;
 
 	if (argc != 3) {
@@ -57,68 +71,64 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
-	if (fseek(f, 0, SEEK_END) < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
+	buf = malloc(BUFFER_SIZE);
+	if (buf == NULL) {
+		printf("Out of memory.\n");
 		fclose(f);
 		return 1;
 	}
 
-	len = ftell(f);
-	if (len < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	if (fseek(f, 0, SEEK_SET) < 0) {
-		printf ("Error rewinding '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	data = malloc(len);
-	if (data == NULL) {
-		printf("Error allocating %ld bytes.\n", len);
-		fclose(f);
-		return 1;
-	}
-
-	nread = fread(data, 1, len, f);
-	if (nread != (size_t)len) {
-		printf("Error reading '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	fclose(f);
-
-	size = (size_t) len;
-
-	rc = gzip_expand(data, size, &ddata, &dsize);
+	rc = gzip_stream_create(gunzip_read, f, &stream);
 	if (rc != EOK) {
 		printf("Error decompressing data.\n");
+		free(buf);
+		fclose(f);
 		return 1;
 	}
 
 	wf = fopen(argv[2], "wb");
 	if (wf == NULL) {
 		printf("Error creating file '%s'\n", argv[2]);
+		gzip_stream_destroy(stream);
+		free(buf);
+		fclose(f);
 		return 1;
 	}
 
-	nwr = fwrite(ddata, 1, dsize, wf);
-	if (nwr != dsize) {
-		printf("Error writing '%s'\n", argv[2]);
-		fclose(wf);
-		return 1;
+	while (true) {
+		rc = gzip_stream_read(stream, buf, BUFFER_SIZE, &nread);
+		if (rc != EOK) {
+			printf("Error decompressing data.\n");
+			goto error;
+		}
+
+		if (nread == 0)
+			break;
+
+		nwr = fwrite(buf, 1, nread, wf);
+		if (nwr != nread) {
+			printf("Error writing '%s'\n", argv[2]);
+			goto error;
+		}
 	}
 
+	gzip_stream_destroy(stream);
+	free(buf);
+	fclose(f);
+
 	if (fclose(wf) != 0) {
 		printf("Error writing '%s'\n", argv[2]);
 		return 1;
 	}
 
 	return 0;
+
+error:
+	gzip_stream_destroy(stream);
+	free(buf);
+	fclose(f);
+	fclose(wf);
+	return 1;
 }
 
 /** @}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/oa_hash_table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Compares the chained hash table with the open-addressing one. The table
+ * is selected by the 'table' parameter ('chained' or 'open'), the number of
+ * items by the 'items' parameter (10000 by default) and the keys by the
+ * 'keys' parameter:
+ *
+ *  seq     consecutive integers such as node indices or task IDs
+ *  random  random 64-bit integers
+ *  str     file names such as "file1234"
+ *
+ * Each iteration inserts all items, looks up every item and as many
+ * missing keys and then removes all items one by one.
+ */
+
+#define HASH_NAME_SIZE 24
+
+typedef struct {
+	ht_link_t link;
+	oa_ht_link_t oa_link;
+	uint64_t key;
+	char name[HASH_NAME_SIZE];
+} hash_item_t;
+
+static bool use_open;
+static bool str_keys;
+static size_t item_cnt;
+static hash_item_t *items = NULL;
+static hash_item_t *missing = NULL;
+
+static size_t name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (uint8_t) *name++);
+
+	return hash;
+}
+
+/** Key of an item: pointer to the name or to the integer key. */
+static const void *item_key(hash_item_t *item)
+{
+	return str_keys ? (const void *) item->name : (const void *) &item->key;
+}
+
+static size_t key_hash(const void *key)
+{
+	return str_keys ? name_hash(key) : hash_mix(*(const uint64_t *) key);
+}
+
+static bool key_equal(const void *key, const hash_item_t *item)
+{
+	if (str_keys)
+		return str_cmp(key, item->name) == 0;
+
+	return *(const uint64_t *) key == item->key;
+}
+
+static size_t ht_hash(const ht_link_t *link)
+{
+	return key_hash(item_key(hash_table_get_inst(link, hash_item_t, link)));
+}
+
+static size_t ht_key_hash(const void *key)
+{
+	return key_hash(key);
+}
+
+static bool ht_key_equal(const void *key, const ht_link_t *link)
+{
+	return key_equal(key, hash_table_get_inst(link, hash_item_t, link));
+}
+
+static hash_table_ops_t ht_ops = {
+	.hash = ht_hash,
+	.key_hash = ht_key_hash,
+	.key_equal = ht_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t oa_hash(const oa_ht_link_t *link)
+{
+	return key_hash(item_key(oa_hash_table_get_inst(link, hash_item_t,
+	    oa_link)));
+}
+
+static bool oa_key_equal(const void *key, const oa_ht_link_t *link)
+{
+	return key_equal(key, oa_hash_table_get_inst(link, hash_item_t,
+	    oa_link));
+}
+
+static oa_hash_table_ops_t oa_ops = {
+	.hash = oa_hash,
+	.key_hash = ht_key_hash,
+	.key_equal = oa_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize @a cnt items starting with sequence number @a first. */
+static void init_items(hash_item_t *item, size_t first, size_t cnt,
+    const char *keys)
+{
+	uint64_t seed = 0x2545f4914f6cdd1dULL + first;
+
+	for (size_t i = 0; i < cnt; i++) {
+		if (str_cmp(keys, "random") == 0) {
+			/* xorshift64 */
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			item[i].key = seed;
+		} else {
+			item[i].key = first + i;
+		}
+
+		snprintf(item[i].name, HASH_NAME_SIZE, "file%zu", first + i);
+	}
+}
+
+static bool hash_setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *table = bench_env_param_get(env, "table", "open");
+	const char *keys = bench_env_param_get(env, "keys", "seq");
+	const char *cnt = bench_env_param_get(env, "items", "10000");
+
+	if (str_cmp(table, "open") == 0) {
+		use_open = true;
+	} else if (str_cmp(table, "chained") == 0) {
+		use_open = false;
+	} else {
+		return bench_run_fail(run, "unknown table '%s'", table);
+	}
+
+	if (str_cmp(keys, "seq") != 0 && str_cmp(keys, "random") != 0 &&
+	    str_cmp(keys, "str") != 0) {
+		return bench_run_fail(run, "unknown keys '%s'", keys);
+	}
+	str_keys = (str_cmp(keys, "str") == 0);
+
+	char *end;
+	item_cnt = strtoul(cnt, &end, 10);
+	if (*end != '\0' || item_cnt == 0)
+		return bench_run_fail(run, "invalid number of items '%s'", cnt);
+
+	items = calloc(item_cnt, sizeof(hash_item_t));
+	missing = calloc(item_cnt, sizeof(hash_item_t));
+	if (items == NULL || missing == NULL) {
+		free(items);
+		free(missing);
+		items = missing = NULL;
+		return bench_run_fail(run, "failed to allocate %zu items",
+		    item_cnt);
+	}
+
+	/* Missing keys follow the inserted ones. */
+	init_items(items, 0, item_cnt, keys);
+	init_items(missing, item_cnt, item_cnt, keys);
+	return true;
+}
+
+static bool hash_teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(items);
+	free(missing);
+	items = missing = NULL;
+	return true;
+}
+
+static bool run_chained(bench_run_t *run)
+{
+	hash_table_t h;
+
+	if (!hash_table_create(&h, 0, 0, &ht_ops))
+		return bench_run_fail(run, "failed to create hash table");
+
+	for (size_t i = 0; i < item_cnt; i++)
+		hash_table_insert(&h, &items[i].link);
+
+	for (size_t i = 0; i < item_cnt; i++) {
+		if (hash_table_find(&h, item_key(&items[i])) == NULL ||
+		    hash_table_find(&h, item_key(&missing[i])) != NULL) {
+			hash_table_destroy(&h);
+			return bench_run_fail(run, "lookup of item %zu failed", i);
+		}
+	}
+
+	for (size_t i = 0; i < item_cnt; i++)
+		hash_table_remove_item(&h, &items[i].link);
+
+	hash_table_destroy(&h);
+	return true;
+}
+
+static bool run_open(bench_run_t *run)
+{
+	oa_hash_table_t h;
+
+	if (!oa_hash_table_create(&h, 0, &oa_ops))
+		return bench_run_fail(run, "failed to create hash table");
+
+	for (size_t i = 0; i < item_cnt; i++) {
+		if (oa_hash_table_insert(&h, &items[i].oa_link) != EOK) {
+			oa_hash_table_destroy(&h);
+			return bench_run_fail(run, "failed to insert item %zu", i);
+		}
+	}
+
+	for (size_t i = 0; i < item_cnt; i++) {
+		if (oa_hash_table_find(&h, item_key(&items[i])) == NULL ||
+		    oa_hash_table_find(&h, item_key(&missing[i])) != NULL) {
+			oa_hash_table_destroy(&h);
+			return bench_run_fail(run, "lookup of item %zu failed", i);
+		}
+	}
+
+	for (size_t i = 0; i < item_cnt; i++)
+		oa_hash_table_remove_item(&h, &items[i].oa_link);
+
+	oa_hash_table_destroy(&h);
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bool ok = true;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; ok && i < size; i++)
+		ok = use_open ? run_open(run) : run_chained(run);
+	bench_run_stop(run);
+
+	return ok;
+}
+
+benchmark_t benchmark_hash_table = {
+	.name = "hash_table",
+	.desc = "Insert, look up and remove items in a hash table (use 'table' "
+	    "param to choose chained or open, 'keys' to choose seq, random "
+	    "or str and 'items' to set the number of items).",
+	.entry = &runner,
+	.setup = &hash_setup,
+	.teardown = &hash_teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <pcm/format.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Synthetic mixer load resembling what hound does for every period: several
+ * playback streams are mixed into one output buffer. Each operation mixes
+ * STREAMS buffers of PERIOD_FRAMES frames, the reported throughput is the
+ * amount of source data consumed.
+ */
+
+#define STREAMS 8
+#define PERIOD_FRAMES 4096
+
+/** Output format of all benchmarks, same as the hound default. */
+static const pcm_format_t out_format = {
+	.channels = 2,
+	.sampling_rate = 44100,
+	.sample_format = PCM_SAMPLE_SINT16_LE,
+};
+
+/** Source formats of the converting benchmark. */
+static const pcm_format_t convert_formats[] = {
+	{ 2, 44100, PCM_SAMPLE_SINT16_LE },
+	{ 1, 44100, PCM_SAMPLE_SINT16_LE },
+	{ 2, 44100, PCM_SAMPLE_UINT8 },
+	{ 2, 44100, PCM_SAMPLE_SINT24_LE },
+	{ 2, 44100, PCM_SAMPLE_SINT32_LE },
+	{ 2, 44100, PCM_SAMPLE_FLOAT32 },
+	{ 2, 44100, PCM_SAMPLE_SINT16_BE },
+	{ 1, 44100, PCM_SAMPLE_UINT8 },
+};
+
+/** Source format of the resampling benchmark. */
+static const pcm_format_t resample_format = {
+	.channels = 2,
+	.sampling_rate = 48000,
+	.sample_format = PCM_SAMPLE_SINT16_LE,
+};
+
+/** Size of source data consumed by one resampling operation. */
+#define RESAMPLE_FRAMES (PERIOD_FRAMES * 48000 / 44100)
+
+/** Allocate and fill a source buffer with a quiet sawtooth. */
+static void *stream_create(size_t size, unsigned seed)
+{
+	uint8_t *buf = malloc(size);
+	if (buf == NULL)
+		return NULL;
+
+	for (size_t i = 0; i < size; i++)
+		buf[i] = (uint8_t) ((i * (seed + 3)) >> 2);
+	return buf;
+}
+
+static void streams_destroy(void **streams)
+{
+	for (unsigned i = 0; i < STREAMS; i++)
+		free(streams[i]);
+}
+
+/** Mix all streams into the output buffer once per operation. */
+static bool mix_streams(bench_run_t *run, uint64_t size,
+    const pcm_format_t *formats)
+{
+	const size_t out_size = PERIOD_FRAMES *
+	    pcm_format_frame_size(&out_format);
+	void *streams[STREAMS] = { NULL };
+	size_t sizes[STREAMS];
+
+	void *out = malloc(out_size);
+	if (out == NULL) {
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    out_size);
+	}
+
+	for (unsigned i = 0; i < STREAMS; i++) {
+		sizes[i] = PERIOD_FRAMES * pcm_format_frame_size(&formats[i]);
+		streams[i] = stream_create(sizes[i], i);
+		if (streams[i] == NULL) {
+			streams_destroy(streams);
+			free(out);
+			return bench_run_fail(run,
+			    "failed to allocate %zuB buffer", sizes[i]);
+		}
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		pcm_format_silence(out, out_size, &out_format);
+		for (unsigned j = 0; j < STREAMS; j++) {
+			errno_t rc = pcm_format_convert_and_mix(out, out_size,
+			    streams[j], sizes[j], &formats[j], &out_format);
+			if (rc != EOK) {
+				streams_destroy(streams);
+				free(out);
+				return bench_run_fail(run, "mixing failed: %s",
+				    str_error(rc));
+			}
+		}
+	}
+	bench_run_stop(run);
+
+	streams_destroy(streams);
+	free(out);
+	return true;
+}
+
+static bool pcm_mix_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	pcm_format_t formats[STREAMS];
+	for (unsigned i = 0; i < STREAMS; i++)
+		formats[i] = out_format;
+
+	return mix_streams(run, size, formats);
+}
+
+static bool pcm_mix_convert_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	return mix_streams(run, size, convert_formats);
+}
+
+static bool pcm_resample_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	const size_t out_size = PERIOD_FRAMES *
+	    pcm_format_frame_size(&out_format);
+	const size_t src_size = RESAMPLE_FRAMES *
+	    pcm_format_frame_size(&resample_format);
+	void *streams[STREAMS] = { NULL };
+	pcm_resampler_t resamplers[STREAMS];
+
+	void *out = malloc(out_size);
+	if (out == NULL) {
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    out_size);
+	}
+
+	for (unsigned i = 0; i < STREAMS; i++) {
+		pcm_resampler_init(&resamplers[i],
+		    resample_format.sampling_rate, out_format.sampling_rate);
+		streams[i] = stream_create(src_size, i);
+		if (streams[i] == NULL) {
+			streams_destroy(streams);
+			free(out);
+			return bench_run_fail(run,
+			    "failed to allocate %zuB buffer", src_size);
+		}
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		pcm_format_silence(out, out_size, &out_format);
+		for (unsigned j = 0; j < STREAMS; j++) {
+			size_t dst_used, src_used;
+			errno_t rc = pcm_resampler_mix(&resamplers[j], out,
+			    out_size, &out_format, streams[j], src_size,
+			    &resample_format, &dst_used, &src_used);
+			if (rc != EOK) {
+				streams_destroy(streams);
+				free(out);
+				return bench_run_fail(run,
+				    "resampling failed: %s", str_error(rc));
+			}
+		}
+	}
+	bench_run_stop(run);
+
+	streams_destroy(streams);
+	free(out);
+	return true;
+}
+
+benchmark_t benchmark_pcm_mix = {
+	.name = "pcm_mix",
+	.desc = "Mix 8 stereo S16LE streams of matching format",
+	.entry = &pcm_mix_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = STREAMS * PERIOD_FRAMES * 4
+};
+
+benchmark_t benchmark_pcm_mix_convert = {
+	.name = "pcm_mix_convert",
+	.desc = "Mix 8 streams of various formats into stereo S16LE",
+	.entry = &pcm_mix_convert_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = STREAMS * PERIOD_FRAMES * 4
+};
+
+benchmark_t benchmark_pcm_resample = {
+	.name = "pcm_resample",
+	.desc = "Resample and mix 8 stereo S16LE streams from 48kHz to 44.1kHz",
+	.entry = &pcm_resample_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = STREAMS * RESAMPLE_FRAMES * 4
+};
+
+/** @}
+ */
@@ -38,13 +38,28 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_aes_ctr,
+	&benchmark_aes_ecb,
+	&benchmark_aes_gcm,
+	&benchmark_compose_span,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
 	&benchmark_file_read,
+	&benchmark_filter_span,
+	&benchmark_hash_table,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_md5,
+	&benchmark_mem_str,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_pbkdf2,
+	&benchmark_pcm_mix,
+	&benchmark_pcm_mix_convert,
+	&benchmark_pcm_resample,
+	&benchmark_ping_pong,
+	&benchmark_printf,
+	&benchmark_sha1,
+	&benchmark_sha256
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <crypto.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Throughput of the AES-128 modes from libcrypto. Each operation processes
+ * one buffer of BUFFER_SIZE bytes in place.
+ */
+
+#define BUFFER_SIZE 16384
+
+static uint8_t key[AES_KEY_LENGTH] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static uint8_t iv[12] = {
+	0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad,
+	0xde, 0xca, 0xf8, 0x88
+};
+
+static bool aes_ecb_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	aes_ctx_t ctx;
+	aes_set_key(&ctx, key);
+
+	uint8_t *buf = calloc(1, BUFFER_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB buffer",
+		    BUFFER_SIZE);
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		aes_encrypt_blocks(&ctx, buf, buf,
+		    BUFFER_SIZE / AES_CIPHER_LENGTH);
+	}
+	bench_run_stop(run);
+
+	free(buf);
+	return true;
+}
+
+static bool aes_ctr_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	aes_ctx_t ctx;
+	aes_set_key(&ctx, key);
+
+	uint8_t ctr[AES_CIPHER_LENGTH];
+	memset(ctr, 0, AES_CIPHER_LENGTH);
+
+	uint8_t *buf = calloc(1, BUFFER_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB buffer",
+		    BUFFER_SIZE);
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		aes_ctr(&ctx, ctr, buf, buf, BUFFER_SIZE);
+	}
+	bench_run_stop(run);
+
+	free(buf);
+	return true;
+}
+
+static bool aes_gcm_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	aes_gcm_ctx_t ctx;
+	aes_gcm_set_key(&ctx, key);
+
+	uint8_t tag[AES_GCM_TAG_LENGTH];
+
+	uint8_t *buf = calloc(1, BUFFER_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB buffer",
+		    BUFFER_SIZE);
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		errno_t rc = aes_gcm_encrypt(&ctx, iv, sizeof(iv), NULL, 0,
+		    buf, buf, BUFFER_SIZE, tag);
+		if (rc != EOK) {
+			free(buf);
+			return bench_run_fail(run, "AES-GCM encryption failed");
+		}
+	}
+	bench_run_stop(run);
+
+	free(buf);
+	return true;
+}
+
+benchmark_t benchmark_aes_ecb = {
+	.name = "aes_ecb",
+	.desc = "AES-128 block encryption throughput",
+	.entry = &aes_ecb_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+benchmark_t benchmark_aes_ctr = {
+	.name = "aes_ctr",
+	.desc = "AES-128-CTR encryption throughput",
+	.entry = &aes_ctr_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+benchmark_t benchmark_aes_gcm = {
+	.name = "aes_gcm",
+	.desc = "AES-128-GCM authenticated encryption throughput",
+	.entry = &aes_gcm_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+/** @}
+ */
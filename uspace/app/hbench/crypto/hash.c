@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <crypto.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Throughput of the hash functions from libcrypto. Each operation hashes
+ * one buffer of BUFFER_SIZE bytes. The PBKDF2 benchmark measures the WPA
+ * passphrase to key derivation (two times 4096 HMAC-SHA1 computations).
+ */
+
+#define BUFFER_SIZE 16384
+
+static bool hash_runner(bench_run_t *run, uint64_t size, hash_func_t hash_sel)
+{
+	uint8_t hash[HASH_SHA256];
+
+	uint8_t *buf = calloc(1, BUFFER_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB buffer",
+		    BUFFER_SIZE);
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		errno_t rc = create_hash(buf, BUFFER_SIZE, hash, hash_sel);
+		if (rc != EOK) {
+			free(buf);
+			return bench_run_fail(run, "hashing failed");
+		}
+	}
+	bench_run_stop(run);
+
+	free(buf);
+	return true;
+}
+
+static bool md5_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return hash_runner(run, size, HASH_MD5);
+}
+
+static bool sha1_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return hash_runner(run, size, HASH_SHA1);
+}
+
+static bool sha256_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return hash_runner(run, size, HASH_SHA256);
+}
+
+static bool pbkdf2_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *pass = bench_env_param_get(env, "passphrase", "password");
+	const char *ssid = bench_env_param_get(env, "ssid", "IEEE");
+	uint8_t key[PBKDF2_KEY_LENGTH];
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		errno_t rc = pbkdf2((uint8_t *) pass, str_size(pass),
+		    (uint8_t *) ssid, str_size(ssid), key);
+		if (rc != EOK) {
+			return bench_run_fail(run, "key derivation failed");
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_md5 = {
+	.name = "md5",
+	.desc = "MD5 hashing throughput",
+	.entry = &md5_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+benchmark_t benchmark_sha1 = {
+	.name = "sha1",
+	.desc = "SHA-1 hashing throughput",
+	.entry = &sha1_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+benchmark_t benchmark_sha256 = {
+	.name = "sha256",
+	.desc = "SHA-256 hashing throughput",
+	.entry = &sha256_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.bytes_per_op = BUFFER_SIZE
+};
+
+benchmark_t benchmark_pbkdf2 = {
+	.name = "pbkdf2",
+	.desc = "WPA key derivation (use 'passphrase' and 'ssid' params to alter the defaults).",
+	.entry = &pbkdf2_runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -16,7 +16,9 @@
  * benchmark) and fill-in the benchmark_t structure.
  *
  * Fill-in the name of the benchmark, its description and a reference to the
- * benchmark function to the benchmark_t.
+ * benchmark function to the benchmark_t. If every iteration processes the
+ * same amount of data, set also bytes_per_op and the throughput will be
+ * reported in MB/s as well.
  *
  * The benchmarking function has to accept trhee arguments:
  *  @li bench_env_t: benchmark environment configuration
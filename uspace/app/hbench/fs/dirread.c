@@ -32,11 +32,109 @@
  */
 
 #include <dirent.h>
+#include <str.h>
 #include <str_error.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vfs/vfs.h>
 #include "../hbench.h"
 
+#define DIR_BUF_SIZE 4096
+
+/** Read the whole directory using the POSIX readdir() interface. */
+static bool read_posix(bench_run_t *run, const char *path)
+{
+	DIR *dir = opendir(path);
+	if (dir == NULL) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(errno));
+	}
+
+	struct dirent *dp;
+	while ((dp = readdir(dir))) {
+		/* Do nothing */
+	}
+
+	closedir(dir);
+	return true;
+}
+
+/** Read the whole directory one entry per request.
+ *
+ * This is how readdir() used to talk to VFS before batched directory reads
+ * were introduced and serves as the baseline for the other modes.
+ */
+static bool read_single(bench_run_t *run, const char *path, bool with_stat)
+{
+	char name[NAME_MAX + 1];
+	char fpath[NAME_MAX + 1 + 256];
+	vfs_stat_t st;
+	aoff64_t pos = 0;
+	ssize_t len;
+	int fd;
+
+	errno_t rc = vfs_lookup_open(path, WALK_DIRECTORY, MODE_READ, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+	}
+
+	while (true) {
+		rc = vfs_read_short(fd, pos, name, sizeof(name), &len);
+		if (rc != EOK || len == 0)
+			break;
+		pos += len;
+
+		if (with_stat) {
+			snprintf(fpath, sizeof(fpath), "%s/%s", path, name);
+			rc = vfs_stat_path(fpath, &st);
+			if (rc != EOK) {
+				vfs_put(fd);
+				return bench_run_fail(run, "failed to stat %s: %s",
+				    fpath, str_error(rc));
+			}
+		}
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
+/** Read the whole directory including attributes in batches. */
+static bool read_batched_stat(bench_run_t *run, const char *path, void *buf)
+{
+	aoff64_t pos = 0;
+	size_t count;
+	int fd;
+
+	errno_t rc = vfs_lookup_open(path, WALK_DIRECTORY, MODE_READ, &fd);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+	}
+
+	while (true) {
+		rc = vfs_readdir(fd, &pos, buf, DIR_BUF_SIZE, VFS_READDIR_STAT,
+		    &count);
+		if (rc != EOK) {
+			vfs_put(fd);
+			return bench_run_fail(run, "failed to read %s: %s",
+			    path, str_error(rc));
+		}
+		if (count == 0)
+			break;
+
+		vfs_dirent_t *ent = buf;
+		for (size_t i = 0; i < count; i++) {
+			/* Do nothing but walk the records */
+			ent = (vfs_dirent_t *) ((char *) ent + ent->reclen);
+		}
+	}
+
+	vfs_put(fd);
+	return true;
+}
+
 /** Execute directory listing benchmark.
  *
  * Note that while this benchmark tries to measure speed of direct
@@ -46,30 +144,42 @@
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
 	const char *path = bench_env_param_get(env, "dirname", "/");
+	const char *mode = bench_env_param_get(env, "mode", "readdir");
+	void *buf = NULL;
+	bool ok = true;
 
-	bench_run_start(run);
-	for (uint64_t i = 0; i < size; i++) {
-		DIR *dir = opendir(path);
-		if (dir == NULL) {
-			return bench_run_fail(run, "failed to open %s for reading: %s",
-			    path, str_error(errno));
-		}
+	if (str_cmp(mode, "readdir") != 0 && str_cmp(mode, "single") != 0 &&
+	    str_cmp(mode, "stat") != 0 && str_cmp(mode, "single-stat") != 0) {
+		return bench_run_fail(run, "unknown mode '%s'", mode);
+	}
 
-		struct dirent *dp;
-		while ((dp = readdir(dir))) {
-			/* Do nothing */
-		}
+	if (str_cmp(mode, "stat") == 0) {
+		buf = malloc(DIR_BUF_SIZE);
+		if (buf == NULL)
+			return bench_run_fail(run, "failed allocating memory");
+	}
 
-		closedir(dir);
+	bench_run_start(run);
+	for (uint64_t i = 0; ok && i < size; i++) {
+		if (str_cmp(mode, "readdir") == 0)
+			ok = read_posix(run, path);
+		else if (str_cmp(mode, "single") == 0)
+			ok = read_single(run, path, false);
+		else if (str_cmp(mode, "single-stat") == 0)
+			ok = read_single(run, path, true);
+		else
+			ok = read_batched_stat(run, path, buf);
 	}
 	bench_run_stop(run);
 
-	return true;
+	free(buf);
+	return ok;
 }
 
 benchmark_t benchmark_dir_read = {
 	.name = "dir_read",
-	.desc = "Read contents of a directory (use 'dirname' param to alter the default).",
+	.desc = "Read contents of a directory (use 'dirname' param to alter the default, "
+	    "'mode' to choose readdir, single, stat or single-stat).",
 	.entry = &runner,
 	.setup = NULL,
 	.teardown = NULL
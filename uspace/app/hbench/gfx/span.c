@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <compose.h>
+#include <filter.h>
+#include <io/pixelmap.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Pixel throughput of the softrend span operations. Each operation processes
+ * one frame of the size given by the 'resolution' parameter (1024x768 by
+ * default). The compositing operator is selected by the 'op' parameter and
+ * the filter by the 'filter' parameter.
+ */
+
+typedef struct {
+	const char *name;
+	compose_span_t span;
+} compose_op_t;
+
+typedef struct {
+	const char *name;
+	filter_span_t span;
+} filter_op_t;
+
+static compose_op_t compose_ops[] = {
+	{ "clr", compose_clr_span },
+	{ "src", compose_src_span },
+	{ "dst", compose_dst_span },
+	{ "over", compose_over_span },
+	{ "in", compose_in_span },
+	{ "out", compose_out_span },
+	{ "atop", compose_atop_span },
+	{ "xor", compose_xor_span },
+	{ "add", compose_add_span }
+};
+
+static filter_op_t filter_ops[] = {
+	{ "nearest", filter_nearest_span },
+	{ "bilinear", filter_bilinear_span },
+	{ "bicubic", filter_bicubic_span }
+};
+
+static sysarg_t width;
+static sysarg_t height;
+static pixel_t *src = NULL;
+static pixel_t *dst = NULL;
+static compose_span_t compose_span;
+static filter_span_t filter_span;
+
+static bool frame_setup(bench_env_t *env, bench_run_t *run,
+    benchmark_t *bench)
+{
+	const char *res = bench_env_param_get(env, "resolution", "1024x768");
+
+	char *end;
+	width = strtoul(res, &end, 10);
+	if (*end != 'x') {
+		return bench_run_fail(run, "invalid resolution '%s'", res);
+	}
+	height = strtoul(end + 1, &end, 10);
+	if (*end != '\0' || width == 0 || height == 0) {
+		return bench_run_fail(run, "invalid resolution '%s'", res);
+	}
+
+	size_t size = width * height * sizeof(pixel_t);
+	src = malloc(size);
+	dst = malloc(size);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		src = dst = NULL;
+		return bench_run_fail(run, "failed to allocate %zuB buffers",
+		    size);
+	}
+
+	/* Mix of opaque, translucent and transparent pixels. */
+	for (size_t i = 0; i < width * height; i++) {
+		uint8_t alpha = (i % 3 == 0) ? 255 : ((i % 3 == 1) ? i : 0);
+		src[i] = PIXEL(alpha, i, i >> 3, i >> 6);
+		dst[i] = PIXEL(255, i >> 2, i, i >> 4);
+	}
+
+	bench->bytes_per_op = size;
+	return true;
+}
+
+static bool frame_teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(src);
+	free(dst);
+	src = dst = NULL;
+	return true;
+}
+
+static bool compose_setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *op = bench_env_param_get(env, "op", "over");
+
+	compose_span = NULL;
+	for (size_t i = 0; i < sizeof(compose_ops) / sizeof(compose_ops[0]); i++) {
+		if (str_cmp(compose_ops[i].name, op) == 0) {
+			compose_span = compose_ops[i].span;
+		}
+	}
+
+	if (compose_span == NULL) {
+		return bench_run_fail(run, "unknown compositing operator '%s'",
+		    op);
+	}
+
+	return frame_setup(env, run, &benchmark_compose_span);
+}
+
+static bool filter_setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *filter = bench_env_param_get(env, "filter", "bilinear");
+
+	filter_span = NULL;
+	for (size_t i = 0; i < sizeof(filter_ops) / sizeof(filter_ops[0]); i++) {
+		if (str_cmp(filter_ops[i].name, filter) == 0) {
+			filter_span = filter_ops[i].span;
+		}
+	}
+
+	if (filter_span == NULL) {
+		return bench_run_fail(run, "unknown filter '%s'", filter);
+	}
+
+	return frame_setup(env, run, &benchmark_filter_span);
+}
+
+static bool compose_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		for (sysarg_t y = 0; y < height; y++) {
+			compose_span(dst + y * width, src + y * width, width);
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static bool filter_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	pixelmap_t pixmap = {
+		.width = width,
+		.height = height,
+		.data = src
+	};
+
+	/* Slightly scaled and rotated, so that pixels are interpolated. */
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		for (sysarg_t y = 0; y < height; y++) {
+			filter_span(&pixmap, 0.25 + y * 0.03, y * 0.9, 0.9, 0.03,
+			    dst + y * width, width,
+			    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_compose_span = {
+	.name = "compose_span",
+	.desc = "Compose frame rows (use 'op' and 'resolution' params to alter the defaults).",
+	.entry = &compose_runner,
+	.setup = &compose_setup,
+	.teardown = &frame_teardown
+};
+
+benchmark_t benchmark_filter_span = {
+	.name = "filter_span",
+	.desc = "Filter frame rows (use 'filter' and 'resolution' params to alter the defaults).",
+	.entry = &filter_runner,
+	.setup = &filter_setup,
+	.teardown = &frame_teardown
+};
+
+/** @}
+ */
@@ -95,6 +95,8 @@ typedef struct {
 	benchmark_entry_t entry;
 	benchmark_helper_t setup;
 	benchmark_helper_t teardown;
+	/** Bytes processed by one operation (zero if not applicable). */
+	size_t bytes_per_op;
 } benchmark_t;
 
 extern void bench_run_init(bench_run_t *, char *, size_t);
@@ -131,13 +133,28 @@ extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_aes_ctr;
+extern benchmark_t benchmark_aes_ecb;
+extern benchmark_t benchmark_aes_gcm;
+extern benchmark_t benchmark_compose_span;
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_filter_span;
+extern benchmark_t benchmark_hash_table;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_md5;
+extern benchmark_t benchmark_mem_str;
 extern benchmark_t benchmark_ns_ping;
+extern benchmark_t benchmark_pbkdf2;
+extern benchmark_t benchmark_pcm_mix;
+extern benchmark_t benchmark_pcm_mix_convert;
+extern benchmark_t benchmark_pcm_resample;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_printf;
+extern benchmark_t benchmark_sha1;
+extern benchmark_t benchmark_sha256;
 
 #endif
 
@@ -34,6 +34,9 @@
 #include <ipc_test.h>
 #include <async.h>
 #include <errno.h>
+#include <fibril.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <str_error.h>
 #include "../hbench.h"
 
@@ -57,8 +60,77 @@ static bool teardown(bench_env_t *env, bench_run_t *run)
 	return true;
 }
 
+/** Shared state of concurrently pinging fibrils. */
+typedef struct {
+	/** Number of pings each fibril sends */
+	uint64_t niter;
+	/** Number of fibrils which have not finished yet */
+	atomic_int running;
+	/** First error encountered */
+	atomic_int rc;
+} ping_shared_t;
+
+static errno_t pinger(void *arg)
+{
+	ping_shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t count = 0; count < shared->niter; count++) {
+		errno_t rc = ipc_test_ping(test);
+		if (rc != EOK) {
+			atomic_store(&shared->rc, rc);
+			break;
+		}
+	}
+
+	atomic_fetch_sub(&shared->running, 1);
+	return EOK;
+}
+
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
 {
+	const char *fibrils_str = bench_env_param_get(env, "fibrils", "1");
+
+	char *end;
+	unsigned long fibrils = strtoul(fibrils_str, &end, 10);
+	if (*end != '\0' || fibrils == 0) {
+		return bench_run_fail(run, "invalid number of fibrils '%s'",
+		    fibrils_str);
+	}
+
+	if (fibrils > 1) {
+		ping_shared_t shared;
+		shared.niter = niter / fibrils;
+		atomic_store(&shared.running, fibrils);
+		atomic_store(&shared.rc, EOK);
+
+		bench_run_start(run);
+
+		for (unsigned long i = 0; i < fibrils; i++) {
+			fid_t fid = fibril_create(pinger, &shared);
+			if (fid == 0) {
+				atomic_store(&shared.rc, ENOMEM);
+				atomic_fetch_sub(&shared.running, fibrils - i);
+				break;
+			}
+			fibril_add_ready(fid);
+		}
+
+		while (atomic_load(&shared.running) > 0) {
+			fibril_yield();
+		}
+
+		bench_run_stop(run);
+
+		errno_t rc = atomic_load(&shared.rc);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending ping message: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		return true;
+	}
+
 	bench_run_start(run);
 
 	for (uint64_t count = 0; count < niter; count++) {
@@ -77,7 +149,7 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
 
 benchmark_t benchmark_ping_pong = {
 	.name = "ping_pong",
-	.desc = "IPC ping-pong benchmark",
+	.desc = "IPC ping-pong benchmark (use 'fibrils' param to ping concurrently)",
 	.entry = &runner,
 	.setup = &setup,
 	.teardown = &teardown
@@ -62,7 +62,12 @@ static void short_report(bench_run_t *info, int run_index,
 	if (duration_usec > 0) {
 		double nanos = stopwatch_get_nanos(&info->stopwatch);
 		double thruput = (double) workload_size / (nanos / 1000000000.0l);
-		printf(", %.0f ops/s.\n", thruput);
+		printf(", %.0f ops/s", thruput);
+		if (bench->bytes_per_op > 0) {
+			printf(", %.2f MB/s",
+			    thruput * bench->bytes_per_op / 1000000.0);
+		}
+		printf(".\n");
 	} else {
 		printf(".\n");
 	}
@@ -144,9 +149,14 @@ static void summary_stats(bench_run_t *runs, size_t run_count,
 	    &duration_avg, &duration_sigma, &thruput_avg);
 
 	printf("Average: %" PRIu64 " ops in %.0f us (sd %.0f us); "
-	    "%.0f ops/s; Samples: %zu\n",
+	    "%.0f ops/s; ",
 	    workload_size, duration_avg / 1000.0, duration_sigma / 1000.0,
-	    thruput_avg * 1000000000.0, run_count);
+	    thruput_avg * 1000000000.0);
+	if (bench->bytes_per_op > 0) {
+		printf("%.2f MB/s; ",
+		    thruput_avg * 1000.0 * bench->bytes_per_op);
+	}
+	printf("Samples: %zu\n", run_count);
 }
 
 static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
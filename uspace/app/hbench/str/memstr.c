@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Throughput of the memory and string primitives of libc. The function is
+ * selected by the 'func' parameter, the buffer size by the 'size' parameter
+ * (4096 bytes by default). The 'align' and 'dalign' parameters offset the
+ * source and destination (or second operand) from a word boundary. The
+ * 'text' parameter fills the buffers with 'ascii' (default) or 'utf8' text.
+ *
+ * The searches and comparisons are set up to scan the whole buffer.
+ */
+
+#define MEMSTR_MAX_ALIGN 64
+
+typedef enum {
+	MEMSTR_MEMCPY,
+	MEMSTR_MEMSET,
+	MEMSTR_MEMCMP,
+	MEMSTR_MEMCHR,
+	MEMSTR_STR_SIZE,
+	MEMSTR_STR_CMP,
+	MEMSTR_STR_CHR
+} memstr_func_t;
+
+typedef struct {
+	const char *name;
+	memstr_func_t func;
+} memstr_op_t;
+
+static memstr_op_t memstr_ops[] = {
+	{ "memcpy", MEMSTR_MEMCPY },
+	{ "memset", MEMSTR_MEMSET },
+	{ "memcmp", MEMSTR_MEMCMP },
+	{ "memchr", MEMSTR_MEMCHR },
+	{ "str_size", MEMSTR_STR_SIZE },
+	{ "str_cmp", MEMSTR_STR_CMP },
+	{ "str_chr", MEMSTR_STR_CHR }
+};
+
+static memstr_op_t *op;
+static size_t size;
+static char *src_buf = NULL;
+static char *dst_buf = NULL;
+static char *src;
+static char *dst;
+
+static bool parse_size(bench_run_t *run, const char *name, const char *str,
+    size_t max, size_t *val)
+{
+	char *end;
+	unsigned long num = strtoul(str, &end, 10);
+	if (*end != '\0' || num > max)
+		return bench_run_fail(run, "invalid %s '%s'", name, str);
+
+	*val = num;
+	return true;
+}
+
+/** Fill @a size bytes of @a buf with text and terminate it. */
+static void fill_text(char *buf, bool utf8)
+{
+	size_t i = 0;
+
+	if (utf8) {
+		/* Two-byte characters (U+00E9) */
+		for (; i + 2 <= size; i += 2) {
+			buf[i] = (char) 0xc3;
+			buf[i + 1] = (char) 0xa9;
+		}
+	}
+
+	for (; i < size; i++)
+		buf[i] = 'a' + (i % 26);
+
+	buf[size] = '\0';
+}
+
+static bool memstr_setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *func = bench_env_param_get(env, "func", "memcpy");
+	const char *text = bench_env_param_get(env, "text", "ascii");
+	size_t align;
+	size_t dalign;
+
+	op = NULL;
+	for (size_t i = 0; i < sizeof(memstr_ops) / sizeof(memstr_ops[0]); i++) {
+		if (str_cmp(memstr_ops[i].name, func) == 0)
+			op = &memstr_ops[i];
+	}
+
+	if (op == NULL)
+		return bench_run_fail(run, "unknown function '%s'", func);
+
+	if (str_cmp(text, "ascii") != 0 && str_cmp(text, "utf8") != 0)
+		return bench_run_fail(run, "unknown text '%s'", text);
+
+	if (!parse_size(run, "size", bench_env_param_get(env, "size", "4096"),
+	    SIZE_MAX / 2, &size))
+		return false;
+	if (!parse_size(run, "align", bench_env_param_get(env, "align", "0"),
+	    MEMSTR_MAX_ALIGN - 1, &align))
+		return false;
+	if (!parse_size(run, "dalign", bench_env_param_get(env, "dalign", "0"),
+	    MEMSTR_MAX_ALIGN - 1, &dalign))
+		return false;
+
+	/* Buffers from malloc() are aligned at least to the word size. */
+	src_buf = malloc(size + MEMSTR_MAX_ALIGN + 1);
+	dst_buf = malloc(size + MEMSTR_MAX_ALIGN + 1);
+	if (src_buf == NULL || dst_buf == NULL) {
+		free(src_buf);
+		free(dst_buf);
+		src_buf = dst_buf = NULL;
+		return bench_run_fail(run, "failed to allocate %zuB buffers",
+		    size);
+	}
+
+	src = src_buf + align;
+	dst = dst_buf + dalign;
+
+	fill_text(src, str_cmp(text, "utf8") == 0);
+	memcpy(dst, src, size + 1);
+
+	benchmark_mem_str.bytes_per_op = size;
+	return true;
+}
+
+static bool memstr_teardown(bench_env_t *env, bench_run_t *run)
+{
+	free(src_buf);
+	free(dst_buf);
+	src_buf = dst_buf = NULL;
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	/* Accumulate the results so that the calls cannot be optimized out. */
+	size_t acc = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		switch (op->func) {
+		case MEMSTR_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case MEMSTR_MEMSET:
+			memset(dst, 'a', size);
+			break;
+		case MEMSTR_MEMCMP:
+			acc += memcmp(src, dst, size);
+			break;
+		case MEMSTR_MEMCHR:
+			acc += (memchr(src, '#', size) != NULL);
+			break;
+		case MEMSTR_STR_SIZE:
+			acc += str_size(src);
+			break;
+		case MEMSTR_STR_CMP:
+			acc += str_cmp(src, dst);
+			break;
+		case MEMSTR_STR_CHR:
+			acc += (str_chr(src, '#') != NULL);
+			break;
+		}
+	}
+	bench_run_stop(run);
+
+	if (acc != ((op->func == MEMSTR_STR_SIZE) ? niter * size : 0))
+		return bench_run_fail(run, "unexpected result of %s", op->name);
+
+	return true;
+}
+
+benchmark_t benchmark_mem_str = {
+	.name = "mem_str",
+	.desc = "Memory and string functions (use 'func' param to choose "
+	    "memcpy, memset, memcmp, memchr, str_size, str_cmp or str_chr, "
+	    "'size', 'align' and 'dalign' to set the buffers up and 'text' "
+	    "to choose ascii or utf8 contents).",
+	.entry = &runner,
+	.setup = &memstr_setup,
+	.teardown = &memstr_teardown
+};
+
+/**
+ * @}
+ */
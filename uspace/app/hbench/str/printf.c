@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <stdio.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Formatting throughput of printf_core() measured through snprintf() into
+ * a buffer on the stack. The 'format' parameter selects one of the formats
+ * below, each iteration formats the line once.
+ */
+
+#define PRINTF_BUF_SIZE 256
+
+typedef enum {
+	PRINTF_INT,
+	PRINTF_STR,
+	PRINTF_MIXED
+} printf_kind_t;
+
+typedef struct {
+	const char *name;
+	printf_kind_t kind;
+} printf_format_t;
+
+static printf_format_t printf_formats[] = {
+	{ "int", PRINTF_INT },
+	{ "str", PRINTF_STR },
+	{ "mixed", PRINTF_MIXED }
+};
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *name = bench_env_param_get(env, "format", "mixed");
+	printf_format_t *format = NULL;
+	char buf[PRINTF_BUF_SIZE];
+	size_t total = 0;
+	int rc;
+
+	for (size_t i = 0; i < sizeof(printf_formats) /
+	    sizeof(printf_formats[0]); i++) {
+		if (str_cmp(printf_formats[i].name, name) == 0) {
+			format = &printf_formats[i];
+			break;
+		}
+	}
+
+	if (format == NULL)
+		return bench_run_fail(run, "unknown format '%s'", name);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		switch (format->kind) {
+		case PRINTF_INT:
+			rc = snprintf(buf, sizeof(buf), "%d %u %llu %x %08x",
+			    (int) i - 1000, (unsigned) i, (unsigned long long) i *
+			    1000003ULL, (unsigned) i, (unsigned) i);
+			break;
+		case PRINTF_STR:
+			rc = snprintf(buf, sizeof(buf), "%s: %s %-12s|%.5s",
+			    "hbench", "formatting strings", "padded",
+			    "truncated");
+			break;
+		default:
+			rc = snprintf(buf, sizeof(buf),
+			    "[%5llu] %s: request %d from %s took %u us (%c)",
+			    (unsigned long long) i, "devman", (int) i, "task",
+			    (unsigned) (i % 10000), 'x');
+			break;
+		}
+
+		if (rc < 0) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "snprintf() failed");
+		}
+
+		total += rc;
+	}
+	bench_run_stop(run);
+
+	/* Make sure the output is used. */
+	if (total == 0)
+		return bench_run_fail(run, "no output produced");
+
+	return true;
+}
+
+benchmark_t benchmark_printf = {
+	.name = "printf",
+	.desc = "Format lines with snprintf() (use 'format' param to choose "
+	    "int, str or mixed).",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/**
+ * @}
+ */
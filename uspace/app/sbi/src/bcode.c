@@ -0,0 +1,949 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Bytecode compiler.
+ *
+ * Translates the body of a procedure from the typed syntax tree into
+ * a compact linear bytecode which is then executed by run_bcode(). Local
+ * variables and arguments are resolved to numbered slots at compile time
+ * so that the interpreter does not need to look them up by name in block
+ * activation records. Values of type @c int and @c bool are kept unboxed.
+ *
+ * Constructs which the compiler does not translate are left to the tree
+ * walker (run_expr(), run_stat()) at run time. Since the tree walker looks
+ * up local variables by name, every variable referenced from such code
+ * is kept in a block AR instead of a slot. The procedure is compiled twice,
+ * the first pass only serves to find the names referenced from the tree
+ * walker code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "bigint.h"
+#include "intmap.h"
+#include "list.h"
+#include "mytypes.h"
+#include "symbol.h"
+
+#include "bcode.h"
+
+static void bcode_gen_init(bcode_gen_t *gen, intmap_t *boxed);
+static void bcode_gen_fini(bcode_gen_t *gen);
+static int bcode_emit(bcode_gen_t *gen, bcode_op_t op, int a, int b,
+    int sdelta);
+static void bcode_patch(bcode_gen_t *gen, int chain, int target);
+static void bcode_local_add(bcode_gen_t *gen, int sid, int slot);
+static bcode_local_t *bcode_local_find(bcode_gen_t *gen, int sid);
+static bool_t bcode_is_boxed(bcode_gen_t *gen, int sid);
+static bool_t bcode_expr_is_tpc(stree_expr_t *expr, tprimitive_class_t tpc);
+
+static void bcode_proc_body(bcode_gen_t *gen, stree_proc_t *proc);
+static void bcode_arg(bcode_gen_t *gen, stree_proc_arg_t *arg);
+static void bcode_block(bcode_gen_t *gen, stree_block_t *block);
+static void bcode_stat(bcode_gen_t *gen, stree_stat_t *stat);
+static void bcode_stat_fallback(bcode_gen_t *gen, stree_stat_t *stat);
+static void bcode_vdecl(bcode_gen_t *gen, stree_vdecl_t *vdecl);
+static void bcode_if(bcode_gen_t *gen, stree_if_t *if_s);
+static void bcode_while(bcode_gen_t *gen, stree_while_t *while_s);
+static void bcode_exps(bcode_gen_t *gen, stree_exps_t *exps);
+
+static void bcode_expr(bcode_gen_t *gen, stree_expr_t *expr);
+static void bcode_expr_fallback(bcode_gen_t *gen, stree_expr_t *expr);
+static void bcode_nameref(bcode_gen_t *gen, stree_nameref_t *nameref);
+static void bcode_literal(bcode_gen_t *gen, stree_literal_t *literal);
+static void bcode_binop(bcode_gen_t *gen, stree_binop_t *binop);
+static void bcode_unop(bcode_gen_t *gen, stree_unop_t *unop);
+static void bcode_call(bcode_gen_t *gen, stree_call_t *call,
+    bool_t want_value);
+static void bcode_assign(bcode_gen_t *gen, stree_assign_t *assign);
+
+static void bcode_collect_block(bcode_gen_t *gen, stree_block_t *block);
+static void bcode_collect_stat(bcode_gen_t *gen, stree_stat_t *stat);
+static void bcode_collect_expr(bcode_gen_t *gen, stree_expr_t *expr);
+static void bcode_collect_expr_list(bcode_gen_t *gen, list_t *exprs);
+
+/** Compile procedure to bytecode.
+ *
+ * @param proc		Procedure with a body (not a builtin procedure)
+ * @return		Compiled procedure
+ */
+bcode_proc_t *bcode_proc_compile(stree_proc_t *proc)
+{
+	bcode_gen_t pass1;
+	bcode_gen_t gen;
+	bcode_proc_t *bproc;
+
+	assert(proc->body != NULL);
+
+	/* Find names referenced from code left to the tree walker. */
+	bcode_gen_init(&pass1, NULL);
+	bcode_proc_body(&pass1, proc);
+
+	/* Generate final code, keeping those variables in block ARs. */
+	bcode_gen_init(&gen, &pass1.fallback);
+	bcode_proc_body(&gen, proc);
+
+	bproc = calloc(1, sizeof(bcode_proc_t));
+	if (bproc == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	bproc->code = gen.code;
+	bproc->ninstr = gen.ninstr;
+	bproc->nslots = gen.nslots;
+	bproc->max_stack = gen.max_stack;
+
+	gen.code = NULL;
+	bcode_gen_fini(&gen);
+	bcode_gen_fini(&pass1);
+
+	return bproc;
+}
+
+/** Initialize compiler state.
+ *
+ * @param gen		Compiler state
+ * @param boxed		Names of variables to keep in block ARs or @c NULL
+ */
+static void bcode_gen_init(bcode_gen_t *gen, intmap_t *boxed)
+{
+	gen->code = NULL;
+	gen->ninstr = 0;
+	gen->code_alloc = 0;
+	gen->locals = NULL;
+	gen->nlocals = 0;
+	gen->locals_alloc = 0;
+	gen->nslots = 0;
+	gen->sp = 0;
+	gen->max_stack = 0;
+	gen->depth = 0;
+	gen->loop = NULL;
+	gen->boxed = boxed;
+	intmap_init(&gen->fallback);
+}
+
+/** Finalize compiler state.
+ *
+ * @param gen		Compiler state
+ */
+static void bcode_gen_fini(bcode_gen_t *gen)
+{
+	map_elem_t *elem;
+
+	elem = intmap_first(&gen->fallback);
+	while (elem != NULL) {
+		intmap_set(&gen->fallback, intmap_elem_get_key(elem), NULL);
+		elem = intmap_first(&gen->fallback);
+	}
+
+	intmap_fini(&gen->fallback);
+	free(gen->code);
+	free(gen->locals);
+}
+
+/** Emit instruction.
+ *
+ * @param gen		Compiler state
+ * @param op		Opcode
+ * @param a		First operand
+ * @param b		Second operand
+ * @param sdelta	Change of value stack depth caused by the instruction
+ * @return		Index of the new instruction
+ */
+static int bcode_emit(bcode_gen_t *gen, bcode_op_t op, int a, int b,
+    int sdelta)
+{
+	bcode_instr_t *code;
+	bcode_instr_t *instr;
+	int nalloc;
+
+	if (gen->ninstr >= gen->code_alloc) {
+		nalloc = gen->code_alloc > 0 ? 2 * gen->code_alloc : 32;
+		code = realloc(gen->code, nalloc * sizeof(bcode_instr_t));
+		if (code == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+
+		gen->code = code;
+		gen->code_alloc = nalloc;
+	}
+
+	instr = &gen->code[gen->ninstr];
+	instr->op = op;
+	instr->a = a;
+	instr->b = b;
+	instr->u.expr = NULL;
+
+	gen->sp += sdelta;
+	assert(gen->sp >= 0);
+	if (gen->sp > gen->max_stack)
+		gen->max_stack = gen->sp;
+
+	return gen->ninstr++;
+}
+
+/** Patch chain of jump instructions.
+ *
+ * Instructions on the chain are linked through their @c a operand,
+ * the chain is terminated by -1.
+ *
+ * @param gen		Compiler state
+ * @param chain		Index of first instruction on the chain or -1
+ * @param target	Jump target
+ */
+static void bcode_patch(bcode_gen_t *gen, int chain, int target)
+{
+	int next;
+
+	while (chain >= 0) {
+		next = gen->code[chain].a;
+		gen->code[chain].a = target;
+		chain = next;
+	}
+}
+
+/** Bring local variable into scope.
+ *
+ * @param gen		Compiler state
+ * @param sid		Variable name
+ * @param slot		Slot number or -1 if variable lives in a block AR
+ */
+static void bcode_local_add(bcode_gen_t *gen, int sid, int slot)
+{
+	bcode_local_t *locals;
+	int nalloc;
+
+	if (gen->nlocals >= gen->locals_alloc) {
+		nalloc = gen->locals_alloc > 0 ? 2 * gen->locals_alloc : 16;
+		locals = realloc(gen->locals, nalloc * sizeof(bcode_local_t));
+		if (locals == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+
+		gen->locals = locals;
+		gen->locals_alloc = nalloc;
+	}
+
+	gen->locals[gen->nlocals].sid = sid;
+	gen->locals[gen->nlocals].slot = slot;
+	++gen->nlocals;
+}
+
+/** Find local variable in scope.
+ *
+ * @param gen		Compiler state
+ * @param sid		Variable name
+ * @return		Innermost variable with name @a sid or @c NULL
+ */
+static bcode_local_t *bcode_local_find(bcode_gen_t *gen, int sid)
+{
+	int i;
+
+	for (i = gen->nlocals - 1; i >= 0; i--) {
+		if (gen->locals[i].sid == sid)
+			return &gen->locals[i];
+	}
+
+	return NULL;
+}
+
+/** Determine whether variable must be kept in a block AR.
+ *
+ * @param gen		Compiler state
+ * @param sid		Variable name
+ * @return		@c b_true if variable must be kept in a block AR
+ */
+static bool_t bcode_is_boxed(bcode_gen_t *gen, int sid)
+{
+	return gen->boxed != NULL && intmap_get(gen->boxed, sid) != NULL;
+}
+
+/** Determine whether expression has the given primitive type.
+ *
+ * @param expr		Expression
+ * @param tpc		Primitive type class
+ * @return		@c b_true if @a expr is of primitive type @a tpc
+ */
+static bool_t bcode_expr_is_tpc(stree_expr_t *expr, tprimitive_class_t tpc)
+{
+	return expr->titem != NULL && expr->titem->tic == tic_tprimitive &&
+	    expr->titem->u.tprimitive->tpc == tpc;
+}
+
+/** Compile procedure body.
+ *
+ * @param gen		Compiler state
+ * @param proc		Procedure
+ */
+static void bcode_proc_body(bcode_gen_t *gen, stree_proc_t *proc)
+{
+	stree_fun_sig_t *sig;
+	list_node_t *arg_n;
+
+	/*
+	 * Bring arguments of functions and constructors into scope.
+	 * Arguments of property accessors stay in the argument block AR
+	 * and are accessed by the tree walker.
+	 */
+	switch (proc->outer_symbol->sc) {
+	case sc_fun:
+		sig = symbol_to_fun(proc->outer_symbol)->sig;
+		break;
+	case sc_ctor:
+		sig = symbol_to_ctor(proc->outer_symbol)->sig;
+		break;
+	default:
+		sig = NULL;
+		break;
+	}
+
+	if (sig != NULL) {
+		arg_n = list_first(&sig->args);
+		while (arg_n != NULL) {
+			bcode_arg(gen,
+			    list_node_data(arg_n, stree_proc_arg_t *));
+			arg_n = list_next(&sig->args, arg_n);
+		}
+
+		if (sig->varg != NULL)
+			bcode_arg(gen, sig->varg);
+	}
+
+	bcode_block(gen, proc->body);
+	(void) bcode_emit(gen, bci_end, 0, 0, 0);
+}
+
+/** Compile procedure argument.
+ *
+ * @param gen		Compiler state
+ * @param arg		Formal argument
+ */
+static void bcode_arg(bcode_gen_t *gen, stree_proc_arg_t *arg)
+{
+	int slot;
+
+	if (bcode_is_boxed(gen, arg->name->sid)) {
+		bcode_local_add(gen, arg->name->sid, -1);
+		return;
+	}
+
+	slot = gen->nslots++;
+	(void) bcode_emit(gen, bci_arg, slot, arg->name->sid, 0);
+	bcode_local_add(gen, arg->name->sid, slot);
+}
+
+/** Compile statement block.
+ *
+ * A block AR is only created for blocks that declare variables which
+ * need to be kept in a block AR.
+ *
+ * @param gen		Compiler state
+ * @param block		Statement block
+ */
+static void bcode_block(bcode_gen_t *gen, stree_block_t *block)
+{
+	list_node_t *stat_n;
+	stree_stat_t *stat;
+	bool_t enter;
+	int nlocals;
+
+	enter = b_false;
+	stat_n = list_first(&block->stats);
+	while (stat_n != NULL) {
+		stat = list_node_data(stat_n, stree_stat_t *);
+		if (stat->sc == st_vdecl &&
+		    bcode_is_boxed(gen, stat->u.vdecl_s->name->sid))
+			enter = b_true;
+		stat_n = list_next(&block->stats, stat_n);
+	}
+
+	if (enter) {
+		(void) bcode_emit(gen, bci_block_enter, 0, 0, 0);
+		++gen->depth;
+	}
+
+	nlocals = gen->nlocals;
+
+	stat_n = list_first(&block->stats);
+	while (stat_n != NULL) {
+		stat = list_node_data(stat_n, stree_stat_t *);
+		bcode_stat(gen, stat);
+		stat_n = list_next(&block->stats, stat_n);
+	}
+
+	gen->nlocals = nlocals;
+
+	if (enter) {
+		(void) bcode_emit(gen, bci_block_leave, 0, 0, 0);
+		--gen->depth;
+	}
+}
+
+/** Compile statement.
+ *
+ * @param gen		Compiler state
+ * @param stat		Statement
+ */
+static void bcode_stat(bcode_gen_t *gen, stree_stat_t *stat)
+{
+	bcode_loop_t *loop;
+
+	switch (stat->sc) {
+	case st_vdecl:
+		bcode_vdecl(gen, stat->u.vdecl_s);
+		break;
+	case st_if:
+		bcode_if(gen, stat->u.if_s);
+		break;
+	case st_while:
+		bcode_while(gen, stat->u.while_s);
+		break;
+	case st_break:
+		loop = gen->loop;
+		if (loop == NULL) {
+			bcode_stat_fallback(gen, stat);
+			break;
+		}
+
+		loop->exits = bcode_emit(gen, bci_break, loop->exits,
+		    loop->depth, 0);
+		break;
+	case st_return:
+		if (stat->u.return_s->expr != NULL) {
+			bcode_expr(gen, stat->u.return_s->expr);
+			(void) bcode_emit(gen, bci_ret, 0, 0, -1);
+		} else {
+			(void) bcode_emit(gen, bci_ret_void, 0, 0, 0);
+		}
+		break;
+	case st_exps:
+		bcode_exps(gen, stat->u.exp_s);
+		break;
+	case st_switch:
+	case st_for:
+	case st_raise:
+	case st_wef:
+		bcode_stat_fallback(gen, stat);
+		break;
+	}
+}
+
+/** Leave statement to the tree walker.
+ *
+ * If the statement breaks out of an enclosing loop, control
+ * continues at the loop exit.
+ *
+ * @param gen		Compiler state
+ * @param stat		Statement
+ */
+static void bcode_stat_fallback(bcode_gen_t *gen, stree_stat_t *stat)
+{
+	bcode_loop_t *loop;
+	int idx;
+
+	loop = gen->loop;
+	if (loop != NULL) {
+		idx = bcode_emit(gen, bci_stat, loop->exits, loop->depth, 0);
+		loop->exits = idx;
+	} else {
+		idx = bcode_emit(gen, bci_stat, -1, 0, 0);
+	}
+
+	gen->code[idx].u.stat = stat;
+	bcode_collect_stat(gen, stat);
+}
+
+/** Compile variable declaration.
+ *
+ * @param gen		Compiler state
+ * @param vdecl		Variable declaration
+ */
+static void bcode_vdecl(bcode_gen_t *gen, stree_vdecl_t *vdecl)
+{
+	int idx;
+	int slot;
+
+	if (bcode_is_boxed(gen, vdecl->name->sid)) {
+		idx = bcode_emit(gen, bci_decl_var, 0, vdecl->name->sid, 0);
+		slot = -1;
+	} else {
+		slot = gen->nslots++;
+		idx = bcode_emit(gen, bci_decl, slot, 0, 0);
+	}
+
+	gen->code[idx].u.titem = vdecl->titem;
+	bcode_local_add(gen, vdecl->name->sid, slot);
+}
+
+/** Compile @c if statement.
+ *
+ * @param gen		Compiler state
+ * @param if_s		@c if statement
+ */
+static void bcode_if(bcode_gen_t *gen, stree_if_t *if_s)
+{
+	list_node_t *ifc_n;
+	stree_if_clause_t *ifc;
+	int exits;
+	int jf;
+
+	exits = -1;
+
+	ifc_n = list_first(&if_s->if_clauses);
+	while (ifc_n != NULL) {
+		ifc = list_node_data(ifc_n, stree_if_clause_t *);
+
+		bcode_expr(gen, ifc->cond);
+		jf = bcode_emit(gen, bci_jf, -1, 0, -1);
+		bcode_block(gen, ifc->block);
+		exits = bcode_emit(gen, bci_jmp, exits, 0, 0);
+		gen->code[jf].a = gen->ninstr;
+
+		ifc_n = list_next(&if_s->if_clauses, ifc_n);
+	}
+
+	if (if_s->else_block != NULL)
+		bcode_block(gen, if_s->else_block);
+
+	bcode_patch(gen, exits, gen->ninstr);
+}
+
+/** Compile @c while statement.
+ *
+ * @param gen		Compiler state
+ * @param while_s	@c while statement
+ */
+static void bcode_while(bcode_gen_t *gen, stree_while_t *while_s)
+{
+	bcode_loop_t loop;
+	int top;
+	int jf;
+
+	loop.outer = gen->loop;
+	loop.depth = gen->depth;
+	loop.exits = -1;
+
+	top = gen->ninstr;
+	bcode_expr(gen, while_s->cond);
+	jf = bcode_emit(gen, bci_jf, -1, 0, -1);
+
+	gen->loop = &loop;
+	bcode_block(gen, while_s->body);
+	gen->loop = loop.outer;
+
+	(void) bcode_emit(gen, bci_jmp, top, 0, 0);
+	gen->code[jf].a = gen->ninstr;
+	bcode_patch(gen, loop.exits, gen->ninstr);
+}
+
+/** Compile expression statement.
+ *
+ * @param gen		Compiler state
+ * @param exps		Expression statement
+ */
+static void bcode_exps(bcode_gen_t *gen, stree_exps_t *exps)
+{
+	int idx;
+
+	switch (exps->expr->ec) {
+	case ec_assign:
+		bcode_assign(gen, exps->expr->u.assign);
+		break;
+	case ec_call:
+		bcode_call(gen, exps->expr->u.call, b_false);
+		break;
+	default:
+		idx = bcode_emit(gen, bci_expr_void, 0, 0, 0);
+		gen->code[idx].u.expr = exps->expr;
+		bcode_collect_expr(gen, exps->expr);
+		break;
+	}
+}
+
+/** Compile expression.
+ *
+ * The generated code pushes the value of the expression.
+ *
+ * @param gen		Compiler state
+ * @param expr		Expression
+ */
+static void bcode_expr(bcode_gen_t *gen, stree_expr_t *expr)
+{
+	switch (expr->ec) {
+	case ec_nameref:
+		bcode_nameref(gen, expr->u.nameref);
+		break;
+	case ec_literal:
+		bcode_literal(gen, expr->u.literal);
+		break;
+	case ec_binop:
+		bcode_binop(gen, expr->u.binop);
+		break;
+	case ec_unop:
+		bcode_unop(gen, expr->u.unop);
+		break;
+	case ec_call:
+		bcode_call(gen, expr->u.call, b_true);
+		break;
+	default:
+		bcode_expr_fallback(gen, expr);
+		break;
+	}
+}
+
+/** Leave expression to the tree walker.
+ *
+ * @param gen		Compiler state
+ * @param expr		Expression
+ */
+static void bcode_expr_fallback(bcode_gen_t *gen, stree_expr_t *expr)
+{
+	int idx;
+
+	idx = bcode_emit(gen, bci_expr, 0, 0, 1);
+	gen->code[idx].u.expr = expr;
+	bcode_collect_expr(gen, expr);
+}
+
+/** Compile name reference.
+ *
+ * @param gen		Compiler state
+ * @param nameref	Name reference
+ */
+static void bcode_nameref(bcode_gen_t *gen, stree_nameref_t *nameref)
+{
+	bcode_local_t *local;
+
+	local = bcode_local_find(gen, nameref->name->sid);
+	if (local == NULL || local->slot < 0) {
+		bcode_expr_fallback(gen, nameref->expr);
+		return;
+	}
+
+	(void) bcode_emit(gen, bci_load, local->slot, 0, 1);
+}
+
+/** Compile literal.
+ *
+ * @param gen		Compiler state
+ * @param literal	Literal
+ */
+static void bcode_literal(bcode_gen_t *gen, stree_literal_t *literal)
+{
+	int value;
+
+	switch (literal->ltc) {
+	case ltc_bool:
+		(void) bcode_emit(gen, bci_bool, literal->u.lit_bool.value,
+		    0, 1);
+		break;
+	case ltc_int:
+		if (bigint_get_value_int(&literal->u.lit_int.value,
+		    &value) != EOK) {
+			bcode_expr_fallback(gen, literal->expr);
+			break;
+		}
+
+		(void) bcode_emit(gen, bci_int, value, 0, 1);
+		break;
+	default:
+		bcode_expr_fallback(gen, literal->expr);
+		break;
+	}
+}
+
+/** Compile binary operation.
+ *
+ * Only operations on @c int and @c bool values are compiled.
+ *
+ * @param gen		Compiler state
+ * @param binop		Binary operation
+ */
+static void bcode_binop(bcode_gen_t *gen, stree_binop_t *binop)
+{
+	bool_t ok;
+
+	if (bcode_expr_is_tpc(binop->arg1, tpc_int) &&
+	    bcode_expr_is_tpc(binop->arg2, tpc_int)) {
+		ok = binop->bc != bo_and && binop->bc != bo_or;
+	} else if (bcode_expr_is_tpc(binop->arg1, tpc_bool) &&
+	    bcode_expr_is_tpc(binop->arg2, tpc_bool)) {
+		ok = binop->bc != bo_plus && binop->bc != bo_minus &&
+		    binop->bc != bo_mult;
+	} else {
+		ok = b_false;
+	}
+
+	if (!ok) {
+		bcode_expr_fallback(gen, binop->expr);
+		return;
+	}
+
+	bcode_expr(gen, binop->arg1);
+	bcode_expr(gen, binop->arg2);
+	(void) bcode_emit(gen, bci_binop, binop->bc, 0, -1);
+}
+
+/** Compile unary operation.
+ *
+ * Only operations on @c int and @c bool values are compiled.
+ *
+ * @param gen		Compiler state
+ * @param unop		Unary operation
+ */
+static void bcode_unop(bcode_gen_t *gen, stree_unop_t *unop)
+{
+	bool_t ok;
+
+	if (bcode_expr_is_tpc(unop->arg, tpc_int))
+		ok = unop->uc != uo_not;
+	else if (bcode_expr_is_tpc(unop->arg, tpc_bool))
+		ok = unop->uc == uo_not;
+	else
+		ok = b_false;
+
+	if (!ok) {
+		bcode_expr_fallback(gen, unop->expr);
+		return;
+	}
+
+	bcode_expr(gen, unop->arg);
+	(void) bcode_emit(gen, bci_unop, unop->uc, 0, 0);
+}
+
+/** Compile function call.
+ *
+ * @param gen		Compiler state
+ * @param call		Function call
+ * @param want_value	@c b_true to push the return value
+ */
+static void bcode_call(bcode_gen_t *gen, stree_call_t *call,
+    bool_t want_value)
+{
+	list_node_t *arg_n;
+	int argc;
+
+	bcode_expr(gen, call->fun);
+
+	argc = 0;
+	arg_n = list_first(&call->args);
+	while (arg_n != NULL) {
+		bcode_expr(gen, list_node_data(arg_n, stree_expr_t *));
+		++argc;
+		arg_n = list_next(&call->args, arg_n);
+	}
+
+	(void) bcode_emit(gen, bci_call, argc, want_value,
+	    (want_value ? 1 : 0) - (argc + 1));
+}
+
+/** Compile assignment.
+ *
+ * @param gen		Compiler state
+ * @param assign	Assignment
+ */
+static void bcode_assign(bcode_gen_t *gen, stree_assign_t *assign)
+{
+	bcode_local_t *local;
+	int idx;
+
+	local = NULL;
+	if (assign->dest->ec == ec_nameref) {
+		local = bcode_local_find(gen,
+		    assign->dest->u.nameref->name->sid);
+	}
+
+	if (local != NULL && local->slot >= 0) {
+		bcode_expr(gen, assign->src);
+		(void) bcode_emit(gen, bci_store, local->slot, 0, -1);
+		return;
+	}
+
+	idx = bcode_emit(gen, bci_addr, 0, 0, 1);
+	gen->code[idx].u.expr = assign->dest;
+	bcode_collect_expr(gen, assign->dest);
+
+	bcode_expr(gen, assign->src);
+	(void) bcode_emit(gen, bci_store_addr, 0, 0, -2);
+}
+
+/** Note names referenced from a block left to the tree walker.
+ *
+ * @param gen		Compiler state
+ * @param block		Statement block
+ */
+static void bcode_collect_block(bcode_gen_t *gen, stree_block_t *block)
+{
+	list_node_t *stat_n;
+
+	stat_n = list_first(&block->stats);
+	while (stat_n != NULL) {
+		bcode_collect_stat(gen, list_node_data(stat_n, stree_stat_t *));
+		stat_n = list_next(&block->stats, stat_n);
+	}
+}
+
+/** Note names referenced from a statement left to the tree walker.
+ *
+ * @param gen		Compiler state
+ * @param stat		Statement
+ */
+static void bcode_collect_stat(bcode_gen_t *gen, stree_stat_t *stat)
+{
+	list_node_t *node;
+	stree_if_clause_t *ifc;
+	stree_when_t *whenc;
+	stree_except_t *except_c;
+
+	switch (stat->sc) {
+	case st_vdecl:
+	case st_break:
+		break;
+	case st_if:
+		node = list_first(&stat->u.if_s->if_clauses);
+		while (node != NULL) {
+			ifc = list_node_data(node, stree_if_clause_t *);
+			bcode_collect_expr(gen, ifc->cond);
+			bcode_collect_block(gen, ifc->block);
+			node = list_next(&stat->u.if_s->if_clauses, node);
+		}
+		if (stat->u.if_s->else_block != NULL)
+			bcode_collect_block(gen, stat->u.if_s->else_block);
+		break;
+	case st_switch:
+		bcode_collect_expr(gen, stat->u.switch_s->expr);
+		node = list_first(&stat->u.switch_s->when_clauses);
+		while (node != NULL) {
+			whenc = list_node_data(node, stree_when_t *);
+			bcode_collect_expr_list(gen, &whenc->exprs);
+			bcode_collect_block(gen, whenc->block);
+			node = list_next(&stat->u.switch_s->when_clauses, node);
+		}
+		if (stat->u.switch_s->else_block != NULL)
+			bcode_collect_block(gen, stat->u.switch_s->else_block);
+		break;
+	case st_while:
+		bcode_collect_expr(gen, stat->u.while_s->cond);
+		bcode_collect_block(gen, stat->u.while_s->body);
+		break;
+	case st_for:
+		bcode_collect_block(gen, stat->u.for_s->body);
+		break;
+	case st_raise:
+		bcode_collect_expr(gen, stat->u.raise_s->expr);
+		break;
+	case st_return:
+		if (stat->u.return_s->expr != NULL)
+			bcode_collect_expr(gen, stat->u.return_s->expr);
+		break;
+	case st_exps:
+		bcode_collect_expr(gen, stat->u.exp_s->expr);
+		break;
+	case st_wef:
+		bcode_collect_block(gen, stat->u.wef_s->with_block);
+		node = list_first(&stat->u.wef_s->except_clauses);
+		while (node != NULL) {
+			except_c = list_node_data(node, stree_except_t *);
+			bcode_collect_block(gen, except_c->block);
+			node = list_next(&stat->u.wef_s->except_clauses, node);
+		}
+		if (stat->u.wef_s->finally_block != NULL)
+			bcode_collect_block(gen, stat->u.wef_s->finally_block);
+		break;
+	}
+}
+
+/** Note names referenced from an expression left to the tree walker.
+ *
+ * @param gen		Compiler state
+ * @param expr		Expression
+ */
+static void bcode_collect_expr(bcode_gen_t *gen, stree_expr_t *expr)
+{
+	switch (expr->ec) {
+	case ec_nameref:
+		intmap_set(&gen->fallback, expr->u.nameref->name->sid,
+		    expr->u.nameref);
+		break;
+	case ec_literal:
+	case ec_self_ref:
+		break;
+	case ec_binop:
+		bcode_collect_expr(gen, expr->u.binop->arg1);
+		bcode_collect_expr(gen, expr->u.binop->arg2);
+		break;
+	case ec_unop:
+		bcode_collect_expr(gen, expr->u.unop->arg);
+		break;
+	case ec_new:
+		bcode_collect_expr_list(gen, &expr->u.new_op->ctor_args);
+		break;
+	case ec_access:
+		bcode_collect_expr(gen, expr->u.access->arg);
+		break;
+	case ec_call:
+		bcode_collect_expr(gen, expr->u.call->fun);
+		bcode_collect_expr_list(gen, &expr->u.call->args);
+		break;
+	case ec_assign:
+		bcode_collect_expr(gen, expr->u.assign->dest);
+		bcode_collect_expr(gen, expr->u.assign->src);
+		break;
+	case ec_index:
+		bcode_collect_expr(gen, expr->u.index->base);
+		bcode_collect_expr_list(gen, &expr->u.index->args);
+		break;
+	case ec_as:
+		bcode_collect_expr(gen, expr->u.as_op->arg);
+		break;
+	case ec_box:
+		bcode_collect_expr(gen, expr->u.box->arg);
+		break;
+	}
+}
+
+/** Note names referenced from a list of expressions.
+ *
+ * @param gen		Compiler state
+ * @param exprs		List of expressions (stree_expr_t)
+ */
+static void bcode_collect_expr_list(bcode_gen_t *gen, list_t *exprs)
+{
+	list_node_t *expr_n;
+
+	expr_n = list_first(exprs);
+	while (expr_n != NULL) {
+		bcode_collect_expr(gen, list_node_data(expr_n, stree_expr_t *));
+		expr_n = list_next(exprs, expr_n);
+	}
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BCODE_T_H_
+#define BCODE_T_H_
+
+#include "intmap_t.h"
+
+/** Bytecode instruction opcode */
+typedef enum {
+	/** Push integer constant @c a */
+	bci_int,
+	/** Push boolean constant @c a */
+	bci_bool,
+	/** Push copy of local slot @c a */
+	bci_load,
+	/** Pop value into local slot @c a */
+	bci_store,
+	/** Move argument named @c b into local slot @c a */
+	bci_arg,
+	/** Initialize local slot @c a with default value of type @c u.titem */
+	bci_decl,
+	/** Declare variable @c b of type @c u.titem in current block AR */
+	bci_decl_var,
+	/** Binary operation @c a (binop_class_t) on two values */
+	bci_binop,
+	/** Unary operation @c a (unop_class_t) */
+	bci_unop,
+	/** Jump to @c a */
+	bci_jmp,
+	/** Pop boolean value and jump to @c a if it is false */
+	bci_jf,
+	/** Evaluate @c u.expr using the tree walker, push its value */
+	bci_expr,
+	/** Evaluate @c u.expr using the tree walker, discard result */
+	bci_expr_void,
+	/** Evaluate @c u.expr using the tree walker, push address item */
+	bci_addr,
+	/** Pop value and address and write value to the address */
+	bci_store_addr,
+	/** Call delegate with @c a arguments, push result if @c b is set */
+	bci_call,
+	/** Execute @c u.stat using the tree walker */
+	bci_stat,
+	/** Enter block (create block AR) */
+	bci_block_enter,
+	/** Leave block (destroy block AR) */
+	bci_block_leave,
+	/** Leave blocks down to depth @c b and jump to @c a */
+	bci_break,
+	/** Pop value and return it from the procedure */
+	bci_ret,
+	/** Return from the procedure without a value */
+	bci_ret_void,
+	/** End of procedure */
+	bci_end
+} bcode_op_t;
+
+/** Bytecode instruction */
+typedef struct {
+	/** Opcode */
+	bcode_op_t op;
+
+	/** Operands */
+	int a, b;
+
+	union {
+		/** Expression for tree-walker fallback */
+		struct stree_expr *expr;
+		/** Statement for tree-walker fallback */
+		struct stree_stat *stat;
+		/** Type of declared variable */
+		struct tdata_item *titem;
+	} u;
+} bcode_instr_t;
+
+/** Compiled procedure */
+typedef struct bcode_proc {
+	/** Instructions */
+	bcode_instr_t *code;
+
+	/** Number of instructions */
+	int ninstr;
+
+	/** Number of local variable slots */
+	int nslots;
+
+	/** Maximum depth of the value stack */
+	int max_stack;
+} bcode_proc_t;
+
+/** Local variable known to the bytecode compiler */
+typedef struct {
+	/** Variable name */
+	int sid;
+
+	/** Slot number or -1 if the variable lives in a block AR */
+	int slot;
+} bcode_local_t;
+
+/** Loop being compiled */
+typedef struct bcode_loop {
+	/** Enclosing loop or @c NULL */
+	struct bcode_loop *outer;
+
+	/** Number of block ARs entered outside of the loop */
+	int depth;
+
+	/** Chain of instructions to patch with the loop exit address */
+	int exits;
+} bcode_loop_t;
+
+/** Bytecode compiler state */
+typedef struct bcode_gen {
+	/** Instructions emitted so far */
+	bcode_instr_t *code;
+	int ninstr;
+	int code_alloc;
+
+	/** Local variables currently in scope */
+	bcode_local_t *locals;
+	int nlocals;
+	int locals_alloc;
+
+	/** Number of allocated slots */
+	int nslots;
+
+	/** Current and maximum value stack depth */
+	int sp;
+	int max_stack;
+
+	/** Number of block ARs entered at the current point */
+	int depth;
+
+	/** Innermost loop or @c NULL */
+	bcode_loop_t *loop;
+
+	/** Variables that must be kept in block ARs or @c NULL */
+	intmap_t *boxed;
+
+	/** Names referenced by code executed by the tree walker */
+	intmap_t fallback;
+} bcode_gen_t;
+
+/** Bytecode value class */
+typedef enum {
+	/** Integer that fits into a C int */
+	bcv_int,
+	/** Boolean */
+	bcv_bool,
+	/** Any other value stored as a value item */
+	bcv_item
+} bcode_val_class_t;
+
+/** Bytecode value
+ *
+ * Values of type @c int and @c bool are kept unboxed while executing
+ * bytecode. Integers that do not fit into a C int fall back to a value
+ * item holding a bigint.
+ */
+typedef struct {
+	bcode_val_class_t vc;
+
+	union {
+		int int_v;
+		bool_t bool_v;
+		struct rdata_item *item;
+	} u;
+} bcode_val_t;
+
+#endif
@@ -34,6 +34,7 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "debug.h"
@@ -182,41 +183,30 @@ void bigint_destroy(bigint_t *bigint)
  *
  * @param bigint	Bigint to obtain value from.
  * @param dval		Place to store value.
- * @return		EOK on success, ELIMIT if bigint is too big to fit
+ * @return		EOK on success, EINVAL if bigint is too big to fit
  *			to @a dval.
  */
 errno_t bigint_get_value_int(bigint_t *bigint, int *dval)
 {
-	bigint_t vval, diff;
 	size_t idx;
-	int val;
-	bool_t zf;
+	unsigned int val;
 
 #ifdef DEBUG_BIGINT_TRACE
 	printf("Get int value of bigint.\n");
 #endif
+	/* Accumulate digits starting from the most significant one. */
 	val = 0;
-	for (idx = 0; idx < bigint->length; ++idx) {
+	idx = bigint->length;
+	while (idx > 0) {
+		--idx;
+		if (val > ((unsigned int) INT_MAX - bigint->digit[idx]) /
+		    BIGINT_BASE)
+			return EINVAL;
+
 		val = val * BIGINT_BASE + bigint->digit[idx];
 	}
 
-	if (bigint->negative)
-		val = -val;
-
-	/* If the value did not fit @c val now contains garbage. Verify. */
-	bigint_init(&vval, val);
-
-	bigint_sub(bigint, &vval, &diff);
-	zf = bigint_is_zero(&diff);
-
-	bigint_destroy(&vval);
-	bigint_destroy(&diff);
-
-	/* If the difference is not zero, the verification failed. */
-	if (zf != b_true)
-		return EINVAL;
-
-	*dval = val;
+	*dval = bigint->negative ? -(int) val : (int) val;
 	return EOK;
 }
 
@@ -549,7 +539,7 @@ static void bigint_sub_abs(bigint_t *a, bigint_t *b, bigint_t *dest)
 		da = idx < a->length ? a->digit[idx] : 0;
 		db = idx < b->length ? b->digit[idx] : 0;
 
-		if (da > db + borrow) {
+		if (da >= db + borrow) {
 			tmp = da - db - borrow;
 			borrow = 0;
 		} else {
@@ -576,7 +566,7 @@ static void bigint_sub_abs(bigint_t *a, bigint_t *b, bigint_t *dest)
 			da = 0;
 			db = dest->digit[idx];
 
-			if (da > db + borrow) {
+			if (da >= db + borrow) {
 				tmp = da - db - borrow;
 				borrow = 0;
 			} else {
@@ -60,6 +60,7 @@ int main(int argc, char *argv[])
 	stree_program_t *program;
 	stype_t stype;
 	run_t run;
+	bool_t use_bcode;
 	errno_t rc;
 
 	/* Store executable file path under which we have been invoked. */
@@ -80,6 +81,14 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
+	use_bcode = b_true;
+	if (os_str_cmp(*argv, "-t") == 0) {
+		/* Only use the tree walker, do not compile to bytecode. */
+		use_bcode = b_false;
+		argv += 1;
+		argc -= 1;
+	}
+
 	strtab_init();
 	program = stree_program_new();
 	program->module = stree_module_new();
@@ -121,6 +130,7 @@ int main(int argc, char *argv[])
 
 	/* Run program. */
 	run_init(&run);
+	run.use_bcode = use_bcode;
 	run_program(&run, program);
 
 	/* Check for run-time errors. */
@@ -133,5 +143,6 @@ int main(int argc, char *argv[])
 /** Print command-line syntax help. */
 static void syntax_print(void)
 {
-	printf("Syntax: sbi <source_file.sy>\n");
+	printf("Syntax: sbi [-t] <source_file.sy>\n");
+	printf("\t-t\tExecute procedures using the tree walker only\n");
 }
@@ -57,6 +57,7 @@ typedef enum {
 #define EOK 0
 #endif
 
+#include "bcode_t.h"
 #include "bigint_t.h"
 #include "builtin_t.h"
 #include "cspan_t.h"
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "bcode.h"
 #include "bigint.h"
 #include "builtin.h"
 #include "cspan.h"
@@ -39,6 +40,7 @@
 #include "list.h"
 #include "mytypes.h"
 #include "rdata.h"
+#include "run_bcode.h"
 #include "run_expr.h"
 #include "run_texpr.h"
 #include "stree.h"
@@ -82,7 +84,7 @@ static void run_var_new_enum(run_t *run, tdata_enum_t *tenum,
  */
 void run_init(run_t *run)
 {
-	(void) run;
+	run->use_bcode = b_true;
 }
 
 /** Run program.
@@ -196,7 +198,12 @@ void run_proc(run_t *run, run_proc_ar_t *proc_ar, rdata_item_t **res)
 	list_append(&run->thread_ar->proc_ar, proc_ar);
 
 	/* Run main procedure block. */
-	if (proc->body != NULL) {
+	if (proc->body != NULL && run->use_bcode) {
+		/* Compile procedure on first invocation. */
+		if (proc->bcode == NULL)
+			proc->bcode = bcode_proc_compile(proc);
+		run_bcode(run, proc_ar, proc->bcode);
+	} else if (proc->body != NULL) {
 		run_block(run, proc->body);
 	} else {
 		builtin_run_proc(run, proc);
@@ -0,0 +1,822 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Bytecode interpreter.
+ *
+ * Executes procedures compiled by bcode_proc_compile(). Local variables
+ * live in slots of the procedure frame. Values of type @c int and @c bool
+ * are kept unboxed; arithmetic is carried out on C integers and only falls
+ * back to bigint when the result does not fit. Constructs that were not
+ * compiled are executed by the tree walker.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include "bigint.h"
+#include "intmap.h"
+#include "list.h"
+#include "mytypes.h"
+#include "rdata.h"
+#include "run.h"
+#include "run_expr.h"
+#include "strtab.h"
+
+#include "run_bcode.h"
+
+/** Number of frame values that fit in the on-stack frame buffer */
+#define RUN_BCODE_LBUF 32
+
+static rdata_item_t *run_bcode_item_new(rdata_var_t *var);
+static void run_bcode_val_destroy(bcode_val_t *val);
+static void run_bcode_val_copy(run_t *run, bcode_val_t *src,
+    bcode_val_t *dest);
+static void run_bcode_val_init(run_t *run, tdata_item_t *titem,
+    bcode_val_t *val);
+static void run_bcode_val_from_var(rdata_var_t *var, bcode_val_t *val);
+static void run_bcode_val_from_item(rdata_item_t *item, bcode_val_t *val);
+static void run_bcode_val_from_bigint(bigint_t *value, bcode_val_t *val);
+static void run_bcode_val_to_item(bcode_val_t *val, rdata_item_t **ritem);
+static bigint_t *run_bcode_val_bigint(bcode_val_t *val, bigint_t *tmp);
+
+static void run_bcode_binop(binop_class_t bc, bcode_val_t *v1,
+    bcode_val_t *v2, bcode_val_t *res);
+static void run_bcode_binop_bigint(binop_class_t bc, bcode_val_t *v1,
+    bcode_val_t *v2, bcode_val_t *res);
+static void run_bcode_unop(unop_class_t uc, bcode_val_t *val);
+
+static void run_bcode_decl_var(run_t *run, sid_t name, tdata_item_t *titem);
+static void run_bcode_block_enter(run_proc_ar_t *proc_ar);
+static void run_bcode_block_leave(run_t *run, run_proc_ar_t *proc_ar);
+
+/** Run compiled procedure.
+ *
+ * Executes the bytecode of the procedure whose activation record
+ * @a proc_ar is on top of the stack. Bailout is reported the same way
+ * as by the tree walker, i.e. the return value is stored in @a proc_ar
+ * and the bailout mode is left set in the thread AR.
+ *
+ * @param run		Runner object
+ * @param proc_ar	Procedure activation record
+ * @param bproc		Compiled procedure
+ */
+void run_bcode(run_t *run, run_proc_ar_t *proc_ar, bcode_proc_t *bproc)
+{
+	bcode_val_t lbuf[RUN_BCODE_LBUF];
+	bcode_val_t *frame, *slots, *stack, *sp;
+	bcode_instr_t *ip;
+	run_block_ar_t *args_ar;
+	rdata_var_t *var;
+	rdata_item_t *item, *vitem;
+	list_t arg_vals;
+	int nvals;
+	int depth;
+	int i;
+
+	nvals = bproc->nslots + bproc->max_stack;
+	if (nvals <= RUN_BCODE_LBUF) {
+		frame = lbuf;
+	} else {
+		frame = calloc(nvals, sizeof(bcode_val_t));
+		if (frame == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+	}
+
+	slots = frame;
+	stack = frame + bproc->nslots;
+	sp = stack;
+
+	for (i = 0; i < bproc->nslots; i++) {
+		slots[i].vc = bcv_int;
+		slots[i].u.int_v = 0;
+	}
+
+	/* Arguments are stored in the first block AR. */
+	args_ar = list_node_data(list_first(&proc_ar->block_ar),
+	    run_block_ar_t *);
+
+	depth = 0;
+	ip = bproc->code;
+
+	while (b_true) {
+		switch (ip->op) {
+		case bci_int:
+			sp->vc = bcv_int;
+			sp->u.int_v = ip->a;
+			++sp;
+			break;
+		case bci_bool:
+			sp->vc = bcv_bool;
+			sp->u.bool_v = ip->a ? b_true : b_false;
+			++sp;
+			break;
+		case bci_load:
+			run_bcode_val_copy(run, &slots[ip->a], sp);
+			++sp;
+			break;
+		case bci_store:
+			--sp;
+			run_bcode_val_destroy(&slots[ip->a]);
+			slots[ip->a] = *sp;
+			break;
+		case bci_arg:
+			var = intmap_get(&args_ar->vars, ip->b);
+			assert(var != NULL);
+			run_bcode_val_destroy(&slots[ip->a]);
+			run_bcode_val_from_var(var, &slots[ip->a]);
+			break;
+		case bci_decl:
+			run_bcode_val_destroy(&slots[ip->a]);
+			run_bcode_val_init(run, ip->u.titem, &slots[ip->a]);
+			break;
+		case bci_decl_var:
+			run_bcode_decl_var(run, ip->b, ip->u.titem);
+			break;
+		case bci_binop:
+			sp -= 2;
+			run_bcode_binop(ip->a, &sp[0], &sp[1], &sp[0]);
+			++sp;
+			break;
+		case bci_unop:
+			run_bcode_unop(ip->a, &sp[-1]);
+			break;
+		case bci_jmp:
+			ip = bproc->code + ip->a;
+			continue;
+		case bci_jf:
+			--sp;
+			assert(sp->vc == bcv_bool);
+			if (!sp->u.bool_v) {
+				ip = bproc->code + ip->a;
+				continue;
+			}
+			break;
+		case bci_expr:
+			vitem = NULL;
+			run_expr(run, ip->u.expr, &item);
+			if (run_is_bo(run)) {
+				if (item != NULL)
+					rdata_item_destroy(item);
+				goto cleanup;
+			}
+
+			run_cvt_value_item(run, item, &vitem);
+			rdata_item_destroy(item);
+			if (run_is_bo(run)) {
+				if (vitem != NULL)
+					rdata_item_destroy(vitem);
+				goto cleanup;
+			}
+
+			run_bcode_val_from_item(vitem, sp);
+			++sp;
+			break;
+		case bci_expr_void:
+			run_expr(run, ip->u.expr, &item);
+			if (item != NULL)
+				rdata_item_destroy(item);
+			if (run_is_bo(run))
+				goto cleanup;
+			break;
+		case bci_addr:
+			run_expr(run, ip->u.expr, &item);
+			if (run_is_bo(run)) {
+				if (item != NULL)
+					rdata_item_destroy(item);
+				goto cleanup;
+			}
+
+			if (item == NULL || item->ic != ic_address) {
+				printf("Error: Address expression required on "
+				    "left side of assignment operator.\n");
+				exit(1);
+			}
+
+			sp->vc = bcv_item;
+			sp->u.item = item;
+			++sp;
+			break;
+		case bci_store_addr:
+			sp -= 2;
+			run_bcode_val_to_item(&sp[1], &vitem);
+			item = sp[0].u.item;
+			run_address_write(run, item->u.address, vitem->u.value);
+			rdata_item_destroy(item);
+			rdata_item_destroy(vitem);
+			if (run_is_bo(run))
+				goto cleanup;
+			break;
+		case bci_call:
+			sp -= ip->a + 1;
+
+			list_init(&arg_vals);
+			for (i = 1; i <= ip->a; i++) {
+				run_bcode_val_to_item(&sp[i], &vitem);
+				list_append(&arg_vals, vitem);
+			}
+
+			assert(sp[0].vc == bcv_item);
+			run_call_deleg(run, sp[0].u.item, &arg_vals, &item);
+			rdata_item_destroy(sp[0].u.item);
+
+			if (run_is_bo(run)) {
+				if (item != NULL)
+					rdata_item_destroy(item);
+				goto cleanup;
+			}
+
+			if (ip->b) {
+				if (item == NULL) {
+					printf("Error: Sub-expression has no "
+					    "value.\n");
+					exit(1);
+				}
+
+				run_bcode_val_from_item(item, sp);
+				++sp;
+			} else if (item != NULL) {
+				rdata_item_destroy(item);
+			}
+			break;
+		case bci_stat:
+			run_stat(run, ip->u.stat, NULL);
+			if (run->thread_ar->bo_mode == bm_none)
+				break;
+
+			/* Break out of the enclosing loop? */
+			if (run->thread_ar->bo_mode != bm_stat || ip->a < 0)
+				goto cleanup;
+
+			run->thread_ar->bo_mode = bm_none;
+			while (depth > ip->b) {
+				run_bcode_block_leave(run, proc_ar);
+				--depth;
+			}
+
+			ip = bproc->code + ip->a;
+			continue;
+		case bci_block_enter:
+			run_bcode_block_enter(proc_ar);
+			++depth;
+			break;
+		case bci_block_leave:
+			run_bcode_block_leave(run, proc_ar);
+			--depth;
+			break;
+		case bci_break:
+			while (depth > ip->b) {
+				run_bcode_block_leave(run, proc_ar);
+				--depth;
+			}
+
+			ip = bproc->code + ip->a;
+			continue;
+		case bci_ret:
+			--sp;
+			run_bcode_val_to_item(sp, &proc_ar->retval);
+			run->thread_ar->bo_mode = bm_proc;
+			goto cleanup;
+		case bci_ret_void:
+			run->thread_ar->bo_mode = bm_proc;
+			goto cleanup;
+		case bci_end:
+			goto cleanup;
+		}
+
+		++ip;
+	}
+
+cleanup:
+	while (depth > 0) {
+		run_bcode_block_leave(run, proc_ar);
+		--depth;
+	}
+
+	while (sp > stack) {
+		--sp;
+		run_bcode_val_destroy(sp);
+	}
+
+	for (i = 0; i < bproc->nslots; i++)
+		run_bcode_val_destroy(&slots[i]);
+
+	if (frame != lbuf)
+		free(frame);
+}
+
+/** Create value item holding a variable.
+ *
+ * @param var		Variable (ownership is transferred to the item)
+ * @return		New value item
+ */
+static rdata_item_t *run_bcode_item_new(rdata_var_t *var)
+{
+	rdata_item_t *item;
+	rdata_value_t *value;
+
+	item = rdata_item_new(ic_value);
+	value = rdata_value_new();
+
+	item->u.value = value;
+	value->var = var;
+
+	return item;
+}
+
+/** Destroy bytecode value.
+ *
+ * @param val		Value
+ */
+static void run_bcode_val_destroy(bcode_val_t *val)
+{
+	if (val->vc == bcv_item && val->u.item != NULL)
+		rdata_item_destroy(val->u.item);
+
+	val->vc = bcv_int;
+	val->u.int_v = 0;
+}
+
+/** Copy bytecode value.
+ *
+ * @param run		Runner object
+ * @param src		Source value
+ * @param dest		Destination
+ */
+static void run_bcode_val_copy(run_t *run, bcode_val_t *src,
+    bcode_val_t *dest)
+{
+	if (src->vc != bcv_item) {
+		*dest = *src;
+		return;
+	}
+
+	dest->vc = bcv_item;
+	run_cvt_value_item(run, src->u.item, &dest->u.item);
+}
+
+/** Initialize bytecode value with default value of a type.
+ *
+ * @param run		Runner object
+ * @param titem		Type
+ * @param val		Place to store value
+ */
+static void run_bcode_val_init(run_t *run, tdata_item_t *titem,
+    bcode_val_t *val)
+{
+	rdata_var_t *var;
+
+	if (titem->tic == tic_tprimitive) {
+		switch (titem->u.tprimitive->tpc) {
+		case tpc_int:
+			val->vc = bcv_int;
+			val->u.int_v = 0;
+			return;
+		case tpc_bool:
+			val->vc = bcv_bool;
+			val->u.bool_v = b_false;
+			return;
+		default:
+			break;
+		}
+	}
+
+	run_var_new(run, titem, &var);
+	val->vc = bcv_item;
+	val->u.item = run_bcode_item_new(var);
+}
+
+/** Read bytecode value from variable.
+ *
+ * @param var		Variable
+ * @param val		Place to store value
+ */
+static void run_bcode_val_from_var(rdata_var_t *var, bcode_val_t *val)
+{
+	rdata_var_t *copy;
+
+	switch (var->vc) {
+	case vc_int:
+		if (bigint_get_value_int(&var->u.int_v->value,
+		    &val->u.int_v) == EOK) {
+			val->vc = bcv_int;
+			return;
+		}
+		break;
+	case vc_bool:
+		val->vc = bcv_bool;
+		val->u.bool_v = var->u.bool_v->value;
+		return;
+	default:
+		break;
+	}
+
+	rdata_var_copy(var, &copy);
+	val->vc = bcv_item;
+	val->u.item = run_bcode_item_new(copy);
+}
+
+/** Convert value item to bytecode value.
+ *
+ * @param item		Value item (ownership is transferred)
+ * @param val		Place to store value
+ */
+static void run_bcode_val_from_item(rdata_item_t *item, bcode_val_t *val)
+{
+	rdata_var_t *var;
+
+	assert(item->ic == ic_value);
+	var = item->u.value->var;
+
+	switch (var->vc) {
+	case vc_int:
+		if (bigint_get_value_int(&var->u.int_v->value,
+		    &val->u.int_v) == EOK) {
+			val->vc = bcv_int;
+			rdata_item_destroy(item);
+			return;
+		}
+		break;
+	case vc_bool:
+		val->vc = bcv_bool;
+		val->u.bool_v = var->u.bool_v->value;
+		rdata_item_destroy(item);
+		return;
+	default:
+		break;
+	}
+
+	val->vc = bcv_item;
+	val->u.item = item;
+}
+
+/** Convert bigint to bytecode value.
+ *
+ * @param value		Big integer (ownership is transferred)
+ * @param val		Place to store value
+ */
+static void run_bcode_val_from_bigint(bigint_t *value, bcode_val_t *val)
+{
+	rdata_var_t *var;
+	rdata_int_t *int_v;
+
+	if (bigint_get_value_int(value, &val->u.int_v) == EOK) {
+		val->vc = bcv_int;
+		bigint_destroy(value);
+		return;
+	}
+
+	int_v = rdata_int_new();
+	bigint_shallow_copy(value, &int_v->value);
+	var = rdata_var_new(vc_int);
+	var->u.int_v = int_v;
+
+	val->vc = bcv_item;
+	val->u.item = run_bcode_item_new(var);
+}
+
+/** Convert bytecode value to value item.
+ *
+ * @param val		Value (consumed)
+ * @param ritem		Place to store pointer to new value item
+ */
+static void run_bcode_val_to_item(bcode_val_t *val, rdata_item_t **ritem)
+{
+	rdata_var_t *var;
+
+	switch (val->vc) {
+	case bcv_int:
+		var = rdata_var_new(vc_int);
+		var->u.int_v = rdata_int_new();
+		bigint_init(&var->u.int_v->value, val->u.int_v);
+		*ritem = run_bcode_item_new(var);
+		break;
+	case bcv_bool:
+		var = rdata_var_new(vc_bool);
+		var->u.bool_v = rdata_bool_new();
+		var->u.bool_v->value = val->u.bool_v;
+		*ritem = run_bcode_item_new(var);
+		break;
+	case bcv_item:
+		*ritem = val->u.item;
+		break;
+	}
+
+	val->vc = bcv_int;
+	val->u.int_v = 0;
+}
+
+/** Get bigint representation of integer value.
+ *
+ * @param val		Integer value
+ * @param tmp		Temporary bigint used for small values. It must
+ *			be destroyed by the caller if @a val is small.
+ * @return		Pointer to bigint
+ */
+static bigint_t *run_bcode_val_bigint(bcode_val_t *val, bigint_t *tmp)
+{
+	if (val->vc == bcv_int) {
+		bigint_init(tmp, val->u.int_v);
+		return tmp;
+	}
+
+	assert(val->vc == bcv_item);
+	assert(val->u.item->u.value->var->vc == vc_int);
+	return &val->u.item->u.value->var->u.int_v->value;
+}
+
+/** Evaluate binary operation.
+ *
+ * @param bc		Binary operation class
+ * @param v1		First argument (consumed)
+ * @param v2		Second argument (consumed)
+ * @param res		Place to store result (may be the same as @a v1)
+ */
+static void run_bcode_binop(binop_class_t bc, bcode_val_t *v1,
+    bcode_val_t *v2, bcode_val_t *res)
+{
+	long long r;
+	int i1, i2;
+	bool_t b1, b2;
+
+	if (v1->vc == bcv_bool) {
+		assert(v2->vc == bcv_bool);
+		b1 = v1->u.bool_v;
+		b2 = v2->u.bool_v;
+
+		res->vc = bcv_bool;
+		switch (bc) {
+		case bo_equal:
+			res->u.bool_v = (b1 == b2);
+			break;
+		case bo_notequal:
+			res->u.bool_v = (b1 != b2);
+			break;
+		case bo_lt:
+			res->u.bool_v = !b1 && b2;
+			break;
+		case bo_gt:
+			res->u.bool_v = b1 && !b2;
+			break;
+		case bo_lt_equal:
+			res->u.bool_v = !b1 || b2;
+			break;
+		case bo_gt_equal:
+			res->u.bool_v = b1 || !b2;
+			break;
+		case bo_and:
+			res->u.bool_v = b1 && b2;
+			break;
+		case bo_or:
+			res->u.bool_v = b1 || b2;
+			break;
+		case bo_plus:
+		case bo_minus:
+		case bo_mult:
+			assert(b_false);
+		}
+		return;
+	}
+
+	if (v1->vc != bcv_int || v2->vc != bcv_int) {
+		run_bcode_binop_bigint(bc, v1, v2, res);
+		return;
+	}
+
+	i1 = v1->u.int_v;
+	i2 = v2->u.int_v;
+
+	switch (bc) {
+	case bo_plus:
+		r = (long long) i1 + i2;
+		break;
+	case bo_minus:
+		r = (long long) i1 - i2;
+		break;
+	case bo_mult:
+		r = (long long) i1 * i2;
+		break;
+	default:
+		res->vc = bcv_bool;
+		switch (bc) {
+		case bo_equal:
+			res->u.bool_v = (i1 == i2);
+			break;
+		case bo_notequal:
+			res->u.bool_v = (i1 != i2);
+			break;
+		case bo_lt:
+			res->u.bool_v = (i1 < i2);
+			break;
+		case bo_gt:
+			res->u.bool_v = (i1 > i2);
+			break;
+		case bo_lt_equal:
+			res->u.bool_v = (i1 <= i2);
+			break;
+		case bo_gt_equal:
+			res->u.bool_v = (i1 >= i2);
+			break;
+		default:
+			assert(b_false);
+		}
+		return;
+	}
+
+	if (r < -INT_MAX || r > INT_MAX) {
+		/* Result does not fit, redo the operation using bigint. */
+		run_bcode_binop_bigint(bc, v1, v2, res);
+		return;
+	}
+
+	res->vc = bcv_int;
+	res->u.int_v = (int) r;
+}
+
+/** Evaluate binary operation on integers using bigint arithmetic.
+ *
+ * @param bc		Binary operation class
+ * @param v1		First argument (consumed)
+ * @param v2		Second argument (consumed)
+ * @param res		Place to store result (may be the same as @a v1)
+ */
+static void run_bcode_binop_bigint(binop_class_t bc, bcode_val_t *v1,
+    bcode_val_t *v2, bcode_val_t *res)
+{
+	bigint_t t1, t2;
+	bigint_t *i1, *i2;
+	bigint_t value;
+	bcode_val_t r;
+	bool_t zf, nf;
+
+	i1 = run_bcode_val_bigint(v1, &t1);
+	i2 = run_bcode_val_bigint(v2, &t2);
+
+	switch (bc) {
+	case bo_plus:
+		bigint_add(i1, i2, &value);
+		run_bcode_val_from_bigint(&value, &r);
+		break;
+	case bo_minus:
+		bigint_sub(i1, i2, &value);
+		run_bcode_val_from_bigint(&value, &r);
+		break;
+	case bo_mult:
+		bigint_mul(i1, i2, &value);
+		run_bcode_val_from_bigint(&value, &r);
+		break;
+	default:
+		/* Relational operation. */
+		bigint_sub(i1, i2, &value);
+		zf = bigint_is_zero(&value);
+		nf = bigint_is_negative(&value);
+		bigint_destroy(&value);
+
+		r.vc = bcv_bool;
+		switch (bc) {
+		case bo_equal:
+			r.u.bool_v = zf;
+			break;
+		case bo_notequal:
+			r.u.bool_v = !zf;
+			break;
+		case bo_lt:
+			r.u.bool_v = (!zf && nf);
+			break;
+		case bo_gt:
+			r.u.bool_v = (!zf && !nf);
+			break;
+		case bo_lt_equal:
+			r.u.bool_v = (zf || nf);
+			break;
+		case bo_gt_equal:
+			r.u.bool_v = !nf;
+			break;
+		default:
+			assert(b_false);
+		}
+		break;
+	}
+
+	if (i1 == &t1)
+		bigint_destroy(&t1);
+	if (i2 == &t2)
+		bigint_destroy(&t2);
+
+	run_bcode_val_destroy(v1);
+	run_bcode_val_destroy(v2);
+	*res = r;
+}
+
+/** Evaluate unary operation in place.
+ *
+ * @param uc		Unary operation class
+ * @param val		Argument, replaced with the result
+ */
+static void run_bcode_unop(unop_class_t uc, bcode_val_t *val)
+{
+	bigint_t value;
+
+	switch (uc) {
+	case uo_plus:
+		assert(val->vc != bcv_bool);
+		break;
+	case uo_minus:
+		if (val->vc == bcv_int) {
+			val->u.int_v = -val->u.int_v;
+			break;
+		}
+
+		assert(val->vc == bcv_item);
+		bigint_reverse_sign(&val->u.item->u.value->var->u.int_v->value,
+		    &value);
+		run_bcode_val_destroy(val);
+		run_bcode_val_from_bigint(&value, val);
+		break;
+	case uo_not:
+		assert(val->vc == bcv_bool);
+		val->u.bool_v = !val->u.bool_v;
+		break;
+	}
+}
+
+/** Declare variable in the current block AR.
+ *
+ * @param run		Runner object
+ * @param name		Variable name
+ * @param titem		Variable type
+ */
+static void run_bcode_decl_var(run_t *run, sid_t name, tdata_item_t *titem)
+{
+	run_block_ar_t *block_ar;
+	rdata_var_t *var;
+
+	run_var_new(run, titem, &var);
+
+	block_ar = run_get_current_block_ar(run);
+	if (intmap_get(&block_ar->vars, name) != NULL) {
+		printf("Error: Duplicate variable '%s'\n",
+		    strtab_get_str(name));
+		exit(1);
+	}
+
+	intmap_set(&block_ar->vars, name, var);
+}
+
+/** Enter block (create block AR).
+ *
+ * @param proc_ar	Procedure activation record
+ */
+static void run_bcode_block_enter(run_proc_ar_t *proc_ar)
+{
+	run_block_ar_t *block_ar;
+
+	block_ar = run_block_ar_new();
+	intmap_init(&block_ar->vars);
+	list_append(&proc_ar->block_ar, block_ar);
+}
+
+/** Leave block (destroy innermost block AR).
+ *
+ * @param run		Runner object
+ * @param proc_ar	Procedure activation record
+ */
+static void run_bcode_block_leave(run_t *run, run_proc_ar_t *proc_ar)
+{
+	list_node_t *node;
+	run_block_ar_t *block_ar;
+
+	node = list_last(&proc_ar->block_ar);
+	block_ar = list_node_data(node, run_block_ar_t *);
+	list_remove(&proc_ar->block_ar, node);
+
+	run_block_ar_destroy(run, block_ar);
+}
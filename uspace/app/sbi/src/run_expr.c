@@ -2005,12 +2005,8 @@ static void run_access_symbol(run_t *run, stree_access_t *access,
 static void run_call(run_t *run, stree_call_t *call, rdata_item_t **res)
 {
 	rdata_item_t *rdeleg, *rdeleg_vi;
-	rdata_deleg_t *deleg_v;
 	list_t arg_vals;
 
-	stree_fun_t *fun;
-	run_proc_ar_t *proc_ar;
-
 #ifdef DEBUG_RUN_TRACE
 	printf("Run call operation.\n");
 #endif
@@ -2029,6 +2025,41 @@ static void run_call(run_t *run, stree_call_t *call, rdata_item_t **res)
 		goto cleanup;
 	}
 
+	/* Evaluate function arguments. */
+	run_call_args(run, &call->args, &arg_vals);
+	if (run_is_bo(run)) {
+		*res = run_recovery_item(run);
+		goto cleanup;
+	}
+
+	run_call_deleg(run, rdeleg_vi, &arg_vals, res);
+
+cleanup:
+	if (rdeleg != NULL)
+		rdata_item_destroy(rdeleg);
+	if (rdeleg_vi != NULL)
+		rdata_item_destroy(rdeleg_vi);
+
+#ifdef DEBUG_RUN_TRACE
+	printf("Returned from function call.\n");
+#endif
+}
+
+/** Call function referenced by a delegate.
+ *
+ * @param run		Runner object
+ * @param rdeleg_vi	Value item containing the delegate
+ * @param arg_vals	Evaluated arguments (list of rdata_item_t). The list
+ *			is destroyed.
+ * @param res		Place to store result
+ */
+void run_call_deleg(run_t *run, rdata_item_t *rdeleg_vi, list_t *arg_vals,
+    rdata_item_t **res)
+{
+	rdata_deleg_t *deleg_v;
+	stree_fun_t *fun;
+	run_proc_ar_t *proc_ar;
+
 	assert(rdeleg_vi->ic == ic_value);
 
 	if (rdeleg_vi->u.value->var->vc != vc_deleg) {
@@ -2050,13 +2081,6 @@ static void run_call(run_t *run, stree_call_t *call, rdata_item_t **res)
 	symbol_print_fqn(deleg_v->sym);
 	printf("'\n");
 #endif
-	/* Evaluate function arguments. */
-	run_call_args(run, &call->args, &arg_vals);
-	if (run_is_bo(run)) {
-		*res = run_recovery_item(run);
-		goto cleanup;
-	}
-
 	fun = symbol_to_fun(deleg_v->sym);
 	assert(fun != NULL);
 
@@ -2064,10 +2088,10 @@ static void run_call(run_t *run, stree_call_t *call, rdata_item_t **res)
 	run_proc_ar_create(run, deleg_v->obj, fun->proc, &proc_ar);
 
 	/* Fill in argument values. */
-	run_proc_ar_set_args(run, proc_ar, &arg_vals);
+	run_proc_ar_set_args(run, proc_ar, arg_vals);
 
 	/* Destroy arg_vals, they are no longer needed. */
-	run_destroy_arg_vals(&arg_vals);
+	run_destroy_arg_vals(arg_vals);
 
 	/* Run the function. */
 	run_proc(run, proc_ar, res);
@@ -2081,16 +2105,6 @@ static void run_call(run_t *run, stree_call_t *call, rdata_item_t **res)
 
 	/* Destroy procedure activation record. */
 	run_proc_ar_destroy(run, proc_ar);
-
-cleanup:
-	if (rdeleg != NULL)
-		rdata_item_destroy(rdeleg);
-	if (rdeleg_vi != NULL)
-		rdata_item_destroy(rdeleg_vi);
-
-#ifdef DEBUG_RUN_TRACE
-	printf("Returned from function call.\n");
-#endif
 }
 
 /** Evaluate call arguments.
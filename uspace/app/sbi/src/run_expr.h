@@ -40,5 +40,7 @@ void run_new_csi_inst(run_t *run, stree_csi_t *csi, statns_t sn,
 
 void run_equal(run_t *run, rdata_value_t *v1, rdata_value_t *v2, bool_t *res);
 bool_t run_item_boolean_value(run_t *run, rdata_item_t *item);
+void run_call_deleg(run_t *run, rdata_item_t *rdeleg_vi, list_t *arg_vals,
+    rdata_item_t **res);
 
 #endif
@@ -115,6 +115,9 @@ typedef struct run {
 
 	/** Global state */
 	struct rdata_var *gdata;
+
+	/** Compile procedures to bytecode before executing them */
+	bool_t use_bcode;
 } run_t;
 
 #endif
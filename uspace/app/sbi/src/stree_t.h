@@ -494,7 +494,7 @@ typedef enum {
 } stat_class_t;
 
 /** Statement */
-typedef struct {
+typedef struct stree_stat {
 	stat_class_t sc;
 
 	union {
@@ -565,6 +565,9 @@ typedef struct stree_proc {
 
 	/** Builtin handler for builtin procedures */
 	builtin_proc_t bi_handler;
+
+	/** Compiled bytecode or @c NULL if not compiled yet */
+	struct bcode_proc *bcode;
 } stree_proc_t;
 
 /** Constructor declaration */
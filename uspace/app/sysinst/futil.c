@@ -34,6 +34,7 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,8 +44,8 @@
 
 #include "futil.h"
 
-#define BUF_SIZE 16384
-static char buf[BUF_SIZE];
+/** Amount of data copied by a single request to VFS */
+#define COPY_SIZE (1024 * 1024)
 
 /** Copy file.
  *
@@ -56,7 +57,8 @@ static char buf[BUF_SIZE];
 errno_t futil_copy_file(const char *srcp, const char *destp)
 {
 	int sf, df;
-	size_t nr, nw;
+	vfs_stat_t st;
+	aoff64_t nc, nreq;
 	errno_t rc;
 	aoff64_t posr = 0, posw = 0;
 
@@ -70,18 +72,23 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 	if (rc != EOK)
 		return EIO;
 
-	do {
-		rc = vfs_read(sf, &posr, buf, BUF_SIZE, &nr);
-		if (rc != EOK)
-			goto error;
-		if (nr == 0)
-			break;
+	rc = vfs_stat(sf, &st);
+	if (rc != EOK)
+		goto error;
 
-		rc = vfs_write(df, &posw, buf, nr, &nw);
+	/* The data is copied by VFS and the file systems directly. */
+	while (posr < st.size) {
+		nreq = min(st.size - posr, COPY_SIZE);
+		rc = vfs_copy_range(sf, &posr, df, &posw, nreq, &nc);
 		if (rc != EOK)
 			goto error;
 
-	} while (nr == BUF_SIZE);
+		/* Do not leave a silently truncated file behind. */
+		if (nc < nreq) {
+			rc = EIO;
+			goto error;
+		}
+	}
 
 	(void) vfs_put(sf);
 
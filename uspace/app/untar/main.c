@@ -33,36 +33,110 @@
  */
 
 #include <errno.h>
+#include <gzip.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <str_error.h>
 #include <untar.h>
 
 typedef struct {
 	const char *filename;
 	FILE *file;
+	/** Decompression stream for gzip-compressed archives (or NULL) */
+	gzip_stream_t *gzip;
+	/** First decompression error, the archive is truncated after it */
+	errno_t gzip_rc;
 } tar_state_t;
 
+static errno_t tar_gzip_read(void *arg, void *buf, size_t size, size_t *nread)
+{
+	FILE *file = (FILE *) arg;
+
+	*nread = fread(buf, 1, size, file);
+	if ((*nread == 0) && ferror(file))
+		return EIO;
+
+	return EOK;
+}
+
 static int tar_open(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
+	uint8_t magic[2];
+	errno_t rc;
 
 	state->file = fopen(state->filename, "rb");
 	if (state->file == NULL)
 		return errno;
 
+	state->gzip = NULL;
+
+	/* Decompress gzip-compressed archives on the fly */
+	if ((fread(magic, 1, sizeof(magic), state->file) == sizeof(magic)) &&
+	    (magic[0] == 0x1f) && (magic[1] == 0x8b)) {
+		rewind(state->file);
+
+		rc = gzip_stream_create(tar_gzip_read, state->file,
+		    &state->gzip);
+		if (rc != EOK) {
+			fclose(state->file);
+			return rc;
+		}
+	} else {
+		rewind(state->file);
+	}
+
 	return EOK;
 }
 
 static void tar_close(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
+
+	if (state->gzip != NULL)
+		gzip_stream_destroy(state->gzip);
+
 	fclose(state->file);
 }
 
 static size_t tar_read(tar_file_t *tar, void *data, size_t size)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
-	return fread(data, 1, size, state->file);
+	size_t total = 0;
+	size_t nread;
+	errno_t rc;
+
+	if (state->gzip == NULL)
+		return fread(data, 1, size, state->file);
+
+	if (state->gzip_rc != EOK) {
+		errno = state->gzip_rc;
+		return 0;
+	}
+
+	while (total < size) {
+		rc = gzip_stream_read(state->gzip, (uint8_t *) data + total,
+		    size - total, &nread);
+		if (rc != EOK) {
+			/*
+			 * A short read looks like the end of the archive to
+			 * untar(), remember the error so that it is not lost.
+			 */
+			fprintf(stderr, "Failed to decompress %s: %s.\n",
+			    state->filename, str_error(rc));
+			state->gzip_rc = rc;
+			errno = rc;
+			break;
+		}
+
+		if (nread == 0)
+			break;
+
+		total += nread;
+	}
+
+	return total;
 }
 
 static void tar_vreport(tar_file_t *tar, const char *fmt, va_list args)
@@ -81,15 +155,20 @@ tar_file_t tar = {
 int main(int argc, char *argv[])
 {
 	if (argc != 2) {
-		fprintf(stderr, "Usage: %s tar-file\n", argv[0]);
+		fprintf(stderr, "Usage: %s tar-file[.gz]\n", argv[0]);
 		return 1;
 	}
 
 	tar_state_t state;
 	state.filename = argv[1];
+	state.gzip_rc = EOK;
 
 	tar.data = (void *) &state;
-	return untar(&tar);
+	int rc = untar(&tar);
+	if (rc == EOK && state.gzip_rc != EOK)
+		rc = state.gzip_rc;
+
+	return rc;
 }
 
 /** @}
@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup webload
+ * @{
+ */
+/**
+ * @file HTTP load generator.
+ *
+ * Issues GET requests for a single path over a number of concurrent
+ * persistent connections and reports throughput and latency percentiles.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <perf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+
+#include <http/http.h>
+#include <http/receive-buffer.h>
+
+#define NAME  "webload"
+
+#define DEFAULT_HOST  "127.0.0.1"
+#define DEFAULT_PORT  8080
+#define DEFAULT_CONNS  4
+#define DEFAULT_REQUESTS  1000
+
+/** Maximum number of requests in flight on one connection. */
+#define MAX_DEPTH  64
+
+/** Size of the buffer for discarding response bodies. */
+#define BODY_BUFFER_SIZE  16384
+
+/** Load generator worker, one per connection. */
+typedef struct {
+	http_t *http;
+	/** Requests sent but not answered yet, in order */
+	size_t inflight_idx[MAX_DEPTH];
+	stopwatch_t inflight_sw[MAX_DEPTH];
+	size_t inflight;
+	size_t inflight_head;
+	char body[BODY_BUFFER_SIZE];
+} worker_t;
+
+static const char *host = DEFAULT_HOST;
+static uint16_t port = DEFAULT_PORT;
+static size_t nconns = DEFAULT_CONNS;
+static size_t nrequests = DEFAULT_REQUESTS;
+static size_t depth = 1;
+static bool keep_alive = true;
+
+/** Formatted request */
+static char *request;
+static size_t request_size;
+
+static FIBRIL_MUTEX_INITIALIZE(load_lock);
+static FIBRIL_CONDVAR_INITIALIZE(load_cv);
+
+/** Number of requests handed out to workers */
+static size_t issued;
+/** Number of running workers */
+static size_t running;
+
+/** Latency of each request in nanoseconds */
+static nsec_t *latency;
+static size_t completed;
+static size_t failed;
+static uint64_t body_bytes;
+
+static void syntax_print(void)
+{
+	fprintf(stderr, "Usage: " NAME " [options] [<host>] [<path>]\n");
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -c <n>  Number of concurrent connections (default %d)\n",
+	    DEFAULT_CONNS);
+	fprintf(stderr, "  -n <n>  Total number of requests (default %d)\n",
+	    DEFAULT_REQUESTS);
+	fprintf(stderr, "  -p <n>  Server port (default %d)\n", DEFAULT_PORT);
+	fprintf(stderr, "  -d <n>  Pipeline depth per connection (default 1, "
+	    "at most %d)\n", MAX_DEPTH);
+	fprintf(stderr, "  -1      Open a new connection for every request\n");
+	fprintf(stderr, "Default host is " DEFAULT_HOST ", default path is /.\n");
+}
+
+/** Claim the next request to send. */
+static bool request_claim(size_t *ridx)
+{
+	bool claimed = false;
+
+	fibril_mutex_lock(&load_lock);
+	if (issued < nrequests) {
+		*ridx = issued++;
+		claimed = true;
+	}
+	fibril_mutex_unlock(&load_lock);
+
+	return claimed;
+}
+
+static errno_t worker_send(worker_t *worker)
+{
+	size_t idx;
+
+	if (!request_claim(&idx))
+		return ENOENT;
+
+	size_t slot = (worker->inflight_head + worker->inflight) % MAX_DEPTH;
+	worker->inflight_idx[slot] = idx;
+	stopwatch_init(&worker->inflight_sw[slot]);
+	stopwatch_start(&worker->inflight_sw[slot]);
+	worker->inflight++;
+
+	return tcp_conn_send(worker->http->conn, request, request_size);
+}
+
+/** Receive one response and discard its body.
+ *
+ * @param worker Worker
+ * @param rclose Place to store @c true if the server closes the connection
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t worker_receive(worker_t *worker, bool *rclose)
+{
+	receive_buffer_t *rb = &worker->http->recv_buffer;
+	http_response_t *response;
+	uint64_t length = 0;
+	uint64_t received = 0;
+	char *value;
+	errno_t rc;
+
+	rc = http_receive_response(rb, &response, 0, 0);
+	if (rc != EOK)
+		return rc;
+
+	*rclose = !keep_alive;
+	if (http_headers_get(&response->headers, "Connection", &value) == EOK) {
+		http_header_normalize_value(value);
+		if (str_casecmp(value, "close") == 0)
+			*rclose = true;
+	}
+
+	rc = http_headers_get(&response->headers, "Content-Length", &value);
+	if (rc == EOK) {
+		http_header_normalize_value(value);
+		rc = str_uint64_t(value, NULL, 10, true, &length);
+	}
+
+	if (rc == EOK && response->status != 200)
+		rc = EIO;
+
+	http_response_destroy(response);
+	if (rc != EOK)
+		return rc;
+
+	while (length > 0) {
+		size_t chunk = BODY_BUFFER_SIZE;
+		if (length < chunk)
+			chunk = length;
+
+		size_t nrecv;
+		rc = recv_buffer(rb, worker->body, chunk, &nrecv);
+		if (rc != EOK)
+			return rc;
+
+		if (nrecv == 0)
+			return EIO;
+
+		length -= nrecv;
+		received += nrecv;
+	}
+
+	stopwatch_t *sw = &worker->inflight_sw[worker->inflight_head];
+	stopwatch_stop(sw);
+
+	fibril_mutex_lock(&load_lock);
+	latency[completed++] = stopwatch_get_nanos(sw);
+	body_bytes += received;
+	fibril_mutex_unlock(&load_lock);
+
+	worker->inflight_head = (worker->inflight_head + 1) % MAX_DEPTH;
+	worker->inflight--;
+	return EOK;
+}
+
+/** Run requests over one connection until the server closes it. */
+static errno_t worker_conn(worker_t *worker, bool *rdone)
+{
+	bool close = false;
+	errno_t rc;
+
+	recv_reset(&worker->http->recv_buffer);
+	worker->inflight = 0;
+	worker->inflight_head = 0;
+
+	rc = http_connect(worker->http);
+	if (rc != EOK)
+		return rc;
+
+	*rdone = false;
+	while (!close) {
+		/* Fill the pipeline */
+		while (!*rdone && worker->inflight < (keep_alive ? depth : 1)) {
+			rc = worker_send(worker);
+			if (rc == ENOENT) {
+				*rdone = true;
+				break;
+			}
+
+			if (rc != EOK)
+				goto out;
+		}
+
+		if (worker->inflight == 0)
+			break;
+
+		rc = worker_receive(worker, &close);
+		if (rc != EOK)
+			goto out;
+	}
+
+	rc = EOK;
+out:
+	/* Requests that did not get a response are lost */
+	fibril_mutex_lock(&load_lock);
+	failed += worker->inflight;
+	fibril_mutex_unlock(&load_lock);
+
+	(void) http_close(worker->http);
+	return rc;
+}
+
+static errno_t worker_fibril(void *arg)
+{
+	worker_t *worker = (worker_t *) arg;
+	bool done = false;
+	errno_t rc;
+
+	while (!done) {
+		rc = worker_conn(worker, &done);
+		if (rc != EOK) {
+			fprintf(stderr, "Connection failed: %s\n", str_error(rc));
+			break;
+		}
+	}
+
+	fibril_mutex_lock(&load_lock);
+	running--;
+	fibril_condvar_broadcast(&load_cv);
+	fibril_mutex_unlock(&load_lock);
+
+	return EOK;
+}
+
+static int nsec_cmp(const void *a, const void *b)
+{
+	nsec_t na = *(const nsec_t *) a;
+	nsec_t nb = *(const nsec_t *) b;
+
+	if (na < nb)
+		return -1;
+	return na > nb ? 1 : 0;
+}
+
+/** Get latency percentile in microseconds from sorted latencies. */
+static usec_t percentile(unsigned pct)
+{
+	size_t idx = (completed * pct + 99) / 100;
+	if (idx > 0)
+		idx--;
+
+	return NSEC2USEC(latency[idx]);
+}
+
+static void report(nsec_t elapsed)
+{
+	uint64_t usec = NSEC2USEC(elapsed);
+	if (usec == 0)
+		usec = 1;
+
+	printf("%zu requests completed, %zu failed in %" PRIu64 " ms\n",
+	    completed, failed, usec / 1000);
+
+	if (completed == 0)
+		return;
+
+	qsort(latency, completed, sizeof(nsec_t), nsec_cmp);
+
+	printf("Throughput: %" PRIu64 " requests/s, %" PRIu64 " KiB/s\n",
+	    (uint64_t) completed * 1000000 / usec,
+	    body_bytes * 1000000 / usec / 1024);
+	printf("Latency (us): min %lld, p50 %lld, p90 %lld, p99 %lld, "
+	    "max %lld\n", NSEC2USEC(latency[0]), percentile(50),
+	    percentile(90), percentile(99), NSEC2USEC(latency[completed - 1]));
+}
+
+static errno_t parse_size(int argc, char *argv[], int *i, size_t *value)
+{
+	if (*i + 1 >= argc)
+		return EINVAL;
+
+	(*i)++;
+	errno_t rc = str_size_t(argv[*i], NULL, 10, true, value);
+	if (rc != EOK || *value == 0)
+		return EINVAL;
+
+	return EOK;
+}
+
+static errno_t request_format(const char *path)
+{
+	http_request_t *req;
+	errno_t rc;
+
+	req = http_request_create("GET", path);
+	if (req == NULL)
+		return ENOMEM;
+
+	rc = http_headers_append(&req->headers, "Host", host);
+	if (rc != EOK)
+		goto out;
+
+	if (!keep_alive) {
+		rc = http_headers_append(&req->headers, "Connection", "close");
+		if (rc != EOK)
+			goto out;
+	}
+
+	rc = http_request_format(req, &request, &request_size);
+out:
+	http_request_destroy(req);
+	return rc;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = "/";
+	worker_t **workers = NULL;
+	stopwatch_t sw;
+	size_t value;
+	errno_t rc;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		rc = EOK;
+
+		if (str_cmp(argv[i], "-c") == 0) {
+			rc = parse_size(argc, argv, &i, &nconns);
+		} else if (str_cmp(argv[i], "-n") == 0) {
+			rc = parse_size(argc, argv, &i, &nrequests);
+		} else if (str_cmp(argv[i], "-d") == 0) {
+			rc = parse_size(argc, argv, &i, &depth);
+			if (rc == EOK && depth > MAX_DEPTH)
+				rc = EINVAL;
+		} else if (str_cmp(argv[i], "-p") == 0) {
+			rc = parse_size(argc, argv, &i, &value);
+			if (rc == EOK && value > UINT16_MAX)
+				rc = EINVAL;
+			port = value;
+		} else if (str_cmp(argv[i], "-1") == 0) {
+			keep_alive = false;
+		} else {
+			rc = EINVAL;
+		}
+
+		if (rc != EOK) {
+			syntax_print();
+			return 1;
+		}
+	}
+
+	if (i < argc)
+		host = argv[i++];
+	if (i < argc)
+		path = argv[i++];
+	if (i < argc) {
+		syntax_print();
+		return 1;
+	}
+
+	rc = request_format(path);
+	if (rc != EOK) {
+		fprintf(stderr, "Error formatting request: %s\n", str_error(rc));
+		return 2;
+	}
+
+	latency = calloc(nrequests, sizeof(nsec_t));
+	workers = calloc(nconns, sizeof(worker_t *));
+	if (latency == NULL || workers == NULL) {
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	printf("%s: %zu requests for http://%s:%" PRIu16 "%s over %zu "
+	    "connections\n", NAME, nrequests, host, port, path, nconns);
+
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+
+	for (size_t j = 0; j < nconns; j++) {
+		workers[j] = calloc(1, sizeof(worker_t));
+		if (workers[j] == NULL) {
+			fprintf(stderr, "Out of memory.\n");
+			break;
+		}
+
+		workers[j]->http = http_create(host, port);
+		if (workers[j]->http == NULL) {
+			fprintf(stderr, "Out of memory.\n");
+			break;
+		}
+
+		fid_t fid = fibril_create(worker_fibril, workers[j]);
+		if (fid == 0) {
+			fprintf(stderr, "Out of memory.\n");
+			break;
+		}
+
+		fibril_mutex_lock(&load_lock);
+		running++;
+		fibril_mutex_unlock(&load_lock);
+
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&load_lock);
+	while (running > 0)
+		fibril_condvar_wait(&load_cv, &load_lock);
+	fibril_mutex_unlock(&load_lock);
+
+	stopwatch_stop(&sw);
+
+	/* Requests never handed out count as failed */
+	failed += nrequests - issued;
+	report(stopwatch_get_nanos(&sw));
+
+	for (size_t j = 0; j < nconns; j++) {
+		if (workers[j] != NULL && workers[j]->http != NULL)
+			http_destroy(workers[j]->http);
+		free(workers[j]);
+	}
+
+	free(workers);
+	free(latency);
+	free(request);
+	return failed == 0 ? 0 : 1;
+}
+
+/** @}
+ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file Open file cache.
+ *
+ * Serving a file costs a path lookup, an open and a stream of reads, each
+ * of them a round trip to VFS. The cache keeps the most
+ * recently served files open and, when possible, mapped into our address
+ * space through the VFS pager, so that the contents can be handed to the
+ * TCP service directly from the mapping. Each hit is revalidated by a stat
+ * of the path, a single round trip, and the entry is dropped if the file has
+ * been replaced or its size has changed.
+ */
+
+#include <align.h>
+#include <assert.h>
+#include <as.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+#include <vfs/vfs.h>
+
+#include "fcache.h"
+
+/** Maximum number of files kept open. */
+#define FCACHE_ENTRIES  16
+
+/** Files larger than this are read rather than mapped. */
+#define FCACHE_MAP_MAX  (16 * 1024 * 1024)
+
+static FIBRIL_MUTEX_INITIALIZE(fcache_lock);
+
+/** Cached files, the most recently used first. */
+static LIST_INITIALIZE(fcache_lru);
+static size_t fcache_count;
+
+static void fcache_entry_destroy(fcache_entry_t *entry)
+{
+	if (entry->map != NULL)
+		as_area_destroy(entry->map);
+	vfs_put(entry->fd);
+	free(entry->name);
+	free(entry);
+}
+
+static errno_t fcache_entry_create(const char *name, fcache_entry_t **rentry)
+{
+	fcache_entry_t *entry;
+	vfs_stat_t stat;
+	errno_t rc;
+
+	entry = calloc(1, sizeof(fcache_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	link_initialize(&entry->lru);
+	entry->refcnt = 1;
+
+	entry->name = str_dup(name);
+	if (entry->name == NULL) {
+		free(entry);
+		return ENOMEM;
+	}
+
+	rc = vfs_lookup_open(name, WALK_REGULAR, MODE_READ, &entry->fd);
+	if (rc != EOK) {
+		free(entry->name);
+		free(entry);
+		return rc;
+	}
+
+	rc = vfs_stat(entry->fd, &stat);
+	if (rc != EOK) {
+		vfs_put(entry->fd);
+		free(entry->name);
+		free(entry);
+		return rc;
+	}
+
+	entry->size = stat.size;
+	entry->fs_handle = stat.fs_handle;
+	entry->service_id = stat.service_id;
+	entry->index = stat.index;
+
+	/* Not being able to map the file is not fatal, it will be read. */
+	if (entry->size > 0 && entry->size <= FCACHE_MAP_MAX) {
+		rc = vfs_map(entry->fd, 0, AS_AREA_ANY,
+		    ALIGN_UP(entry->size, PAGE_SIZE),
+		    AS_AREA_READ | AS_AREA_CACHEABLE, &entry->map);
+		if (rc != EOK)
+			entry->map = NULL;
+	}
+
+	*rentry = entry;
+	return EOK;
+}
+
+/** Check that a cache entry still describes the file at its path. */
+static bool fcache_entry_valid(fcache_entry_t *entry)
+{
+	vfs_stat_t stat;
+
+	if (vfs_stat_path(entry->name, &stat) != EOK)
+		return false;
+
+	return stat.fs_handle == entry->fs_handle &&
+	    stat.service_id == entry->service_id &&
+	    stat.index == entry->index && stat.size == entry->size;
+}
+
+static fcache_entry_t *fcache_find(const char *name)
+{
+	list_foreach(fcache_lru, lru, fcache_entry_t, entry) {
+		if (str_cmp(entry->name, name) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/** Get an open file from the cache.
+ *
+ * The file is opened and entered into the cache if it is not there yet.
+ * The least recently used file is evicted if the cache is full.
+ *
+ * @param name   File name
+ * @param rentry Place to store pointer to the cache entry
+ *
+ * @return EOK on success or an error code
+ */
+errno_t fcache_get(const char *name, fcache_entry_t **rentry)
+{
+	fcache_entry_t *entry;
+	fcache_entry_t *new_entry;
+	fcache_entry_t *victim = NULL;
+	errno_t rc;
+
+	fibril_mutex_lock(&fcache_lock);
+
+	entry = fcache_find(name);
+	if (entry != NULL) {
+		list_remove(&entry->lru);
+		list_prepend(&entry->lru, &fcache_lru);
+		entry->refcnt++;
+		fibril_mutex_unlock(&fcache_lock);
+
+		if (fcache_entry_valid(entry)) {
+			*rentry = entry;
+			return EOK;
+		}
+
+		/* The file has changed, drop the entry and open it anew */
+		fibril_mutex_lock(&fcache_lock);
+		if (!entry->evicted) {
+			list_remove(&entry->lru);
+			fcache_count--;
+			entry->evicted = true;
+		}
+		fibril_mutex_unlock(&fcache_lock);
+		fcache_put(entry);
+	} else {
+		fibril_mutex_unlock(&fcache_lock);
+	}
+
+	/* Do not hold the lock over the VFS round trips */
+	rc = fcache_entry_create(name, &new_entry);
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&fcache_lock);
+
+	/* Another fibril may have opened the same file in the meantime */
+	entry = fcache_find(name);
+	if (entry != NULL) {
+		entry->refcnt++;
+		fibril_mutex_unlock(&fcache_lock);
+		fcache_entry_destroy(new_entry);
+		*rentry = entry;
+		return EOK;
+	}
+
+	if (fcache_count == FCACHE_ENTRIES) {
+		link_t *link = list_last(&fcache_lru);
+		entry = list_get_instance(link, fcache_entry_t, lru);
+		list_remove(&entry->lru);
+		fcache_count--;
+
+		if (entry->refcnt == 0)
+			victim = entry;
+		else
+			entry->evicted = true;
+	}
+
+	list_prepend(&new_entry->lru, &fcache_lru);
+	fcache_count++;
+
+	fibril_mutex_unlock(&fcache_lock);
+
+	/* Closing the file takes VFS round trips, do it without the lock */
+	if (victim != NULL)
+		fcache_entry_destroy(victim);
+
+	*rentry = new_entry;
+	return EOK;
+}
+
+/** Return a file obtained by fcache_get() to the cache.
+ *
+ * @param entry Cache entry
+ */
+void fcache_put(fcache_entry_t *entry)
+{
+	bool destroy;
+
+	fibril_mutex_lock(&fcache_lock);
+	assert(entry->refcnt > 0);
+	entry->refcnt--;
+	destroy = entry->evicted && entry->refcnt == 0;
+	fibril_mutex_unlock(&fcache_lock);
+
+	if (destroy)
+		fcache_entry_destroy(entry);
+}
+
+/** @}
+ */
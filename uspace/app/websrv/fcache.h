@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file Open file cache.
+ */
+
+#ifndef FCACHE_H
+#define FCACHE_H
+
+#include <adt/list.h>
+#include <errno.h>
+#include <offset.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <vfs/vfs.h>
+
+/** Cached open file. */
+typedef struct {
+	/** Link to fcache_lru */
+	link_t lru;
+	/** File name, relative to the web root */
+	char *name;
+	/** Open file handle */
+	int fd;
+	/** File size */
+	aoff64_t size;
+	/** File system of the file */
+	fs_handle_t fs_handle;
+	/** Service of the file system instance */
+	service_id_t service_id;
+	/** Index of the file's node */
+	fs_index_t index;
+	/** Area mapping the whole file or @c NULL */
+	void *map;
+	/** Number of users of the entry */
+	unsigned refcnt;
+	/** Entry has been evicted and is destroyed once the last user leaves */
+	bool evicted;
+} fcache_entry_t;
+
+extern errno_t fcache_get(const char *, fcache_entry_t **);
+extern void fcache_put(fcache_entry_t *);
+
+#endif
+
+/** @}
+ */
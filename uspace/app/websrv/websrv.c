@@ -48,19 +48,34 @@
 #include <inet/endpoint.h>
 #include <inet/tcp.h>
 
+#include <http/http.h>
+#include <http/receive-buffer.h>
+
 #include <arg_parse.h>
 #include <macros.h>
 #include <str.h>
 #include <str_error.h>
 
+#include "fcache.h"
+
 #define NAME  "websrv"
 
 #define DEFAULT_PORT  8080
 
 #define WEB_ROOT  "/data/web"
 
-/** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+/** Size of the buffer for receiving requests. */
+#define RECV_BUFFER_SIZE  4096
+
+/** Maximum length of the request line. */
+#define REQLINE_SIZE  1024
+
+/** Limits on the request headers. */
+#define HEADERS_SIZE_MAX   4096
+#define HEADERS_COUNT_MAX  64
+
+/** Size of the buffer for sending responses. */
+#define XFER_BUFFER_SIZE  DATA_XFER_LIMIT
 
 static void websrv_new_conn(tcp_listener_t *, tcp_conn_t *);
 
@@ -74,28 +89,30 @@ static tcp_cb_t conn_cb = {
 
 static uint16_t port = DEFAULT_PORT;
 
+/** Connection with a client.
+ *
+ * Requests are parsed from the receive buffer, which keeps any data
+ * received beyond the current request, so pipelined requests are
+ * served in turn without waiting for more data to arrive.
+ */
 typedef struct {
 	tcp_conn_t *conn;
+	receive_buffer_t rbuf;
 
-	char rbuf[BUFFER_SIZE];
-	size_t rbuf_out;
-	size_t rbuf_in;
+	char reqline[REQLINE_SIZE];
+	char *xbuf;
 
-	char lbuf[BUFFER_SIZE + 1];
-	size_t lbuf_used;
-} recv_t;
+	/** Current request is HEAD, do not send the body */
+	bool head;
+	/** Keep the connection open after the current request */
+	bool keep_alive;
+} websrv_conn_t;
 
 static bool verbose = false;
 
 /** Responses to send to client. */
 
-static const char *msg_ok =
-    "HTTP/1.0 200 OK\r\n"
-    "\r\n";
-
 static const char *msg_bad_request =
-    "HTTP/1.0 400 Bad Request\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>400 Bad Request</title>\r\n"
@@ -107,8 +124,6 @@ static const char *msg_bad_request =
     "</html>\r\n";
 
 static const char *msg_not_found =
-    "HTTP/1.0 404 Not Found\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>404 Not Found</title>\r\n"
@@ -120,8 +135,6 @@ static const char *msg_not_found =
     "</html>\r\n";
 
 static const char *msg_not_implemented =
-    "HTTP/1.0 501 Not Implemented\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>501 Not Implemented</title>\r\n"
@@ -132,77 +145,52 @@ static const char *msg_not_implemented =
     "</body>\r\n"
     "</html>\r\n";
 
-static errno_t recv_create(tcp_conn_t *conn, recv_t **rrecv)
+static errno_t websrv_recv(void *arg, void *buf, size_t size, size_t *nrecv)
 {
-	recv_t *recv;
-
-	recv = calloc(1, sizeof(recv_t));
-	if (recv == NULL)
-		return ENOMEM;
+	websrv_conn_t *wc = (websrv_conn_t *) arg;
 
-	recv->conn = conn;
-	recv->rbuf_out = 0;
-	recv->rbuf_in = 0;
-	recv->lbuf_used = 0;
+	errno_t rc = tcp_conn_recv_wait(wc->conn, buf, size, nrecv);
+	if (rc != EOK && verbose)
+		fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
 
-	*rrecv = recv;
-	return EOK;
-}
-
-static void recv_destroy(recv_t *recv)
-{
-	free(recv);
+	return rc;
 }
 
-/** Receive one character (with buffering) */
-static errno_t recv_char(recv_t *recv, char *c)
+static errno_t websrv_conn_create(tcp_conn_t *conn, websrv_conn_t **rwc)
 {
-	size_t nrecv;
+	websrv_conn_t *wc;
 	errno_t rc;
 
-	if (recv->rbuf_out == recv->rbuf_in) {
-		recv->rbuf_out = 0;
-		recv->rbuf_in = 0;
+	wc = calloc(1, sizeof(websrv_conn_t));
+	if (wc == NULL)
+		return ENOMEM;
 
-		rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
-			return rc;
-		}
+	wc->xbuf = malloc(XFER_BUFFER_SIZE);
+	if (wc->xbuf == NULL) {
+		free(wc);
+		return ENOMEM;
+	}
 
-		recv->rbuf_in = nrecv;
+	rc = recv_buffer_init(&wc->rbuf, RECV_BUFFER_SIZE, websrv_recv, wc);
+	if (rc != EOK) {
+		free(wc->xbuf);
+		free(wc);
+		return rc;
 	}
 
-	*c = recv->rbuf[recv->rbuf_out++];
+	wc->conn = conn;
+	*rwc = wc;
 	return EOK;
 }
 
-/** Receive one line with length limit */
-static errno_t recv_line(recv_t *recv, char **rbuf)
+static void websrv_conn_destroy(websrv_conn_t *wc)
 {
-	char *bp = recv->lbuf;
-	char c = '\0';
+	if (wc == NULL)
+		return;
 
-	while (bp < recv->lbuf + BUFFER_SIZE) {
-		char prev = c;
-		errno_t rc = recv_char(recv, &c);
-
-		if (rc != EOK)
-			return rc;
-
-		*bp++ = c;
-		if ((prev == '\r') && (c == '\n'))
-			break;
-	}
-
-	recv->lbuf_used = bp - recv->lbuf;
-	*bp = '\0';
-
-	if (bp == recv->lbuf + BUFFER_SIZE)
-		return ELIMIT;
-
-	*rbuf = recv->lbuf;
-	return EOK;
+	recv_buffer_fini(&wc->rbuf);
+	free(wc->xbuf);
+	free(wc);
 }
 
 static bool uri_is_valid(char *uri)
@@ -224,14 +212,9 @@ static bool uri_is_valid(char *uri)
 	return true;
 }
 
-static errno_t send_response(tcp_conn_t *conn, const char *msg)
+static errno_t send_data(websrv_conn_t *wc, const void *data, size_t size)
 {
-	size_t response_size = str_size(msg);
-
-	if (verbose)
-		fprintf(stderr, "Sending response\n");
-
-	errno_t rc = tcp_conn_send(conn, (void *) msg, response_size);
+	errno_t rc = tcp_conn_send(wc->conn, data, size);
 	if (rc != EOK) {
 		fprintf(stderr, "tcp_conn_send() failed\n");
 		return rc;
@@ -240,101 +223,280 @@ static errno_t send_response(tcp_conn_t *conn, const char *msg)
 	return EOK;
 }
 
-static errno_t uri_get(const char *uri, tcp_conn_t *conn)
+/** Format response header into the transfer buffer.
+ *
+ * @param wc     Connection
+ * @param status Status code and reason phrase
+ * @param length Length of the response body
+ *
+ * @return Size of the header
+ */
+static size_t format_header(websrv_conn_t *wc, const char *status,
+    aoff64_t length)
 {
-	char *fbuf = NULL;
-	char *fname = NULL;
-	errno_t rc;
-	size_t nr;
-	int fd = -1;
+	int size = snprintf(wc->xbuf, XFER_BUFFER_SIZE,
+	    "HTTP/1.1 %s\r\n"
+	    "Content-Length: %" PRIu64 "\r\n"
+	    "Connection: %s\r\n"
+	    "\r\n", status, length, wc->keep_alive ? "keep-alive" : "close");
+
+	assert(size > 0 && size < XFER_BUFFER_SIZE);
+	return size;
+}
 
-	fbuf = calloc(BUFFER_SIZE, 1);
-	if (fbuf == NULL) {
-		rc = ENOMEM;
-		goto out;
-	}
+static errno_t send_response(websrv_conn_t *wc, const char *status,
+    const char *body)
+{
+	size_t body_size = str_size(body);
 
-	if (str_cmp(uri, "/") == 0)
-		uri = "/index.html";
+	if (verbose)
+		fprintf(stderr, "Sending response\n");
 
-	if (asprintf(&fname, "%s%s", WEB_ROOT, uri) < 0) {
-		rc = ENOMEM;
-		goto out;
+	size_t size = format_header(wc, status, body_size);
+	if (!wc->head) {
+		assert(size + body_size <= XFER_BUFFER_SIZE);
+		memcpy(wc->xbuf + size, body, body_size);
+		size += body_size;
 	}
 
-	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
-	if (rc != EOK) {
-		rc = send_response(conn, msg_not_found);
-		goto out;
-	}
+	return send_data(wc, wc->xbuf, size);
+}
 
-	free(fname);
-	fname = NULL;
+/** Send file contents directly from its mapping. */
+static errno_t send_mapped(websrv_conn_t *wc, fcache_entry_t *entry,
+    size_t hdr_size)
+{
+	const char *data = entry->map;
+	size_t size = entry->size;
+	errno_t rc;
 
-	rc = send_response(conn, msg_ok);
+	/* Small files go out in a single message with the header */
+	if (size <= XFER_BUFFER_SIZE - hdr_size) {
+		memcpy(wc->xbuf + hdr_size, data, size);
+		return send_data(wc, wc->xbuf, hdr_size + size);
+	}
+
+	rc = send_data(wc, wc->xbuf, hdr_size);
 	if (rc != EOK)
-		goto out;
+		return rc;
+
+	while (size > 0) {
+		size_t chunk = min(size, (size_t) XFER_BUFFER_SIZE);
+
+		rc = send_data(wc, data, chunk);
+		if (rc != EOK)
+			return rc;
+
+		data += chunk;
+		size -= chunk;
+	}
 
+	return EOK;
+}
+
+/** Send file contents read through the transfer buffer. */
+static errno_t send_read(websrv_conn_t *wc, fcache_entry_t *entry,
+    size_t hdr_size)
+{
+	size_t used = hdr_size;
 	aoff64_t pos = 0;
-	while (true) {
-		rc = vfs_read(fd, &pos, fbuf, BUFFER_SIZE, &nr);
+	size_t nr;
+	errno_t rc;
+
+	while (pos < entry->size) {
+		size_t chunk = XFER_BUFFER_SIZE - used;
+		if (entry->size - pos < chunk)
+			chunk = entry->size - pos;
+
+		rc = vfs_read(entry->fd, &pos, wc->xbuf + used, chunk, &nr);
 		if (rc != EOK)
-			goto out;
+			return rc;
 
+		/* The file is shorter than announced */
 		if (nr == 0)
-			break;
+			return EIO;
 
-		rc = tcp_conn_send(conn, fbuf, nr);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_send() failed\n");
-			goto out;
+		used += nr;
+		if (used == XFER_BUFFER_SIZE || pos == entry->size) {
+			rc = send_data(wc, wc->xbuf, used);
+			if (rc != EOK)
+				return rc;
+			used = 0;
 		}
 	}
 
-	rc = EOK;
-out:
-	if (fd >= 0)
-		vfs_put(fd);
+	if (used > 0)
+		return send_data(wc, wc->xbuf, used);
+
+	return EOK;
+}
+
+static errno_t uri_get(websrv_conn_t *wc, const char *uri)
+{
+	fcache_entry_t *entry;
+	char *fname = NULL;
+	errno_t rc;
+
+	if (str_cmp(uri, "/") == 0)
+		uri = "/index.html";
+
+	if (asprintf(&fname, "%s%s", WEB_ROOT, uri) < 0)
+		return ENOMEM;
+
+	rc = fcache_get(fname, &entry);
 	free(fname);
-	free(fbuf);
+	if (rc != EOK)
+		return send_response(wc, "404 Not Found", msg_not_found);
+
+	size_t hdr_size = format_header(wc, "200 OK", entry->size);
+
+	if (wc->head)
+		rc = send_data(wc, wc->xbuf, hdr_size);
+	else if (entry->map != NULL)
+		rc = send_mapped(wc, entry, hdr_size);
+	else
+		rc = send_read(wc, entry, hdr_size);
+
+	fcache_put(entry);
 	return rc;
 }
 
-static errno_t req_process(tcp_conn_t *conn, recv_t *recv)
+/** Skip request body announced by the Content-Length header. */
+static errno_t req_skip_body(websrv_conn_t *wc, uint64_t length)
 {
-	char *reqline = NULL;
+	while (length > 0) {
+		size_t chunk = XFER_BUFFER_SIZE;
+		if (length < chunk)
+			chunk = length;
+
+		size_t nrecv;
+		errno_t rc = recv_buffer(&wc->rbuf, wc->xbuf, chunk, &nrecv);
+		if (rc != EOK)
+			return rc;
 
-	errno_t rc = recv_line(recv, &reqline);
+		if (nrecv == 0)
+			return EIO;
+
+		length -= nrecv;
+	}
+
+	return EOK;
+}
+
+/** Receive request headers and determine connection persistence. */
+static errno_t req_headers(websrv_conn_t *wc, http_headers_t *headers)
+{
+	char *value;
+	size_t nrecv;
+	errno_t rc;
+
+	rc = http_headers_receive(&wc->rbuf, headers, HEADERS_SIZE_MAX,
+	    HEADERS_COUNT_MAX);
+	if (rc != EOK)
+		return rc;
+
+	rc = recv_eol(&wc->rbuf, &nrecv);
+	if (rc == EOK && nrecv == 0)
+		rc = HTTP_EPARSE;
+	if (rc != EOK)
+		return rc;
+
+	if (http_headers_get(headers, "Connection", &value) == EOK) {
+		http_header_normalize_value(value);
+		if (str_casecmp(value, "close") == 0)
+			wc->keep_alive = false;
+		else if (str_casecmp(value, "keep-alive") == 0)
+			wc->keep_alive = true;
+	}
+
+	/*
+	 * We cannot find the end of a body in other transfer coding,
+	 * so close the connection after responding.
+	 */
+	if (http_headers_get(headers, "Transfer-Encoding", &value) == EOK)
+		wc->keep_alive = false;
+
+	rc = http_headers_get(headers, "Content-Length", &value);
+	if (rc == HTTP_EMULTIPLE_HEADERS)
+		return HTTP_EPARSE;
+
+	if (rc == EOK) {
+		uint64_t length;
+
+		http_header_normalize_value(value);
+		rc = str_uint64_t(value, NULL, 10, true, &length);
+		if (rc != EOK)
+			return HTTP_EPARSE;
+
+		rc = req_skip_body(wc, length);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+static errno_t req_process(websrv_conn_t *wc)
+{
+	http_headers_t headers;
+	size_t nrecv;
+	errno_t rc;
+
+	wc->head = false;
+	wc->keep_alive = false;
+
+	rc = recv_line(&wc->rbuf, wc->reqline, REQLINE_SIZE, &nrecv);
+	if (rc == ELIMIT)
+		return send_response(wc, "400 Bad Request", msg_bad_request);
 	if (rc != EOK) {
 		fprintf(stderr, "recv_line() failed\n");
 		return rc;
 	}
 
 	if (verbose)
-		fprintf(stderr, "Request: %s", reqline);
-
-	if (str_lcmp(reqline, "GET ", 4) != 0) {
-		rc = send_response(conn, msg_not_implemented);
-		return rc;
+		fprintf(stderr, "Request: %s\n", wc->reqline);
+
+	char *method = wc->reqline;
+	char *uri = str_chr(method, ' ');
+	if (uri == NULL)
+		return send_response(wc, "400 Bad Request", msg_bad_request);
+	*uri++ = '\0';
+
+	char *version = str_chr(uri, ' ');
+	if (version != NULL) {
+		*version++ = '\0';
+
+		/* Connections are persistent by default since HTTP/1.1 */
+		if (str_lcmp(version, "HTTP/1.", 7) == 0 &&
+		    str_cmp(version, "HTTP/1.0") != 0)
+			wc->keep_alive = true;
 	}
 
-	char *uri = reqline + 4;
-	char *end_uri = str_chr(uri, ' ');
-	if (end_uri == NULL) {
-		end_uri = reqline + str_size(reqline) - 2;
-		assert(*end_uri == '\r');
+	http_headers_init(&headers);
+	rc = req_headers(wc, &headers);
+	http_headers_clear(&headers);
+
+	if (rc == ELIMIT || rc == HTTP_EPARSE) {
+		wc->keep_alive = false;
+		return send_response(wc, "400 Bad Request", msg_bad_request);
 	}
 
-	*end_uri = '\0';
+	if (rc != EOK)
+		return rc;
+
+	if (str_cmp(method, "HEAD") == 0)
+		wc->head = true;
+	else if (str_cmp(method, "GET") != 0)
+		return send_response(wc, "501 Not Implemented",
+		    msg_not_implemented);
+
 	if (verbose)
 		fprintf(stderr, "Requested URI: %s\n", uri);
 
-	if (!uri_is_valid(uri)) {
-		rc = send_response(conn, msg_bad_request);
-		return rc;
-	}
+	if (!uri_is_valid(uri))
+		return send_response(wc, "400 Bad Request", msg_bad_request);
 
-	return uri_get(uri, conn);
+	return uri_get(wc, uri);
 }
 
 static void usage(void)
@@ -402,23 +564,33 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 {
 	errno_t rc;
-	recv_t *recv = NULL;
+	websrv_conn_t *wc = NULL;
+	char c;
 
 	if (verbose)
 		fprintf(stderr, "New connection, waiting for request\n");
 
-	rc = recv_create(conn, &recv);
+	rc = websrv_conn_create(conn, &wc);
 	if (rc != EOK) {
 		fprintf(stderr, "Out of memory.\n");
 		goto error;
 	}
 
-	rc = req_process(conn, recv);
-	if (rc != EOK) {
-		fprintf(stderr, "Error processing request (%s)\n",
-		    str_error(rc));
-		goto error;
-	}
+	do {
+		/*
+		 * Wait for the next request. The client is free to close
+		 * a persistent connection between requests.
+		 */
+		if (recv_char(&wc->rbuf, &c, false) != EOK)
+			break;
+
+		rc = req_process(wc);
+		if (rc != EOK) {
+			fprintf(stderr, "Error processing request (%s)\n",
+			    str_error(rc));
+			goto error;
+		}
+	} while (wc->keep_alive);
 
 	rc = tcp_conn_send_fin(conn);
 	if (rc != EOK) {
@@ -426,14 +598,14 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 		goto error;
 	}
 
-	recv_destroy(recv);
+	websrv_conn_destroy(wc);
 	return;
 error:
 	rc = tcp_conn_reset(conn);
 	if (rc != EOK)
 		fprintf(stderr, "Error resetting connection.\n");
 
-	recv_destroy(recv);
+	websrv_conn_destroy(wc);
 }
 
 int main(int argc, char *argv[])
@@ -30,6 +30,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <adt/hash.h>
+#include <fibril.h>
+#include <macros.h>
 
 #include <as.h>
 #include <ddf/driver.h>
@@ -45,11 +48,22 @@
 
 #define NAME	"virtio-net"
 
-#define VIRTIO_NET_NUM_QUEUES	3
+/*
+ * Virtqueues of the RX/TX pair number i have indices 2 * i and 2 * i + 1.
+ * The control virtqueue follows the last pair supported by the device.
+ */
+#define RX_QUEUE(pair)	(2 * (pair))
+#define TX_QUEUE(pair)	(2 * (pair) + 1)
 
-#define RX_QUEUE_1	0
-#define TX_QUEUE_1	1
-#define CT_QUEUE_1	2
+/** Ethernet header size and EtherTypes used for TX virtqueue selection */
+#define ETH_HDR_SIZE	14
+#define ETHERTYPE_IPV4	0x0800
+#define ETHERTYPE_IPV6	0x86dd
+
+/** Number of attempts to wait for a control command to complete */
+#define CT_POLL_RETRIES	1000
+/** Delay between the attempts in microseconds */
+#define CT_POLL_DELAY	1000
 
 #define BUFFER_SIZE	2048
 #define RX_BUF_SIZE	BUFFER_SIZE
@@ -69,47 +83,76 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Receive frames from one RX virtqueue
+ *
+ * All frames are passed to the NIC framework in a single list and all the
+ * buffers are returned to the device with a single notification.
+ */
+static void virtio_net_receive(nic_t *nic, unsigned pair)
 {
-	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+	uint16_t done[RX_BUFFERS];
+	size_t ndone = 0;
 
 	uint16_t descno;
 	uint32_t len;
-	while (virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len)) {
+	while (ndone < RX_BUFFERS &&
+	    virtio_virtq_consume_used(vdev, RX_QUEUE(pair), &descno, &len)) {
+		done[ndone++] = descno;
+
 		virtio_net_hdr_t *hdr =
-		    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
+		    (virtio_net_hdr_t *) virtio_net->rx_buf[pair][descno];
 		if (len <= sizeof(*hdr)) {
 			ddf_msg(LVL_WARN,
 			    "RX data length too short, packet dropped");
-			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
-			    descno);
 			continue;
 		}
 
 		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
 		if (frame) {
 			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
+			if (frames != NULL)
+				nic_frame_list_append(frames, frame);
+			else
+				nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_WARN,
 			    "Cannot allocate RX frame, packet dropped");
 		}
-
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
 	}
 
-	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
-		    descno);
-	}
-	while (virtio_virtq_consume_used(vdev, CT_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, CT_QUEUE_1, &virtio_net->ct_free_head,
-		    descno);
+	virtio_virtq_produce_available_batch(vdev, RX_QUEUE(pair), done, ndone);
+	nic_received_frame_list(nic, frames);
+}
+
+/** Process used buffers of all RX and TX virtqueues */
+static void virtio_net_process(nic_t *nic)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		virtio_net_receive(nic, i);
+
+		uint16_t descno;
+		uint32_t len;
+		while (virtio_virtq_consume_used(vdev, TX_QUEUE(i), &descno,
+		    &len)) {
+			virtio_free_desc(vdev, TX_QUEUE(i),
+			    &virtio_net->tx_free_head[i], descno);
+		}
 	}
 }
 
+static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+
+	virtio_net_process(nic);
+}
+
 static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
@@ -166,6 +209,77 @@ static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 	    virtio_net_irq_handler, &irq_code, &virtio_net->irq_handle);
 }
 
+static void virtio_net_teardown_bufs(virtio_net_t *virtio_net)
+{
+	for (unsigned i = 0; i < VIRTIO_NET_MAX_PAIRS; i++) {
+		virtio_teardown_dma_bufs(virtio_net->rx_buf[i]);
+		virtio_teardown_dma_bufs(virtio_net->tx_buf[i]);
+	}
+	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+}
+
+/** Set the number of RX/TX virtqueue pairs used by the device
+ *
+ * The command is submitted to the control virtqueue and its completion is
+ * polled for. It must be called only after the device went live.
+ */
+static errno_t virtio_net_set_pairs(virtio_net_t *virtio_net, uint16_t pairs)
+{
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	uint16_t ctq = virtio_net->ct_queue;
+
+	uint16_t cmd = virtio_alloc_desc(vdev, ctq, &virtio_net->ct_free_head);
+	if (cmd == (uint16_t) -1U)
+		return ENOMEM;
+	uint16_t ack = virtio_alloc_desc(vdev, ctq, &virtio_net->ct_free_head);
+	if (ack == (uint16_t) -1U) {
+		virtio_free_desc(vdev, ctq, &virtio_net->ct_free_head, cmd);
+		return ENOMEM;
+	}
+
+	/*
+	 * The command header and data are read by the device, the
+	 * acknowledgement is written by it. Both live in the command
+	 * descriptor's buffer.
+	 */
+	uint8_t *buf = virtio_net->ct_buf[cmd];
+	virtio_net_ctrl_hdr_t *hdr = (virtio_net_ctrl_hdr_t *) buf;
+	hdr->class = VIRTIO_NET_CTRL_MQ;
+	hdr->command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+	pio_write_le16((ioport16_t *) &hdr[1], pairs);
+
+	size_t ack_offs = sizeof(*hdr) + sizeof(uint16_t);
+	buf[ack_offs] = VIRTIO_NET_ERR;
+
+	virtio_virtq_desc_set(vdev, ctq, cmd, virtio_net->ct_buf_p[cmd],
+	    ack_offs, VIRTQ_DESC_F_NEXT, ack);
+	virtio_virtq_desc_set(vdev, ctq, ack,
+	    virtio_net->ct_buf_p[cmd] + ack_offs, 1, VIRTQ_DESC_F_WRITE, 0);
+	virtio_virtq_produce_available(vdev, ctq, cmd);
+
+	uint16_t descno;
+	uint32_t len;
+	errno_t rc = ETIMEOUT;
+	for (unsigned i = 0; i < CT_POLL_RETRIES; i++) {
+		if (virtio_virtq_consume_used(vdev, ctq, &descno, &len)) {
+			rc = (buf[ack_offs] == VIRTIO_NET_OK) ? EOK : EIO;
+			break;
+		}
+		fibril_usleep(CT_POLL_DELAY);
+	}
+
+	/*
+	 * On timeout the device still owns the descriptors, so they cannot
+	 * be reused.
+	 */
+	if (rc != ETIMEOUT) {
+		virtio_free_desc(vdev, ctq, &virtio_net->ct_free_head, ack);
+		virtio_free_desc(vdev, ctq, &virtio_net->ct_free_head, cmd);
+	}
+
+	return rc;
+}
+
 static errno_t virtio_net_initialize(ddf_dev_t *dev)
 {
 	nic_t *nic = nic_create_and_bind(dev);
@@ -196,8 +310,10 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	uint32_t features;
+	rc = virtio_device_setup_start_optional(vdev,
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ, VIRTIO_NET_F_MQ,
+	    &features);
 	if (rc != EOK)
 		goto fail;
 
@@ -206,41 +322,52 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Discover and configure the virtqueues
 	 */
+	uint16_t max_pairs = 1;
+	if (features & VIRTIO_NET_F_MQ)
+		max_pairs = pio_read_le16(&netcfg->max_virtqueue_pairs);
+
 	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
-	if (num_queues != VIRTIO_NET_NUM_QUEUES) {
+	if (max_pairs < 1 || num_queues < 2 * max_pairs + 1) {
 		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
 		    num_queues);
 		rc = ELIMIT;
 		goto fail;
 	}
 
+	virtio_net->pairs = min(max_pairs, VIRTIO_NET_MAX_PAIRS);
+	virtio_net->ct_queue = 2 * max_pairs;
+
 	vdev->queues = calloc(sizeof(virtq_t), num_queues);
 	if (!vdev->queues) {
 		rc = ENOMEM;
 		goto fail;
 	}
 
-	rc = virtio_virtq_setup(vdev, RX_QUEUE_1, RX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, TX_QUEUE_1, TX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, CT_QUEUE_1, CT_BUFFERS);
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		rc = virtio_virtq_setup(vdev, RX_QUEUE(i), RX_BUFFERS);
+		if (rc != EOK)
+			goto fail;
+		rc = virtio_virtq_setup(vdev, TX_QUEUE(i), TX_BUFFERS);
+		if (rc != EOK)
+			goto fail;
+	}
+	rc = virtio_virtq_setup(vdev, virtio_net->ct_queue, CT_BUFFERS);
 	if (rc != EOK)
 		goto fail;
 
 	/*
 	 * Setup DMA buffers
 	 */
-	rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, false,
-	    virtio_net->rx_buf, virtio_net->rx_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
-	    virtio_net->tx_buf, virtio_net->tx_buf_p);
-	if (rc != EOK)
-		goto fail;
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, false,
+		    virtio_net->rx_buf[i], virtio_net->rx_buf_p[i]);
+		if (rc != EOK)
+			goto fail;
+		rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
+		    virtio_net->tx_buf[i], virtio_net->tx_buf_p[i]);
+		if (rc != EOK)
+			goto fail;
+	}
 	rc = virtio_setup_dma_bufs(CT_BUFFERS, CT_BUF_SIZE, true,
 	    virtio_net->ct_buf, virtio_net->ct_buf_p);
 	if (rc != EOK)
@@ -249,27 +376,36 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Give all RX buffers to the NIC
 	 */
-	for (unsigned i = 0; i < RX_BUFFERS; i++) {
-		/*
-		 * Associtate the buffer with the descriptor, set length and
-		 * flags.
-		 */
-		virtio_virtq_desc_set(vdev, RX_QUEUE_1, i,
-		    virtio_net->rx_buf_p[i], RX_BUF_SIZE, VIRTQ_DESC_F_WRITE,
-		    0);
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		uint16_t descs[RX_BUFFERS];
+
+		for (unsigned j = 0; j < RX_BUFFERS; j++) {
+			/*
+			 * Associtate the buffer with the descriptor, set length
+			 * and flags.
+			 */
+			virtio_virtq_desc_set(vdev, RX_QUEUE(i), j,
+			    virtio_net->rx_buf_p[i][j], RX_BUF_SIZE,
+			    VIRTQ_DESC_F_WRITE, 0);
+			descs[j] = j;
+		}
+
 		/*
-		 * Put the set descriptor into the available ring of the RX
+		 * Put the set descriptors into the available ring of the RX
 		 * queue.
 		 */
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, i);
+		virtio_virtq_produce_available_batch(vdev, RX_QUEUE(i), descs,
+		    RX_BUFFERS);
 	}
 
 	/*
 	 * Put all TX and CT buffers on a free list
 	 */
-	virtio_create_desc_free_list(vdev, TX_QUEUE_1, TX_BUFFERS,
-	    &virtio_net->tx_free_head);
-	virtio_create_desc_free_list(vdev, CT_QUEUE_1, CT_BUFFERS,
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		virtio_create_desc_free_list(vdev, TX_QUEUE(i), TX_BUFFERS,
+		    &virtio_net->tx_free_head[i]);
+	}
+	virtio_create_desc_free_list(vdev, virtio_net->ct_queue, CT_BUFFERS,
 	    &virtio_net->ct_free_head);
 
 	/*
@@ -299,12 +435,23 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/* Go live */
 	virtio_device_setup_finalize(vdev);
 
+	/* Let the device steer received flows to all our RX virtqueues */
+	if (virtio_net->pairs > 1) {
+		rc = virtio_net_set_pairs(virtio_net, virtio_net->pairs);
+		if (rc != EOK) {
+			ddf_msg(LVL_WARN, "Cannot enable %u virtqueue pairs",
+			    virtio_net->pairs);
+			virtio_net->pairs = 1;
+		}
+	}
+
+	ddf_msg(LVL_NOTE, "Using %u RX/TX virtqueue pair(s)",
+	    virtio_net->pairs);
+
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -316,26 +463,67 @@ static void virtio_net_uninitialize(ddf_dev_t *dev)
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = (virtio_net_t *) nic_get_specific(nic);
 
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(&virtio_net->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_net->virtio_dev);
 }
 
+/** Choose the TX virtqueue pair for a frame
+ *
+ * Frames of the same IPv4 or IPv6 flow are always sent using the same pair
+ * so that the device steers the replies to the RX virtqueue of that pair.
+ */
+static unsigned virtio_net_tx_pair(virtio_net_t *virtio_net, uint8_t *data,
+    size_t size)
+{
+	size_t addr_offs, addr_size, l4_offs;
+	uint8_t proto;
+
+	if (virtio_net->pairs == 1 || size < ETH_HDR_SIZE)
+		return 0;
+
+	uint16_t ethertype = (data[12] << 8) | data[13];
+	if (ethertype == ETHERTYPE_IPV4 && size >= ETH_HDR_SIZE + 20) {
+		proto = data[ETH_HDR_SIZE + 9];
+		addr_offs = ETH_HDR_SIZE + 12;
+		addr_size = 8;
+		l4_offs = ETH_HDR_SIZE + 4 * (data[ETH_HDR_SIZE] & 0x0f);
+	} else if (ethertype == ETHERTYPE_IPV6 && size >= ETH_HDR_SIZE + 40) {
+		proto = data[ETH_HDR_SIZE + 6];
+		addr_offs = ETH_HDR_SIZE + 8;
+		addr_size = 32;
+		l4_offs = ETH_HDR_SIZE + 40;
+	} else {
+		return 0;
+	}
+
+	size_t hash = 0;
+	for (size_t i = 0; i < addr_size; i++)
+		hash = hash * 31 + data[addr_offs + i];
+
+	/* TCP and UDP ports */
+	if ((proto == 6 || proto == 17) && size >= l4_offs + 4) {
+		for (size_t i = 0; i < 4; i++)
+			hash = hash * 31 + data[l4_offs + i];
+	}
+
+	return hash_mix(hash) % virtio_net->pairs;
+}
+
 static void virtio_net_send(nic_t *nic, void *data, size_t size)
 {
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
 
-	if (size > sizeof(virtio_net) + TX_BUF_SIZE) {
+	if (size > TX_BUF_SIZE - sizeof(virtio_net_hdr_t)) {
 		ddf_msg(LVL_WARN, "TX data too big, frame dropped");
 		return;
 	}
 
-	uint16_t descno = virtio_alloc_desc(vdev, TX_QUEUE_1,
-	    &virtio_net->tx_free_head);
+	unsigned pair = virtio_net_tx_pair(virtio_net, data, size);
+	uint16_t descno = virtio_alloc_desc(vdev, TX_QUEUE(pair),
+	    &virtio_net->tx_free_head[pair]);
 	if (descno == (uint16_t) -1U) {
 		ddf_msg(LVL_WARN, "No TX buffers available, frame dropped");
 		return;
@@ -343,7 +531,8 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	assert(descno < TX_BUFFERS);
 
 	/* Setup the packet header */
-	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) virtio_net->tx_buf[descno];
+	virtio_net_hdr_t *hdr =
+	    (virtio_net_hdr_t *) virtio_net->tx_buf[pair][descno];
 	memset(hdr, 0, sizeof(virtio_net_hdr_t));
 	hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 	hdr->num_buffers = 0;
@@ -354,9 +543,10 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	/*
 	 * Set the descriptor, put it into the virtqueue and notify the device
 	 */
-	virtio_virtq_desc_set(vdev, TX_QUEUE_1, descno,
-	    virtio_net->tx_buf_p[descno], sizeof(virtio_net_hdr_t) + size, 0, 0);
-	virtio_virtq_produce_available(vdev, TX_QUEUE_1, descno);
+	virtio_virtq_desc_set(vdev, TX_QUEUE(pair), descno,
+	    virtio_net->tx_buf_p[pair][descno], sizeof(virtio_net_hdr_t) + size,
+	    0, 0);
+	virtio_virtq_produce_available(vdev, TX_QUEUE(pair), descno);
 }
 
 static errno_t virtio_net_on_multicast_mode_change(nic_t *nic,
@@ -392,6 +582,36 @@ static errno_t virtio_net_on_broadcast_mode_change(nic_t *nic,
 	}
 }
 
+/** Set polling mode
+ *
+ * Interrupts of the RX virtqueues are suppressed unless the mode is
+ * NIC_POLL_IMMEDIATE. Periodic polling is left to the NIC framework.
+ */
+static errno_t virtio_net_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	bool enable;
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+		enable = true;
+		break;
+	case NIC_POLL_ON_DEMAND:
+		enable = false;
+		break;
+	default:
+		return ENOTSUP;
+	}
+
+	for (unsigned i = 0; i < virtio_net->pairs; i++) {
+		virtio_virtq_set_interrupt(&virtio_net->virtio_dev, RX_QUEUE(i),
+		    enable);
+	}
+
+	return EOK;
+}
+
 static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 {
 	ddf_msg(LVL_NOTE, "%s %s (handle = %zu)", __func__,
@@ -411,6 +631,8 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 	ddf_fun_set_ops(fun, &virtio_net_dev_ops);
 
 	nic_set_send_frame_handler(nic, virtio_net_send);
+	nic_set_poll_handlers(nic, virtio_net_poll_mode_change,
+	    virtio_net_process);
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
@@ -37,6 +37,9 @@
 #define TX_BUFFERS	8
 #define CT_BUFFERS	4
 
+/** Maximum number of RX/TX virtqueue pairs used by the driver */
+#define VIRTIO_NET_MAX_PAIRS	4
+
 /** Device handles packets with partial checksum. */
 #define VIRTIO_NET_F_CSUM		(1U << 0)
 /** Driver handles packets with partial checksum. */
@@ -45,6 +48,8 @@
 #define VIRTIO_NET_F_MAC		(1U << 5)
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
+/** Device supports multiqueue with automatic receive steering */
+#define VIRTIO_NET_F_MQ			(1U << 22)
 
 #define VIRTIO_NET_HDR_GSO_NONE 0
 typedef struct {
@@ -57,22 +62,43 @@ typedef struct {
 	uint16_t num_buffers;
 } virtio_net_hdr_t;
 
+/** Control virtqueue command classes and commands */
+#define VIRTIO_NET_CTRL_MQ			4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET		0
+
+/** Control virtqueue command acknowledgements */
+#define VIRTIO_NET_OK		0
+#define VIRTIO_NET_ERR		1
+
+typedef struct {
+	uint8_t class;
+	uint8_t command;
+} virtio_net_ctrl_hdr_t;
+
 typedef struct {
 	uint8_t mac[ETH_ADDR];
+	ioport16_t status;
+	/** Valid only if VIRTIO_NET_F_MQ was negotiated */
+	ioport16_t max_virtqueue_pairs;
 } virtio_net_cfg_t;
 
 typedef struct {
 	virtio_dev_t virtio_dev;
-	void *rx_buf[RX_BUFFERS];
-	uintptr_t rx_buf_p[RX_BUFFERS];
-	void *tx_buf[TX_BUFFERS];
-	uintptr_t tx_buf_p[TX_BUFFERS];
+	void *rx_buf[VIRTIO_NET_MAX_PAIRS][RX_BUFFERS];
+	uintptr_t rx_buf_p[VIRTIO_NET_MAX_PAIRS][RX_BUFFERS];
+	void *tx_buf[VIRTIO_NET_MAX_PAIRS][TX_BUFFERS];
+	uintptr_t tx_buf_p[VIRTIO_NET_MAX_PAIRS][TX_BUFFERS];
 	void *ct_buf[CT_BUFFERS];
 	uintptr_t ct_buf_p[CT_BUFFERS];
 
-	uint16_t tx_free_head;
+	uint16_t tx_free_head[VIRTIO_NET_MAX_PAIRS];
 	uint16_t ct_free_head;
 
+	/** Number of RX/TX virtqueue pairs in use */
+	unsigned pairs;
+	/** Index of the control virtqueue */
+	uint16_t ct_queue;
+
 	int irq;
 	cap_irq_handle_t irq_handle;
 } virtio_net_t;
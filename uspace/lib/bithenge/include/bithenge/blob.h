@@ -37,7 +37,9 @@
 #ifndef BITHENGE_BLOB_H_
 #define BITHENGE_BLOB_H_
 
+#ifdef __HELENOS__
 #include <offset.h>
+#endif
 #include <errno.h>
 #include "tree.h"
 
@@ -259,6 +261,8 @@ errno_t bithenge_new_offset_blob(bithenge_node_t **, bithenge_blob_t *, aoff64_t
 errno_t bithenge_new_subblob(bithenge_node_t **, bithenge_blob_t *, aoff64_t,
     aoff64_t);
 /** @memberof bithenge_blob_t */
+errno_t bithenge_new_cached_blob(bithenge_node_t **, bithenge_blob_t *);
+/** @memberof bithenge_blob_t */
 errno_t bithenge_blob_equal(bool *, bithenge_blob_t *, bithenge_blob_t *);
 
 #endif
@@ -43,6 +43,7 @@ typedef int64_t bithenge_int_t;
 #define BITHENGE_PRId PRIdMAX
 typedef intmax_t bithenge_int_t;
 typedef uint64_t aoff64_t;
+typedef int errno_t;
 #define EOK 0
 
 #endif
@@ -456,6 +456,218 @@ errno_t bithenge_new_subblob(bithenge_node_t **out, bithenge_blob_t *source,
 	return new_subblob(out, source, offset, size, true);
 }
 
+/** Size of the aligned blocks a cached blob reads from its source. */
+#define CACHE_BLOCK_SIZE ((aoff64_t) 65536)
+/** Number of separately cached windows. */
+#define CACHE_SLOTS 4
+/** Maximum number of blocks read at once during sequential access. */
+#define CACHE_MAX_WINDOW 4
+
+typedef struct {
+	char *data;
+	aoff64_t capacity;
+	aoff64_t offset;
+	aoff64_t size;
+	unsigned last_use;
+} cache_slot_t;
+
+typedef struct {
+	bithenge_blob_t base;
+	bithenge_blob_t *source;
+	aoff64_t size;
+	bool size_known;
+	cache_slot_t slots[CACHE_SLOTS];
+	unsigned clock;
+	/** Offset just past the most recently filled window. */
+	aoff64_t next_fill;
+	/** Current read-ahead window, in blocks. */
+	aoff64_t window;
+} cached_blob_t;
+
+static inline cached_blob_t *blob_as_cached(bithenge_blob_t *base)
+{
+	return (cached_blob_t *)base;
+}
+
+static inline bithenge_blob_t *cached_as_blob(cached_blob_t *blob)
+{
+	return &blob->base;
+}
+
+static errno_t cached_get_size(cached_blob_t *blob)
+{
+	if (blob->size_known)
+		return EOK;
+	errno_t rc = bithenge_blob_size(blob->source, &blob->size);
+	if (rc != EOK)
+		return rc;
+	blob->size_known = true;
+	return EOK;
+}
+
+static errno_t cached_size(bithenge_blob_t *base, aoff64_t *size)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	errno_t rc = cached_get_size(blob);
+	if (rc != EOK)
+		return rc;
+	*size = blob->size;
+	return EOK;
+}
+
+static cache_slot_t *cached_lookup(cached_blob_t *blob, aoff64_t offset)
+{
+	for (int i = 0; i < CACHE_SLOTS; i++) {
+		cache_slot_t *slot = &blob->slots[i];
+		if (slot->size && offset >= slot->offset &&
+		    offset - slot->offset < slot->size) {
+			slot->last_use = ++blob->clock;
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+/** Read the aligned window containing @a offset into the least recently used
+ * slot. Misses that continue where the previous window ended double the
+ * window size, so sequential decoding issues few large reads; any other miss
+ * falls back to a single block. */
+static errno_t cached_fill(cached_blob_t *blob, aoff64_t offset,
+    cache_slot_t **out)
+{
+	aoff64_t start = offset - offset % CACHE_BLOCK_SIZE;
+	if (start == blob->next_fill)
+		blob->window = min(blob->window * 2, CACHE_MAX_WINDOW);
+	else
+		blob->window = 1;
+	aoff64_t len = min(blob->window * CACHE_BLOCK_SIZE, blob->size - start);
+
+	cache_slot_t *slot = &blob->slots[0];
+	for (int i = 1; i < CACHE_SLOTS; i++) {
+		if (blob->slots[i].last_use < slot->last_use)
+			slot = &blob->slots[i];
+	}
+
+	slot->size = 0;
+	if (slot->capacity < len) {
+		char *data = realloc(slot->data, len);
+		if (!data)
+			return ENOMEM;
+		slot->data = data;
+		slot->capacity = len;
+	}
+
+	errno_t rc = bithenge_blob_read(blob->source, start, slot->data, &len);
+	if (rc != EOK)
+		return rc;
+	if (offset - start >= len)
+		return ELIMIT;
+
+	slot->offset = start;
+	slot->size = len;
+	slot->last_use = ++blob->clock;
+	blob->next_fill = start + len;
+	*out = slot;
+	return EOK;
+}
+
+static errno_t cached_read(bithenge_blob_t *base, aoff64_t offset,
+    char *buffer, aoff64_t *size)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	errno_t rc = cached_get_size(blob);
+	if (rc != EOK)
+		return rc;
+	if (offset > blob->size)
+		return ELIMIT;
+	*size = min(*size, blob->size - offset);
+
+	/* Large reads gain nothing from an extra copy. */
+	if (*size >= CACHE_BLOCK_SIZE)
+		return bithenge_blob_read(blob->source, offset, buffer, size);
+
+	aoff64_t done = 0;
+	while (done < *size) {
+		aoff64_t pos = offset + done;
+		cache_slot_t *slot = cached_lookup(blob, pos);
+		if (!slot) {
+			rc = cached_fill(blob, pos, &slot);
+			if (rc != EOK)
+				return rc;
+		}
+		aoff64_t amount = min(*size - done,
+		    slot->offset + slot->size - pos);
+		memcpy(buffer + done, slot->data + (pos - slot->offset),
+		    amount);
+		done += amount;
+	}
+	return EOK;
+}
+
+static void cached_destroy(bithenge_blob_t *base)
+{
+	cached_blob_t *blob = blob_as_cached(base);
+	for (int i = 0; i < CACHE_SLOTS; i++)
+		free(blob->slots[i].data);
+	bithenge_blob_dec_ref(blob->source);
+	free(blob);
+}
+
+static const bithenge_random_access_blob_ops_t cached_ops = {
+	.size = cached_size,
+	.read = cached_read,
+	.destroy = cached_destroy,
+};
+
+/** Create a blob that caches another blob's data in large aligned windows.
+ * Decoding usually issues many small reads at increasing offsets; this turns
+ * them into a few big reads of the source, which matters for files and block
+ * devices. Sources that cannot be read bytewise are returned unchanged. This
+ * function takes ownership of a reference to @a source.
+ * @memberof bithenge_blob_t
+ * @param[out] out Stores the created blob node. On error, this is unchanged.
+ * @param[in] source The blob to cache.
+ * @return EOK on success or an error code from errno.h.
+ */
+errno_t bithenge_new_cached_blob(bithenge_node_t **out,
+    bithenge_blob_t *source)
+{
+	assert(out);
+	assert(source);
+	if (!source->base.blob_ops->read) {
+		*out = bithenge_blob_as_node(source);
+		return EOK;
+	}
+
+	cached_blob_t *blob = malloc(sizeof(*blob));
+	if (!blob) {
+		bithenge_blob_dec_ref(source);
+		return ENOMEM;
+	}
+	errno_t rc = bithenge_init_random_access_blob(cached_as_blob(blob),
+	    &cached_ops);
+	if (rc != EOK) {
+		free(blob);
+		bithenge_blob_dec_ref(source);
+		return rc;
+	}
+	blob->source = source;
+	blob->size = 0;
+	blob->size_known = false;
+	for (int i = 0; i < CACHE_SLOTS; i++) {
+		blob->slots[i].data = NULL;
+		blob->slots[i].capacity = 0;
+		blob->slots[i].offset = 0;
+		blob->slots[i].size = 0;
+		blob->slots[i].last_use = 0;
+	}
+	blob->clock = 0;
+	blob->next_fill = 0;
+	blob->window = 1;
+	*out = bithenge_blob_as_node(cached_as_blob(blob));
+	return EOK;
+}
+
 /** Check whether the contents of two blobs are equal.
  * @memberof bithenge_blob_t
  * @param[out] out Holds whether the blobs are equal.
@@ -39,8 +39,14 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <vfs/vfs.h>
 #include <stddef.h>
+#ifdef __HELENOS__
+#include <vfs/vfs.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "common.h"
 #include <bithenge/blob.h>
 #include <bithenge/file.h>
@@ -76,18 +82,42 @@ static errno_t file_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	if (offset > blob->size)
 		return ELIMIT;
 
+#ifdef __HELENOS__
 	size_t amount_read;
 	errno_t rc = vfs_read(blob->fd, &offset, buffer, *size, &amount_read);
 	if (rc != EOK)
-		return errno;
-	*size += amount_read;
+		return rc;
+	*size = amount_read;
+#else
+	aoff64_t amount_read = 0;
+	while (amount_read < *size) {
+		ssize_t rc = pread(blob->fd, buffer + amount_read,
+		    *size - amount_read, offset + amount_read);
+		if (rc < 0)
+			return errno;
+		if (rc == 0)
+			break;
+		amount_read += rc;
+	}
+	*size = amount_read;
+#endif
 	return EOK;
 }
 
+static void file_close(int fd)
+{
+#ifdef __HELENOS__
+	vfs_put(fd);
+#else
+	close(fd);
+#endif
+}
+
 static void file_destroy(bithenge_blob_t *base)
 {
 	file_blob_t *blob = blob_as_file(base);
-	vfs_put(blob->fd);
+	if (blob->needs_close)
+		file_close(blob->fd);
 	free(blob);
 }
 
@@ -101,26 +131,36 @@ static errno_t new_file_blob(bithenge_node_t **out, int fd, bool needs_close)
 {
 	assert(out);
 
+#ifdef __HELENOS__
 	vfs_stat_t stat;
 	errno_t rc = vfs_stat(fd, &stat);
 	if (rc != EOK) {
 		if (needs_close)
-			vfs_put(fd);
+			file_close(fd);
+		return rc;
+	}
+#else
+	struct stat stat;
+	errno_t rc = fstat(fd, &stat) == 0 ? EOK : errno;
+	if (rc != EOK) {
+		if (needs_close)
+			file_close(fd);
 		return rc;
 	}
+#endif
 
 	// Create blob
 	file_blob_t *blob = malloc(sizeof(*blob));
 	if (!blob) {
 		if (needs_close)
-			vfs_put(fd);
+			file_close(fd);
 		return ENOMEM;
 	}
 	rc = bithenge_init_random_access_blob(file_as_blob(blob), &file_ops);
 	if (rc != EOK) {
 		free(blob);
 		if (needs_close)
-			vfs_put(fd);
+			file_close(fd);
 		return rc;
 	}
 	blob->fd = fd;
@@ -146,9 +186,15 @@ errno_t bithenge_new_file_blob(bithenge_node_t **out, const char *filename)
 	assert(filename);
 
 	int fd;
+#ifdef __HELENOS__
 	errno_t rc = vfs_lookup_open(filename, WALK_REGULAR, MODE_READ, &fd);
 	if (rc != EOK)
 		return rc;
+#else
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return errno;
+#endif
 
 	return new_file_blob(out, fd, true);
 }
@@ -29,6 +29,7 @@
 #ifndef BITHENGE_LINUX_COMMON_H_
 #define BITHENGE_LINUX_COMMON_H_
 
+#include <bithenge/os.h>
 #include <endian.h>
 #include <errno.h>
 #include <inttypes.h>
@@ -41,12 +42,8 @@
 #define max(aleph, bet) ((aleph) > (bet) ? (aleph) : (bet))
 #define min(aleph, bet) ((aleph) < (bet) ? (aleph) : (bet))
 
-#define EOK 0
 #define ELIMIT EINVAL
 
-typedef intmax_t bithenge_int_t;
-#define BITHENGE_PRId PRIdMAX
-typedef uint64_t aoff64_t;
 typedef const char *string_iterator_t;
 
 static inline string_iterator_t string_iterator(const char *string)
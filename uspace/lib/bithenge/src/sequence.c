@@ -50,6 +50,7 @@ typedef struct {
 	bithenge_scope_t *scope;
 	aoff64_t *ends;
 	size_t num_ends;
+	size_t ends_capacity;
 	bool end_on_empty;
 	bithenge_int_t num_xforms;
 } seq_node_t;
@@ -69,6 +70,21 @@ static seq_node_t *node_as_seq(bithenge_node_t *node)
 	return (seq_node_t *)node;
 }
 
+/** Make room for one more entry in @a ends. The array grows geometrically,
+ * so long repeats do not reallocate it once per element. */
+static errno_t seq_node_reserve_end(seq_node_t *self)
+{
+	if (self->num_ends < self->ends_capacity)
+		return EOK;
+	size_t capacity = self->ends_capacity ? 2 * self->ends_capacity : 16;
+	aoff64_t *new_ends = realloc(self->ends, capacity * sizeof(*new_ends));
+	if (!new_ends)
+		return ENOMEM;
+	self->ends = new_ends;
+	self->ends_capacity = capacity;
+	return EOK;
+}
+
 static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t index)
 {
 	if (index == 0) {
@@ -118,13 +134,9 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 		if (rc != EOK)
 			return rc;
 
-		if (self->num_xforms == -1) {
-			aoff64_t *new_ends = realloc(self->ends,
-			    (self->num_ends + 1) * sizeof(*new_ends));
-			if (!new_ends)
-				return ENOMEM;
-			self->ends = new_ends;
-		}
+		rc = seq_node_reserve_end(self);
+		if (rc != EOK)
+			return rc;
 
 		prev_offset = self->ends[self->num_ends] =
 		    prev_offset + field_size;
@@ -183,13 +195,9 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 		if (rc != EOK)
 			return rc;
 
-		if (self->num_xforms == -1) {
-			aoff64_t *new_ends = realloc(self->ends,
-			    (self->num_ends + 1) * sizeof(*new_ends));
-			if (!new_ends)
-				return ENOMEM;
-			self->ends = new_ends;
-		}
+		rc = seq_node_reserve_end(self);
+		if (rc != EOK)
+			return rc;
 		self->ends[self->num_ends++] = start_pos + size;
 	} else {
 		aoff64_t end_pos;
@@ -259,8 +267,11 @@ static errno_t seq_node_init(seq_node_t *self, const seq_node_ops_t *ops,
 		self->ends = malloc(sizeof(*self->ends) * num_xforms);
 		if (!self->ends)
 			return ENOMEM;
-	} else
+		self->ends_capacity = num_xforms;
+	} else {
 		self->ends = NULL;
+		self->ends_capacity = 0;
+	}
 	bithenge_blob_inc_ref(blob);
 	self->blob = blob;
 	self->num_xforms = num_xforms;
@@ -294,6 +305,8 @@ typedef struct {
 	seq_node_t base;
 	struct_transform_t *transform;
 	bool prefix;
+	/** Memoized results of fields that do not depend on a scope. */
+	bithenge_node_t **fields;
 } struct_node_t;
 
 static seq_node_t *struct_as_seq(struct_node_t *node)
@@ -316,6 +329,30 @@ static struct_node_t *node_as_struct(bithenge_node_t *node)
 	return seq_as_struct(node_as_seq(node));
 }
 
+static errno_t struct_node_field(struct_node_t *self, bithenge_node_t **out,
+    bithenge_int_t index)
+{
+	if (self->fields[index]) {
+		bithenge_node_inc_ref(self->fields[index]);
+		*out = self->fields[index];
+		return EOK;
+	}
+	errno_t rc = seq_node_subtransform(struct_as_seq(self), out, index);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Internal nodes and blobs may hold a reference to a scope, which
+	 * could form a cycle through this node, so only keep simple values.
+	 */
+	bithenge_node_type_t type = bithenge_node_type(*out);
+	if (type != BITHENGE_NODE_INTERNAL && type != BITHENGE_NODE_BLOB) {
+		bithenge_node_inc_ref(*out);
+		self->fields[index] = *out;
+	}
+	return EOK;
+}
+
 static errno_t struct_node_for_each(bithenge_node_t *base,
     bithenge_for_each_func_t func, void *data)
 {
@@ -326,8 +363,7 @@ static errno_t struct_node_for_each(bithenge_node_t *base,
 
 	for (bithenge_int_t i = 0; subxforms[i].transform; i++) {
 		bithenge_node_t *subxform_result;
-		rc = seq_node_subtransform(struct_as_seq(self),
-		    &subxform_result, i);
+		rc = struct_node_field(self, &subxform_result, i);
 		if (rc != EOK)
 			return rc;
 
@@ -379,7 +415,7 @@ static errno_t struct_node_get(bithenge_node_t *base, bithenge_node_t *key,
 	    self->transform->subtransforms;
 	for (bithenge_int_t i = 0; subxforms[i].transform; i++) {
 		if (subxforms[i].name && !str_cmp(name, subxforms[i].name)) {
-			rc = seq_node_subtransform(struct_as_seq(self), out, i);
+			rc = struct_node_field(self, out, i);
 			goto end;
 		}
 	}
@@ -388,8 +424,7 @@ static errno_t struct_node_get(bithenge_node_t *base, bithenge_node_t *key,
 		if (subxforms[i].name)
 			continue;
 		bithenge_node_t *subxform_result;
-		rc = seq_node_subtransform(struct_as_seq(self),
-		    &subxform_result, i);
+		rc = struct_node_field(self, &subxform_result, i);
 		if (rc != EOK)
 			goto end;
 		if (bithenge_node_type(subxform_result) !=
@@ -450,6 +485,9 @@ static void struct_node_destroy(bithenge_node_t *base)
 		seq_node_destroy(struct_as_seq(node));
 	}
 
+	for (size_t i = 0; i < node->transform->num_subtransforms; i++)
+		bithenge_node_dec_ref(node->fields[i]);
+	free(node->fields);
 	bithenge_transform_dec_ref(struct_as_transform(node->transform));
 	free(node);
 }
@@ -480,16 +518,23 @@ static errno_t struct_transform_make_node(struct_transform_t *self,
 	struct_node_t *node = malloc(sizeof(*node));
 	if (!node)
 		return ENOMEM;
+	node->fields = calloc(self->num_subtransforms, sizeof(*node->fields));
+	if (!node->fields && self->num_subtransforms) {
+		free(node);
+		return ENOMEM;
+	}
 
 	errno_t rc = bithenge_init_internal_node(struct_as_node(node),
 	    &struct_node_ops);
 	if (rc != EOK) {
+		free(node->fields);
 		free(node);
 		return rc;
 	}
 	bithenge_scope_t *inner;
 	rc = bithenge_scope_new(&inner, scope);
 	if (rc != EOK) {
+		free(node->fields);
 		free(node);
 		return rc;
 	}
@@ -498,6 +543,7 @@ static errno_t struct_transform_make_node(struct_transform_t *self,
 	    blob, self->num_subtransforms, false);
 	if (rc != EOK) {
 		bithenge_scope_dec_ref(inner);
+		free(node->fields);
 		free(node);
 		return rc;
 	}
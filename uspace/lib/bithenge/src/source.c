@@ -78,6 +78,18 @@ static errno_t blob_from_hex(bithenge_node_t **out, const char *hex)
 	return bithenge_new_blob_from_buffer(out, buffer, size, true);
 }
 
+/* Files and block devices are expensive to read in small pieces, so decode
+ * them through a cache. */
+static errno_t new_cached_file_blob(bithenge_node_t **out,
+    const char *filename)
+{
+	bithenge_node_t *node;
+	errno_t rc = bithenge_new_file_blob(&node, filename);
+	if (rc != EOK)
+		return rc;
+	return bithenge_new_cached_blob(out, bithenge_node_as_blob(node));
+}
+
 /** Create a node from a source described with a string. For instance,
  * "hex:55aa" will result in a blob node. If there is no colon in the string,
  * it is assumed to be a filename.
@@ -90,7 +102,7 @@ errno_t bithenge_node_from_source(bithenge_node_t **out, const char *source)
 	if (str_chr(source, ':')) {
 		if (!str_lcmp(source, "file:", 5)) {
 			// Example: file:/textdemo
-			return bithenge_new_file_blob(out, source + 5);
+			return new_cached_file_blob(out, source + 5);
 #ifdef __HELENOS__
 		} else if (!str_lcmp(source, "block:", 6)) {
 			// Example: block:bd/initrd
@@ -98,7 +110,12 @@ errno_t bithenge_node_from_source(bithenge_node_t **out, const char *source)
 			errno_t rc = loc_service_get_id(source + 6, &service_id, 0);
 			if (rc != EOK)
 				return rc;
-			return bithenge_new_block_blob(out, service_id);
+			bithenge_node_t *node;
+			rc = bithenge_new_block_blob(&node, service_id);
+			if (rc != EOK)
+				return rc;
+			return bithenge_new_cached_blob(out,
+			    bithenge_node_as_blob(node));
 #endif
 		} else if (!str_lcmp(source, "hex:", 4)) {
 			// Example: hex:04000000
@@ -107,7 +124,7 @@ errno_t bithenge_node_from_source(bithenge_node_t **out, const char *source)
 			return EINVAL;
 		}
 	}
-	return bithenge_new_file_blob(out, source);
+	return new_cached_file_blob(out, source);
 }
 
 /** @}
@@ -45,11 +45,98 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/rtld_arch.h>
 
+#include "../../../../generic/private/rtld.h"
+
+extern void rtld_lazy_bind_tramp(void);
+extern uint32_t rtld_lazy_bind(module_t *, size_t);
+
 void module_process_pre_arch(module_t *m)
 {
 	/* Unused */
 }
 
+/** Prepare the PLT of a module for lazy binding.
+ *
+ * Each JUMP_SLOT entry in the GOT initially points back into its own PLT
+ * entry, right after the indirect jump, so it only needs to be relocated.
+ * The first PLT entry pushes GOT[1] and jumps to GOT[2], which we set up
+ * to pass the module to the resolver trampoline.
+ *
+ * @return @c true if lazy binding has been set up, @c false if PLT
+ *         relocations need to be processed eagerly.
+ */
+bool module_lazy_bind_arch(module_t *m)
+{
+	elf_rel_t *rt = m->dyn.jmp_rel;
+	uint32_t *got = m->dyn.plt_got;
+	size_t rt_entries;
+	size_t i;
+
+	if (got == NULL || m->dyn.plt_rel != DT_REL)
+		return false;
+
+	rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rel_t);
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF32_R_TYPE(rt[i].r_info) != R_386_JUMP_SLOT)
+			return false;
+	}
+
+	for (i = 0; i < rt_entries; ++i)
+		*(uint32_t *)(rt[i].r_offset + m->bias) += m->bias;
+
+	got[1] = (uint32_t) m;
+	got[2] = (uint32_t) rtld_lazy_bind_tramp;
+
+	DPRINTF("%zu PLT entries set up for lazy binding\n", rt_entries);
+	return true;
+}
+
+/** Resolve a PLT entry on its first call.
+ *
+ * Called from rtld_lazy_bind_tramp.
+ *
+ * @param m Module whose PLT is being resolved
+ * @param offset Byte offset of the relocation in the PLT relocation table
+ * @return Address of the function definition
+ */
+uint32_t rtld_lazy_bind(module_t *m, size_t offset)
+{
+	elf_rel_t *rel = (elf_rel_t *) ((uint8_t *) m->dyn.jmp_rel + offset);
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_symbol_t *sym;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	uint32_t sym_addr;
+	const char *name;
+
+	sym = &sym_table[ELF32_R_SYM(rel->r_info)];
+	name = m->dyn.str_tab + sym->st_name;
+
+	/*
+	 * Can be called from any thread at any time. Do not touch the
+	 * symbol cache, which is not synchronized, and keep dlopen() from
+	 * modifying the list of modules while it is being searched.
+	 */
+	rtld_modules_lock();
+	sym_def = symbol_def_find(name, m, ssf_nocache, &dest);
+	rtld_modules_unlock();
+
+	if (sym_def == NULL) {
+		/*
+		 * Report the missing definition just like eager binding does.
+		 * Unlike eager binding, there is no way to go on without a
+		 * target of the call, so do not return into the caller.
+		 */
+		printf("Definition of '%s' not found.\n", name);
+		abort();
+	}
+
+	sym_addr = (uint32_t) symbol_get_addr(sym_def, dest, NULL);
+	*(uint32_t *)(rel->r_offset + m->bias) = sym_addr;
+
+	return sym_addr;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table.
  */
@@ -115,6 +202,12 @@ void rel_table_process(module_t *m, elf_rel_t *rt, size_t rt_size)
 			} else {
 				printf("Definition of '%s' not found.\n",
 				    str_tab + sym->st_name);
+				/*
+				 * A call through the PLT entry faults instead
+				 * of jumping into the lazy binding stub.
+				 */
+				if (rel_type == R_386_JUMP_SLOT)
+					*r_ptr = 0;
 				continue;
 			}
 		} else {
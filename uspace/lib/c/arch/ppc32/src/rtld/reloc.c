@@ -59,6 +59,12 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+bool module_lazy_bind_arch(module_t *m)
+{
+	/* Lazy binding not supported, process PLT relocations eagerly */
+	return false;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table.
  */
@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+/*
+ * This is an implementation of a generic resizable open-addressing hash
+ * table.
+ *
+ * Pointers to the items are stored directly in an array of slots searched
+ * by linear probing. A separate array holds one control byte per slot,
+ * which marks the slot as empty or deleted or stores a 7-bit fragment of
+ * the hash of the item in the slot. Lookups therefore scan a small dense
+ * array and only touch items whose hash fragment matches. The full hash
+ * is cached in the item link, so the table can be resized without calling
+ * back to the user.
+ *
+ * Hashes supplied by the user are multiplied by a 64-bit odd constant
+ * (Fibonacci hashing) and the slot index is taken from the topmost bits of
+ * the product, the hash fragment from the bits just below the index. This
+ * spreads even sequential keys over the table of power-of-two size.
+ *
+ * Removed items leave deleted slots behind unless the following slot is
+ * empty. The table is rehashed when the non-empty slots take more than
+ * 7/8 of the table and shrunk when the items take less than 1/8.
+ */
+
+#include <adt/oa_hash_table.h>
+#include <assert.h>
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/* Binary logarithm of the minimal number of slots. */
+#define OA_MIN_ORDER  4
+/* Binary logarithm of the maximal number of slots. */
+#define OA_MAX_ORDER  min(64 - 7, sizeof(size_t) * 8 - 1)
+
+/* Control byte of an empty slot. */
+#define OA_EMPTY    0x80
+/* Control byte of a slot whose item was removed. */
+#define OA_DELETED  0xfe
+/* Mask of the hash fragment in the control byte of a full slot. */
+#define OA_FRAG_MASK  0x7f
+
+/* Multiplier used to mix the user supplied hashes (2^64 / phi). */
+#define OA_HASH_MUL  UINT64_C(0x9e3779b97f4a7c15)
+
+/** Return true if the control byte belongs to a slot holding an item. */
+static inline bool oa_full(uint8_t ctrl)
+{
+	return (ctrl & OA_EMPTY) == 0;
+}
+
+/** Mix the user supplied hash. */
+static inline uint64_t oa_mix(size_t hash)
+{
+	return (uint64_t) hash * OA_HASH_MUL;
+}
+
+/** Return the index of the first slot to probe for a mixed hash. */
+static inline size_t oa_index(unsigned int order, uint64_t hash)
+{
+	return (size_t) (hash >> (64 - order));
+}
+
+/** Return the hash fragment stored in the control byte for a mixed hash. */
+static inline uint8_t oa_frag(unsigned int order, uint64_t hash)
+{
+	return (uint8_t) (hash >> (64 - 7 - order)) & OA_FRAG_MASK;
+}
+
+/** Return the smallest order of a table holding @a cnt items at half load. */
+static unsigned int oa_order_for(size_t cnt)
+{
+	unsigned int order = OA_MIN_ORDER;
+
+	while (order < OA_MAX_ORDER && ((size_t) 1 << order) / 2 < cnt)
+		order++;
+
+	return order;
+}
+
+/** Allocate the arrays for a table with 2^order slots. */
+static bool oa_alloc(unsigned int order, oa_ht_link_t ***pslot,
+    uint8_t **pctrl)
+{
+	size_t slot_cnt = (size_t) 1 << order;
+
+	/* Keep both arrays in a single block, the pointers first. */
+	oa_ht_link_t **slot = malloc(slot_cnt * (sizeof(oa_ht_link_t *) + 1));
+	if (slot == NULL)
+		return false;
+
+	uint8_t *ctrl = (uint8_t *) (slot + slot_cnt);
+	memset(ctrl, OA_EMPTY, slot_cnt);
+
+	*pslot = slot;
+	*pctrl = ctrl;
+	return true;
+}
+
+/** Move all items to a new table with 2^order slots.
+ *
+ * @return True on success, false if the new table could not be allocated.
+ *
+ */
+static bool oa_rehash(oa_hash_table_t *h, unsigned int order)
+{
+	oa_ht_link_t **slot;
+	uint8_t *ctrl;
+
+	assert(!h->apply_ongoing);
+
+	if (!oa_alloc(order, &slot, &ctrl))
+		return false;
+
+	size_t mask = ((size_t) 1 << order) - 1;
+
+	for (size_t i = 0; i < h->slot_cnt; i++) {
+		if (!oa_full(h->ctrl[i]))
+			continue;
+
+		oa_ht_link_t *item = h->slot[i];
+		size_t idx = oa_index(order, item->hash);
+
+		/* There are no deleted slots in the new table. */
+		while (ctrl[idx] != OA_EMPTY)
+			idx = (idx + 1) & mask;
+
+		ctrl[idx] = oa_frag(order, item->hash);
+		slot[idx] = item;
+	}
+
+	free(h->slot);
+	h->slot = slot;
+	h->ctrl = ctrl;
+	h->slot_cnt = mask + 1;
+	h->order = order;
+	h->used_cnt = h->item_cnt;
+	return true;
+}
+
+/** Shrinks the table if the table is only sparely populated. */
+static void oa_shrink_if_needed(oa_hash_table_t *h)
+{
+	if (h->apply_ongoing || h->order <= OA_MIN_ORDER)
+		return;
+
+	if (h->item_cnt < h->slot_cnt / 8) {
+		/* Leave the table as is if we cannot resize. */
+		(void) oa_rehash(h, oa_order_for(h->item_cnt));
+	}
+}
+
+/** Make room for one more item.
+ *
+ * @return EOK on success, ENOMEM if the table is full and cannot be
+ *         resized.
+ *
+ */
+static errno_t oa_reserve(oa_hash_table_t *h)
+{
+	if (h->used_cnt + 1 <= h->slot_cnt / 8 * 7)
+		return EOK;
+
+	/*
+	 * Grow the table if it is getting full of items, otherwise just get
+	 * rid of the deleted slots.
+	 */
+	if (oa_rehash(h, oa_order_for(h->item_cnt + 1)))
+		return EOK;
+
+	/* Keep at least one empty slot to terminate the searches. */
+	if (h->used_cnt + 1 < h->slot_cnt)
+		return EOK;
+
+	return ENOMEM;
+}
+
+/** Store item in a free slot found on its probe sequence. */
+static void oa_store(oa_hash_table_t *h, size_t idx, oa_ht_link_t *item)
+{
+	assert(!oa_full(h->ctrl[idx]));
+
+	if (h->ctrl[idx] == OA_EMPTY)
+		h->used_cnt++;
+
+	h->ctrl[idx] = oa_frag(h->order, item->hash);
+	h->slot[idx] = item;
+	h->item_cnt++;
+}
+
+/** Remove the item from a slot.
+ *
+ * If no probe sequence can continue past the slot, the slot is made empty
+ * together with the deleted slots preceding it.
+ *
+ */
+static void oa_erase(oa_hash_table_t *h, size_t idx)
+{
+	size_t mask = h->slot_cnt - 1;
+
+	assert(oa_full(h->ctrl[idx]));
+
+	h->slot[idx] = NULL;
+	h->item_cnt--;
+
+	if (h->ctrl[(idx + 1) & mask] != OA_EMPTY) {
+		h->ctrl[idx] = OA_DELETED;
+		return;
+	}
+
+	do {
+		h->ctrl[idx] = OA_EMPTY;
+		h->used_cnt--;
+		idx = (idx - 1) & mask;
+	} while (h->ctrl[idx] == OA_DELETED);
+}
+
+/** Find the slot holding the item. The item must be in the table. */
+static size_t oa_find_slot(const oa_hash_table_t *h, oa_ht_link_t *item)
+{
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_index(h->order, item->hash);
+
+	while (!oa_full(h->ctrl[idx]) || h->slot[idx] != item) {
+		assert(h->ctrl[idx] != OA_EMPTY);
+		idx = (idx + 1) & mask;
+	}
+
+	return idx;
+}
+
+/** Create open-addressing hash table.
+ *
+ * @param h        Hash table structure. Will be initialized by this call.
+ * @param init_size Initial expected number of items. Pass zero if you want
+ *                 the default initial size.
+ * @param op       Hash table operations structure. remove_callback()
+ *                 is optional and can be NULL if no action is to be taken
+ *                 upon removal. equal() is optional if and only if
+ *                 oa_hash_table_insert_unique() and
+ *                 oa_hash_table_find_next() will never be invoked.
+ *                 All other operations are mandatory.
+ *
+ * @return True on success
+ *
+ */
+bool oa_hash_table_create(oa_hash_table_t *h, size_t init_size,
+    oa_hash_table_ops_t *op)
+{
+	assert(h);
+	assert(op && op->hash && op->key_hash && op->key_equal);
+
+	/* Check for compulsory ops. */
+	if (!op || !op->hash || !op->key_hash || !op->key_equal)
+		return false;
+
+	h->order = oa_order_for(init_size);
+	if (!oa_alloc(h->order, &h->slot, &h->ctrl))
+		return false;
+
+	h->op = op;
+	h->slot_cnt = (size_t) 1 << h->order;
+	h->item_cnt = 0;
+	h->used_cnt = 0;
+	h->apply_ongoing = false;
+	return true;
+}
+
+/** Removes all items and calls remove_callback() for them. */
+static void oa_clear_items(oa_hash_table_t *h)
+{
+	if (h->used_cnt == 0)
+		return;
+
+	for (size_t i = 0; i < h->slot_cnt; i++) {
+		if (oa_full(h->ctrl[i]) && h->op->remove_callback != NULL)
+			h->op->remove_callback(h->slot[i]);
+	}
+
+	memset(h->ctrl, OA_EMPTY, h->slot_cnt);
+	h->item_cnt = 0;
+	h->used_cnt = 0;
+}
+
+/** Destroy a hash table instance.
+ *
+ * @param h Hash table to be destroyed.
+ *
+ */
+void oa_hash_table_destroy(oa_hash_table_t *h)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	oa_clear_items(h);
+
+	free(h->slot);
+
+	h->slot = NULL;
+	h->ctrl = NULL;
+	h->slot_cnt = 0;
+}
+
+/** Returns true if there are no items in the table. */
+bool oa_hash_table_empty(oa_hash_table_t *h)
+{
+	assert(h && h->slot);
+	return h->item_cnt == 0;
+}
+
+/** Returns the number of items in the table. */
+size_t oa_hash_table_size(oa_hash_table_t *h)
+{
+	assert(h && h->slot);
+	return h->item_cnt;
+}
+
+/** Remove all elements from the hash table
+ *
+ * @param h Hash table to be cleared
+ */
+void oa_hash_table_clear(oa_hash_table_t *h)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	oa_clear_items(h);
+
+	/* Shrink the table to its minimum size if possible. */
+	if (OA_MIN_ORDER < h->order)
+		(void) oa_rehash(h, OA_MIN_ORDER);
+}
+
+/** Insert item into a hash table.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ *
+ * @return EOK on success, ENOMEM if the table is full and cannot grow.
+ */
+errno_t oa_hash_table_insert(oa_hash_table_t *h, oa_ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	errno_t rc = oa_reserve(h);
+	if (rc != EOK)
+		return rc;
+
+	item->hash = oa_mix(h->op->hash(item));
+
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_index(h->order, item->hash);
+
+	while (oa_full(h->ctrl[idx]))
+		idx = (idx + 1) & mask;
+
+	oa_store(h, idx, item);
+	return EOK;
+}
+
+/** Insert item into a hash table if not already present.
+ *
+ * @param h    Hash table.
+ * @param item Item to be inserted into the hash table.
+ *
+ * @return EOK if the inserted item was the only item with such a lookup key.
+ * @return EEXIST if such an item had already been inserted.
+ * @return ENOMEM if the table is full and cannot grow.
+ */
+errno_t oa_hash_table_insert_unique(oa_hash_table_t *h, oa_ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(h->op && h->op->hash && h->op->equal);
+	assert(!h->apply_ongoing);
+
+	errno_t rc = oa_reserve(h);
+	if (rc != EOK)
+		return rc;
+
+	item->hash = oa_mix(h->op->hash(item));
+
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_index(h->order, item->hash);
+	uint8_t frag = oa_frag(h->order, item->hash);
+	size_t free_idx = h->slot_cnt;
+
+	/* Check for duplicates and remember the first free slot. */
+	while (h->ctrl[idx] != OA_EMPTY) {
+		if (h->ctrl[idx] == frag && h->slot[idx]->hash == item->hash &&
+		    h->op->equal(h->slot[idx], item))
+			return EEXIST;
+
+		if (h->ctrl[idx] == OA_DELETED && free_idx == h->slot_cnt)
+			free_idx = idx;
+
+		idx = (idx + 1) & mask;
+	}
+
+	oa_store(h, (free_idx != h->slot_cnt) ? free_idx : idx, item);
+	return EOK;
+}
+
+/** Search hash table for an item matching keys.
+ *
+ * @param h   Hash table.
+ * @param key Array of all keys needed to compute hash index.
+ *
+ * @return Matching item on success, NULL if there is no such item.
+ *
+ */
+oa_ht_link_t *oa_hash_table_find(const oa_hash_table_t *h, const void *key)
+{
+	assert(h && h->slot);
+
+	uint64_t hash = oa_mix(h->op->key_hash(key));
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_index(h->order, hash);
+	uint8_t frag = oa_frag(h->order, hash);
+
+	while (h->ctrl[idx] != OA_EMPTY) {
+		/*
+		 * Only items with a matching hash fragment and hash are
+		 * compared with the key.
+		 */
+		if (h->ctrl[idx] == frag && h->slot[idx]->hash == hash &&
+		    h->op->key_equal(key, h->slot[idx]))
+			return h->slot[idx];
+
+		idx = (idx + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/** Find the next item equal to item.
+ *
+ * @param h    Hash table.
+ * @param item Item in the table, as returned by oa_hash_table_find()
+ *             or a previous call to this function.
+ *
+ * @return Next item with the same lookup key or NULL if there is none.
+ *
+ */
+oa_ht_link_t *oa_hash_table_find_next(const oa_hash_table_t *h,
+    oa_ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+	assert(h->op->equal);
+
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_find_slot(h, item);
+	uint8_t frag = h->ctrl[idx];
+
+	/* Equal items follow the item on the same probe sequence. */
+	idx = (idx + 1) & mask;
+	while (h->ctrl[idx] != OA_EMPTY) {
+		if (h->ctrl[idx] == frag && h->slot[idx]->hash == item->hash &&
+		    h->op->equal(h->slot[idx], item))
+			return h->slot[idx];
+
+		idx = (idx + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/** Remove all matching items from hash table.
+ *
+ * For each removed item, h->remove_callback() is called.
+ *
+ * @param h    Hash table.
+ * @param key  Array of keys that will be compared against items of
+ *             the hash table.
+ *
+ * @return Returns the number of removed items.
+ */
+size_t oa_hash_table_remove(oa_hash_table_t *h, const void *key)
+{
+	assert(h && h->slot);
+	assert(!h->apply_ongoing);
+
+	uint64_t hash = oa_mix(h->op->key_hash(key));
+	size_t mask = h->slot_cnt - 1;
+	size_t idx = oa_index(h->order, hash);
+	uint8_t frag = oa_frag(h->order, hash);
+	size_t removed = 0;
+
+	while (h->ctrl[idx] != OA_EMPTY) {
+		if (h->ctrl[idx] == frag && h->slot[idx]->hash == hash &&
+		    h->op->key_equal(key, h->slot[idx])) {
+			oa_ht_link_t *item = h->slot[idx];
+
+			oa_erase(h, idx);
+			++removed;
+
+			if (h->op->remove_callback != NULL)
+				h->op->remove_callback(item);
+		}
+
+		idx = (idx + 1) & mask;
+	}
+
+	oa_shrink_if_needed(h);
+	return removed;
+}
+
+/** Removes an item already present in the table. The item must be in the table.*/
+void oa_hash_table_remove_item(oa_hash_table_t *h, oa_ht_link_t *item)
+{
+	assert(item);
+	assert(h && h->slot);
+
+	oa_erase(h, oa_find_slot(h, item));
+
+	if (h->op->remove_callback != NULL)
+		h->op->remove_callback(item);
+
+	oa_shrink_if_needed(h);
+}
+
+/** Apply function to all items in hash table.
+ *
+ * @param h   Hash table.
+ * @param f   Function to be applied. Return false if no more items
+ *            should be visited. The functor may only delete the supplied
+ *            item.
+ * @param arg Argument to be passed to the function.
+ */
+void oa_hash_table_apply(oa_hash_table_t *h,
+    bool (*f)(oa_ht_link_t *, void *), void *arg)
+{
+	assert(f);
+	assert(h && h->slot);
+
+	if (h->item_cnt == 0)
+		return;
+
+	h->apply_ongoing = true;
+
+	/* Removing an item never moves the other items between slots. */
+	for (size_t idx = 0; idx < h->slot_cnt; ++idx) {
+		if (oa_full(h->ctrl[idx]) && !f(h->slot[idx], arg))
+			break;
+	}
+
+	h->apply_ongoing = false;
+
+	oa_shrink_if_needed(h);
+}
+
+/** @}
+ */
@@ -140,8 +140,29 @@ typedef struct {
 	ipc_call_t *dataptr;
 
 	errno_t retval;
+
+	/** Completion group the message belongs to or NULL. */
+	async_group_t *group;
+
+	/** Group member argument. */
+	void *group_arg;
+
+	/** Link into the pending or done list of the group. */
+	link_t group_link;
 } amsg_t;
 
+/** Completion group */
+struct async_group {
+	/** Messages whose replies have not arrived yet */
+	list_t pending;
+
+	/** Messages whose replies have arrived */
+	list_t done;
+
+	/** Notified whenever a reply of a pending message arrives */
+	fibril_event_t completed;
+};
+
 static amsg_t *amsg_create(void)
 {
 	return calloc(1, sizeof(amsg_t));
@@ -152,20 +173,62 @@ static void amsg_destroy(amsg_t *msg)
 	free(msg);
 }
 
-/** Mutex protecting inactive_exch_list and avail_phone_cv.
+/** Mutex protecting phone accounting.
+ *
+ * Protects phone_sess_list, phone_wait_list and the avail_phone_cv
+ * wait queues of all sessions. Starting and finishing an exchange does
+ * not need it unless the task runs out of phones.
  *
  */
 static FIBRIL_MUTEX_INITIALIZE(async_sess_mutex);
 
-/** List of all currently inactive exchanges.
+/** List of all sessions which own data phones of parallel exchanges.
  *
  */
-static LIST_INITIALIZE(inactive_exch_list);
+static LIST_INITIALIZE(phone_sess_list);
 
-/** Condition variable to wait for a phone to become available.
+/** List of all sessions with fibrils waiting for a phone.
  *
  */
-static FIBRIL_CONDVAR_INITIALIZE(avail_phone_cv);
+static LIST_INITIALIZE(phone_wait_list);
+
+/** Number of fibrils waiting for a phone in all sessions.
+ *
+ */
+static atomic_int phone_waiters;
+
+/** Initialize a new session.
+ *
+ * @param sess  Session structure.
+ * @param iface Session interface or zero.
+ * @param mgmt  Exchange management style.
+ * @param phone Session phone.
+ *
+ */
+void async_sess_init_internal(async_sess_t *sess, iface_t iface,
+    exch_mgmt_t mgmt, cap_phone_handle_t phone)
+{
+	sess->iface = iface;
+	sess->mgmt = mgmt;
+	sess->phone = phone;
+	sess->arg1 = iface;
+	sess->arg2 = 0;
+	sess->arg3 = 0;
+
+	atomic_init(&sess->exch_cache, NULL);
+	list_initialize(&sess->exch_list);
+	fibril_mutex_initialize(&sess->exch_mtx);
+	fibril_mutex_initialize(&sess->mutex);
+	atomic_init(&sess->exchanges, 0);
+
+	link_initialize(&sess->global_link);
+	fibril_condvar_initialize(&sess->avail_phone_cv);
+	sess->phone_waiters = 0;
+	link_initialize(&sess->wait_link);
+
+	fibril_mutex_initialize(&sess->remote_state_mtx);
+	sess->remote_state_data = NULL;
+}
 
 /** Initialize the async framework.
  *
@@ -175,19 +238,7 @@ void __async_client_init(void)
 	if (fibril_rmutex_initialize(&message_mutex) != EOK)
 		abort();
 
-	session_ns.iface = 0;
-	session_ns.mgmt = EXCHANGE_ATOMIC;
-	session_ns.phone = PHONE_NS;
-	session_ns.arg1 = 0;
-	session_ns.arg2 = 0;
-	session_ns.arg3 = 0;
-
-	fibril_mutex_initialize(&session_ns.remote_state_mtx);
-	session_ns.remote_state_data = NULL;
-
-	list_initialize(&session_ns.exch_list);
-	fibril_mutex_initialize(&session_ns.mutex);
-	session_ns.exchanges = 0;
+	async_sess_init_internal(&session_ns, 0, EXCHANGE_ATOMIC, PHONE_NS);
 }
 
 void __async_client_fini(void)
@@ -225,6 +276,10 @@ void async_reply_received(ipc_call_t *data)
 
 	if (msg->forget) {
 		amsg_destroy(msg);
+	} else if (msg->group != NULL) {
+		list_remove(&msg->group_link);
+		list_append(&msg->group_link, &msg->group->done);
+		fibril_notify(&msg->group->completed);
 	} else {
 		fibril_notify(&msg->received);
 	}
@@ -448,6 +503,177 @@ void async_forget(aid_t amsgid)
 	fibril_rmutex_unlock(&message_mutex);
 }
 
+/** Create a completion group.
+ *
+ * A completion group collects messages sent by the async framework so
+ * that the caller can keep several requests in flight and then wait for
+ * any or all of them to complete.
+ *
+ * @return New completion group or NULL if out of memory.
+ *
+ */
+async_group_t *async_group_create(void)
+{
+	async_group_t *group = calloc(1, sizeof(async_group_t));
+	if (group == NULL)
+		return NULL;
+
+	list_initialize(&group->pending);
+	list_initialize(&group->done);
+	group->completed = FIBRIL_EVENT_INIT;
+
+	return group;
+}
+
+/** Destroy a completion group.
+ *
+ * Messages which have not been waited for are forgotten as if
+ * async_forget() was called on them.
+ *
+ * @param group Completion group.
+ *
+ */
+void async_group_destroy(async_group_t *group)
+{
+	if (group == NULL)
+		return;
+
+	fibril_rmutex_lock(&message_mutex);
+
+	while (!list_empty(&group->pending)) {
+		amsg_t *msg = list_get_instance(list_first(&group->pending),
+		    amsg_t, group_link);
+
+		list_remove(&msg->group_link);
+		msg->group = NULL;
+		msg->dataptr = NULL;
+		msg->forget = true;
+	}
+
+	while (!list_empty(&group->done)) {
+		amsg_t *msg = list_get_instance(list_first(&group->done),
+		    amsg_t, group_link);
+
+		list_remove(&msg->group_link);
+		amsg_destroy(msg);
+	}
+
+	fibril_rmutex_unlock(&message_mutex);
+
+	free(group);
+}
+
+/** Add a message to a completion group.
+ *
+ * Once added, the message must not be passed to async_wait_for(),
+ * async_wait_timeout() or async_forget(). It is consumed by
+ * async_group_wait_any(), async_group_wait_all() or
+ * async_group_destroy() instead.
+ *
+ * @param group  Completion group.
+ * @param amsgid Hash of the message to add.
+ * @param arg    Argument returned by async_group_wait_any() once the
+ *               message completes.
+ *
+ * @return EOK on success, ENOMEM if @a amsgid is zero (i.e. sending the
+ *         message failed for lack of memory).
+ *
+ */
+errno_t async_group_add(async_group_t *group, aid_t amsgid, void *arg)
+{
+	if (amsgid == 0)
+		return ENOMEM;
+
+	amsg_t *msg = (amsg_t *) amsgid;
+
+	assert(!msg->forget);
+	assert(msg->group == NULL);
+
+	fibril_rmutex_lock(&message_mutex);
+
+	msg->group = group;
+	msg->group_arg = arg;
+
+	if (msg->done) {
+		list_append(&msg->group_link, &group->done);
+		fibril_notify(&group->completed);
+	} else {
+		list_append(&msg->group_link, &group->pending);
+	}
+
+	fibril_rmutex_unlock(&message_mutex);
+
+	return EOK;
+}
+
+/** Wait for any message in a completion group.
+ *
+ * The completed message is removed from the group and destroyed.
+ *
+ * @param group  Completion group.
+ * @param rarg   If non-NULL, place to store the argument the message was
+ *               added with.
+ * @param retval If non-NULL, place to store the retval of the answer.
+ *
+ * @return EOK on success, ENOENT if the group is empty.
+ *
+ */
+errno_t async_group_wait_any(async_group_t *group, void **rarg,
+    errno_t *retval)
+{
+	while (true) {
+		fibril_rmutex_lock(&message_mutex);
+
+		if (!list_empty(&group->done)) {
+			amsg_t *msg = list_get_instance(list_first(&group->done),
+			    amsg_t, group_link);
+			list_remove(&msg->group_link);
+
+			fibril_rmutex_unlock(&message_mutex);
+
+			if (rarg)
+				*rarg = msg->group_arg;
+			if (retval)
+				*retval = msg->retval;
+
+			amsg_destroy(msg);
+			return EOK;
+		}
+
+		bool empty = list_empty(&group->pending);
+
+		fibril_rmutex_unlock(&message_mutex);
+
+		if (empty)
+			return ENOENT;
+
+		fibril_wait_for(&group->completed);
+	}
+}
+
+/** Wait for all messages in a completion group.
+ *
+ * All messages are removed from the group and destroyed.
+ *
+ * @param group Completion group.
+ *
+ * @return EOK if all messages were answered with EOK, otherwise the
+ *         first error returned by any of them.
+ *
+ */
+errno_t async_group_wait_all(async_group_t *group)
+{
+	errno_t rc = EOK;
+	errno_t retval;
+
+	while (async_group_wait_any(group, NULL, &retval) == EOK) {
+		if (rc == EOK)
+			rc = retval;
+	}
+
+	return rc;
+}
+
 /** Pseudo-synchronous message sending - fast version.
  *
  * Send message asynchronously and return only after the reply arrives.
@@ -844,16 +1070,10 @@ async_sess_t *async_connect_me_to(async_exch_t *exch, iface_t iface,
 		return NULL;
 	}
 
-	sess->iface = iface;
-	sess->phone = phone;
-	sess->arg1 = iface;
+	async_sess_init_internal(sess, iface, 0, phone);
 	sess->arg2 = arg2;
 	sess->arg3 = arg3;
 
-	fibril_mutex_initialize(&sess->remote_state_mtx);
-	list_initialize(&sess->exch_list);
-	fibril_mutex_initialize(&sess->mutex);
-
 	return sess;
 }
 
@@ -912,16 +1132,10 @@ async_sess_t *async_connect_me_to_blocking(async_exch_t *exch, iface_t iface,
 		return NULL;
 	}
 
-	sess->iface = iface;
-	sess->phone = phone;
-	sess->arg1 = iface;
+	async_sess_init_internal(sess, iface, 0, phone);
 	sess->arg2 = arg2;
 	sess->arg3 = arg3;
 
-	fibril_mutex_initialize(&sess->remote_state_mtx);
-	list_initialize(&sess->exch_list);
-	fibril_mutex_initialize(&sess->mutex);
-
 	return sess;
 }
 
@@ -944,13 +1158,7 @@ async_sess_t *async_connect_kbox(task_id_t id)
 		return NULL;
 	}
 
-	sess->iface = 0;
-	sess->mgmt = EXCHANGE_ATOMIC;
-	sess->phone = phone;
-
-	fibril_mutex_initialize(&sess->remote_state_mtx);
-	list_initialize(&sess->exch_list);
-	fibril_mutex_initialize(&sess->mutex);
+	async_sess_init_internal(sess, 0, EXCHANGE_ATOMIC, phone);
 
 	return sess;
 }
@@ -970,29 +1178,45 @@ static errno_t async_hangup_internal(cap_phone_handle_t phone)
 errno_t async_hangup(async_sess_t *sess)
 {
 	async_exch_t *exch;
+	bool reclaimed = false;
 
 	assert(sess);
 
 	fibril_mutex_lock(&async_sess_mutex);
 
-	if (sess->exchanges > 0) {
+	if (atomic_load(&sess->exchanges) > 0) {
 		fibril_mutex_unlock(&async_sess_mutex);
 		return EBUSY;
 	}
 
 	errno_t rc = async_hangup_internal(sess->phone);
 
+	if (link_in_use(&sess->global_link))
+		list_remove(&sess->global_link);
+
+	exch = atomic_exchange(&sess->exch_cache, NULL);
+	if (exch != NULL)
+		list_append(&exch->sess_link, &sess->exch_list);
+
 	while (!list_empty(&sess->exch_list)) {
 		exch = (async_exch_t *)
 		    list_get_instance(list_first(&sess->exch_list),
 		    async_exch_t, sess_link);
 
 		list_remove(&exch->sess_link);
-		list_remove(&exch->global_link);
-		async_hangup_internal(exch->phone);
+		if (exch->phone != sess->phone) {
+			async_hangup_internal(exch->phone);
+			reclaimed = true;
+		}
 		free(exch);
 	}
 
+	/* Let fibrils waiting for a phone in other sessions retry. */
+	if (reclaimed) {
+		list_foreach(phone_wait_list, wait_link, async_sess_t, waiting)
+			fibril_condvar_broadcast(&waiting->avail_phone_cv);
+	}
+
 	free(sess);
 
 	fibril_mutex_unlock(&async_sess_mutex);
@@ -1000,101 +1224,216 @@ errno_t async_hangup(async_sess_t *sess)
 	return rc;
 }
 
-/** Start new exchange in a session.
+/** Create a new exchange structure.
  *
- * @param session Session.
+ * @param sess  Session.
+ * @param phone Phone of the exchange.
  *
- * @return New exchange or NULL on error.
+ * @return New exchange or NULL if out of memory.
  *
  */
-async_exch_t *async_exchange_begin(async_sess_t *sess)
+static async_exch_t *async_exch_create(async_sess_t *sess,
+    cap_phone_handle_t phone)
 {
-	if (sess == NULL)
+	async_exch_t *exch = (async_exch_t *) malloc(sizeof(async_exch_t));
+	if (exch == NULL)
 		return NULL;
 
-	exch_mgmt_t mgmt = sess->mgmt;
-	if (sess->iface != 0)
-		mgmt = sess->iface & IFACE_EXCHANGE_MASK;
+	link_initialize(&exch->sess_link);
+	exch->sess = sess;
+	exch->phone = phone;
 
-	async_exch_t *exch = NULL;
+	return exch;
+}
 
-	fibril_mutex_lock(&async_sess_mutex);
+/** Take an inactive exchange from a session.
+ *
+ * The most recently finished exchange is taken without any locking,
+ * only the other inactive exchanges need the session's exch_mtx.
+ *
+ * @param sess Session.
+ *
+ * @return Inactive exchange or NULL if there is none.
+ *
+ */
+static async_exch_t *async_exch_get(async_sess_t *sess)
+{
+	async_exch_t *exch = atomic_exchange(&sess->exch_cache, NULL);
+	if (exch != NULL)
+		return exch;
+
+	fibril_mutex_lock(&sess->exch_mtx);
 
 	if (!list_empty(&sess->exch_list)) {
-		/*
-		 * There are inactive exchanges in the session.
-		 */
 		exch = (async_exch_t *)
 		    list_get_instance(list_first(&sess->exch_list),
 		    async_exch_t, sess_link);
 
 		list_remove(&exch->sess_link);
-		list_remove(&exch->global_link);
-	} else {
+	}
+
+	fibril_mutex_unlock(&sess->exch_mtx);
+
+	return exch;
+}
+
+/** Return an inactive exchange to its session.
+ *
+ * @param sess Session.
+ * @param exch Exchange which has just been finished.
+ *
+ */
+static void async_exch_put(async_sess_t *sess, async_exch_t *exch)
+{
+	async_exch_t *expected = NULL;
+
+	if (atomic_compare_exchange_strong(&sess->exch_cache, &expected, exch))
+		return;
+
+	fibril_mutex_lock(&sess->exch_mtx);
+	list_append(&exch->sess_link, &sess->exch_list);
+	fibril_mutex_unlock(&sess->exch_mtx);
+}
+
+/** Hang up an inactive data phone of some session.
+ *
+ * Must be called with async_sess_mutex held.
+ *
+ * @return True if a phone has been hung up, false if there is no
+ *         inactive data phone.
+ *
+ */
+static bool async_phone_reclaim(void)
+{
+	list_foreach(phone_sess_list, global_link, async_sess_t, sess) {
+		async_exch_t *exch = async_exch_get(sess);
+		if (exch != NULL) {
+			async_hangup_internal(exch->phone);
+			free(exch);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Create a parallel exchange with a new data phone.
+ *
+ * If the task runs out of phones, inactive data phones of other sessions
+ * are hung up. If there are none, wait until an exchange of this session
+ * is finished or until some other session makes a phone available.
+ *
+ * @param sess Session.
+ *
+ * @return New exchange or NULL on error.
+ *
+ */
+static async_exch_t *async_exch_connect(async_sess_t *sess)
+{
+	async_exch_t *exch;
+	cap_phone_handle_t phone;
+
+	errno_t rc = async_connect_me_to_internal(sess->phone, sess->arg1,
+	    sess->arg2, sess->arg3, 0, &phone);
+	if (rc == EOK) {
+		exch = async_exch_create(sess, phone);
+		if (exch == NULL) {
+			async_hangup_internal(phone);
+			return NULL;
+		}
+
+		fibril_mutex_lock(&async_sess_mutex);
+		if (!link_in_use(&sess->global_link))
+			list_append(&sess->global_link, &phone_sess_list);
+		fibril_mutex_unlock(&async_sess_mutex);
+
+		return exch;
+	}
+
+	fibril_mutex_lock(&async_sess_mutex);
+
+	/*
+	 * Announce the waiter before looking at the inactive exchanges
+	 * so that async_exchange_end() cannot miss it.
+	 */
+	atomic_fetch_add(&phone_waiters, 1);
+	if (sess->phone_waiters++ == 0)
+		list_append(&sess->wait_link, &phone_wait_list);
+
+	while (true) {
 		/*
-		 * There are no available exchanges in the session.
+		 * An exchange of this session might have been finished
+		 * in the meantime.
 		 */
-
-		if ((mgmt == EXCHANGE_ATOMIC) ||
-		    (mgmt == EXCHANGE_SERIALIZE)) {
-			exch = (async_exch_t *) malloc(sizeof(async_exch_t));
-			if (exch != NULL) {
-				link_initialize(&exch->sess_link);
-				link_initialize(&exch->global_link);
-				exch->sess = sess;
-				exch->phone = sess->phone;
-			}
-		} else if (mgmt == EXCHANGE_PARALLEL) {
-			cap_phone_handle_t phone;
-			errno_t rc;
-
-		retry:
-			/*
-			 * Make a one-time attempt to connect a new data phone.
-			 */
-			rc = async_connect_me_to_internal(sess->phone, sess->arg1,
-			    sess->arg2, sess->arg3, 0, &phone);
-			if (rc == EOK) {
-				exch = (async_exch_t *) malloc(sizeof(async_exch_t));
-				if (exch != NULL) {
-					link_initialize(&exch->sess_link);
-					link_initialize(&exch->global_link);
-					exch->sess = sess;
-					exch->phone = phone;
-				} else
-					async_hangup_internal(phone);
-			} else if (!list_empty(&inactive_exch_list)) {
-				/*
-				 * We did not manage to connect a new phone. But we
-				 * can try to close some of the currently inactive
-				 * connections in other sessions and try again.
-				 */
-				exch = (async_exch_t *)
-				    list_get_instance(list_first(&inactive_exch_list),
-				    async_exch_t, global_link);
-
-				list_remove(&exch->sess_link);
-				list_remove(&exch->global_link);
-				async_hangup_internal(exch->phone);
-				free(exch);
-				goto retry;
-			} else {
-				/*
-				 * Wait for a phone to become available.
-				 */
-				fibril_condvar_wait(&avail_phone_cv, &async_sess_mutex);
-				goto retry;
-			}
+		exch = async_exch_get(sess);
+		if (exch != NULL)
+			break;
+
+		rc = async_connect_me_to_internal(sess->phone, sess->arg1,
+		    sess->arg2, sess->arg3, 0, &phone);
+		if (rc == EOK) {
+			exch = async_exch_create(sess, phone);
+			if (exch == NULL)
+				async_hangup_internal(phone);
+			else if (!link_in_use(&sess->global_link))
+				list_append(&sess->global_link, &phone_sess_list);
+			break;
 		}
+
+		/*
+		 * We did not manage to connect a new phone. But we can try
+		 * to close some of the currently inactive connections in
+		 * other sessions and try again. Otherwise wait for a phone
+		 * to become available.
+		 */
+		if (!async_phone_reclaim())
+			fibril_condvar_wait(&sess->avail_phone_cv, &async_sess_mutex);
 	}
 
-	if (exch != NULL)
-		sess->exchanges++;
+	if (--sess->phone_waiters == 0)
+		list_remove(&sess->wait_link);
+	atomic_fetch_sub(&phone_waiters, 1);
 
 	fibril_mutex_unlock(&async_sess_mutex);
 
-	if (exch != NULL && mgmt == EXCHANGE_SERIALIZE)
-		fibril_mutex_lock(&sess->mutex);
+	return exch;
+}
+
+/** Start new exchange in a session.
+ *
+ * @param session Session.
+ *
+ * @return New exchange or NULL on error.
+ *
+ */
+async_exch_t *async_exchange_begin(async_sess_t *sess)
+{
+	if (sess == NULL)
+		return NULL;
+
+	exch_mgmt_t mgmt = sess->mgmt;
+	if (sess->iface != 0)
+		mgmt = sess->iface & IFACE_EXCHANGE_MASK;
+
+	async_exch_t *exch = async_exch_get(sess);
+	if (exch == NULL) {
+		/*
+		 * There are no available exchanges in the session.
+		 */
+
+		if ((mgmt == EXCHANGE_ATOMIC) ||
+		    (mgmt == EXCHANGE_SERIALIZE))
+			exch = async_exch_create(sess, sess->phone);
+		else if (mgmt == EXCHANGE_PARALLEL)
+			exch = async_exch_connect(sess);
+	}
+
+	if (exch != NULL) {
+		atomic_fetch_add(&sess->exchanges, 1);
+
+		if (mgmt == EXCHANGE_SERIALIZE)
+			fibril_mutex_lock(&sess->mutex);
+	}
 
 	return exch;
 }
@@ -1119,15 +1458,30 @@ void async_exchange_end(async_exch_t *exch)
 	if (mgmt == EXCHANGE_SERIALIZE)
 		fibril_mutex_unlock(&sess->mutex);
 
-	fibril_mutex_lock(&async_sess_mutex);
+	bool data_phone = (exch->phone != sess->phone);
 
-	sess->exchanges--;
+	async_exch_put(sess, exch);
 
-	list_append(&exch->sess_link, &sess->exch_list);
-	list_append(&exch->global_link, &inactive_exch_list);
-	fibril_condvar_signal(&avail_phone_cv);
+	/*
+	 * Wake up a fibril waiting for a phone. Prefer waiters in this
+	 * session, which can reuse the exchange directly.
+	 */
+	if (data_phone && atomic_load(&phone_waiters) > 0) {
+		fibril_mutex_lock(&async_sess_mutex);
+
+		if (sess->phone_waiters > 0) {
+			fibril_condvar_signal(&sess->avail_phone_cv);
+		} else if (!list_empty(&phone_wait_list)) {
+			async_sess_t *waiting = (async_sess_t *)
+			    list_get_instance(list_first(&phone_wait_list),
+			    async_sess_t, wait_link);
+			fibril_condvar_signal(&waiting->avail_phone_cv);
+		}
 
-	fibril_mutex_unlock(&async_sess_mutex);
+		fibril_mutex_unlock(&async_sess_mutex);
+	}
+
+	atomic_fetch_sub(&sess->exchanges, 1);
 }
 
 /** Wrapper for IPC_M_SHARE_IN calls using the async framework.
@@ -1237,6 +1591,23 @@ errno_t async_data_read_start(async_exch_t *exch, void *dst, size_t size)
 	    (sysarg_t) size);
 }
 
+/** Start IPC_M_DATA_WRITE using the async framework.
+ *
+ * @param exch    Exchange for sending the message.
+ * @param src     Address of the beginning of the source buffer.
+ * @param size    Size of the source buffer (in bytes).
+ * @param dataptr Storage of call data (arg 2 holds actual data size).
+ *
+ * @return Hash of the sent message or 0 on error.
+ *
+ */
+aid_t async_data_write(async_exch_t *exch, const void *src, size_t size,
+    ipc_call_t *dataptr)
+{
+	return async_send_2(exch, IPC_M_DATA_WRITE, (sysarg_t) src,
+	    (sysarg_t) size, dataptr);
+}
+
 /** Wrapper for IPC_M_DATA_WRITE calls using the async framework.
  *
  * @param exch Exchange for sending the message.
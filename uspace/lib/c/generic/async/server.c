@@ -105,6 +105,7 @@
 #include <ipc/event.h>
 #include <fibril.h>
 #include <adt/hash_table.h>
+#include <adt/oa_hash_table.h>
 #include <adt/hash.h>
 #include <adt/list.h>
 #include <assert.h>
@@ -125,7 +126,7 @@
 
 /* Client connection data */
 typedef struct {
-	ht_link_t link;
+	oa_ht_link_t link;
 
 	task_id_t in_task_id;
 	int refcnt;
@@ -216,7 +217,7 @@ void async_set_client_data_destructor(async_client_data_dtor_t dtor)
 }
 
 static fibril_rmutex_t client_mutex;
-static hash_table_t client_hash_table;
+static oa_hash_table_t client_hash_table;
 
 // TODO: lockfree notification_queue?
 static fibril_rmutex_t notification_mutex;
@@ -236,21 +237,21 @@ static size_t client_key_hash(const void *key)
 	return *in_task_id;
 }
 
-static size_t client_hash(const ht_link_t *item)
+static size_t client_hash(const oa_ht_link_t *item)
 {
-	client_t *client = hash_table_get_inst(item, client_t, link);
+	client_t *client = oa_hash_table_get_inst(item, client_t, link);
 	return client_key_hash(&client->in_task_id);
 }
 
-static bool client_key_equal(const void *key, const ht_link_t *item)
+static bool client_key_equal(const void *key, const oa_ht_link_t *item)
 {
 	const task_id_t *in_task_id = key;
-	client_t *client = hash_table_get_inst(item, client_t, link);
+	client_t *client = oa_hash_table_get_inst(item, client_t, link);
 	return *in_task_id == client->in_task_id;
 }
 
 /** Operations for the client hash table. */
-static hash_table_ops_t client_hash_table_ops = {
+static oa_hash_table_ops_t client_hash_table_ops = {
 	.hash = client_hash,
 	.key_hash = client_key_hash,
 	.key_equal = client_key_equal,
@@ -263,9 +264,9 @@ static client_t *async_client_get(task_id_t client_id, bool create)
 	client_t *client = NULL;
 
 	fibril_rmutex_lock(&client_mutex);
-	ht_link_t *link = hash_table_find(&client_hash_table, &client_id);
+	oa_ht_link_t *link = oa_hash_table_find(&client_hash_table, &client_id);
 	if (link) {
-		client = hash_table_get_inst(link, client_t, link);
+		client = oa_hash_table_get_inst(link, client_t, link);
 		client->refcnt++;
 	} else if (create) {
 		// TODO: move the malloc out of critical section
@@ -276,7 +277,14 @@ static client_t *async_client_get(task_id_t client_id, bool create)
 			client->data = async_client_data_create();
 
 			client->refcnt = 1;
-			hash_table_insert(&client_hash_table, &client->link);
+			if (oa_hash_table_insert(&client_hash_table,
+			    &client->link) != EOK) {
+				if (client->data)
+					async_client_data_destroy(client->data);
+
+				free(client);
+				client = NULL;
+			}
 		}
 	}
 
@@ -291,7 +299,7 @@ static void async_client_put(client_t *client)
 	fibril_rmutex_lock(&client_mutex);
 
 	if (--client->refcnt == 0) {
-		hash_table_remove(&client_hash_table, &client->in_task_id);
+		oa_hash_table_remove_item(&client_hash_table, &client->link);
 		destroy = true;
 	} else
 		destroy = false;
@@ -1024,7 +1032,7 @@ void __async_server_init(void)
 	if (fibril_rmutex_initialize(&notification_mutex) != EOK)
 		abort();
 
-	if (!hash_table_create(&client_hash_table, 0, 0, &client_hash_table_ops))
+	if (!oa_hash_table_create(&client_hash_table, 0, &client_hash_table_ops))
 		abort();
 
 	if (!hash_table_create(&notification_hash_table, 0, 0,
@@ -1745,13 +1753,7 @@ async_sess_t *async_callback_receive(exch_mgmt_t mgmt)
 		return NULL;
 	}
 
-	sess->iface = 0;
-	sess->mgmt = mgmt;
-	sess->phone = phandle;
-
-	fibril_mutex_initialize(&sess->remote_state_mtx);
-	list_initialize(&sess->exch_list);
-	fibril_mutex_initialize(&sess->mutex);
+	async_sess_init_internal(sess, 0, mgmt, phandle);
 
 	/* Acknowledge the connected phone */
 	async_answer_0(&call, EOK);
@@ -1785,13 +1787,7 @@ async_sess_t *async_callback_receive_start(exch_mgmt_t mgmt, ipc_call_t *call)
 	if (sess == NULL)
 		return NULL;
 
-	sess->iface = 0;
-	sess->mgmt = mgmt;
-	sess->phone = phandle;
-
-	fibril_mutex_initialize(&sess->remote_state_mtx);
-	list_initialize(&sess->exch_list);
-	fibril_mutex_initialize(&sess->mutex);
+	async_sess_init_internal(sess, 0, mgmt, phandle);
 
 	return sess;
 }
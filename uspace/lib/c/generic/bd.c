@@ -106,6 +106,34 @@ errno_t bd_read_blocks(bd_t *bd, aoff64_t ba, size_t cnt, void *data, size_t siz
 	return EOK;
 }
 
+/** Start reading blocks without waiting for completion.
+ *
+ * @a data must remain valid until @a *rreq, which can be waited for with
+ * async_wait_for() or added to a completion group, completes.
+ */
+errno_t bd_read_blocks_send(bd_t *bd, aoff64_t ba, size_t cnt, void *data,
+    size_t size, aid_t *rreq)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	aid_t req = async_send_3(exch, BD_READ_BLOCKS, LOWER32(ba),
+	    UPPER32(ba), cnt, NULL);
+	aid_t xfer = async_data_read(exch, data, size, NULL);
+	async_exchange_end(exch);
+
+	if (req == 0 || xfer == 0) {
+		if (req != 0)
+			async_forget(req);
+		if (xfer != 0)
+			async_forget(xfer);
+		return ENOMEM;
+	}
+
+	async_forget(xfer);
+	*rreq = req;
+	return EOK;
+}
+
 errno_t bd_read_toc(bd_t *bd, uint8_t session, void *buf, size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
@@ -153,6 +181,33 @@ errno_t bd_write_blocks(bd_t *bd, aoff64_t ba, size_t cnt, const void *data,
 	return EOK;
 }
 
+/** Start writing blocks without waiting for completion.
+ *
+ * @a data must remain valid until @a *rreq completes.
+ */
+errno_t bd_write_blocks_send(bd_t *bd, aoff64_t ba, size_t cnt,
+    const void *data, size_t size, aid_t *rreq)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	aid_t req = async_send_3(exch, BD_WRITE_BLOCKS, LOWER32(ba),
+	    UPPER32(ba), cnt, NULL);
+	aid_t xfer = async_data_write(exch, data, size, NULL);
+	async_exchange_end(exch);
+
+	if (req == 0 || xfer == 0) {
+		if (req != 0)
+			async_forget(req);
+		if (xfer != 0)
+			async_forget(xfer);
+		return ENOMEM;
+	}
+
+	async_forget(xfer);
+	*rreq = req;
+	return EOK;
+}
+
 errno_t bd_sync_cache(bd_t *bd, aoff64_t ba, size_t cnt)
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
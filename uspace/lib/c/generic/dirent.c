@@ -39,11 +39,21 @@
 #include <errno.h>
 #include <assert.h>
 #include <string.h>
+#include <str.h>
+
+/** Size of the buffer for directory entries read ahead by readdir(). */
+#define DIR_BUF_SIZE  4096
 
 struct __dirstream {
 	int fd;
 	struct dirent res;
 	aoff64_t pos;
+	/** Entries read ahead with vfs_readdir(), or NULL if not supported */
+	char *buf;
+	/** Offset of the next unread record in @c buf */
+	size_t offs;
+	/** Number of unread records in @c buf */
+	size_t count;
 };
 
 /** Open directory.
@@ -76,18 +86,26 @@ DIR *opendir(const char *dirname)
 		return NULL;
 	}
 
+	dirp->buf = malloc(DIR_BUF_SIZE);
+	if (!dirp->buf) {
+		free(dirp);
+		vfs_put(fd);
+		errno = ENOMEM;
+		return NULL;
+	}
+
 	dirp->fd = fd;
 	dirp->pos = 0;
+	dirp->offs = 0;
+	dirp->count = 0;
 	return dirp;
 }
 
-/** Read directory entry.
+/** Read directory entry one request at a time.
  *
- * @param dirp Open directory
- * @return Non-NULL pointer to directory entry on success. On error returns
- *         @c NULL and sets errno.
+ * Used with file systems that cannot read directories in batches.
  */
-struct dirent *readdir(DIR *dirp)
+static struct dirent *readdir_single(DIR *dirp)
 {
 	errno_t rc;
 	ssize_t len = 0;
@@ -106,6 +124,44 @@ struct dirent *readdir(DIR *dirp)
 	return &dirp->res;
 }
 
+/** Read directory entry.
+ *
+ * @param dirp Open directory
+ * @return Non-NULL pointer to directory entry on success. On error returns
+ *         @c NULL and sets errno.
+ */
+struct dirent *readdir(DIR *dirp)
+{
+	if (!dirp->buf)
+		return readdir_single(dirp);
+
+	if (dirp->count == 0) {
+		errno_t rc = vfs_readdir(dirp->fd, &dirp->pos, dirp->buf,
+		    DIR_BUF_SIZE, 0, &dirp->count);
+		if (rc == ENOTSUP) {
+			free(dirp->buf);
+			dirp->buf = NULL;
+			return readdir_single(dirp);
+		}
+		if (rc != EOK) {
+			errno = rc;
+			return NULL;
+		}
+		if (dirp->count == 0) {
+			errno = ENOENT;
+			return NULL;
+		}
+		dirp->offs = 0;
+	}
+
+	vfs_dirent_t *d = (vfs_dirent_t *) (dirp->buf + dirp->offs);
+	str_cpy(dirp->res.d_name, sizeof(dirp->res.d_name), d->name);
+	dirp->offs += d->reclen;
+	dirp->count--;
+
+	return &dirp->res;
+}
+
 /** Rewind directory position to the beginning.
  *
  * @param dirp Open directory
@@ -113,6 +169,7 @@ struct dirent *readdir(DIR *dirp)
 void rewinddir(DIR *dirp)
 {
 	dirp->pos = 0;
+	dirp->count = 0;
 }
 
 /** Close directory.
@@ -123,6 +180,7 @@ void rewinddir(DIR *dirp)
 int closedir(DIR *dirp)
 {
 	errno_t rc = vfs_put(dirp->fd);
+	free(dirp->buf);
 	free(dirp);
 
 	if (rc == EOK) {
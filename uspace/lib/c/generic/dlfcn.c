@@ -42,22 +42,30 @@
 
 #ifdef CONFIG_RTLD
 
+#include <fibril_synch.h>
 #include <rtld/module.h>
 #include <rtld/rtld.h>
 #include <rtld/symbol.h>
 
+/** Serializes loading of modules */
+static FIBRIL_MUTEX_INITIALIZE(dlopen_mutex);
+
 void *dlopen(const char *path, int flag)
 {
 	module_t *m;
 
+	fibril_mutex_lock(&dlopen_mutex);
+
 	m = module_find(runtime_env, path);
 	if (m == NULL) {
 		m = module_load(runtime_env, path, mlf_local);
 		if (m == NULL) {
+			fibril_mutex_unlock(&dlopen_mutex);
 			return NULL;
 		}
 
 		if (module_load_deps(m, mlf_local) != EOK) {
+			fibril_mutex_unlock(&dlopen_mutex);
 			return NULL;
 		}
 
@@ -65,6 +73,7 @@ void *dlopen(const char *path, int flag)
 		module_process_relocs(m);
 	}
 
+	fibril_mutex_unlock(&dlopen_mutex);
 	return (void *) m;
 }
 
@@ -37,10 +37,13 @@
  * @brief	Userspace ELF module loader.
  *
  * This module allows loading ELF binaries (both executables and
- * shared objects) from VFS. The current implementation allocates
- * anonymous memory, fills it with segment data and then adjusts
- * the memory areas' flags to the final value. In the future,
- * the segments will be mapped directly from the file.
+ * shared objects) from VFS. Whenever possible, the file-backed part of
+ * each segment is mapped from the file using the VFS pager so that pages
+ * are only read when they are first accessed and read-only pages can be
+ * shared among tasks. The rest of the segment and segments which the
+ * caller wants to modify are loaded into anonymous memory, filled with
+ * segment data and then the memory areas' flags are adjusted to the final
+ * value.
  */
 
 #include <errno.h>
@@ -66,6 +69,8 @@
 static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
+static errno_t map_segment(elf_ld_t *elf, elf_segment_header_t *entry,
+    int flags, size_t *mapped);
 
 /** Load ELF binary from a file.
  *
@@ -98,10 +103,16 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 	elf.fd = ofile;
 	elf.info = info;
 	elf.flags = flags;
+	elf.mapped = false;
 
 	rc = elf_load_module(&elf);
 
-	vfs_put(ofile);
+	/*
+	 * Segments mapped from the file are paged in on demand, so the file
+	 * must remain open for the rest of the task's life.
+	 */
+	if (!elf.mapped)
+		vfs_put(ofile);
 	return rc;
 }
 
@@ -388,6 +399,8 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	uintptr_t seg_addr;
 	size_t mem_sz;
 	aoff64_t pos;
+	size_t file_sz;
+	size_t mapped;
 	errno_t rc;
 	size_t nr;
 
@@ -428,6 +441,26 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	base = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
 	mem_sz = entry->p_memsz + (entry->p_vaddr - base);
 
+	/*
+	 * Map as much of the segment from the file as possible. Only the
+	 * remainder, if any, needs to be loaded into anonymous memory.
+	 */
+	rc = map_segment(elf, entry, flags, &mapped);
+	if (rc != EOK)
+		return rc;
+	if (mapped >= mem_sz)
+		return EOK;
+
+	base += mapped;
+	mem_sz -= mapped;
+	file_sz = entry->p_filesz;
+	pos = entry->p_offset;
+	if (mapped > 0) {
+		seg_ptr = (void *) (base + bias);
+		file_sz -= (base - entry->p_vaddr);
+		pos += (base - entry->p_vaddr);
+	}
+
 	DPRINTF("Map to seg_addr=%p-%p.\n", (void *) seg_addr,
 	    (void *) (entry->p_vaddr + bias +
 	    ALIGN_UP(entry->p_memsz, PAGE_SIZE)));
@@ -451,9 +484,8 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	/*
 	 * Load segment data
 	 */
-	pos = entry->p_offset;
-	rc = vfs_read(elf->fd, &pos, seg_ptr, entry->p_filesz, &nr);
-	if (rc != EOK || nr != entry->p_filesz) {
+	rc = vfs_read(elf->fd, &pos, seg_ptr, file_sz, &nr);
+	if (rc != EOK || nr != file_sz) {
 		DPRINTF("read error\n");
 		return EIO;
 	}
@@ -475,12 +507,68 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 
 	if (flags & AS_AREA_EXEC) {
 		/* Enforce SMC coherence for the segment */
-		if (smc_coherence(seg_ptr, entry->p_filesz))
+		if (smc_coherence(seg_ptr, file_sz))
 			return ENOMEM;
 	}
 
 	return EOK;
 }
 
+/** Map the file-backed part of a segment using the VFS pager.
+ *
+ * The mapping starts at the page-aligned beginning of the segment and
+ * covers all pages which are fully backed by the file. The last page
+ * is mapped as well if the segment has no zero-initialized part.
+ * Nothing is mapped if the caller wants to modify the segments, if the
+ * segment is not suitably aligned in the file or if the VFS pager is
+ * not available.
+ *
+ * @param elf     Loader state.
+ * @param entry   Program header entry describing the segment.
+ * @param flags   Final address space area flags of the segment.
+ * @param mapped  Place to store the number of bytes mapped from the
+ *                page-aligned beginning of the segment.
+ *
+ * @return EOK on success, error code otherwise.
+ */
+static errno_t map_segment(elf_ld_t *elf, elf_segment_header_t *entry,
+    int flags, size_t *mapped)
+{
+	uintptr_t base;
+	uintptr_t file_end;
+	size_t size;
+	void *a;
+
+	*mapped = 0;
+
+	if ((elf->flags & ELDF_RW) != 0 || entry->p_filesz == 0)
+		return EOK;
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return EOK;
+
+	base = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
+	file_end = entry->p_vaddr + entry->p_filesz;
+	if (entry->p_memsz == entry->p_filesz)
+		size = ALIGN_UP(file_end, PAGE_SIZE) - base;
+	else
+		size = ALIGN_DOWN(file_end, PAGE_SIZE) - base;
+	if (size == 0)
+		return EOK;
+
+	errno_t rc = vfs_map(elf->fd, entry->p_offset - (entry->p_vaddr - base),
+	    (uint8_t *) base + elf->bias, size, flags, &a);
+	if (rc != EOK) {
+		DPRINTF("vfs_map failed (%s), loading segment\n",
+		    str_error(rc));
+		return EOK;
+	}
+
+	DPRINTF("Mapped %p-%p from file.\n", a, (uint8_t *) a + size);
+
+	elf->mapped = true;
+	*mapped = size;
+	return EOK;
+}
+
 /** @}
  */
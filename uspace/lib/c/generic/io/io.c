@@ -37,6 +37,8 @@
 #include <str.h>
 #include <errno.h>
 #include <limits.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <async.h>
@@ -52,6 +54,7 @@
 
 static void _ffillbuf(FILE *stream);
 static void _fflushbuf(FILE *stream);
+static void _fcancelra(FILE *stream);
 
 static size_t stdio_kio_read(void *, size_t, size_t, FILE *);
 static size_t stdio_kio_write(const void *, size_t, size_t, FILE *);
@@ -263,18 +266,33 @@ static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
 	return true;
 }
 
-/** Set stream buffer. */
+/** Set stream buffer.
+ *
+ * The stream must have its buffer and read-ahead fields initialized, any
+ * buffer previously allocated by the library is released.
+ */
 int setvbuf(FILE *stream, void *buf, int mode, size_t size)
 {
 	if (mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
 		return -1;
 
+	/* Drop any read-ahead and the buffer allocated for the stream. */
+	_fcancelra(stream);
+	free(stream->ra_buf);
+	stream->ra_buf = NULL;
+	stream->ra_size = 0;
+
+	if (stream->buf_alloc)
+		free(stream->buf);
+
 	stream->btype = mode;
 	stream->buf = buf;
 	stream->buf_size = size;
 	stream->buf_head = stream->buf;
 	stream->buf_tail = stream->buf;
 	stream->buf_state = _bs_empty;
+	stream->buf_alloc = false;
+	stream->seq_count = 0;
 
 	return 0;
 }
@@ -323,9 +341,81 @@ static int _fallocbuf(FILE *stream)
 
 	stream->buf_head = stream->buf;
 	stream->buf_tail = stream->buf;
+	stream->buf_alloc = true;
 	return 0;
 }
 
+/** Determine the size of the next buffer of a stream.
+ *
+ * The buffer of a stream accessed sequentially is doubled up to
+ * STDIO_BUF_MAX so that fewer requests are needed to transfer its data.
+ * Buffers supplied by the user are never resized.
+ */
+static size_t _fnextsize(FILE *stream)
+{
+	if (!stream->buf_alloc || stream->seq_count < STDIO_SEQ_THRESHOLD)
+		return stream->buf_size;
+
+	return max(min(2 * stream->buf_size, STDIO_BUF_MAX), stream->buf_size);
+}
+
+/** Grow the empty buffer of a sequentially accessed stream. */
+static void _fgrowbuf(FILE *stream)
+{
+	size_t size = _fnextsize(stream);
+	if (size == stream->buf_size)
+		return;
+
+	/* The buffer is empty so there is nothing to preserve. */
+	uint8_t *buf = malloc(size);
+	if (buf == NULL)
+		return;
+
+	free(stream->buf);
+	stream->buf = buf;
+	stream->buf_size = size;
+	stream->buf_head = buf;
+	stream->buf_tail = buf;
+}
+
+/** Start reading the data which follow the stream buffer in advance.
+ *
+ * This is done only for sequentially read VFS streams with a buffer
+ * allocated by the library. The data are read to a second buffer which is
+ * swapped in by the next _ffillbuf().
+ */
+static void _fstartra(FILE *stream)
+{
+	if (stream->ops != &stdio_vfs_ops || !stream->buf_alloc ||
+	    stream->seq_count < STDIO_SEQ_THRESHOLD || stream->ra_req != 0)
+		return;
+
+	size_t size = _fnextsize(stream);
+	if (stream->ra_size != size) {
+		free(stream->ra_buf);
+		stream->ra_size = 0;
+		stream->ra_buf = malloc(size);
+		if (stream->ra_buf == NULL)
+			return;
+		stream->ra_size = size;
+	}
+
+	stream->ra_pos = stream->pos;
+	if (vfs_read_send(stream->fd, stream->ra_pos, stream->ra_buf, size,
+	    &stream->ra_answer, &stream->ra_req) != EOK)
+		stream->ra_req = 0;
+}
+
+/** Wait for the pending read-ahead request, if any, and drop its data. */
+static void _fcancelra(FILE *stream)
+{
+	if (stream->ra_req == 0)
+		return;
+
+	async_wait_for(stream->ra_req, NULL);
+	stream->ra_req = 0;
+}
+
 /** Open a stream.
  *
  * @param path Path of the file to open.
@@ -388,6 +478,12 @@ FILE *fopen(const char *path, const char *fmode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->buf = NULL;
+	stream->buf_alloc = false;
+	stream->seq_count = 0;
+	stream->ra_buf = NULL;
+	stream->ra_size = 0;
+	stream->ra_req = 0;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -413,6 +509,12 @@ FILE *fdopen(int fd, const char *mode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->buf = NULL;
+	stream->buf_alloc = false;
+	stream->seq_count = 0;
+	stream->ra_buf = NULL;
+	stream->ra_size = 0;
+	stream->ra_req = 0;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -427,6 +529,17 @@ static int _fclose_nofree(FILE *stream)
 
 	fflush(stream);
 
+	_fcancelra(stream);
+	free(stream->ra_buf);
+	stream->ra_buf = NULL;
+	stream->ra_size = 0;
+
+	if (stream->buf_alloc) {
+		free(stream->buf);
+		stream->buf = NULL;
+		stream->buf_alloc = false;
+	}
+
 	if (stream->sess != NULL)
 		async_hangup(stream->sess);
 
@@ -527,25 +640,53 @@ static size_t _fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 static void _ffillbuf(FILE *stream)
 {
 	errno_t rc;
-	size_t nread;
+	size_t nread = 0;
+
+	if (stream->ra_req != 0 && stream->ra_pos == stream->pos) {
+		/* The data have been read in advance, swap them in. */
+		async_wait_for(stream->ra_req, &rc);
+		stream->ra_req = 0;
+
+		uint8_t *buf = stream->buf;
+		size_t size = stream->buf_size;
+		stream->buf = stream->ra_buf;
+		stream->buf_size = stream->ra_size;
+		stream->ra_buf = buf;
+		stream->ra_size = size;
+
+		if (rc == EOK) {
+			nread = ipc_get_arg1(&stream->ra_answer);
+			stream->pos += nread;
+		}
+	} else {
+		_fcancelra(stream);
+		_fgrowbuf(stream);
+
+		rc = vfs_read(stream->fd, &stream->pos, stream->buf,
+		    stream->buf_size, &nread);
+	}
 
 	stream->buf_head = stream->buf_tail = stream->buf;
 
-	rc = vfs_read(stream->fd, &stream->pos, stream->buf, stream->buf_size,
-	    &nread);
 	if (rc != EOK) {
 		errno = rc;
 		stream->error = true;
+		stream->seq_count = 0;
 		return;
 	}
 
 	if (nread == 0) {
 		stream->eof = true;
+		stream->seq_count = 0;
 		return;
 	}
 
 	stream->buf_head += nread;
 	stream->buf_state = _bs_read;
+
+	/* The buffer is refilled only once it has been consumed. */
+	stream->seq_count++;
+	_fstartra(stream);
 }
 
 /** Write out stream buffer, do not sync stream. */
@@ -553,6 +694,8 @@ static void _fflushbuf(FILE *stream)
 {
 	size_t bytes_used;
 
+	_fcancelra(stream);
+
 	if ((!stream->buf) || (stream->btype == _IONBF) || (stream->error))
 		return;
 
@@ -590,7 +733,6 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 	size_t now;
 	size_t data_avail;
 	size_t total_read;
-	size_t i;
 
 	if (size == 0 || nmemb == 0)
 		return 0;
@@ -638,9 +780,7 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 		else
 			now = bytes_left;
 
-		for (i = 0; i < now; i++) {
-			dp[i] = stream->buf_tail[i];
-		}
+		memcpy(dp, stream->buf_tail, now);
 
 		dp += now;
 		stream->buf_tail += now;
@@ -666,8 +806,6 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	size_t now;
 	size_t buf_free;
 	size_t total_written;
-	size_t i;
-	uint8_t b;
 	bool need_flush;
 
 	if (size == 0 || nmemb == 0)
@@ -702,13 +840,10 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 		else
 			now = bytes_left;
 
-		for (i = 0; i < now; i++) {
-			b = data[i];
-			stream->buf_head[i] = b;
-
-			if ((b == '\n') && (stream->btype == _IOLBF))
-				need_flush = true;
-		}
+		memcpy(stream->buf_head, data, now);
+		if ((stream->btype == _IOLBF) &&
+		    (memchr(data, '\n', now) != NULL))
+			need_flush = true;
 
 		data += now;
 		stream->buf_head += now;
@@ -720,8 +855,11 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 		if (buf_free == 0) {
 			/* Only need to drain buffer. */
 			_fflushbuf(stream);
-			if (!stream->error)
+			if (!stream->error) {
 				need_flush = false;
+				stream->seq_count++;
+				_fgrowbuf(stream);
+			}
 		}
 	}
 
@@ -759,6 +897,18 @@ int fputc(int c, FILE *stream)
 	size_t wr;
 
 	b = (unsigned char) c;
+
+	/*
+	 * Fast path: store the byte if it neither fills the buffer nor
+	 * requires a line-buffered stream to be flushed.
+	 */
+	if ((stream->buf_state == _bs_write) && (!stream->error) &&
+	    (stream->buf_head + 1 < stream->buf + stream->buf_size) &&
+	    ((b != '\n') || (stream->btype != _IOLBF))) {
+		*stream->buf_head++ = b;
+		return b;
+	}
+
 	wr = fwrite(&b, sizeof(b), 1, stream);
 	if (wr < 1)
 		return EOF;
@@ -786,11 +936,24 @@ int puts(const char *str)
 	return putchar('\n');
 }
 
+/** Return the number of bytes fgetc() can take directly from the buffer. */
+static size_t _fbufavail(FILE *stream)
+{
+	if ((stream->ungetc_chars > 0) || (stream->buf_state != _bs_read))
+		return 0;
+
+	return stream->buf_head - stream->buf_tail;
+}
+
 int fgetc(FILE *stream)
 {
-	char c;
+	unsigned char c;
+
+	/* Fast path: take the byte from the buffer. */
+	if (_fbufavail(stream) > 0)
+		return *stream->buf_tail++;
 
-	/* This could be made faster by only flushing when needed. */
+	/* Flush pending output before possibly blocking on input. */
 	if (stdout)
 		fflush(stdout);
 	if (stderr)
@@ -809,6 +972,23 @@ char *fgets(char *str, int size, FILE *stream)
 
 	idx = 0;
 	while (idx < size - 1) {
+		size_t avail = _fbufavail(stream);
+		if (avail > 0) {
+			/* Copy up to the end of line straight from the buffer. */
+			size_t now = min(avail, (size_t) (size - 1 - idx));
+			uint8_t *nl = memchr(stream->buf_tail, '\n', now);
+			if (nl != NULL)
+				now = nl - stream->buf_tail + 1;
+
+			memcpy(str + idx, stream->buf_tail, now);
+			stream->buf_tail += now;
+			idx += now;
+
+			if (nl != NULL)
+				break;
+			continue;
+		}
+
 		c = fgetc(stream);
 		if (c == EOF)
 			break;
@@ -884,6 +1064,7 @@ int fseek64(FILE *stream, off64_t offset, int whence)
 	}
 
 	stream->eof = false;
+	stream->seq_count = 0;
 	return 0;
 }
 
@@ -997,6 +1178,63 @@ errno_t vfs_fhandle(FILE *stream, int *handle)
 	return ENOENT;
 }
 
+/*
+ * Streams are not locked so the _unlocked variants of the stream functions
+ * are the same as the regular ones. They are provided for programs which use
+ * them in single-threaded hot loops.
+ */
+
+int fgetc_unlocked(FILE *stream)
+{
+	return fgetc(stream);
+}
+
+char *fgets_unlocked(char *str, int size, FILE *stream)
+{
+	return fgets(str, size, stream);
+}
+
+int fputc_unlocked(int c, FILE *stream)
+{
+	return fputc(c, stream);
+}
+
+int fputs_unlocked(const char *str, FILE *stream)
+{
+	return fputs(str, stream);
+}
+
+size_t fread_unlocked(void *dest, size_t size, size_t nmemb, FILE *stream)
+{
+	return fread(dest, size, nmemb, stream);
+}
+
+size_t fwrite_unlocked(const void *buf, size_t size, size_t nmemb,
+    FILE *stream)
+{
+	return fwrite(buf, size, nmemb, stream);
+}
+
+int fflush_unlocked(FILE *stream)
+{
+	return fflush(stream);
+}
+
+int feof_unlocked(FILE *stream)
+{
+	return feof(stream);
+}
+
+int ferror_unlocked(FILE *stream)
+{
+	return ferror(stream);
+}
+
+void clearerr_unlocked(FILE *stream)
+{
+	clearerr(stream);
+}
+
 /** Read from KIO stream. */
 static size_t stdio_kio_read(void *buf, size_t size, size_t nmemb, FILE *stream)
 {
@@ -50,6 +50,7 @@
 #include "private/malloc.h"
 #include "private/io.h"
 #include "private/fibril.h"
+#include "private/rtld.h"
 
 #ifdef CONFIG_RTLD
 #include <rtld/rtld.h>
@@ -95,6 +96,8 @@ void __libc_main(void *pcb_ptr)
 	__malloc_init();
 
 #ifdef CONFIG_RTLD
+	__rtld_init();
+
 	if (__pcb != NULL && __pcb->rtld_runtime != NULL) {
 		runtime_env = (rtld_t *) __pcb->rtld_runtime;
 	} else {
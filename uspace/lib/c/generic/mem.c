@@ -38,22 +38,23 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "private/cc.h"
+#include "private/word.h"
 
 /** Fill memory block with a constant value. */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
     void *memset(void *dest, int b, size_t n)
 {
 	char *pb;
-	unsigned long *pw;
+	word_t *pw;
 	size_t word_size;
 	size_t n_words;
 
-	unsigned long pattern;
+	word_t pattern;
 	size_t i;
 	size_t fill;
 
 	/* Fill initial segment. */
-	word_size = sizeof(unsigned long);
+	word_size = WORD_SIZE;
 	fill = word_size - ((uintptr_t) dest & (word_size - 1));
 	if (fill > n)
 		fill = n;
@@ -71,15 +72,21 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 
 	n_words = n / word_size;
 	n = n % word_size;
-	pw = (unsigned long *) pb;
+	pw = (word_t *) pb;
 
 	/* Create word-sized pattern for aligned segment. */
-	pattern = 0;
-	i = word_size;
-	while (i-- != 0)
-		pattern = (pattern << 8) | (uint8_t) b;
+	pattern = word_pattern((uint8_t) b);
+
+	/* Fill aligned segment, four words at a time. */
+	while (n_words >= 4) {
+		pw[0] = pattern;
+		pw[1] = pattern;
+		pw[2] = pattern;
+		pw[3] = pattern;
+		pw += 4;
+		n_words -= 4;
+	}
 
-	/* Fill aligned segment. */
 	i = n_words;
 	while (i-- != 0)
 		*pw++ = pattern;
@@ -123,12 +130,12 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	size_t word_size;
 	size_t n_words;
 
-	const unsigned long *srcw;
-	unsigned long *dstw;
+	const word_t *srcw;
+	word_t *dstw;
 	const uint8_t *srcb;
 	uint8_t *dstb;
 
-	word_size = sizeof(unsigned long);
+	word_size = WORD_SIZE;
 
 	/*
 	 * Are source and destination addresses congruent modulo word_size?
@@ -167,13 +174,29 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 
 	/* Pointers to aligned segment. */
 
-	dstw = (unsigned long *) dstb;
-	srcw = (const unsigned long *) srcb;
+	dstw = (word_t *) dstb;
+	srcw = (const word_t *) srcb;
 
 	n_words = n / word_size;	/* Number of whole words to copy. */
 	n -= n_words * word_size;	/* Remaining bytes at the end. */
 
-	/* "Fast" copy. */
+	/* "Fast" copy, four words at a time. */
+	while (n_words >= 4) {
+		word_t w0 = srcw[0];
+		word_t w1 = srcw[1];
+		word_t w2 = srcw[2];
+		word_t w3 = srcw[3];
+
+		dstw[0] = w0;
+		dstw[1] = w1;
+		dstw[2] = w2;
+		dstw[3] = w3;
+
+		dstw += 4;
+		srcw += 4;
+		n_words -= 4;
+	}
+
 	i = n_words;
 	while (i-- != 0)
 		*dstw++ = *srcw++;
@@ -244,6 +267,28 @@ int memcmp(const void *s1, const void *s2, size_t len)
 	uint8_t *u2 = (uint8_t *) s2;
 	size_t i;
 
+	/*
+	 * If both areas are aligned the same way, skip equal words and leave
+	 * only the word with the first difference to the byte loop.
+	 */
+	if (((uintptr_t) u1 & (WORD_SIZE - 1)) ==
+	    ((uintptr_t) u2 & (WORD_SIZE - 1))) {
+		while (len > 0 && !word_aligned(u1)) {
+			if (*u1 != *u2)
+				return (int)(*u1) - (int)(*u2);
+			++u1;
+			++u2;
+			--len;
+		}
+
+		while (len >= WORD_SIZE &&
+		    *(const word_t *) u1 == *(const word_t *) u2) {
+			u1 += WORD_SIZE;
+			u2 += WORD_SIZE;
+			len -= WORD_SIZE;
+		}
+	}
+
 	for (i = 0; i < len; i++) {
 		if (*u1 != *u2)
 			return (int)(*u1) - (int)(*u2);
@@ -269,6 +314,21 @@ void *memchr(const void *s, int c, size_t n)
 	unsigned char uc = (unsigned char) c;
 	size_t i;
 
+	while (n > 0 && !word_aligned(u)) {
+		if (*u == uc)
+			return (void *) u;
+		++u;
+		--n;
+	}
+
+	/* Skip words which do not contain the character. */
+	word_t pattern = word_pattern(uc);
+	while (n >= WORD_SIZE &&
+	    !word_has_zero(*(const word_t *) u ^ pattern)) {
+		u += WORD_SIZE;
+		n -= WORD_SIZE;
+	}
+
 	for (i = 0; i < n; i++) {
 		if (u[i] == uc)
 			return (void *) &u[i];
@@ -38,15 +38,22 @@
 #include <async.h>
 #include <adt/list.h>
 #include <fibril.h>
+#include <stdatomic.h>
 #include <fibril_synch.h>
 #include <time.h>
 #include <stdbool.h>
 
 /** Session data */
 struct async_sess {
-	/** List of inactive exchanges */
+	/** Most recently finished exchange, reusable without locking */
+	_Atomic(async_exch_t *) exch_cache;
+
+	/** List of other inactive exchanges, protected by exch_mtx */
 	list_t exch_list;
 
+	/** Mutex protecting exch_list */
+	fibril_mutex_t exch_mtx;
+
 	/** Session interface */
 	iface_t iface;
 
@@ -69,7 +76,19 @@ struct async_sess {
 	fibril_mutex_t mutex;
 
 	/** Number of opened exchanges */
-	int exchanges;
+	atomic_int exchanges;
+
+	/** Link into the global list of sessions owning data phones */
+	link_t global_link;
+
+	/** Fibrils waiting for a phone to become available */
+	fibril_condvar_t avail_phone_cv;
+
+	/** Number of fibrils waiting on avail_phone_cv */
+	int phone_waiters;
+
+	/** Link into the global list of sessions waiting for a phone */
+	link_t wait_link;
 
 	/** Mutex for stateful connections */
 	fibril_mutex_t remote_state_mtx;
@@ -83,9 +102,6 @@ struct async_exch {
 	/** Link into list of inactive exchanges */
 	link_t sess_link;
 
-	/** Link into global list of inactive exchanges */
-	link_t global_link;
-
 	/** Session pointer */
 	async_sess_t *sess;
 
@@ -93,6 +109,9 @@ struct async_exch {
 	cap_phone_handle_t phone;
 };
 
+extern void async_sess_init_internal(async_sess_t *, iface_t, exch_mgmt_t,
+    cap_phone_handle_t);
+
 extern void __async_server_init(void);
 extern void __async_server_fini(void);
 extern void __async_client_init(void);
@@ -38,12 +38,19 @@
 #include <adt/list.h>
 #include <stdio.h>
 #include <async.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <offset.h>
 
 /** Maximum characters that can be pushed back by ungetc() */
 #define UNGETC_MAX 1
 
+/** Largest buffer the library grows the buffer of a sequential stream to */
+#define STDIO_BUF_MAX  (64 * 1024)
+
+/** Refills or drains in a row after which a stream is deemed sequential */
+#define STDIO_SEQ_THRESHOLD  2
+
 /** Stream operations */
 typedef struct {
 	/** Read from stream */
@@ -115,6 +122,27 @@ struct _IO_FILE {
 	/** Points to end of occupied space when in read mode. */
 	uint8_t *buf_tail;
 
+	/** Buffer was allocated by the library, which may resize and free it */
+	bool buf_alloc;
+
+	/** Number of consecutive buffer refills or drains without a seek */
+	unsigned int seq_count;
+
+	/** Buffer being filled by the read-ahead request */
+	uint8_t *ra_buf;
+
+	/** Size of the read-ahead buffer */
+	size_t ra_size;
+
+	/** Pending read-ahead request or 0 if there is none */
+	aid_t ra_req;
+
+	/** File position the read-ahead request reads from */
+	aoff64_t ra_pos;
+
+	/** Answer to the read-ahead request */
+	ipc_call_t ra_answer;
+
 	/** Pushed back characters */
 	uint8_t ungetc_buf[UNGETC_MAX];
 
@@ -52,6 +52,7 @@
 #include <libarch/rtld/module.h>
 
 #include "../private/libc.h"
+#include "../private/rtld.h"
 
 /** Create module for static executable.
  *
@@ -99,9 +100,12 @@ errno_t module_create_static_exec(rtld_t *rtld, module_t **rmodule)
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Process all relocation tables in a module.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * PLT relocations are bound lazily, on the first call through the PLT,
+ * if the architecture supports it and neither the module nor the runtime
+ * environment request immediate binding. All other relocations are
+ * processed eagerly.
  */
 void module_process_relocs(module_t *m)
 {
@@ -116,7 +120,10 @@ void module_process_relocs(module_t *m)
 	/* jmp_rel table */
 	if (m->dyn.jmp_rel != NULL) {
 		DPRINTF("jmp_rel table\n");
-		if (m->dyn.plt_rel == DT_REL) {
+		if (!m->dyn.bind_now && !m->rtld->bind_now &&
+		    module_lazy_bind_arch(m)) {
+			DPRINTF("jmp_rel table bound lazily\n");
+		} else if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
 			rel_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
 		} else {
@@ -232,7 +239,9 @@ module_t *module_load(rtld_t *rtld, const char *name, mlflags_t flags)
 	dynamic_parse(info.dynamic, m->bias, &m->dyn);
 
 	/* Insert into the list of loaded modules */
+	rtld_modules_lock();
 	list_append(&m->modules_link, &rtld->modules);
+	rtld_modules_unlock();
 
 	/* Copy TLS info */
 	m->tdata = info.tls.tdata;
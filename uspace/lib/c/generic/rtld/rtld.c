@@ -41,9 +41,39 @@
 #include <stdlib.h>
 #include <str.h>
 
+#include "../private/fibril.h"
+#include "../private/rtld.h"
+
 rtld_t *runtime_env;
 static rtld_t rt_env_static;
 
+/** Protects the list of global modules against lazy binding in other threads */
+static fibril_rmutex_t modules_mutex;
+
+/** Initialize the runtime linker locking. */
+void __rtld_init(void)
+{
+	if (fibril_rmutex_initialize(&modules_mutex) != EOK)
+		abort();
+}
+
+/** Lock the list of loaded modules.
+ *
+ * Only needs to be held while modifying the list or while walking it from
+ * a context that can run concurrently with dlopen(). The holder must not
+ * block.
+ */
+void rtld_modules_lock(void)
+{
+	fibril_rmutex_lock(&modules_mutex);
+}
+
+/** Unlock the list of loaded modules. */
+void rtld_modules_unlock(void)
+{
+	fibril_rmutex_unlock(&modules_mutex);
+}
+
 /** Initialize the runtime linker for use in a statically-linked executable. */
 errno_t rtld_init_static(void)
 {
@@ -136,9 +166,15 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 	 * Now relocate/link all modules together.
 	 */
 
-	/* Process relocations in all modules */
+	/*
+	 * Process relocations in all modules. Bind the PLT eagerly, since
+	 * lazy binding would run the resolver from the loader's own copy of
+	 * the runtime linker in the program's threads.
+	 */
 	DPRINTF("Relocate all modules\n");
+	env->bind_now = true;
 	modules_process_relocs(env, prog);
+	env->bind_now = false;
 
 	*rre = env;
 	return EOK;
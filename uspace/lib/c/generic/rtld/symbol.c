@@ -34,6 +34,9 @@
  * @file
  */
 
+#include <adt/hash_table.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +47,51 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Number of buckets in the symbol lookup cache */
+#define SYMBOL_CACHE_BUCKETS 256
+
+/** Symbol name together with its (lazily computed) hash values. */
+typedef struct {
+	const char *name;
+	/** GNU hash of the name */
+	elf_word gnu_hash;
+	/** System V hash of the name */
+	elf_word elf_hash;
+	/** @c true if @c elf_hash has been computed */
+	bool elf_hash_valid;
+} symbol_key_t;
+
+/** Symbol lookup cache entry.
+ *
+ * Caches the result of a symbol_def_find() lookup among the global
+ * modules. Modules are never unloaded and new global modules are appended
+ * to the end of the search order, so a positive result never goes stale.
+ */
+typedef struct {
+	ht_link_t link;
+	rtld_t *rtld;
+	symbol_search_flags_t flags;
+	elf_word gnu_hash;
+	/** Name (points into the string table of the defining module) */
+	const char *name;
+	elf_symbol_t *sym;
+	module_t *mod;
+} symbol_cache_entry_t;
+
+/** Symbol cache lookup key */
+typedef struct {
+	rtld_t *rtld;
+	symbol_search_flags_t flags;
+	symbol_key_t *skey;
+} symbol_cache_key_t;
+
+/*
+ * The cache is per libc image. The loader and the program's libc.so each
+ * have their own copy of the run-time linker and their own heap.
+ */
+static hash_table_t symbol_cache;
+static bool symbol_cache_ready = false;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +110,223 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Compute the hash used in DT_GNU_HASH tables. */
+static elf_word gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *skey, const char *name)
+{
+	skey->name = name;
+	skey->gnu_hash = gnu_hash((const unsigned char *) name);
+	skey->elf_hash_valid = false;
+}
+
+static size_t symbol_cache_hash(rtld_t *rtld, symbol_search_flags_t flags,
+    elf_word hash)
+{
+	return hash ^ ((uintptr_t) rtld >> 4) ^ flags;
+}
+
+static size_t symbol_cache_key_hash(const void *key)
+{
+	const symbol_cache_key_t *ckey = key;
+
+	return symbol_cache_hash(ckey->rtld, ckey->flags,
+	    ckey->skey->gnu_hash);
+}
+
+static size_t symbol_cache_item_hash(const ht_link_t *item)
+{
+	symbol_cache_entry_t *entry = hash_table_get_inst(item,
+	    symbol_cache_entry_t, link);
+
+	return symbol_cache_hash(entry->rtld, entry->flags, entry->gnu_hash);
+}
+
+static bool symbol_cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const symbol_cache_key_t *ckey = key;
+	symbol_cache_entry_t *entry = hash_table_get_inst(item,
+	    symbol_cache_entry_t, link);
+
+	return entry->rtld == ckey->rtld && entry->flags == ckey->flags &&
+	    entry->gnu_hash == ckey->skey->gnu_hash &&
+	    str_cmp(entry->name, ckey->skey->name) == 0;
+}
+
+static hash_table_ops_t symbol_cache_ops = {
+	.hash = symbol_cache_item_hash,
+	.key_hash = symbol_cache_key_hash,
+	.key_equal = symbol_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Look up symbol in the symbol cache.
+ *
+ * @return Cache entry or @c NULL if not found.
+ */
+static symbol_cache_entry_t *symbol_cache_find(rtld_t *rtld,
+    symbol_search_flags_t flags, symbol_key_t *skey)
+{
+	symbol_cache_key_t ckey;
+	ht_link_t *link;
+
+	if (!symbol_cache_ready)
+		return NULL;
+
+	ckey.rtld = rtld;
+	ckey.flags = flags;
+	ckey.skey = skey;
+
+	link = hash_table_find(&symbol_cache, &ckey);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, symbol_cache_entry_t, link);
+}
+
+/** Insert lookup result into the symbol cache.
+ *
+ * Failure to allocate memory is not fatal, the result is simply not cached.
+ */
+static void symbol_cache_insert(rtld_t *rtld, symbol_search_flags_t flags,
+    symbol_key_t *skey, elf_symbol_t *sym, module_t *mod)
+{
+	symbol_cache_entry_t *entry;
+
+	if (!symbol_cache_ready) {
+		if (!hash_table_create(&symbol_cache, SYMBOL_CACHE_BUCKETS, 0,
+		    &symbol_cache_ops))
+			return;
+		symbol_cache_ready = true;
+	}
+
+	entry = calloc(1, sizeof(symbol_cache_entry_t));
+	if (entry == NULL)
+		return;
+
+	entry->rtld = rtld;
+	entry->flags = flags;
+	entry->gnu_hash = skey->gnu_hash;
+	entry->name = mod->dyn.str_tab + sym->st_name;
+	entry->sym = sym;
+	entry->mod = mod;
+
+	hash_table_insert(&symbol_cache, &entry->link);
+}
+
+/** Find symbol in a module using its DT_GNU_HASH table.
+ *
+ * The Bloom filter allows rejecting most symbols not defined in the module
+ * without touching the hash chains at all.
+ */
+static elf_symbol_t *gnu_hash_find(symbol_key_t *skey, module_t *m)
+{
+	elf_word *ht = m->dyn.gnu_hash;
+	elf_word nbuckets = ht[0];
+	elf_word symoffset = ht[1];
+	elf_word bloom_size = ht[2];
+	elf_word bloom_shift = ht[3];
+	const uintptr_t *bloom = (const uintptr_t *) &ht[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbuckets];
+	const size_t bits = sizeof(uintptr_t) * 8;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_word h = skey->gnu_hash;
+	uintptr_t word;
+	uintptr_t mask;
+	elf_word i;
+	elf_word ch;
+	elf_symbol_t *s;
+
+	if (nbuckets == 0)
+		return NULL;
+
+	word = bloom[(h / bits) % bloom_size];
+	mask = ((uintptr_t) 1 << (h % bits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbuckets];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		ch = chain[i - symoffset];
+		if ((ch | 1) == (h | 1)) {
+			s = &sym_table[i];
+			if (str_cmp(skey->name,
+			    m->dyn.str_tab + s->st_name) == 0)
+				return s;
+		}
+
+		/* Lowest bit set marks the end of the chain */
+		if ((ch & 1) != 0)
+			break;
+		++i;
+	}
+
+	return NULL;
+}
+
+/** Find symbol in a module using its System V DT_HASH table. */
+static elf_symbol_t *elf_hash_find(symbol_key_t *skey, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/*elf_word nchain;*/
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!skey->elf_hash_valid) {
+		skey->elf_hash = elf_hash((const unsigned char *) skey->name);
+		skey->elf_hash_valid = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/*nchain = m->dyn.hash[1]; XXX Use to check HT range*/
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = skey->elf_hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(skey->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *skey, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", skey->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = gnu_hash_find(skey, m);
+	else if (m->dyn.hash != NULL)
+		sym = elf_hash_find(skey, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -121,6 +354,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	symbol_key_t skey;
 	list_t queue;
 	size_t i;
 
@@ -141,6 +375,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 
 	/* If the symbol is found, it will be stored in 'sym' */
 	sym = NULL;
+	symbol_key_init(&skey, name);
 
 	/* While queue is not empty */
 	while (!list_empty(&queue)) {
@@ -149,7 +384,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&skey, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -188,27 +423,39 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
  * origin is searched first. Otherwise, search global modules in the default
  * order.
  *
+ * Definitions found among the global modules are remembered in a per-process
+ * cache so that each symbol is looked up in the module hash tables only once,
+ * unless @c ssf_nocache is specified.
+ *
  * @param name		Name of the symbol to search for.
  * @param origin	Module in which the dependency originates.
  * @param flags		@c ssf_none or @c ssf_noexec to not look for the symbol
- *			in the executable program.
+ *			in the executable program, optionally combined with
+ *			@c ssf_nocache.
  * @param mod		(output) Will be filled with a pointer to the module
  *			that contains the symbol.
  */
 elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
+	symbol_search_flags_t sflags = flags & ssf_noexec;
+	bool use_cache = (flags & ssf_nocache) == 0;
+	symbol_cache_entry_t *entry;
+	symbol_key_t skey;
 	elf_symbol_t *s;
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
+
+	symbol_key_init(&skey, name);
+
 	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
 		DPRINTF("symbolic->find '%s' in module '%s'\n", name, origin->dyn.soname);
 		/*
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&skey, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -218,13 +465,24 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
+	if (use_cache) {
+		entry = symbol_cache_find(origin->rtld, sflags, &skey);
+		if (entry != NULL) {
+			*mod = entry->mod;
+			return entry->sym;
+		}
+	}
+
 	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
 		DPRINTF("module '%s' local?\n", m->dyn.soname);
 		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
 			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
+			s = def_find_in_module(&skey, m);
 			if (s != NULL) {
 				/* Found */
+				if (use_cache)
+					symbol_cache_insert(origin->rtld, sflags,
+					    &skey, s, m);
 				*mod = m;
 				return s;
 			}
@@ -237,7 +495,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&skey, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -117,6 +117,7 @@
 
 #include <align.h>
 #include <mem.h>
+#include "private/word.h"
 
 /** Check the condition if wchar_t is signed */
 #ifdef __WCHAR_UNSIGNED__
@@ -333,12 +334,26 @@ errno_t chr_encode(const wchar_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
+	const char *ptr = str;
 
-	while (*str++ != 0)
-		size++;
+	while (!word_aligned(ptr)) {
+		if (*ptr == 0)
+			return ptr - str;
+		ptr++;
+	}
 
-	return size;
+	/*
+	 * Look for the NULL-terminator a word at a time. An aligned word
+	 * never crosses a page boundary, so reading the bytes following the
+	 * terminator within the same word is harmless.
+	 */
+	while (!word_has_zero(*(const word_t *) ptr))
+		ptr += WORD_SIZE;
+
+	while (*ptr != 0)
+		ptr++;
+
+	return ptr - str;
 }
 
 /** Get size of wide string.
@@ -568,6 +583,49 @@ bool chr_check(wchar_t ch)
 	return false;
 }
 
+/** Get size of the common ASCII prefix of two strings.
+ *
+ * The prefix ends before the first NULL-terminator, non-ASCII byte or
+ * position where the strings differ. As ASCII characters are encoded in
+ * single bytes, the prefix ends on a character boundary in both strings.
+ *
+ * @param s1 First string.
+ * @param s2 Second string.
+ *
+ * @return Size of the prefix in bytes (and characters).
+ *
+ */
+static size_t str_ascii_prefix(const char *s1, const char *s2)
+{
+	size_t off = 0;
+
+	/* Compare whole words if both strings are aligned the same way. */
+	if (((uintptr_t) s1 & (WORD_SIZE - 1)) ==
+	    ((uintptr_t) s2 & (WORD_SIZE - 1))) {
+		while (!word_aligned(s1 + off)) {
+			uint8_t b = (uint8_t) s1[off];
+			if ((b == 0) || (b >= 0x80) || (b != (uint8_t) s2[off]))
+				return off;
+			off++;
+		}
+
+		while (true) {
+			word_t w = *(const word_t *) (s1 + off);
+			if ((w != *(const word_t *) (s2 + off)) ||
+			    (word_has_zero(w)) || (!word_is_ascii(w)))
+				break;
+			off += WORD_SIZE;
+		}
+	}
+
+	while (true) {
+		uint8_t b = (uint8_t) s1[off];
+		if ((b == 0) || (b >= 0x80) || (b != (uint8_t) s2[off]))
+			return off;
+		off++;
+	}
+}
+
 /** Compare two NULL terminated strings.
  *
  * Do a char-by-char comparison of two NULL-terminated strings.
@@ -591,8 +649,9 @@ int str_cmp(const char *s1, const char *s2)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	/* The common ASCII prefix needs no decoding. */
+	size_t off1 = str_ascii_prefix(s1, s2);
+	size_t off2 = off1;
 
 	while (true) {
 		c1 = str_decode(s1, &off1, STR_NO_LIMIT);
@@ -638,10 +697,14 @@ int str_lcmp(const char *s1, const char *s2, size_t max_len)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	/* The common ASCII prefix needs no decoding. */
+	size_t off1 = str_ascii_prefix(s1, s2);
+	size_t off2 = off1;
 
-	size_t len = 0;
+	if (off1 >= max_len)
+		return 0;
+
+	size_t len = off1;
 
 	while (true) {
 		if (len >= max_len)
@@ -1187,6 +1250,44 @@ wchar_t *str_to_awstr(const char *str)
 	return wstr;
 }
 
+/** Find the leading ASCII part of a string not containing a character.
+ *
+ * @param str String to search.
+ * @param ch  ASCII character to look for.
+ *
+ * @return Offset of the first occurence of @a ch, non-ASCII byte or the
+ *         NULL-terminator in @a str.
+ *
+ */
+static size_t str_ascii_span(const char *str, uint8_t ch)
+{
+	const char *ptr = str;
+
+	while (!word_aligned(ptr)) {
+		uint8_t b = (uint8_t) *ptr;
+		if ((b == 0) || (b == ch) || (b >= 0x80))
+			return ptr - str;
+		ptr++;
+	}
+
+	word_t pattern = word_pattern(ch);
+
+	while (true) {
+		word_t w = *(const word_t *) ptr;
+		if ((word_has_zero(w)) || (word_has_zero(w ^ pattern)) ||
+		    (!word_is_ascii(w)))
+			break;
+		ptr += WORD_SIZE;
+	}
+
+	while (true) {
+		uint8_t b = (uint8_t) *ptr;
+		if ((b == 0) || (b == ch) || (b >= 0x80))
+			return ptr - str;
+		ptr++;
+	}
+}
+
 /** Find first occurence of character in string.
  *
  * @param str String to search.
@@ -1200,6 +1301,20 @@ char *str_chr(const char *str, wchar_t ch)
 	size_t off = 0;
 	size_t last = 0;
 
+	/*
+	 * An ASCII character is never part of a multibyte sequence, so it
+	 * can be looked for bytewise in the leading ASCII part of the string.
+	 * U_SPECIAL also stands for decoding errors and needs decoding.
+	 */
+	if ((ch > 0) && (ch < 0x80) && (ch != U_SPECIAL)) {
+		off = str_ascii_span(str, (uint8_t) ch);
+		if (str[off] == ch)
+			return (char *) (str + off);
+		if (str[off] == 0)
+			return NULL;
+		last = off;
+	}
+
 	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
 		if (acc == ch)
 			return (char *) (str + last);
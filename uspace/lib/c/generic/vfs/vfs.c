@@ -36,6 +36,8 @@
 #include <vfs/canonify.h>
 #include <vfs/vfs_mtab.h>
 #include <vfs/vfs_sess.h>
+#include <align.h>
+#include <as.h>
 #include <macros.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -117,6 +119,7 @@
 
 static FIBRIL_MUTEX_INITIALIZE(vfs_mutex);
 static async_sess_t *vfs_sess = NULL;
+static async_sess_t *vfs_pager_sess = NULL;
 
 static FIBRIL_MUTEX_INITIALIZE(cwd_mutex);
 
@@ -253,6 +256,65 @@ errno_t vfs_clone(int file_from, int file_to, bool high, int *handle)
 	return rc;
 }
 
+/** Copy a range of data between two files
+ *
+ * The data do not pass through the caller. If both files reside on the same
+ * file system which supports it, the file system copies the data itself,
+ * otherwise VFS streams them from one file system to the other.
+ *
+ * When copying within a single file, the ranges may overlap as long as the
+ * destination does not start inside the source range, i.e. data can only be
+ * moved towards the beginning of the file. Otherwise EINVAL is returned.
+ *
+ * @param src           Source file handle, must be open for reading
+ * @param[in,out] spos  Position to copy from, updated by the actual bytes
+ *                      copied
+ * @param dst           Destination file handle, must be open for writing
+ * @param[in,out] dpos  Position to copy to, updated by the actual bytes
+ *                      copied
+ * @param size          Number of bytes to copy
+ * @param[out] ncopied  Actual number of bytes copied. On success, it is less
+ *                      than @a size only if the end of the source file was
+ *                      reached. On failure, it holds the number of bytes
+ *                      copied before the error occurred.
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_copy_range(int src, aoff64_t *spos, int dst, aoff64_t *dpos,
+    aoff64_t size, aoff64_t *ncopied)
+{
+	vfs_copy_range_t range = {
+		.src_pos = *spos,
+		.dst_pos = *dpos,
+		.size = size
+	};
+	ipc_call_t answer;
+	errno_t rc;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	aid_t req = async_send_2(exch, VFS_IN_COPY_RANGE, src, dst, &answer);
+	rc = async_data_write_start(exch, &range, sizeof(range));
+
+	vfs_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		*ncopied = 0;
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+
+	/* The answer carries the number of bytes copied even on failure. */
+	aoff64_t copied = MERGE_LOUP32(ipc_get_arg1(&answer),
+	    ipc_get_arg2(&answer));
+	*spos += copied;
+	*dpos += copied;
+	*ncopied = copied;
+	return rc;
+}
+
 /** Get current working directory path
  *
  * @param[out] buf      Buffer
@@ -602,6 +664,55 @@ errno_t vfs_lookup_open(const char *path, int flags, int mode, int *handle)
 	return EOK;
 }
 
+/** Map part of a file into memory
+ *
+ * Create an address space area backed by the VFS pager. Pages of the area
+ * are read from the file only when they are first accessed. Read-only
+ * areas may share pages with other tasks mapping the same part of the file,
+ * the kernel gives writable areas private copies of the pages.
+ *
+ * The file must stay open for as long as the area exists. Each page is
+ * a private copy of the file data at the time it was first accessed, i.e.
+ * writes to a writable area are never written back to the file.
+ *
+ * @param file      File handle of a file open for reading
+ * @param pos       Page-aligned file position where the mapping starts
+ * @param base      Starting virtual address of the area or AS_AREA_ANY
+ * @param size      Size of the area
+ * @param flags     Address space area flags
+ * @param[out] area Place to store the address of the created area
+ *
+ * @return          EOK on success or an error code
+ */
+errno_t vfs_map(int file, aoff64_t pos, void *base, size_t size,
+    unsigned int flags, void **area)
+{
+	if (ALIGN_DOWN(pos, PAGE_SIZE) != pos)
+		return EINVAL;
+	if ((sysarg_t) pos != pos)
+		return EOVERFLOW;
+
+	fibril_mutex_lock(&vfs_mutex);
+
+	if (vfs_pager_sess == NULL) {
+		vfs_pager_sess = service_connect_blocking(SERVICE_VFS,
+		    INTERFACE_PAGER, 0);
+	}
+
+	fibril_mutex_unlock(&vfs_mutex);
+
+	if (vfs_pager_sess == NULL)
+		return ENOENT;
+
+	void *a = async_as_area_create(base, size, flags, vfs_pager_sess,
+	    (sysarg_t) file, (sysarg_t) pos, 0);
+	if (a == AS_MAP_FAILED)
+		return ENOMEM;
+
+	*area = a;
+	return EOK;
+}
+
 /** Mount a file system
  *
  * @param[in] mp                File handle representing the mount-point
@@ -906,6 +1017,307 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Start reading bytes from a file
+ *
+ * Send a request to read up to @a nbyte bytes from file without waiting
+ * for it to complete. The caller can wait for the request using
+ * async_wait_for() or add it to a completion group. Once the request
+ * completes with EOK, ipc_get_arg1(answer) is the actual number of bytes
+ * read, which may be lower than @a nbyte, and the data is in @a buf.
+ *
+ * @a buf and @a answer must remain valid until the request completes.
+ *
+ * @param file          File handle to read from
+ * @param[in] pos       Position to read from
+ * @param buf           Buffer to read to
+ * @param nbyte         Maximum number of bytes to read
+ * @param answer        Storage for the answer to the request
+ * @param[out] rreq     Request to wait for
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_read_send(int file, aoff64_t pos, void *buf, size_t nbyte,
+    ipc_call_t *answer, aid_t *rreq)
+{
+	aid_t req;
+	aid_t xfer;
+
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_3(exch, VFS_IN_READ, file, LOWER32(pos),
+	    UPPER32(pos), answer);
+	xfer = async_data_read(exch, buf, nbyte, NULL);
+
+	vfs_exchange_end(exch);
+
+	if (req == 0 || xfer == 0) {
+		if (req != 0)
+			async_forget(req);
+		if (xfer != 0)
+			async_forget(xfer);
+		return ENOMEM;
+	}
+
+	/*
+	 * The data transfer is answered before the request itself, whose
+	 * answer reports any failure of the transfer as well.
+	 */
+	async_forget(xfer);
+
+	*rreq = req;
+	return EOK;
+}
+
+/** Copy data between a vector of buffers and a contiguous buffer.
+ *
+ * @param iov           Vector of buffers
+ * @param i             Index of the first buffer in @a iov
+ * @param off           Offset into the first buffer
+ * @param buf           Contiguous buffer
+ * @param size          Number of bytes to copy
+ * @param to_iov        Copy from @a buf to @a iov rather than vice versa
+ */
+static void vfs_iov_copy(const vfs_iovec_t *iov, size_t i, size_t off,
+    void *buf, size_t size, bool to_iov)
+{
+	uint8_t *bp = buf;
+
+	while (size > 0) {
+		size_t n = min(iov[i].size - off, size);
+		if (to_iov)
+			memcpy((uint8_t *) iov[i].buf + off, bp, n);
+		else
+			memcpy(bp, (uint8_t *) iov[i].buf + off, n);
+
+		bp += n;
+		size -= n;
+		i++;
+		off = 0;
+	}
+}
+
+/** Send a single vectored read or write request
+ *
+ * @param file          File handle
+ * @param read          Read rather than write
+ * @param segs          File segments
+ * @param cnt           Number of segments
+ * @param buf           Contiguous buffer with the data of all segments
+ * @param size          Total size of all segments
+ * @param[out] nbytes   Number of bytes transferred, on failure the number
+ *                      of bytes transferred before the error occurred
+ *
+ * @return              EOK on success or an error code
+ */
+static errno_t vfs_rdwrv_batch(int file, bool read, vfs_io_seg_t *segs,
+    size_t cnt, void *buf, size_t size, size_t *nbytes)
+{
+	errno_t rc;
+	ipc_call_t answer;
+	aid_t req;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_2(exch, read ? VFS_IN_READV : VFS_IN_WRITEV, file,
+	    cnt, &answer);
+	rc = async_data_write_start(exch, segs, cnt * sizeof(vfs_io_seg_t));
+	if (rc == EOK) {
+		if (read)
+			rc = async_data_read_start(exch, buf, size);
+		else
+			rc = async_data_write_start(exch, buf, size);
+	}
+
+	vfs_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		*nbytes = 0;
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+
+	/* The answer carries the number of bytes transferred even on failure. */
+	*nbytes = ipc_get_arg1(&answer);
+	return rc;
+}
+
+/** Read or write a vector of buffers
+ *
+ * The buffers are packed into requests carrying up to VFS_IO_SEG_MAX
+ * segments and DATA_XFER_LIMIT bytes each, so that many small buffers
+ * cost a single VFS round trip. The transfer stops at the first segment
+ * which cannot be transferred completely. If an error occurs, the data
+ * transferred before it are still accounted for in @a nbytes and @a pos.
+ *
+ * @param file          File handle
+ * @param read          Read rather than write
+ * @param iov           Vector of buffers
+ * @param cnt           Number of buffers in @a iov
+ * @param pos           If not NULL, the buffers are transferred
+ *                      contiguously starting at @a *pos, which is updated,
+ *                      otherwise each at its own position
+ * @param[out] nbytes   Number of bytes transferred
+ *
+ * @return              EOK on success or an error code
+ */
+static errno_t vfs_rdwrv(int file, bool read, const vfs_iovec_t *iov,
+    size_t cnt, aoff64_t *pos, size_t *nbytes)
+{
+	vfs_io_seg_t segs[VFS_IO_SEG_MAX];
+	size_t total = 0;
+	size_t i = 0;
+	size_t off = 0;
+	errno_t rc = EOK;
+
+	uint8_t *buf = malloc(DATA_XFER_LIMIT);
+	if (buf == NULL)
+		return ENOMEM;
+
+	while (i < cnt) {
+		size_t first = i;
+		size_t first_off = off;
+		size_t nsegs = 0;
+		size_t size = 0;
+
+		while (i < cnt && nsegs < VFS_IO_SEG_MAX &&
+		    size < DATA_XFER_LIMIT) {
+			size_t n = min(iov[i].size - off, DATA_XFER_LIMIT - size);
+			if (n > 0) {
+				segs[nsegs].pos = (pos != NULL) ?
+				    *pos + total + size : iov[i].pos + off;
+				segs[nsegs].size = n;
+				nsegs++;
+				size += n;
+			}
+
+			off += n;
+			if (off == iov[i].size) {
+				i++;
+				off = 0;
+			}
+		}
+
+		if (nsegs == 0)
+			break;
+
+		if (!read)
+			vfs_iov_copy(iov, first, first_off, buf, size, false);
+
+		size_t n = 0;
+		rc = vfs_rdwrv_batch(file, read, segs, nsegs, buf, size, &n);
+
+		if (read)
+			vfs_iov_copy(iov, first, first_off, buf, n, true);
+
+		total += n;
+		if (rc != EOK || n < size)
+			break;
+	}
+
+	free(buf);
+
+	if (pos != NULL)
+		*pos += total;
+	*nbytes = total;
+	return rc;
+}
+
+/** Read from a file into a vector of buffers
+ *
+ * The buffers are filled with consecutive data starting at @a *pos. The
+ * file may be read partially only if the end of file is reached.
+ *
+ * @param file          File handle to read from
+ * @param[in,out] pos   Position to read from, updated by the actual bytes
+ *                      read
+ * @param iov           Vector of buffers to read to
+ * @param cnt           Number of buffers in @a iov
+ * @param[out] nread    Actual number of bytes read (0 or more), also if
+ *                      an error occurs
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_readv(int file, aoff64_t *pos, const vfs_iovec_t *iov,
+    size_t cnt, size_t *nread)
+{
+	return vfs_rdwrv(file, true, iov, cnt, pos, nread);
+}
+
+/** Read from multiple file positions at once
+ *
+ * Each buffer in @a iov is filled with the file data at its own position.
+ * The buffers are filled in order and reading stops at the first buffer
+ * which cannot be filled completely due to the end of file.
+ *
+ * @param file          File handle to read from
+ * @param iov           Vector of buffers and positions to read
+ * @param cnt           Number of buffers in @a iov
+ * @param[out] nread    Total number of bytes read, also if an error occurs
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_preadv(int file, const vfs_iovec_t *iov, size_t cnt,
+    size_t *nread)
+{
+	return vfs_rdwrv(file, true, iov, cnt, NULL, nread);
+}
+
+/** Read a batch of directory entries
+ *
+ * Unlike reading a directory with vfs_read_short(), which yields a single
+ * name per request, this fills @a buf with as many vfs_dirent_t records as
+ * fit. With VFS_READDIR_STAT, each record also carries the attributes of
+ * its entry, which spares the caller a vfs_stat() per entry.
+ *
+ * @param file          Directory handle
+ * @param[in,out] pos   Position to read from; on success updated to the
+ *                      position following the last returned entry
+ * @param buf           Buffer for the records
+ * @param size          Size of @a buf
+ * @param flags         VFS_READDIR_* flags
+ * @param[out] count    Number of records stored in @a buf, zero at the end
+ *                      of the directory
+ *
+ * @return              EOK on success, ENOTSUP if the file system cannot
+ *                      read directories in batches, EOVERFLOW if @a buf is
+ *                      too small for the next entry or another error code
+ */
+errno_t vfs_readdir(int file, aoff64_t *pos, void *buf, size_t size,
+    unsigned int flags, size_t *count)
+{
+	errno_t rc;
+	ipc_call_t answer;
+	aid_t req;
+
+	if (size > DATA_XFER_LIMIT)
+		size = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_4(exch, VFS_IN_READDIR, file, LOWER32(*pos),
+	    UPPER32(*pos), flags, &answer);
+	rc = async_data_read_start(exch, buf, size);
+
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	if (rc != EOK)
+		return rc;
+
+	*pos = MERGE_LOUP32(ipc_get_arg1(&answer), ipc_get_arg2(&answer));
+	*count = ipc_get_arg3(&answer);
+	return EOK;
+}
+
 /** Rename a file or directory
  *
  * There is no file-handle-based variant to disallow attempts to introduce loops
@@ -1370,5 +1782,92 @@ errno_t vfs_write_short(int file, aoff64_t pos, const void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Start writing bytes to a file
+ *
+ * Send a request to write up to @a nbyte bytes to file without waiting
+ * for it to complete. Once the request completes with EOK,
+ * ipc_get_arg1(answer) is the actual number of bytes written, which may
+ * be lower than @a nbyte.
+ *
+ * @a buf and @a answer must remain valid until the request completes.
+ *
+ * @param file          File handle to write to
+ * @param[in] pos       Position to write to
+ * @param buf           Buffer to write from
+ * @param nbyte         Maximum number of bytes to write
+ * @param answer        Storage for the answer to the request
+ * @param[out] rreq     Request to wait for
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_write_send(int file, aoff64_t pos, const void *buf, size_t nbyte,
+    ipc_call_t *answer, aid_t *rreq)
+{
+	aid_t req;
+	aid_t xfer;
+
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_3(exch, VFS_IN_WRITE, file, LOWER32(pos),
+	    UPPER32(pos), answer);
+	xfer = async_data_write(exch, buf, nbyte, NULL);
+
+	vfs_exchange_end(exch);
+
+	if (req == 0 || xfer == 0) {
+		if (req != 0)
+			async_forget(req);
+		if (xfer != 0)
+			async_forget(xfer);
+		return ENOMEM;
+	}
+
+	async_forget(xfer);
+
+	*rreq = req;
+	return EOK;
+}
+
+/** Write a vector of buffers to a file
+ *
+ * The buffers are written consecutively starting at @a *pos.
+ *
+ * @param file          File handle to write to
+ * @param[in,out] pos   Position to write to, updated by the actual bytes
+ *                      written
+ * @param iov           Vector of buffers to write
+ * @param cnt           Number of buffers in @a iov
+ * @param[out] nwritten Actual number of bytes written, also if an error
+ *                      occurs
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_writev(int file, aoff64_t *pos, const vfs_iovec_t *iov,
+    size_t cnt, size_t *nwritten)
+{
+	return vfs_rdwrv(file, false, iov, cnt, pos, nwritten);
+}
+
+/** Write to multiple file positions at once
+ *
+ * Each buffer in @a iov is written at its own position, in order.
+ *
+ * @param file          File handle to write to
+ * @param iov           Vector of buffers and positions to write
+ * @param cnt           Number of buffers in @a iov
+ * @param[out] nwritten Total number of bytes written, also if an error
+ *                      occurs
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_pwritev(int file, const vfs_iovec_t *iov, size_t cnt,
+    size_t *nwritten)
+{
+	return vfs_rdwrv(file, false, iov, cnt, NULL, nwritten);
+}
+
 /** @}
  */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_OA_HASH_TABLE_H_
+#define _LIBC_OA_HASH_TABLE_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <macros.h>
+
+/** Open-addressing hash table link type. */
+typedef struct oa_ht_link {
+	/** Mixed hash of the item's lookup key. */
+	uint64_t hash;
+} oa_ht_link_t;
+
+/** Set of operations for open-addressing hash table. */
+typedef struct {
+	/** Returns the hash of the key stored in the item (ie its lookup key). */
+	size_t (*hash)(const oa_ht_link_t *item);
+
+	/** Returns the hash of the key. */
+	size_t (*key_hash)(const void *key);
+
+	/** True if the items are equal (have the same lookup keys). */
+	bool (*equal)(const oa_ht_link_t *item1, const oa_ht_link_t *item2);
+
+	/** Returns true if the key is equal to the item's lookup key. */
+	bool (*key_equal)(const void *key, const oa_ht_link_t *item);
+
+	/** Hash table item removal callback.
+	 *
+	 * Must not invoke any mutating functions of the hash table.
+	 *
+	 * @param item Item that was removed from the hash table.
+	 */
+	void (*remove_callback)(oa_ht_link_t *item);
+} oa_hash_table_ops_t;
+
+/** Open-addressing hash table structure. */
+typedef struct {
+	oa_hash_table_ops_t *op;
+	/** Control byte of each slot (hash fragment, empty or deleted). */
+	uint8_t *ctrl;
+	/** Item stored in each slot. */
+	oa_ht_link_t **slot;
+	/** Number of slots, always a power of two. */
+	size_t slot_cnt;
+	/** Binary logarithm of slot_cnt. */
+	unsigned int order;
+	/** Number of items in the table. */
+	size_t item_cnt;
+	/** Number of slots that are not empty (items and deleted slots). */
+	size_t used_cnt;
+	bool apply_ongoing;
+} oa_hash_table_t;
+
+#define oa_hash_table_get_inst(item, type, member) \
+	member_to_inst((item), type, member)
+
+extern bool oa_hash_table_create(oa_hash_table_t *, size_t,
+    oa_hash_table_ops_t *);
+extern void oa_hash_table_destroy(oa_hash_table_t *);
+
+extern bool oa_hash_table_empty(oa_hash_table_t *);
+extern size_t oa_hash_table_size(oa_hash_table_t *);
+
+extern void oa_hash_table_clear(oa_hash_table_t *);
+extern errno_t oa_hash_table_insert(oa_hash_table_t *, oa_ht_link_t *);
+extern errno_t oa_hash_table_insert_unique(oa_hash_table_t *, oa_ht_link_t *);
+extern oa_ht_link_t *oa_hash_table_find(const oa_hash_table_t *, const void *);
+extern oa_ht_link_t *oa_hash_table_find_next(const oa_hash_table_t *,
+    oa_ht_link_t *);
+extern size_t oa_hash_table_remove(oa_hash_table_t *, const void *);
+extern void oa_hash_table_remove_item(oa_hash_table_t *, oa_ht_link_t *);
+extern void oa_hash_table_apply(oa_hash_table_t *,
+    bool (*)(oa_ht_link_t *, void *), void *);
+
+#endif
+
+/** @}
+ */
@@ -104,6 +104,7 @@ struct async_sess;
 
 typedef struct async_sess async_sess_t;
 typedef struct async_exch async_exch_t;
+typedef struct async_group async_group_t;
 
 extern __noreturn void async_manager(void);
 
@@ -125,6 +126,12 @@ extern void async_wait_for(aid_t, errno_t *);
 extern errno_t async_wait_timeout(aid_t, errno_t *, usec_t);
 extern void async_forget(aid_t);
 
+extern async_group_t *async_group_create(void);
+extern void async_group_destroy(async_group_t *);
+extern errno_t async_group_add(async_group_t *, aid_t, void *);
+extern errno_t async_group_wait_any(async_group_t *, void **, errno_t *);
+extern errno_t async_group_wait_all(async_group_t *);
+
 extern void async_set_client_data_constructor(async_client_data_ctor_t);
 extern void async_set_client_data_destructor(async_client_data_dtor_t);
 extern void *async_get_client_data(void);
@@ -356,6 +363,8 @@ extern errno_t async_data_write_forward_3_1(async_exch_t *, sysarg_t, sysarg_t,
 extern errno_t async_data_write_forward_4_1(async_exch_t *, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
 
+extern aid_t async_data_write(async_exch_t *, const void *, size_t,
+    ipc_call_t *);
 extern errno_t async_data_write_start(async_exch_t *, const void *, size_t);
 extern bool async_data_write_receive(ipc_call_t *, size_t *);
 extern errno_t async_data_write_finalize(ipc_call_t *, void *, size_t);
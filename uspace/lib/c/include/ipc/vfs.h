@@ -61,6 +61,8 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** Attributes of nodes may change behind VFS's back, do not cache. */
+	bool volatile_stat;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -69,14 +71,33 @@ typedef struct {
 	char vuid[FS_VUID_MAXLEN + 1];
 } vfs_fs_probe_info_t;
 
+/** Maximum number of segments of a single vectored request. */
+#define VFS_IO_SEG_MAX  64
+
+/** File segment of a VFS_IN_READV or VFS_IN_WRITEV request. */
+typedef struct {
+	uint64_t pos;
+	size_t size;
+} vfs_io_seg_t;
+
+/** Ranges of a VFS_IN_COPY_RANGE or VFS_OUT_COPY_RANGE request. */
+typedef struct {
+	uint64_t src_pos;
+	uint64_t dst_pos;
+	uint64_t size;
+} vfs_copy_range_t;
+
 typedef enum {
 	VFS_IN_CLONE = IPC_FIRST_USER_METHOD,
+	VFS_IN_COPY_RANGE,
 	VFS_IN_FSPROBE,
 	VFS_IN_FSTYPES,
 	VFS_IN_MOUNT,
 	VFS_IN_OPEN,
 	VFS_IN_PUT,
 	VFS_IN_READ,
+	VFS_IN_READDIR,
+	VFS_IN_READV,
 	VFS_IN_REGISTER,
 	VFS_IN_RENAME,
 	VFS_IN_RESIZE,
@@ -88,10 +109,12 @@ typedef enum {
 	VFS_IN_WAIT_HANDLE,
 	VFS_IN_WALK,
 	VFS_IN_WRITE,
+	VFS_IN_WRITEV,
 } vfs_in_request_t;
 
 typedef enum {
 	VFS_OUT_CLOSE = IPC_FIRST_USER_METHOD,
+	VFS_OUT_COPY_RANGE,
 	VFS_OUT_DESTROY,
 	VFS_OUT_FSPROBE,
 	VFS_OUT_IS_EMPTY,
@@ -100,6 +123,7 @@ typedef enum {
 	VFS_OUT_MOUNTED,
 	VFS_OUT_OPEN_NODE,
 	VFS_OUT_READ,
+	VFS_OUT_READDIR,
 	VFS_OUT_STAT,
 	VFS_OUT_STATFS,
 	VFS_OUT_SYNC,
@@ -213,6 +213,17 @@ extern int fileno(FILE *);
 extern int fseek64(FILE *, off64_t, int);
 extern off64_t ftell64(FILE *);
 
+extern int fgetc_unlocked(FILE *);
+extern char *fgets_unlocked(char *, int, FILE *);
+extern int fputc_unlocked(int, FILE *);
+extern int fputs_unlocked(const char *, FILE *);
+extern size_t fread_unlocked(void *, size_t, size_t, FILE *);
+extern size_t fwrite_unlocked(const void *, size_t, size_t, FILE *);
+extern int fflush_unlocked(FILE *);
+extern int feof_unlocked(FILE *);
+extern int ferror_unlocked(FILE *);
+extern void clearerr_unlocked(FILE *);
+
 __HELENOS_DECLS_END;
 #endif
 
@@ -37,6 +37,7 @@
 
 #include <adt/list.h>
 #include <elf/elf_mod.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -60,6 +61,9 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Process PLT relocations eagerly, regardless of the modules */
+	bool bind_now;
 } rtld_t;
 
 #endif
@@ -64,6 +64,29 @@ typedef struct {
 	service_id_t service;
 } vfs_stat_t;
 
+/** Buffer and file position of a vectored read or write. */
+typedef struct {
+	/** File position, ignored by vfs_readv() and vfs_writev(). */
+	aoff64_t pos;
+	/** Buffer. */
+	void *buf;
+	/** Size of the buffer. */
+	size_t size;
+} vfs_iovec_t;
+
+/** Ask vfs_readdir() to return the attributes of each entry as well. */
+#define VFS_READDIR_STAT  1
+
+/** Directory entry record filled in by vfs_readdir(). */
+typedef struct {
+	/** Size of the whole record, including the name and padding. */
+	size_t reclen;
+	/** Entry attributes, valid only if VFS_READDIR_STAT was requested. */
+	vfs_stat_t stat;
+	/** Null-terminated entry name. */
+	char name[];
+} vfs_dirent_t;
+
 typedef struct {
 	char fs_name[FS_NAME_MAXLEN + 1];
 	uint32_t f_bsize;    /* fundamental file system block size */
@@ -82,6 +105,8 @@ extern errno_t vfs_fhandle(FILE *, int *);
 
 extern char *vfs_absolutize(const char *, size_t *);
 extern errno_t vfs_clone(int, int, bool, int *);
+extern errno_t vfs_copy_range(int, aoff64_t *, int, aoff64_t *, aoff64_t,
+    aoff64_t *);
 extern errno_t vfs_cwd_get(char *path, size_t);
 extern errno_t vfs_cwd_set(const char *path);
 extern async_exch_t *vfs_exchange_begin(void);
@@ -93,6 +118,7 @@ extern errno_t vfs_link(int, const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_link_path(const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_lookup(const char *, int, int *);
 extern errno_t vfs_lookup_open(const char *, int, int, int *);
+extern errno_t vfs_map(int, aoff64_t, void *, size_t, unsigned int, void **);
 extern errno_t vfs_mount_path(const char *, const char *, const char *,
     const char *, unsigned int, unsigned int);
 extern errno_t vfs_mount(int, const char *, service_id_t, const char *, unsigned,
@@ -102,6 +128,13 @@ extern errno_t vfs_pass_handle(async_exch_t *, int, async_exch_t *);
 extern errno_t vfs_put(int);
 extern errno_t vfs_read(int, aoff64_t *, void *, size_t, size_t *);
 extern errno_t vfs_read_short(int, aoff64_t, void *, size_t, ssize_t *);
+extern errno_t vfs_readv(int, aoff64_t *, const vfs_iovec_t *, size_t,
+    size_t *);
+extern errno_t vfs_preadv(int, const vfs_iovec_t *, size_t, size_t *);
+extern errno_t vfs_read_send(int, aoff64_t, void *, size_t, ipc_call_t *,
+    aid_t *);
+extern errno_t vfs_readdir(int, aoff64_t *, void *, size_t, unsigned int,
+    size_t *);
 extern errno_t vfs_receive_handle(bool, int *);
 extern errno_t vfs_rename_path(const char *, const char *);
 extern errno_t vfs_resize(int, aoff64_t);
@@ -119,6 +152,11 @@ extern errno_t vfs_unmount_path(const char *);
 extern errno_t vfs_walk(int, const char *, int, int *);
 extern errno_t vfs_write(int, aoff64_t *, const void *, size_t, size_t *);
 extern errno_t vfs_write_short(int, aoff64_t, const void *, size_t, ssize_t *);
+extern errno_t vfs_writev(int, aoff64_t *, const vfs_iovec_t *, size_t,
+    size_t *);
+extern errno_t vfs_pwritev(int, const vfs_iovec_t *, size_t, size_t *);
+extern errno_t vfs_write_send(int, aoff64_t, const void *, size_t, ipc_call_t *,
+    aid_t *);
 
 #endif
 
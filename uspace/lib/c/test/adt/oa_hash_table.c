@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/oa_hash_table.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+/** Test entry */
+typedef struct {
+	oa_ht_link_t link;
+	int key;
+	int value;
+} test_entry_t;
+
+enum {
+	/** Number of test entries */
+	test_cnt = 1000
+};
+
+static size_t test_key_hash(const void *key)
+{
+	return *(const int *) key;
+}
+
+static size_t test_hash(const oa_ht_link_t *item)
+{
+	return oa_hash_table_get_inst(item, test_entry_t, link)->key;
+}
+
+static bool test_equal(const oa_ht_link_t *item1, const oa_ht_link_t *item2)
+{
+	return oa_hash_table_get_inst(item1, test_entry_t, link)->key ==
+	    oa_hash_table_get_inst(item2, test_entry_t, link)->key;
+}
+
+static bool test_key_equal(const void *key, const oa_ht_link_t *item)
+{
+	return *(const int *) key ==
+	    oa_hash_table_get_inst(item, test_entry_t, link)->key;
+}
+
+static size_t removed_cnt;
+
+static void test_remove_callback(oa_ht_link_t *item)
+{
+	++removed_cnt;
+}
+
+static oa_hash_table_ops_t test_ops = {
+	.hash = test_hash,
+	.key_hash = test_key_hash,
+	.equal = test_equal,
+	.key_equal = test_key_equal,
+	.remove_callback = test_remove_callback
+};
+
+static test_entry_t entries[test_cnt];
+
+/** Initialize the test entries with keys 0, step, 2 * step, ... */
+static void init_entries(int step)
+{
+	for (int i = 0; i < test_cnt; i++) {
+		entries[i].key = i * step;
+		entries[i].value = i;
+	}
+
+	removed_cnt = 0;
+}
+
+/** Check that exactly entries with index from @a lo to @a hi are found. */
+static void check_entries(oa_hash_table_t *h, int step, int lo, int hi)
+{
+	for (int i = 0; i < test_cnt; i++) {
+		int key = i * step;
+		oa_ht_link_t *item = oa_hash_table_find(h, &key);
+
+		if (i >= lo && i < hi) {
+			PCUT_ASSERT_NOT_NULL(item);
+			PCUT_ASSERT_INT_EQUALS(i, oa_hash_table_get_inst(item,
+			    test_entry_t, link)->value);
+		} else {
+			PCUT_ASSERT_NULL(item);
+		}
+	}
+}
+
+static bool count_and_remove_odd(oa_ht_link_t *item, void *arg)
+{
+	oa_hash_table_t *h = arg;
+	test_entry_t *entry = oa_hash_table_get_inst(item, test_entry_t, link);
+
+	if (entry->value % 2 != 0)
+		oa_hash_table_remove_item(h, item);
+
+	return true;
+}
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(oa_hash_table);
+
+/** Insert items and look them up, growing the table on the way. */
+PCUT_TEST(insert_find)
+{
+	oa_hash_table_t h;
+
+	init_entries(7);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, 0, &test_ops));
+	PCUT_ASSERT_TRUE(oa_hash_table_empty(&h));
+
+	for (int i = 0; i < test_cnt; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert(&h,
+		    &entries[i].link));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(test_cnt, oa_hash_table_size(&h));
+	check_entries(&h, 7, 0, test_cnt);
+
+	oa_hash_table_destroy(&h);
+	PCUT_ASSERT_INT_EQUALS(test_cnt, removed_cnt);
+}
+
+/** Items with duplicate keys are refused by insert_unique(). */
+PCUT_TEST(insert_unique)
+{
+	oa_hash_table_t h;
+	test_entry_t dup;
+
+	init_entries(1);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, test_cnt, &test_ops));
+
+	for (int i = 0; i < test_cnt; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert_unique(&h,
+		    &entries[i].link));
+	}
+
+	dup.key = test_cnt / 2;
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, oa_hash_table_insert_unique(&h,
+	    &dup.link));
+	PCUT_ASSERT_INT_EQUALS(test_cnt, oa_hash_table_size(&h));
+
+	oa_hash_table_destroy(&h);
+}
+
+/** Duplicate keys are found one after another by find_next(). */
+PCUT_TEST(find_next)
+{
+	oa_hash_table_t h;
+	int key = 42;
+
+	init_entries(0);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, 0, &test_ops));
+
+	for (int i = 0; i < 10; i++) {
+		entries[i].key = key;
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert(&h,
+		    &entries[i].link));
+	}
+
+	unsigned int seen = 0;
+	oa_ht_link_t *item = oa_hash_table_find(&h, &key);
+	while (item != NULL) {
+		test_entry_t *entry = oa_hash_table_get_inst(item,
+		    test_entry_t, link);
+		PCUT_ASSERT_EQUALS(0, seen & (1U << entry->value));
+		seen |= 1U << entry->value;
+		item = oa_hash_table_find_next(&h, item);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0x3ff, seen);
+	PCUT_ASSERT_INT_EQUALS(10, oa_hash_table_remove(&h, &key));
+	PCUT_ASSERT_TRUE(oa_hash_table_empty(&h));
+
+	oa_hash_table_destroy(&h);
+}
+
+/** Removing items leaves the remaining ones reachable and shrinks the table. */
+PCUT_TEST(remove)
+{
+	oa_hash_table_t h;
+
+	init_entries(3);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, 0, &test_ops));
+
+	for (int i = 0; i < test_cnt; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert(&h,
+		    &entries[i].link));
+	}
+
+	size_t slot_cnt = h.slot_cnt;
+
+	/* Remove by key and by item */
+	for (int i = 0; i < test_cnt - 10; i++) {
+		if (i % 2 == 0) {
+			PCUT_ASSERT_INT_EQUALS(1, oa_hash_table_remove(&h,
+			    &entries[i].key));
+		} else {
+			oa_hash_table_remove_item(&h, &entries[i].link);
+		}
+	}
+
+	PCUT_ASSERT_INT_EQUALS(test_cnt - 10, removed_cnt);
+	PCUT_ASSERT_INT_EQUALS(10, oa_hash_table_size(&h));
+	PCUT_ASSERT_TRUE(h.slot_cnt < slot_cnt);
+	check_entries(&h, 3, test_cnt - 10, test_cnt);
+
+	oa_hash_table_destroy(&h);
+}
+
+/** Repeated insertion and removal does not fill the table with deleted slots. */
+PCUT_TEST(churn)
+{
+	oa_hash_table_t h;
+
+	init_entries(1);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, 0, &test_ops));
+
+	for (int i = 0; i < test_cnt; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert(&h,
+		    &entries[i].link));
+		if (i >= 5)
+			oa_hash_table_remove_item(&h, &entries[i - 5].link);
+
+		PCUT_ASSERT_TRUE(h.used_cnt < h.slot_cnt);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(5, oa_hash_table_size(&h));
+	check_entries(&h, 1, test_cnt - 5, test_cnt);
+
+	oa_hash_table_destroy(&h);
+}
+
+/** Items can be removed while walking the table. */
+PCUT_TEST(apply)
+{
+	oa_hash_table_t h;
+
+	init_entries(5);
+	PCUT_ASSERT_TRUE(oa_hash_table_create(&h, 0, &test_ops));
+
+	for (int i = 0; i < test_cnt; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, oa_hash_table_insert(&h,
+		    &entries[i].link));
+	}
+
+	oa_hash_table_apply(&h, count_and_remove_odd, &h);
+	PCUT_ASSERT_INT_EQUALS(test_cnt / 2, oa_hash_table_size(&h));
+
+	for (int i = 0; i < test_cnt; i++) {
+		int key = i * 5;
+		oa_ht_link_t *item = oa_hash_table_find(&h, &key);
+		if (i % 2 == 0)
+			PCUT_ASSERT_NOT_NULL(item);
+		else
+			PCUT_ASSERT_NULL(item);
+	}
+
+	oa_hash_table_clear(&h);
+	PCUT_ASSERT_TRUE(oa_hash_table_empty(&h));
+	PCUT_ASSERT_INT_EQUALS(test_cnt, removed_cnt);
+
+	oa_hash_table_destroy(&h);
+}
+
+PCUT_EXPORT(oa_hash_table);
@@ -203,6 +203,91 @@ PCUT_TEST(fgetpos_setpos)
 	(void) fclose(f);
 }
 
+/** Sequential reading of a file spanning many stream buffers */
+PCUT_TEST(read_sequential)
+{
+	char line[16];
+	char exp[16];
+	unsigned i;
+	int rc;
+	char *p;
+	FILE *f;
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	/* Enough lines for the stream buffer to grow and read ahead */
+	for (i = 0; i < 20000; i++) {
+		rc = fprintf(f, "%u\n", i);
+		PCUT_ASSERT_TRUE(rc > 0);
+	}
+
+	rewind(f);
+
+	for (i = 0; i < 20000; i++) {
+		snprintf(exp, sizeof(exp), "%u\n", i);
+		p = fgets(line, sizeof(line), f);
+		PCUT_ASSERT_NOT_NULL(p);
+		PCUT_ASSERT_STR_EQUALS(exp, line);
+	}
+
+	p = fgets(line, sizeof(line), f);
+	PCUT_ASSERT_NULL(p);
+	PCUT_ASSERT_TRUE(feof(f));
+
+	(void) fclose(f);
+}
+
+/** Seeking while data are being read ahead */
+PCUT_TEST(read_seek)
+{
+	unsigned i;
+	size_t n;
+	int c;
+	int rc;
+	FILE *f;
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	for (i = 0; i < 65536; i++) {
+		c = fputc(i % 251, f);
+		PCUT_ASSERT_INT_EQUALS((int) (i % 251), c);
+	}
+
+	rewind(f);
+
+	/* Read a few buffers so that the stream is deemed sequential */
+	for (i = 0; i < 20000; i++) {
+		c = fgetc_unlocked(f);
+		PCUT_ASSERT_INT_EQUALS((int) (i % 251), c);
+	}
+
+	rc = fseek(f, 100, SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	PCUT_ASSERT_INT_EQUALS(100, ftell(f));
+
+	c = fgetc(f);
+	PCUT_ASSERT_INT_EQUALS(100, c);
+
+	/* Write in the middle and read it back */
+	rc = fseek(f, 30000, SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	n = fwrite("X", 1, 1, f);
+	PCUT_ASSERT_INT_EQUALS(1, n);
+
+	rc = fseek(f, 29999, SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	c = fgetc(f);
+	PCUT_ASSERT_INT_EQUALS(29999 % 251, c);
+	c = fgetc(f);
+	PCUT_ASSERT_INT_EQUALS('X', c);
+	c = fgetc(f);
+	PCUT_ASSERT_INT_EQUALS(30001 % 251, c);
+
+	(void) fclose(f);
+}
+
 /** perror function with NULL as argument */
 PCUT_TEST(perror_null_msg)
 {
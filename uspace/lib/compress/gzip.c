@@ -26,12 +26,14 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <errno.h>
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/checksum.h>
 #include "gzip.h"
 #include "inflate.h"
 
@@ -61,6 +63,14 @@ typedef struct {
 	uint32_t size;
 } __attribute__((packed)) gzip_footer_t;
 
+/** Streaming GZIP decompression */
+struct gzip_stream {
+	inflate_stream_t *inflate;  /**< Underlying inflate stream */
+	uint32_t crc32;             /**< CRC32 of the data read so far */
+	uint32_t size;              /**< Size of the data read so far */
+	bool done;                  /**< Footer checked */
+};
+
 /** Expand GZIP compressed data
  *
  * The routine allocates the output buffer based
@@ -175,9 +185,191 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 
 	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
 	if (ret != EOK) {
-		free(dest);
+		free(*dest);
 		return ret;
 	}
 
 	return EOK;
 }
+
+/** Skip zero-terminated string in GZIP stream header
+ *
+ * @param inflate Inflate stream.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t gzip_stream_skip_string(inflate_stream_t *inflate)
+{
+	uint8_t c;
+
+	do {
+		errno_t rc = inflate_stream_read_raw(inflate, &c, sizeof(c));
+		if (rc != EOK)
+			return rc;
+	} while (c != 0);
+
+	return EOK;
+}
+
+/** Create streaming GZIP decompression
+ *
+ * The GZIP header is read and checked immediately. The decompressed
+ * data are then returned by gzip_stream_read() while the compressed
+ * data are being read on demand by the @a read callback. Unlike
+ * gzip_expand(), the size of the data is not limited and the CRC32 of
+ * the data is verified.
+ *
+ * @param[in]  read    Input callback.
+ * @param[in]  arg     Argument passed to the input callback.
+ * @param[out] rstream Place to store pointer to the new stream.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression method or invalid stream.
+ * @return ELIMIT on premature end of input.
+ * @return ENOMEM if out of memory.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t gzip_stream_create(inflate_read_t read, void *arg,
+    gzip_stream_t **rstream)
+{
+	gzip_header_t header;
+	gzip_stream_t *stream;
+	errno_t rc;
+
+	stream = calloc(1, sizeof(gzip_stream_t));
+	if (stream == NULL)
+		return ENOMEM;
+
+	rc = inflate_stream_create(read, arg, &stream->inflate);
+	if (rc != EOK)
+		goto error;
+
+	rc = inflate_stream_read_raw(stream->inflate, &header, sizeof(header));
+	if (rc != EOK)
+		goto error;
+
+	if ((header.id1 != GZIP_ID1) ||
+	    (header.id2 != GZIP_ID2) ||
+	    (header.method != GZIP_METHOD_DEFLATE) ||
+	    ((header.flags & (~GZIP_FLAGS_MASK)) != 0)) {
+		rc = EINVAL;
+		goto error;
+	}
+
+	/* Ignore extra metadata */
+
+	if ((header.flags & GZIP_FLAG_FEXTRA) != 0) {
+		uint8_t extra_length[2];
+
+		rc = inflate_stream_read_raw(stream->inflate, extra_length,
+		    sizeof(extra_length));
+		if (rc != EOK)
+			goto error;
+
+		uint16_t len = extra_length[0] | (extra_length[1] << 8);
+		while (len > 0) {
+			uint8_t c;
+
+			rc = inflate_stream_read_raw(stream->inflate, &c,
+			    sizeof(c));
+			if (rc != EOK)
+				goto error;
+
+			len--;
+		}
+	}
+
+	if ((header.flags & GZIP_FLAG_FNAME) != 0) {
+		rc = gzip_stream_skip_string(stream->inflate);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
+		rc = gzip_stream_skip_string(stream->inflate);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
+		uint8_t hcrc[2];
+
+		rc = inflate_stream_read_raw(stream->inflate, hcrc,
+		    sizeof(hcrc));
+		if (rc != EOK)
+			goto error;
+	}
+
+	*rstream = stream;
+	return EOK;
+
+error:
+	if (stream->inflate != NULL)
+		inflate_stream_destroy(stream->inflate);
+
+	free(stream);
+	return rc;
+}
+
+/** Destroy streaming GZIP decompression
+ *
+ * @param stream GZIP stream.
+ *
+ */
+void gzip_stream_destroy(gzip_stream_t *stream)
+{
+	inflate_stream_destroy(stream->inflate);
+	free(stream);
+}
+
+/** Read decompressed data from GZIP stream
+ *
+ * @param[in]  stream GZIP stream.
+ * @param[out] buf    Destination buffer.
+ * @param[in]  size   Size of the destination buffer.
+ * @param[out] nread  Number of bytes actually read. Zero is returned
+ *                    at the end of the data.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid deflate data or CRC/size mismatch.
+ * @return ELIMIT on premature end of input.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t gzip_stream_read(gzip_stream_t *stream, void *buf, size_t size,
+    size_t *nread)
+{
+	gzip_footer_t footer;
+
+	if (stream->done) {
+		*nread = 0;
+		return EOK;
+	}
+
+	errno_t rc = inflate_stream_read(stream->inflate, buf, size, nread);
+	if (rc != EOK)
+		return rc;
+
+	if (*nread > 0) {
+		stream->crc32 = compute_crc32_seed((uint8_t *) buf, *nread,
+		    stream->crc32);
+		stream->size += *nread;
+		return EOK;
+	}
+
+	/* End of deflate data, check the footer */
+
+	rc = inflate_stream_read_raw(stream->inflate, &footer, sizeof(footer));
+	if (rc != EOK)
+		return rc;
+
+	if ((uint32_t_le2host(footer.crc32) != stream->crc32) ||
+	    (uint32_t_le2host(footer.size) != stream->size))
+		return EINVAL;
+
+	stream->done = true;
+	return EOK;
+}
@@ -29,8 +29,17 @@
 #ifndef LIBCOMPRESS_GZIP_H_
 #define LIBCOMPRESS_GZIP_H_
 
+#include <errno.h>
 #include <stddef.h>
+#include "inflate.h"
+
+struct gzip_stream;
+typedef struct gzip_stream gzip_stream_t;
 
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
 
+extern errno_t gzip_stream_create(inflate_read_t, void *, gzip_stream_t **);
+extern void gzip_stream_destroy(gzip_stream_t *);
+extern errno_t gzip_stream_read(gzip_stream_t *, void *, size_t, size_t *);
+
 #endif
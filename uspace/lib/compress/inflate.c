@@ -31,11 +31,23 @@
  * @brief Implementation of inflate decompression
  *
  * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. This code is
- * currently not optimized for speed but for readability.
+ * described by RFC 1951) based on puff.c by Mark Adler.
  *
- * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * Bits are fetched from the input into a 64-bit bit buffer several bytes
+ * at a time. Huffman codes up to FAST_BITS bits long are decoded using
+ * a single lookup into a table indexed by the next input bits, only the
+ * rare longer codes are decoded bit by bit.
+ *
+ * The decoder can either inflate a complete stream from memory to memory
+ * (inflate()) or it can pull the input via a callback and produce the
+ * output incrementally through a sliding window of bounded size
+ * (inflate_stream_read()).
+ *
+ * In the memory to memory case all dynamically allocated memory is taken
+ * from the stack. The stack usage should be typically bounded by 5 KB.
+ *
+ * The boot loader builds this file as well (with BOOT defined) to unpack
+ * its payload, it only uses the memory to memory decoder.
  *
  * Original copyright notice:
  *
@@ -67,7 +79,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <byteorder.h>
+
+#ifdef BOOT
+#include <memstr.h>
+#else
+#include <stdlib.h>
 #include <mem.h>
+#endif
+
 #include "inflate.h"
 
 /** Maximum bits in the Huffman code */
@@ -87,6 +107,27 @@
 /** Number of all codes */
 #define MAX_CODE  (MAX_LITLEN + MAX_DIST)
 
+/** Maximum length of a match */
+#define MAX_MATCH  258
+
+/** Number of bits decoded by a single table lookup */
+#define FAST_BITS  9
+/** Number of entries in the fast lookup table */
+#define FAST_SIZE  (1 << FAST_BITS)
+
+/** Fast lookup table entry (zero marks codes longer than FAST_BITS) */
+#define FAST_ENTRY(len, symbol)  ((uint16_t) (((len) << 9) | (symbol)))
+#define FAST_LEN(entry)          ((entry) >> 9)
+#define FAST_SYMBOL(entry)       ((entry) & 0x1ff)
+
+/** Size of the sliding window (maximum distance) */
+#define WINDOW_SIZE  32768
+
+/** Size of the output buffer of a stream (a multiple of the window) */
+#define STREAM_OUTBUF_SIZE  (4 * WINDOW_SIZE)
+/** Size of the input buffer of a stream */
+#define STREAM_INBUF_SIZE   16384
+
 /** Check for input buffer overrun condition */
 #define CHECK_OVERRUN(state) \
 	do { \
@@ -94,6 +135,29 @@
 			return ELIMIT; \
 	} while (false)
 
+/** Huffman code description
+ *
+ */
+typedef struct {
+	uint16_t *count;   /**< Array of symbol counts */
+	uint16_t *symbol;  /**< Array of symbols */
+	uint16_t *fast;    /**< Fast lookup table (FAST_SIZE entries) */
+} huffman_t;
+
+/** Inflate decoder mode
+ *
+ */
+typedef enum {
+	/** Expecting block header */
+	INFLATE_HEADER,
+	/** Inside a stored block */
+	INFLATE_STORED,
+	/** Inside a fixed or dynamic codes block */
+	INFLATE_CODES,
+	/** After the last block */
+	INFLATE_DONE
+} inflate_mode_t;
+
 /** Inflate algorithm state
  *
  */
@@ -102,23 +166,56 @@ typedef struct {
 	size_t destlen;   /**< Output buffer size */
 	size_t destcnt;   /**< Position in the output buffer */
 
-	uint8_t *src;     /**< Input buffer */
-	size_t srclen;    /**< Input buffer size */
-	size_t srccnt;    /**< Position in the input buffer */
+	/**
+	 * The output buffer is a sliding window, decoding is suspended
+	 * when it is full instead of failing.
+	 */
+	bool window;
+
+	const uint8_t *src;  /**< Input buffer */
+	size_t srclen;       /**< Input buffer size */
+	size_t srccnt;       /**< Position in the input buffer */
+
+	inflate_read_t read;  /**< Input callback (or NULL) */
+	void *arg;            /**< Input callback argument */
+	uint8_t *inbuf;       /**< Buffer for the input callback */
+	errno_t read_rc;      /**< Error returned by the input callback */
 
-	uint16_t bitbuf;  /**< Bit buffer */
+	uint64_t bitbuf;  /**< Bit buffer */
 	size_t bitlen;    /**< Number of bits in the bit buffer */
 
 	bool overrun;     /**< Overrun condition */
+
+	inflate_mode_t mode;  /**< Decoder mode */
+	bool last;            /**< Current block is the last one */
+	size_t stored_left;   /**< Bytes left in the current stored block */
+
+	huffman_t len_code;   /**< Huffman code for literal/length */
+	huffman_t dist_code;  /**< Huffman code for distance */
+
+	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
+	uint16_t dyn_len_symbol[MAX_LITLEN];
+	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
+	uint16_t dyn_dist_symbol[MAX_DIST];
+	uint16_t len_fast[FAST_SIZE];
+	uint16_t dist_fast[FAST_SIZE];
 } inflate_state_t;
 
-/** Huffman code description
+#ifndef BOOT
+
+/** Streaming inflate
  *
  */
-typedef struct {
-	uint16_t *count;   /**< Array of symbol counts */
-	uint16_t *symbol;  /**< Array of symbols */
-} huffman_t;
+struct inflate_stream {
+	inflate_state_t state;  /**< Decoder state */
+	size_t readpos;         /**< Position of unread data in the window */
+	errno_t error;          /**< Deferred decoding error */
+
+	uint8_t inbuf[STREAM_INBUF_SIZE];
+	uint8_t outbuf[STREAM_OUTBUF_SIZE];
+};
+
+#endif
 
 /** Length codes
  *
@@ -210,96 +307,252 @@ static uint16_t dist_symbol[MAX_DIST] = {
 	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
 };
 
-/** Huffman code for lengths
+/** Initialize inflate state
+ *
+ * @param state  Inflate state.
+ * @param dest   Output buffer.
+ * @param destlen Output buffer size.
+ * @param window Whether the output buffer is a sliding window.
  *
  */
-static huffman_t len_code = {
-	.count = len_count,
-	.symbol = len_symbol
-};
+static void inflate_state_init(inflate_state_t *state, void *dest,
+    size_t destlen, bool window)
+{
+	state->dest = (uint8_t *) dest;
+	state->destlen = destlen;
+	state->destcnt = 0;
+	state->window = window;
+
+	state->src = NULL;
+	state->srclen = 0;
+	state->srccnt = 0;
+
+	state->read = NULL;
+	state->arg = NULL;
+	state->inbuf = NULL;
+	state->read_rc = EOK;
+
+	state->bitbuf = 0;
+	state->bitlen = 0;
 
-/** Huffman code for distances
+	state->overrun = false;
+
+	state->mode = INFLATE_HEADER;
+	state->last = false;
+	state->stored_left = 0;
+
+	state->len_code.fast = state->len_fast;
+	state->dist_code.fast = state->dist_fast;
+}
+
+/** Get more input using the input callback
+ *
+ * @param state Inflate state.
+ *
+ * @return True if at least one more byte of input is available.
  *
  */
-static huffman_t dist_code = {
-	.count = dist_count,
-	.symbol = dist_symbol
-};
+static bool input_refill(inflate_state_t *state)
+{
+	if ((state->read == NULL) || (state->read_rc != EOK))
+		return false;
+
+	size_t nread;
+	errno_t rc = state->read(state->arg, state->inbuf, STREAM_INBUF_SIZE,
+	    &nread);
+	if (rc != EOK) {
+		state->read_rc = rc;
+		return false;
+	}
 
-/** Get bits from the bit buffer
+	state->src = state->inbuf;
+	state->srclen = nread;
+	state->srccnt = 0;
+
+	return (nread > 0);
+}
+
+/** Fill the bit buffer
  *
- * @param state Inflate state.
- * @param cnt   Number of bits to return (at most 16).
+ * Load at least 56 bits into the bit buffer unless the input is
+ * exhausted. If enough input is available, load a whole 64-bit word
+ * at once. The bits above bitlen are then either zero or they match the
+ * next input bits, thus it does not matter that they are loaded again.
  *
- * @return Returned bits.
+ * @param state Inflate state.
  *
  */
-static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
+static inline void bits_refill(inflate_state_t *state)
 {
-	/* Bit accumulator for at least 20 bits */
-	uint32_t val = state->bitbuf;
+	while (state->bitlen < 56) {
+		if (state->srclen - state->srccnt >= sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, state->src + state->srccnt, sizeof(word));
+
+			size_t bytes = (63 - state->bitlen) >> 3;
+			state->bitbuf |= uint64_t_le2host(word) << state->bitlen;
+			state->srccnt += bytes;
+			state->bitlen += bytes << 3;
+			return;
+		}
 
-	while (state->bitlen < cnt) {
 		if (state->srccnt == state->srclen) {
-			state->overrun = true;
-			return 0;
+			if (!input_refill(state))
+				return;
+
+			continue;
 		}
 
 		/* Load 8 more bits */
-		val |= ((uint32_t) state->src[state->srccnt]) << state->bitlen;
+		state->bitbuf |= ((uint64_t) state->src[state->srccnt]) <<
+		    state->bitlen;
 		state->srccnt++;
 		state->bitlen += 8;
 	}
+}
+
+/** Get bits from the bit buffer
+ *
+ * @param state Inflate state.
+ * @param cnt   Number of bits to return (at most 32).
+ *
+ * @return Returned bits.
+ *
+ */
+static inline uint32_t get_bits(inflate_state_t *state, size_t cnt)
+{
+	if (state->bitlen < cnt) {
+		bits_refill(state);
+
+		if (state->bitlen < cnt) {
+			state->overrun = true;
+			return 0;
+		}
+	}
+
+	uint32_t val = (uint32_t) (state->bitbuf & ((UINT64_C(1) << cnt) - 1));
 
 	/* Update bits in the buffer */
-	state->bitbuf = (uint16_t) (val >> cnt);
+	state->bitbuf >>= cnt;
 	state->bitlen -= cnt;
 
-	return ((uint16_t) (val & ((1 << cnt) - 1)));
+	return val;
 }
 
-/** Decode `stored' block
+/** Read raw bytes from the input
+ *
+ * The bit buffer is first aligned to a byte boundary.
+ *
+ * @param state Inflate state.
+ * @param buf   Destination buffer.
+ * @param cnt   Number of bytes to read.
+ *
+ * @return EOK on success.
+ * @return ELIMIT on input buffer overrun.
+ *
+ */
+static errno_t get_bytes(inflate_state_t *state, uint8_t *buf, size_t cnt)
+{
+	/* Discard bits up to the byte boundary */
+	state->bitbuf >>= state->bitlen & 7;
+	state->bitlen &= ~((size_t) 7);
+
+	/* Return whole bytes from the bit buffer first */
+	while ((cnt > 0) && (state->bitlen > 0)) {
+		*buf = (uint8_t) state->bitbuf;
+		buf++;
+		cnt--;
+
+		state->bitbuf >>= 8;
+		state->bitlen -= 8;
+	}
+
+	if (state->bitlen == 0)
+		state->bitbuf = 0;
+
+	while (cnt > 0) {
+		if (state->srccnt == state->srclen) {
+			if (!input_refill(state)) {
+				state->overrun = true;
+				return ELIMIT;
+			}
+		}
+
+		size_t chunk = state->srclen - state->srccnt;
+		if (chunk > cnt)
+			chunk = cnt;
+
+		memcpy(buf, state->src + state->srccnt, chunk);
+		state->srccnt += chunk;
+		buf += chunk;
+		cnt -= chunk;
+	}
+
+	return EOK;
+}
+
+/** Start decoding `stored' block
  *
  * @param state Inflate state.
  *
  * @return EOK on success.
  * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  * @return EINVAL on invalid data.
  *
  */
-static errno_t inflate_stored(inflate_state_t *state)
+static errno_t inflate_stored_start(inflate_state_t *state)
 {
-	/* Discard bits in the bit buffer */
-	state->bitbuf = 0;
-	state->bitlen = 0;
+	uint8_t hdr[4];
 
-	if (state->srccnt + 4 > state->srclen)
-		return ELIMIT;
+	errno_t rc = get_bytes(state, hdr, sizeof(hdr));
+	if (rc != EOK)
+		return rc;
 
-	uint16_t len =
-	    state->src[state->srccnt] | (state->src[state->srccnt + 1] << 8);
-	uint16_t len_compl =
-	    state->src[state->srccnt + 2] | (state->src[state->srccnt + 3] << 8);
+	uint16_t len = hdr[0] | (hdr[1] << 8);
+	uint16_t len_compl = hdr[2] | (hdr[3] << 8);
 
 	/* Check block length and its complement */
 	if (((int16_t) len) != ~((int16_t) len_compl))
 		return EINVAL;
 
-	state->srccnt += 4;
+	state->stored_left = len;
+	state->mode = INFLATE_STORED;
 
-	/* Check input buffer size */
-	if (state->srccnt + len > state->srclen)
-		return ELIMIT;
+	return EOK;
+}
 
-	/* Check output buffer size */
-	if (state->destcnt + len > state->destlen)
-		return ENOMEM;
+/** Decode `stored' block
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success (the block might be only partially decoded
+ *         if the output window is full).
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+static errno_t inflate_stored(inflate_state_t *state)
+{
+	size_t room = state->destlen - state->destcnt;
+	size_t len = state->stored_left;
+
+	if (len > room) {
+		if (!state->window)
+			return ENOMEM;
+
+		len = room;
+	}
 
 	/* Copy data */
-	memcpy(state->dest + state->destcnt, state->src + state->srccnt, len);
-	state->srccnt += len;
+	errno_t rc = get_bytes(state, state->dest + state->destcnt, len);
+	if (rc != EOK)
+		return rc;
+
 	state->destcnt += len;
+	state->stored_left -= len;
+
+	if (state->stored_left == 0)
+		state->mode = INFLATE_HEADER;
 
 	return EOK;
 }
@@ -312,11 +565,31 @@ static errno_t inflate_stored(inflate_state_t *state)
  *
  * @param EOK on success.
  * @param EINVAL on invalid Huffman code.
+ * @param ELIMIT on input buffer overrun.
  *
  */
-static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
-    uint16_t *symbol)
+static inline errno_t huffman_decode(inflate_state_t *state,
+    huffman_t *huffman, uint16_t *symbol)
 {
+	if (state->bitlen < MAX_HUFFMAN_BIT)
+		bits_refill(state);
+
+	/* Fast path: short code decoded by a single lookup */
+	uint16_t entry = huffman->fast[state->bitbuf & (FAST_SIZE - 1)];
+	if (entry != 0) {
+		size_t len = FAST_LEN(entry);
+		if (len > state->bitlen) {
+			state->overrun = true;
+			return ELIMIT;
+		}
+
+		state->bitbuf >>= len;
+		state->bitlen -= len;
+
+		*symbol = FAST_SYMBOL(entry);
+		return EOK;
+	}
+
 	/* Decode bits */
 	uint16_t code = 0;
 
@@ -333,12 +606,19 @@ static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
 	size_t len;
 
 	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		if (len > state->bitlen) {
+			state->overrun = true;
+			return ELIMIT;
+		}
+
 		/* Get next bit */
-		code |= get_bits(state, 1);
-		CHECK_OVERRUN(*state);
+		code |= (state->bitbuf >> (len - 1)) & 1;
 
 		uint16_t count = huffman->count[len];
 		if (code < first + count) {
+			state->bitbuf >>= len;
+			state->bitlen -= len;
+
 			/* Return decoded symbol */
 			*symbol = huffman->symbol[index + code - first];
 			return EOK;
@@ -410,13 +690,53 @@ static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 	return left;
 }
 
+/** Construct the fast lookup table of a Huffman code
+ *
+ * Codes are stored in the input stream starting from the most
+ * significant bit, thus the table is indexed by the bit-reversed code.
+ * All entries whose low bits match a code shorter than FAST_BITS
+ * are filled with that code.
+ *
+ * @param huffman Huffman code with valid counts and symbols.
+ *
+ */
+static void huffman_construct_fast(huffman_t *huffman)
+{
+	memset(huffman->fast, 0, FAST_SIZE * sizeof(uint16_t));
+
+	uint16_t code = 0;
+	size_t index = 0;
+	size_t len;
+
+	for (len = 1; len <= FAST_BITS; len++) {
+		uint16_t count;
+		for (count = 0; count < huffman->count[len]; count++) {
+			/* Reverse the code */
+			uint16_t rev = 0;
+			size_t bit;
+			for (bit = 0; bit < len; bit++) {
+				if ((code & (1 << bit)) != 0)
+					rev |= 1 << (len - 1 - bit);
+			}
+
+			uint16_t entry = FAST_ENTRY(len, huffman->symbol[index]);
+			size_t pos;
+			for (pos = rev; pos < FAST_SIZE; pos += 1 << len)
+				huffman->fast[pos] = entry;
+
+			code++;
+			index++;
+		}
+
+		code <<= 1;
+	}
+}
+
 /** Decode literal/length and distance codes
  *
- * Decode until end-of-block code.
+ * Decode until end-of-block code or until the output window is full.
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
  *
  * @return EOK on success.
  * @return ENOENT on distance too large.
@@ -425,13 +745,17 @@ static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
  * @return ENOMEM on output buffer overrun.
  *
  */
-static errno_t inflate_codes(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static errno_t inflate_codes(inflate_state_t *state)
 {
 	uint16_t symbol;
 
-	do {
-		errno_t err = huffman_decode(state, len_code, &symbol);
+	while (true) {
+		/* Suspend if the next match might not fit into the window */
+		if ((state->window) &&
+		    (state->destlen - state->destcnt < MAX_MATCH))
+			return EOK;
+
+		errno_t err = huffman_decode(state, &state->len_code, &symbol);
 		if (err != EOK) {
 			/* Error decoding */
 			return err;
@@ -454,75 +778,86 @@ static errno_t inflate_codes(inflate_state_t *state, huffman_t *len_code,
 			CHECK_OVERRUN(*state);
 
 			/* Get distance */
-			err = huffman_decode(state, dist_code, &symbol);
+			err = huffman_decode(state, &state->dist_code, &symbol);
 			if (err != EOK)
 				return err;
 
+			if (symbol >= MAX_DIST)
+				return EINVAL;
+
 			size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
+			CHECK_OVERRUN(*state);
+
 			if (dist > state->destcnt)
 				return ENOENT;
 
 			if (state->destcnt + len > state->destlen)
 				return ENOMEM;
 
-			while (len > 0) {
-				/* Copy len bytes from distance bytes back */
-				state->dest[state->destcnt] =
-				    state->dest[state->destcnt - dist];
-				state->destcnt++;
-				len--;
+			/* Copy len bytes from distance bytes back */
+			uint8_t *out = state->dest + state->destcnt;
+			const uint8_t *from = out - dist;
+
+			if (dist >= len) {
+				memcpy(out, from, len);
+			} else if (dist == 1) {
+				memset(out, *from, len);
+			} else {
+				size_t i;
+				for (i = 0; i < len; i++)
+					out[i] = from[i];
 			}
-		}
-	} while (symbol != 256);
 
-	return EOK;
+			state->destcnt += len;
+		} else {
+			/* End of block */
+			state->mode = INFLATE_HEADER;
+			return EOK;
+		}
+	}
 }
 
-/** Decode `fixed codes' block
+/** Start decoding `fixed codes' block
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
-static errno_t inflate_fixed(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static errno_t inflate_fixed_start(inflate_state_t *state)
 {
-	return inflate_codes(state, len_code, dist_code);
+	state->len_code.count = len_count;
+	state->len_code.symbol = len_symbol;
+	huffman_construct_fast(&state->len_code);
+
+	state->dist_code.count = dist_count;
+	state->dist_code.symbol = dist_symbol;
+	huffman_construct_fast(&state->dist_code);
+
+	state->mode = INFLATE_CODES;
+	return EOK;
 }
 
-/** Decode `dynamic codes' block
+/** Start decoding `dynamic codes' block
  *
- * @param state     Inflate state.
+ * @param state Inflate state.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code.
  * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
-static errno_t inflate_dynamic(inflate_state_t *state)
+static errno_t inflate_dynamic_start(inflate_state_t *state)
 {
 	uint16_t length[MAX_CODE];
-	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_len_symbol[MAX_LITLEN];
-	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_dist_symbol[MAX_DIST];
-	huffman_t dyn_len_code;
-	huffman_t dyn_dist_code;
+	huffman_t *dyn_len_code = &state->len_code;
+	huffman_t *dyn_dist_code = &state->dist_code;
 
-	dyn_len_code.count = dyn_len_count;
-	dyn_len_code.symbol = dyn_len_symbol;
+	dyn_len_code->count = state->dyn_len_count;
+	dyn_len_code->symbol = state->dyn_len_symbol;
 
-	dyn_dist_code.count = dyn_dist_count;
-	dyn_dist_code.symbol = dyn_dist_symbol;
+	dyn_dist_code->count = state->dyn_dist_count;
+	dyn_dist_code->symbol = state->dyn_dist_symbol;
 
 	/* Get number of bits in each table */
 	uint16_t nlen = get_bits(state, 5) + 257;
@@ -550,17 +885,19 @@ static errno_t inflate_dynamic(inflate_state_t *state)
 		length[order[index]] = 0;
 
 	/* Build Huffman code */
-	int16_t rc = huffman_construct(&dyn_len_code, length, MAX_ORDER);
+	int16_t rc = huffman_construct(dyn_len_code, length, MAX_ORDER);
 	if (rc != 0)
 		return EINVAL;
 
+	huffman_construct_fast(dyn_len_code);
+
 	/* Read length/literal and distance code length tables */
 	index = 0;
 	while (index < nlen + ndist) {
 		uint16_t symbol;
-		errno_t err = huffman_decode(state, &dyn_len_code, &symbol);
+		errno_t err = huffman_decode(state, dyn_len_code, &symbol);
 		if (err != EOK)
-			return EOK;
+			return err;
 
 		if (symbol < 16) {
 			length[index] = symbol;
@@ -599,16 +936,112 @@ static errno_t inflate_dynamic(inflate_state_t *state)
 		return EINVAL;
 
 	/* Build Huffman tables for literal/length codes */
-	rc = huffman_construct(&dyn_len_code, length, nlen);
-	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
+	rc = huffman_construct(dyn_len_code, length, nlen);
+	if ((rc < 0) || ((rc > 0) && (dyn_len_code->count[0] + 1 != nlen)))
 		return EINVAL;
 
 	/* Build Huffman tables for distance codes */
-	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
-	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
+	rc = huffman_construct(dyn_dist_code, length + nlen, ndist);
+	if ((rc < 0) || ((rc > 0) && (dyn_dist_code->count[0] + 1 != ndist)))
 		return EINVAL;
 
-	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
+	huffman_construct_fast(dyn_len_code);
+	huffman_construct_fast(dyn_dist_code);
+
+	state->mode = INFLATE_CODES;
+	return EOK;
+}
+
+/** Decode block header
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ * @return ELIMIT on input buffer overrun.
+ *
+ */
+static errno_t inflate_block_start(inflate_state_t *state)
+{
+	if (state->last) {
+		state->mode = INFLATE_DONE;
+		return EOK;
+	}
+
+	/* Last block is indicated by a non-zero bit */
+	state->last = get_bits(state, 1);
+	CHECK_OVERRUN(*state);
+
+	/* Block type */
+	uint16_t type = get_bits(state, 2);
+	CHECK_OVERRUN(*state);
+
+	switch (type) {
+	case 0:
+		return inflate_stored_start(state);
+	case 1:
+		return inflate_fixed_start(state);
+	case 2:
+		return inflate_dynamic_start(state);
+	default:
+		return EINVAL;
+	}
+}
+
+/** Run the decoder
+ *
+ * Decode blocks until the end of the last block. If the output
+ * buffer is a sliding window, return early once it is full.
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+static errno_t inflate_run(inflate_state_t *state)
+{
+	errno_t ret;
+
+	while (state->mode != INFLATE_DONE) {
+		switch (state->mode) {
+		case INFLATE_HEADER:
+			ret = inflate_block_start(state);
+			if (ret != EOK)
+				return ret;
+
+			break;
+		case INFLATE_STORED:
+			ret = inflate_stored(state);
+			if (ret != EOK)
+				return ret;
+
+			if (state->mode == INFLATE_STORED) {
+				/* Output window full */
+				return EOK;
+			}
+
+			break;
+		case INFLATE_CODES:
+			ret = inflate_codes(state);
+			if (ret != EOK)
+				return ret;
+
+			if (state->mode == INFLATE_CODES) {
+				/* Output window full */
+				return EOK;
+			}
+
+			break;
+		case INFLATE_DONE:
+			break;
+		}
+	}
+
+	return EOK;
 }
 
 /** Inflate data
@@ -625,50 +1058,155 @@ static errno_t inflate_dynamic(inflate_state_t *state)
  * @return ENOMEM on output buffer overrun.
  *
  */
-errno_t inflate(void *src, size_t srclen, void *dest, size_t destlen)
+errno_t inflate(const void *src, size_t srclen, void *dest, size_t destlen)
 {
 	/* Initialize the state */
 	inflate_state_t state;
 
-	state.dest = (uint8_t *) dest;
-	state.destlen = destlen;
-	state.destcnt = 0;
+	inflate_state_init(&state, dest, destlen, false);
 
-	state.src = (uint8_t *) src;
+	state.src = (const uint8_t *) src;
 	state.srclen = srclen;
-	state.srccnt = 0;
 
-	state.bitbuf = 0;
-	state.bitlen = 0;
+	return inflate_run(&state);
+}
+
+#ifndef BOOT
 
-	state.overrun = false;
+/** Create inflate stream
+ *
+ * The compressed data are read using the @a read callback on demand.
+ * The decompressed data are returned by inflate_stream_read(). The memory
+ * used by the stream is bounded and does not depend on the size of
+ * the data.
+ *
+ * @param[in]  read   Input callback.
+ * @param[in]  arg    Argument passed to the input callback.
+ * @param[out] rstream Place to store pointer to the new stream.
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t inflate_stream_create(inflate_read_t read, void *arg,
+    inflate_stream_t **rstream)
+{
+	inflate_stream_t *stream = malloc(sizeof(inflate_stream_t));
+	if (stream == NULL)
+		return ENOMEM;
 
-	uint16_t last;
-	errno_t ret = EOK;
+	inflate_state_init(&stream->state, stream->outbuf, STREAM_OUTBUF_SIZE,
+	    true);
 
-	do {
-		/* Last block is indicated by a non-zero bit */
-		last = get_bits(&state, 1);
-		CHECK_OVERRUN(state);
+	stream->state.read = read;
+	stream->state.arg = arg;
+	stream->state.inbuf = stream->inbuf;
+	stream->readpos = 0;
+	stream->error = EOK;
 
-		/* Block type */
-		uint16_t type = get_bits(&state, 2);
-		CHECK_OVERRUN(state);
+	*rstream = stream;
+	return EOK;
+}
 
-		switch (type) {
-		case 0:
-			ret = inflate_stored(&state);
-			break;
-		case 1:
-			ret = inflate_fixed(&state, &len_code, &dist_code);
-			break;
-		case 2:
-			ret = inflate_dynamic(&state);
-			break;
-		default:
-			ret = EINVAL;
+/** Destroy inflate stream
+ *
+ * @param stream Inflate stream.
+ *
+ */
+void inflate_stream_destroy(inflate_stream_t *stream)
+{
+	free(stream);
+}
+
+/** Read decompressed data from inflate stream
+ *
+ * @param[in]  stream Inflate stream.
+ * @param[out] buf    Destination buffer.
+ * @param[in]  size   Size of the destination buffer.
+ * @param[out] nread  Number of bytes actually read. Zero is returned
+ *                    at the end of the deflate stream.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ * @return ELIMIT on premature end of input.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t inflate_stream_read(inflate_stream_t *stream, void *buf, size_t size,
+    size_t *nread)
+{
+	inflate_state_t *state = &stream->state;
+
+	while (stream->readpos == state->destcnt) {
+		if (state->mode == INFLATE_DONE) {
+			*nread = 0;
+			return EOK;
 		}
-	} while ((!last) && (ret == 0));
 
-	return ret;
+		if ((state->destlen - state->destcnt < MAX_MATCH) &&
+		    (state->destcnt > WINDOW_SIZE)) {
+			/*
+			 * Slide the window. All data has already been read,
+			 * only keep the data that can still be referenced.
+			 */
+			memmove(state->dest, state->dest + state->destcnt -
+			    WINDOW_SIZE, WINDOW_SIZE);
+			state->destcnt = WINDOW_SIZE;
+			stream->readpos = WINDOW_SIZE;
+		}
+
+		if (stream->error != EOK)
+			return stream->error;
+
+		errno_t rc = inflate_run(state);
+		if (rc != EOK) {
+			if (state->read_rc != EOK)
+				rc = state->read_rc;
+
+			/* Return the data decoded so far first */
+			stream->error = rc;
+			if (stream->readpos == state->destcnt)
+				return rc;
+		}
+	}
+
+	size_t avail = state->destcnt - stream->readpos;
+	if (size > avail)
+		size = avail;
+
+	memcpy(buf, state->dest + stream->readpos, size);
+	stream->readpos += size;
+
+	*nread = size;
+	return EOK;
+}
+
+/** Read raw data from inflate stream
+ *
+ * Read bytes which are not deflate-compressed from the input of the stream,
+ * starting at the next byte boundary. This can be used to read headers
+ * before the beginning and trailers after the end of the deflate data.
+ *
+ * @param stream Inflate stream.
+ * @param buf    Destination buffer.
+ * @param size   Number of bytes to read.
+ *
+ * @return EOK on success.
+ * @return ELIMIT on premature end of input.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t inflate_stream_read_raw(inflate_stream_t *stream, void *buf,
+    size_t size)
+{
+	inflate_state_t *state = &stream->state;
+
+	errno_t rc = get_bytes(state, (uint8_t *) buf, size);
+	if (rc != EOK)
+		return (state->read_rc != EOK) ? state->read_rc : rc;
+
+	return EOK;
 }
+
+#endif
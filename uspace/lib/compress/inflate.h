@@ -29,8 +29,27 @@
 #ifndef LIBCOMPRESS_INFLATE_H_
 #define LIBCOMPRESS_INFLATE_H_
 
+#include <errno.h>
 #include <stddef.h>
 
-extern errno_t inflate(void *, size_t, void *, size_t);
+/** Inflate stream input callback
+ *
+ * The callback reads at most the given number of bytes into the buffer
+ * and stores the number of bytes actually read. Zero bytes read indicates
+ * the end of input.
+ */
+typedef errno_t (*inflate_read_t)(void *, void *, size_t, size_t *);
+
+struct inflate_stream;
+typedef struct inflate_stream inflate_stream_t;
+
+extern errno_t inflate(const void *, size_t, void *, size_t);
+
+extern errno_t inflate_stream_create(inflate_read_t, void *,
+    inflate_stream_t **);
+extern void inflate_stream_destroy(inflate_stream_t *);
+extern errno_t inflate_stream_read(inflate_stream_t *, void *, size_t,
+    size_t *);
+extern errno_t inflate_stream_read_raw(inflate_stream_t *, void *, size_t);
 
 #endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file accel.c
+ *
+ * Generic stand-in for architectures without accelerated primitives.
+ */
+
+#include <assert.h>
+#include "accel.h"
+
+bool aes_accel_available(void)
+{
+	return false;
+}
+
+void aes_accel_set_key(const uint32_t *key_exp, uint32_t *enc_key,
+    uint32_t *dec_key)
+{
+	assert(false);
+}
+
+void aes_accel_encrypt(const uint32_t *enc_key, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	assert(false);
+}
+
+void aes_accel_decrypt(const uint32_t *dec_key, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	assert(false);
+}
+
+void aes_accel_ctr(const uint32_t *enc_key, uint8_t *ctr,
+    const uint8_t *input, uint8_t *output, size_t blocks, size_t width)
+{
+	assert(false);
+}
+
+bool ghash_accel_available(void)
+{
+	return false;
+}
+
+void ghash_accel_set_key(const uint8_t *h, uint8_t *key)
+{
+	assert(false);
+}
+
+void ghash_accel(const uint8_t *key, uint8_t *x, const uint8_t *data,
+    size_t blocks)
+{
+	assert(false);
+}
+
+bool sha256_accel_available(void)
+{
+	return false;
+}
+
+void sha256_accel(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	assert(false);
+}
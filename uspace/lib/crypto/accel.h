@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file accel.h
+ *
+ * Interface to CPU-specific implementations of cryptographic primitives.
+ *
+ * Each architecture may provide its own implementation in
+ * arch/$(UARCH)/accel.c. The generic accel.c only reports that no
+ * acceleration is available. The *_available() functions are queried
+ * at runtime and the remaining functions are called only if the
+ * corresponding feature is present on the running CPU.
+ */
+
+#ifndef LIBCRYPTO_ACCEL_H
+#define LIBCRYPTO_ACCEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern bool aes_accel_available(void);
+extern void aes_accel_set_key(const uint32_t *, uint32_t *, uint32_t *);
+extern void aes_accel_encrypt(const uint32_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern void aes_accel_decrypt(const uint32_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern void aes_accel_ctr(const uint32_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t, size_t);
+
+extern bool ghash_accel_available(void);
+extern void ghash_accel_set_key(const uint8_t *, uint8_t *);
+extern void ghash_accel(const uint8_t *, uint8_t *, const uint8_t *, size_t);
+
+extern bool sha256_accel_available(void);
+extern void sha256_accel(uint32_t *, const uint8_t *, size_t);
+
+extern const uint32_t sha256_k[];
+extern void ctr_increment(uint8_t *, size_t);
+
+#endif
@@ -25,18 +25,25 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 /** @file aes.c
  *
- * Implementation of AES-128 symmetric cipher cryptographic algorithm.
+ * Implementation of AES-128 symmetric cipher cryptographic algorithm
+ * and of the CTR and GCM modes of operation.
+ *
+ * Based on FIPS 197 and NIST SP 800-38A/800-38D.
  *
- * Based on FIPS 197.
+ * The portable implementation combines SubBytes, ShiftRows and
+ * MixColumns into lookups in a single 32-bit table per direction
+ * (the remaining three tables are obtained by rotation). When the CPU
+ * supports it, the AES and GHASH computations are delegated to the
+ * architecture-specific implementation (see accel.h).
  */
 
 #include <stdbool.h>
 #include <errno.h>
 #include <mem.h>
 #include "crypto.h"
+#include "accel.h"
 
 /* Number of elements in rows/columns in AES arrays. */
 #define ELEMS  4
@@ -48,14 +55,11 @@
 #define BLOCK_LEN  16
 
 /* Number of iterations in AES algorithm. */
-#define ROUNDS  10
+#define ROUNDS  AES_ROUNDS
 
-/** Irreducible polynomial used in AES algorithm.
- *
- * NOTE: x^8 + x^4 + x^3 + x + 1.
- *
- */
-#define AES_IP  0x1b
+/* Width of the incremented part of the counter block in CTR and GCM. */
+#define CTR_WIDTH_FULL  16
+#define CTR_WIDTH_GCM   4
 
 /** Precomputed values for AES sub_byte transformation. */
 static const uint8_t sbox[BLOCK_LEN][BLOCK_LEN] = {
@@ -126,7 +130,7 @@ static const uint8_t sbox[BLOCK_LEN][BLOCK_LEN] = {
 };
 
 /** Precomputed values for AES inv_sub_byte transformation. */
-static uint8_t inv_sbox[BLOCK_LEN][BLOCK_LEN] = {
+static const uint8_t inv_sbox[BLOCK_LEN][BLOCK_LEN] = {
 	{
 		0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38,
 		0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb
@@ -200,6 +204,188 @@ static const uint32_t r_con_array[] = {
 	0x1b000000, 0x36000000
 };
 
+
+/** Encryption round table combining SubBytes and MixColumns. */
+static const uint32_t te0[256] = {
+	0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d,
+	0xfff2f20d, 0xd66b6bbd, 0xde6f6fb1, 0x91c5c554,
+	0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d,
+	0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a,
+	0x8fcaca45, 0x1f82829d, 0x89c9c940, 0xfa7d7d87,
+	0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+	0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea,
+	0x239c9cbf, 0x53a4a4f7, 0xe4727296, 0x9bc0c05b,
+	0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a,
+	0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f,
+	0x6834345c, 0x51a5a5f4, 0xd1e5e534, 0xf9f1f108,
+	0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+	0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e,
+	0x30181828, 0x379696a1, 0x0a05050f, 0x2f9a9ab5,
+	0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d,
+	0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f,
+	0x1209091b, 0x1d83839e, 0x582c2c74, 0x341a1a2e,
+	0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+	0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce,
+	0x5229297b, 0xdde3e33e, 0x5e2f2f71, 0x13848497,
+	0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c,
+	0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed,
+	0xd46a6abe, 0x8dcbcb46, 0x67bebed9, 0x7239394b,
+	0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+	0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16,
+	0x864343c5, 0x9a4d4dd7, 0x66333355, 0x11858594,
+	0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81,
+	0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3,
+	0xa25151f3, 0x5da3a3fe, 0x804040c0, 0x058f8f8a,
+	0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+	0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163,
+	0x20101030, 0xe5ffff1a, 0xfdf3f30e, 0xbfd2d26d,
+	0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f,
+	0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739,
+	0x93c4c457, 0x55a7a7f2, 0xfc7e7e82, 0x7a3d3d47,
+	0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+	0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f,
+	0x44222266, 0x542a2a7e, 0x3b9090ab, 0x0b888883,
+	0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c,
+	0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76,
+	0xdbe0e03b, 0x64323256, 0x743a3a4e, 0x140a0a1e,
+	0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+	0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6,
+	0x399191a8, 0x319595a4, 0xd3e4e437, 0xf279798b,
+	0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7,
+	0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0,
+	0xd86c6cb4, 0xac5656fa, 0xf3f4f407, 0xcfeaea25,
+	0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+	0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72,
+	0x381c1c24, 0x57a6a6f1, 0x73b4b4c7, 0x97c6c651,
+	0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21,
+	0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85,
+	0xe0707090, 0x7c3e3e42, 0x71b5b5c4, 0xcc6666aa,
+	0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+	0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0,
+	0x17868691, 0x99c1c158, 0x3a1d1d27, 0x279e9eb9,
+	0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133,
+	0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7,
+	0x2d9b9bb6, 0x3c1e1e22, 0x15878792, 0xc9e9e920,
+	0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+	0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17,
+	0x65bfbfda, 0xd7e6e631, 0x844242c6, 0xd06868b8,
+	0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11,
+	0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a
+};
+
+/** Decryption round table combining InvSubBytes and InvMixColumns. */
+static const uint32_t td0[256] = {
+	0x51f4a750, 0x7e416553, 0x1a17a4c3, 0x3a275e96,
+	0x3bab6bcb, 0x1f9d45f1, 0xacfa58ab, 0x4be30393,
+	0x2030fa55, 0xad766df6, 0x88cc7691, 0xf5024c25,
+	0x4fe5d7fc, 0xc52acbd7, 0x26354480, 0xb562a38f,
+	0xdeb15a49, 0x25ba1b67, 0x45ea0e98, 0x5dfec0e1,
+	0xc32f7502, 0x814cf012, 0x8d4697a3, 0x6bd3f9c6,
+	0x038f5fe7, 0x15929c95, 0xbf6d7aeb, 0x955259da,
+	0xd4be832d, 0x587421d3, 0x49e06929, 0x8ec9c844,
+	0x75c2896a, 0xf48e7978, 0x99583e6b, 0x27b971dd,
+	0xbee14fb6, 0xf088ad17, 0xc920ac66, 0x7dce3ab4,
+	0x63df4a18, 0xe51a3182, 0x97513360, 0x62537f45,
+	0xb16477e0, 0xbb6bae84, 0xfe81a01c, 0xf9082b94,
+	0x70486858, 0x8f45fd19, 0x94de6c87, 0x527bf8b7,
+	0xab73d323, 0x724b02e2, 0xe31f8f57, 0x6655ab2a,
+	0xb2eb2807, 0x2fb5c203, 0x86c57b9a, 0xd33708a5,
+	0x302887f2, 0x23bfa5b2, 0x02036aba, 0xed16825c,
+	0x8acf1c2b, 0xa779b492, 0xf307f2f0, 0x4e69e2a1,
+	0x65daf4cd, 0x0605bed5, 0xd134621f, 0xc4a6fe8a,
+	0x342e539d, 0xa2f355a0, 0x058ae132, 0xa4f6eb75,
+	0x0b83ec39, 0x4060efaa, 0x5e719f06, 0xbd6e1051,
+	0x3e218af9, 0x96dd063d, 0xdd3e05ae, 0x4de6bd46,
+	0x91548db5, 0x71c45d05, 0x0406d46f, 0x605015ff,
+	0x1998fb24, 0xd6bde997, 0x894043cc, 0x67d99e77,
+	0xb0e842bd, 0x07898b88, 0xe7195b38, 0x79c8eedb,
+	0xa17c0a47, 0x7c420fe9, 0xf8841ec9, 0x00000000,
+	0x09808683, 0x322bed48, 0x1e1170ac, 0x6c5a724e,
+	0xfd0efffb, 0x0f853856, 0x3daed51e, 0x362d3927,
+	0x0a0fd964, 0x685ca621, 0x9b5b54d1, 0x24362e3a,
+	0x0c0a67b1, 0x9357e70f, 0xb4ee96d2, 0x1b9b919e,
+	0x80c0c54f, 0x61dc20a2, 0x5a774b69, 0x1c121a16,
+	0xe293ba0a, 0xc0a02ae5, 0x3c22e043, 0x121b171d,
+	0x0e090d0b, 0xf28bc7ad, 0x2db6a8b9, 0x141ea9c8,
+	0x57f11985, 0xaf75074c, 0xee99ddbb, 0xa37f60fd,
+	0xf701269f, 0x5c72f5bc, 0x44663bc5, 0x5bfb7e34,
+	0x8b432976, 0xcb23c6dc, 0xb6edfc68, 0xb8e4f163,
+	0xd731dcca, 0x42638510, 0x13972240, 0x84c61120,
+	0x854a247d, 0xd2bb3df8, 0xaef93211, 0xc729a16d,
+	0x1d9e2f4b, 0xdcb230f3, 0x0d8652ec, 0x77c1e3d0,
+	0x2bb3166c, 0xa970b999, 0x119448fa, 0x47e96422,
+	0xa8fc8cc4, 0xa0f03f1a, 0x567d2cd8, 0x223390ef,
+	0x87494ec7, 0xd938d1c1, 0x8ccaa2fe, 0x98d40b36,
+	0xa6f581cf, 0xa57ade28, 0xdab78e26, 0x3fadbfa4,
+	0x2c3a9de4, 0x5078920d, 0x6a5fcc9b, 0x547e4662,
+	0xf68d13c2, 0x90d8b8e8, 0x2e39f75e, 0x82c3aff5,
+	0x9f5d80be, 0x69d0937c, 0x6fd52da9, 0xcf2512b3,
+	0xc8ac993b, 0x10187da7, 0xe89c636e, 0xdb3bbb7b,
+	0xcd267809, 0x6e5918f4, 0xec9ab701, 0x834f9aa8,
+	0xe6956e65, 0xaaffe67e, 0x21bccf08, 0xef15e8e6,
+	0xbae79bd9, 0x4a6f36ce, 0xea9f09d4, 0x29b07cd6,
+	0x31a4b2af, 0x2a3f2331, 0xc6a59430, 0x35a266c0,
+	0x744ebc37, 0xfc82caa6, 0xe090d0b0, 0x33a7d815,
+	0xf104984a, 0x41ecdaf7, 0x7fcd500e, 0x1791f62f,
+	0x764dd68d, 0x43efb04d, 0xccaa4d54, 0xe49604df,
+	0x9ed1b5e3, 0x4c6a881b, 0xc12c1fb8, 0x4665517f,
+	0x9d5eea04, 0x018c355d, 0xfa877473, 0xfb0b412e,
+	0xb3671d5a, 0x92dbd252, 0xe9105633, 0x6dd64713,
+	0x9ad7618c, 0x37a10c7a, 0x59f8148e, 0xeb133c89,
+	0xcea927ee, 0xb761c935, 0xe11ce5ed, 0x7a47b13c,
+	0x9cd2df59, 0x55f2733f, 0x1814ce79, 0x73c737bf,
+	0x53f7cdea, 0x5ffdaa5b, 0xdf3d6f14, 0x7844db86,
+	0xcaaff381, 0xb968c43e, 0x3824342c, 0xc2a3405f,
+	0x161dc372, 0xbce2250c, 0x283c498b, 0xff0d9541,
+	0x39a80171, 0x080cb3de, 0xd8b4e49c, 0x6456c190,
+	0x7bcb8461, 0xd532b670, 0x486c5c74, 0xd0b85742
+};
+
+/** Reduction constants for the 4-bit table-driven GHASH multiplication. */
+static const uint64_t ghash_last4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460,
+	0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560,
+	0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/** One round of the T-table encryption for the output column @a a. */
+#define ENC_ROUND(a, b, c, d) \
+	(te0[(a) >> 24] ^ \
+	rotr_uint32(te0[((b) >> 16) & 0xff], 8) ^ \
+	rotr_uint32(te0[((c) >> 8) & 0xff], 16) ^ \
+	rotr_uint32(te0[(d) & 0xff], 24))
+
+/** One round of the T-table decryption for the output column @a a. */
+#define DEC_ROUND(a, b, c, d) \
+	(td0[(a) >> 24] ^ \
+	rotr_uint32(td0[((b) >> 16) & 0xff], 8) ^ \
+	rotr_uint32(td0[((c) >> 8) & 0xff], 16) ^ \
+	rotr_uint32(td0[(d) & 0xff], 24))
+
+/** Last round (no mix columns) for the output column @a a. */
+#define LAST_ROUND(a, b, c, d, inv) \
+	(((uint32_t) sub_byte((a) >> 24, (inv)) << 24) | \
+	((uint32_t) sub_byte(((b) >> 16) & 0xff, (inv)) << 16) | \
+	((uint32_t) sub_byte(((c) >> 8) & 0xff, (inv)) << 8) | \
+	(uint32_t) sub_byte((d) & 0xff, (inv)))
+
+/** Read big-endian 32-bit word from byte sequence. */
+static inline uint32_t load_be32(const uint8_t *src)
+{
+	return ((uint32_t) src[0] << 24) | ((uint32_t) src[1] << 16) |
+	    ((uint32_t) src[2] << 8) | (uint32_t) src[3];
+}
+
+/** Write 32-bit word to byte sequence in big-endian order. */
+static inline void store_be32(uint8_t *dest, uint32_t val)
+{
+	dest[0] = val >> 24;
+	dest[1] = (val >> 16) & 0xff;
+	dest[2] = (val >> 8) & 0xff;
+	dest[3] = val & 0xff;
+}
+
 /** Perform substitution transformation on given byte.
  *
  * @param byte Input byte.
@@ -208,7 +394,7 @@ static const uint32_t r_con_array[] = {
  * @return Substituted value.
  *
  */
-static uint8_t sub_byte(uint8_t byte, bool inv)
+static inline uint8_t sub_byte(uint8_t byte, bool inv)
 {
 	uint8_t i = byte >> 4;
 	uint8_t j = byte & 0xF;
@@ -219,232 +405,618 @@ static uint8_t sub_byte(uint8_t byte, bool inv)
 	return inv_sbox[i][j];
 }
 
-/** Perform substitution transformation on state table.
+/** Perform substitution transformation on given word.
+ *
+ * @param byte Input word.
+ *
+ * @return Substituted word.
+ *
+ */
+static uint32_t sub_word(uint32_t word)
+{
+	uint32_t temp = word;
+	uint8_t *start = (uint8_t *) &temp;
+
+	for (size_t i = 0; i < 4; i++)
+		*(start + i) = sub_byte(*(start + i), false);
+
+	return temp;
+}
+
+/** Perform left rotation by one byte on given word.
+ *
+ * @param byte Input word.
+ *
+ * @return Rotated word.
+ *
+ */
+static uint32_t rot_word(uint32_t word)
+{
+	return (word << 8 | word >> 24);
+}
+
+/** Apply inverse mix columns transformation on one round key word.
+ *
+ * @param word Round key word.
+ *
+ * @return Transformed word.
+ *
+ */
+static uint32_t inv_mix_column(uint32_t word)
+{
+	return DEC_ROUND(
+	    (uint32_t) sub_byte(word >> 24, false) << 24,
+	    (uint32_t) sub_byte((word >> 16) & 0xff, false) << 16,
+	    (uint32_t) sub_byte((word >> 8) & 0xff, false) << 8,
+	    sub_byte(word & 0xff, false));
+}
+
+/** Key expansion procedure for AES algorithm.
  *
- * @param state State table to be modified.
- * @param inv   Flag indicating whether to use inverse table.
+ * @param key     Input key.
+ * @param key_exp Result key expansion.
  *
  */
-static void sub_bytes(uint8_t state[ELEMS][ELEMS], bool inv)
+static void key_expansion(const uint8_t *key, uint32_t *key_exp)
 {
-	uint8_t val;
+	uint32_t temp;
+
+	for (size_t i = 0; i < CIPHER_ELEMS; i++)
+		key_exp[i] = load_be32(key + 4 * i);
 
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++) {
-			val = state[i][j];
-			state[i][j] = sub_byte(val, inv);
+	for (size_t i = CIPHER_ELEMS; i < ELEMS * (ROUNDS + 1); i++) {
+		temp = key_exp[i - 1];
+
+		if ((i % CIPHER_ELEMS) == 0) {
+			temp = sub_word(rot_word(temp)) ^
+			    r_con_array[i / CIPHER_ELEMS - 1];
 		}
+
+		key_exp[i] = key_exp[i - CIPHER_ELEMS] ^ temp;
 	}
 }
 
-/** Perform shift rows transformation on state table.
+/** Encrypt one block using the T-table implementation.
  *
- * @param state State table to be modified.
+ * @param key_exp Expanded encryption key.
+ * @param input   Input block.
+ * @param output  Output block (may be the same as @a input).
  *
  */
-static void shift_rows(uint8_t state[ELEMS][ELEMS])
+static void encrypt_block(const uint32_t *key_exp, const uint8_t *input,
+    uint8_t *output)
 {
-	uint8_t temp[ELEMS];
+	uint32_t s0 = load_be32(input) ^ key_exp[0];
+	uint32_t s1 = load_be32(input + 4) ^ key_exp[1];
+	uint32_t s2 = load_be32(input + 8) ^ key_exp[2];
+	uint32_t s3 = load_be32(input + 12) ^ key_exp[3];
+	uint32_t t0, t1, t2, t3;
 
-	for (size_t i = 1; i < ELEMS; i++) {
-		memcpy(temp, state[i], i);
-		memmove(state[i], state[i] + i, ELEMS - i);
-		memcpy(state[i] + ELEMS - i, temp, i);
+	for (size_t k = 1; k < ROUNDS; k++) {
+		key_exp += ELEMS;
+
+		t0 = ENC_ROUND(s0, s1, s2, s3) ^ key_exp[0];
+		t1 = ENC_ROUND(s1, s2, s3, s0) ^ key_exp[1];
+		t2 = ENC_ROUND(s2, s3, s0, s1) ^ key_exp[2];
+		t3 = ENC_ROUND(s3, s0, s1, s2) ^ key_exp[3];
+
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
 	}
+
+	key_exp += ELEMS;
+
+	store_be32(output, LAST_ROUND(s0, s1, s2, s3, false) ^ key_exp[0]);
+	store_be32(output + 4, LAST_ROUND(s1, s2, s3, s0, false) ^ key_exp[1]);
+	store_be32(output + 8, LAST_ROUND(s2, s3, s0, s1, false) ^ key_exp[2]);
+	store_be32(output + 12, LAST_ROUND(s3, s0, s1, s2, false) ^ key_exp[3]);
 }
 
-/** Perform inverted shift rows transformation on state table.
+/** Decrypt one block using the T-table implementation.
+ *
+ * Uses the equivalent inverse cipher, i.e. the round keys
+ * are expected in the order and form prepared by aes_set_key().
  *
- * @param state State table to be modified.
+ * @param key_exp Expanded decryption key.
+ * @param input   Input block.
+ * @param output  Output block (may be the same as @a input).
  *
  */
-static void inv_shift_rows(uint8_t state[ELEMS][ELEMS])
+static void decrypt_block(const uint32_t *key_exp, const uint8_t *input,
+    uint8_t *output)
 {
-	uint8_t temp[ELEMS];
+	uint32_t s0 = load_be32(input) ^ key_exp[0];
+	uint32_t s1 = load_be32(input + 4) ^ key_exp[1];
+	uint32_t s2 = load_be32(input + 8) ^ key_exp[2];
+	uint32_t s3 = load_be32(input + 12) ^ key_exp[3];
+	uint32_t t0, t1, t2, t3;
+
+	for (size_t k = 1; k < ROUNDS; k++) {
+		key_exp += ELEMS;
+
+		t0 = DEC_ROUND(s0, s3, s2, s1) ^ key_exp[0];
+		t1 = DEC_ROUND(s1, s0, s3, s2) ^ key_exp[1];
+		t2 = DEC_ROUND(s2, s1, s0, s3) ^ key_exp[2];
+		t3 = DEC_ROUND(s3, s2, s1, s0) ^ key_exp[3];
 
-	for (size_t i = 1; i < ELEMS; i++) {
-		memcpy(temp, state[i], ELEMS - i);
-		memmove(state[i], state[i] + ELEMS - i, i);
-		memcpy(state[i] + i, temp, ELEMS - i);
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
 	}
+
+	key_exp += ELEMS;
+
+	store_be32(output, LAST_ROUND(s0, s3, s2, s1, true) ^ key_exp[0]);
+	store_be32(output + 4, LAST_ROUND(s1, s0, s3, s2, true) ^ key_exp[1]);
+	store_be32(output + 8, LAST_ROUND(s2, s1, s0, s3, true) ^ key_exp[2]);
+	store_be32(output + 12, LAST_ROUND(s3, s2, s1, s0, true) ^ key_exp[3]);
 }
 
-/** Multiplication in GF(2^8).
+/** Increment counter block.
  *
- * @param x First factor.
- * @param y Second factor.
+ * @param ctr   Counter block.
+ * @param width Number of trailing bytes forming the big-endian counter.
  *
- * @return Multiplication of given factors in GF(2^8).
+ */
+void ctr_increment(uint8_t *ctr, size_t width)
+{
+	for (size_t i = BLOCK_LEN; i > BLOCK_LEN - width; i--) {
+		if (++ctr[i - 1] != 0)
+			break;
+	}
+}
+
+/** Prepare AES-128 key schedule.
+ *
+ * @param ctx AES context to initialize.
+ * @param key Input key (AES_KEY_LENGTH bytes).
+ *
+ * @return EINVAL when key or context not specified, otherwise EOK.
  *
  */
-static uint8_t galois_mult(uint8_t x, uint8_t y)
+errno_t aes_set_key(aes_ctx_t *ctx, const uint8_t *key)
 {
-	uint8_t result = 0;
-	uint8_t f_bith;
+	if ((!ctx) || (!key))
+		return EINVAL;
 
-	for (size_t i = 0; i < 8; i++) {
-		if (y & 1)
-			result ^= x;
+	uint32_t key_exp[AES_KEY_EXP_WORDS];
+	key_expansion(key, key_exp);
 
-		f_bith = (x & 0x80);
-		x <<= 1;
+	if (aes_accel_available()) {
+		aes_accel_set_key(key_exp, ctx->enc_key, ctx->dec_key);
+		ctx->accel = true;
+		return EOK;
+	}
+
+	memcpy(ctx->enc_key, key_exp, sizeof(key_exp));
+
+	/* Round keys for the equivalent inverse cipher. */
+	for (size_t k = 0; k <= ROUNDS; k++) {
+		for (size_t i = 0; i < ELEMS; i++) {
+			uint32_t word = key_exp[(ROUNDS - k) * ELEMS + i];
 
-		if (f_bith)
-			x ^= AES_IP;
+			if ((k > 0) && (k < ROUNDS))
+				word = inv_mix_column(word);
 
-		y >>= 1;
+			ctx->dec_key[k * ELEMS + i] = word;
+		}
 	}
 
-	return result;
+	ctx->accel = false;
+	return EOK;
 }
 
-/** Perform mix columns transformation on state table.
+/** Encrypt a sequence of blocks (ECB).
  *
- * @param state State table to be modified.
+ * @param ctx    AES context.
+ * @param input  Input data.
+ * @param output Output data (may be the same as @a input).
+ * @param blocks Number of AES_CIPHER_LENGTH blocks to encrypt.
  *
  */
-static void mix_columns(uint8_t state[ELEMS][ELEMS])
+void aes_encrypt_blocks(aes_ctx_t *ctx, const uint8_t *input, uint8_t *output,
+    size_t blocks)
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
-
-	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x2, orig_state[0][j]) ^
-		    galois_mult(0x3, orig_state[1][j]) ^
-		    orig_state[2][j] ^
-		    orig_state[3][j];
-		state[1][j] =
-		    orig_state[0][j] ^
-		    galois_mult(0x2, orig_state[1][j]) ^
-		    galois_mult(0x3, orig_state[2][j]) ^
-		    orig_state[3][j];
-		state[2][j] =
-		    orig_state[0][j] ^
-		    orig_state[1][j] ^
-		    galois_mult(0x2, orig_state[2][j]) ^
-		    galois_mult(0x3, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x3, orig_state[0][j]) ^
-		    orig_state[1][j] ^
-		    orig_state[2][j] ^
-		    galois_mult(0x2, orig_state[3][j]);
+	if (ctx->accel) {
+		aes_accel_encrypt(ctx->enc_key, input, output, blocks);
+		return;
+	}
+
+	for (size_t i = 0; i < blocks; i++) {
+		encrypt_block(ctx->enc_key, input, output);
+		input += BLOCK_LEN;
+		output += BLOCK_LEN;
 	}
 }
 
-/** Perform inverted mix columns transformation on state table.
+/** Decrypt a sequence of blocks (ECB).
  *
- * @param state State table to be modified.
+ * @param ctx    AES context.
+ * @param input  Input data.
+ * @param output Output data (may be the same as @a input).
+ * @param blocks Number of AES_CIPHER_LENGTH blocks to decrypt.
  *
  */
-static void inv_mix_columns(uint8_t state[ELEMS][ELEMS])
+void aes_decrypt_blocks(aes_ctx_t *ctx, const uint8_t *input, uint8_t *output,
+    size_t blocks)
 {
-	uint8_t orig_state[ELEMS][ELEMS];
-	memcpy(orig_state, state, BLOCK_LEN);
-
-	for (size_t j = 0; j < ELEMS; j++) {
-		state[0][j] =
-		    galois_mult(0x0e, orig_state[0][j]) ^
-		    galois_mult(0x0b, orig_state[1][j]) ^
-		    galois_mult(0x0d, orig_state[2][j]) ^
-		    galois_mult(0x09, orig_state[3][j]);
-		state[1][j] =
-		    galois_mult(0x09, orig_state[0][j]) ^
-		    galois_mult(0x0e, orig_state[1][j]) ^
-		    galois_mult(0x0b, orig_state[2][j]) ^
-		    galois_mult(0x0d, orig_state[3][j]);
-		state[2][j] =
-		    galois_mult(0x0d, orig_state[0][j]) ^
-		    galois_mult(0x09, orig_state[1][j]) ^
-		    galois_mult(0x0e, orig_state[2][j]) ^
-		    galois_mult(0x0b, orig_state[3][j]);
-		state[3][j] =
-		    galois_mult(0x0b, orig_state[0][j]) ^
-		    galois_mult(0x0d, orig_state[1][j]) ^
-		    galois_mult(0x09, orig_state[2][j]) ^
-		    galois_mult(0x0e, orig_state[3][j]);
+	if (ctx->accel) {
+		aes_accel_decrypt(ctx->dec_key, input, output, blocks);
+		return;
+	}
+
+	for (size_t i = 0; i < blocks; i++) {
+		decrypt_block(ctx->dec_key, input, output);
+		input += BLOCK_LEN;
+		output += BLOCK_LEN;
 	}
 }
 
-/** Perform round key transformation on state table.
+/** Encrypt or decrypt data in counter mode.
  *
- * @param state     State table to be modified.
- * @param round_key Round key to be applied on state table.
+ * @param ctx    AES context.
+ * @param ctr    Counter block, updated to the next unused value.
+ * @param input  Input data.
+ * @param output Output data (may be the same as @a input).
+ * @param size   Size of data.
+ * @param width  Number of trailing counter block bytes to increment.
  *
  */
-static void add_round_key(uint8_t state[ELEMS][ELEMS], uint32_t *round_key)
+static void ctr_crypt(aes_ctx_t *ctx, uint8_t *ctr, const uint8_t *input,
+    uint8_t *output, size_t size, size_t width)
 {
-	uint8_t byte_round;
-	uint8_t shift;
-	uint32_t mask = 0xff;
+	uint8_t stream[BLOCK_LEN];
+	size_t blocks = size / BLOCK_LEN;
 
-	for (size_t j = 0; j < ELEMS; j++) {
-		for (size_t i = 0; i < ELEMS; i++) {
-			shift = 24 - 8 * i;
-			byte_round = (round_key[j] & (mask << shift)) >> shift;
-			state[i][j] = state[i][j] ^ byte_round;
+	if (ctx->accel) {
+		aes_accel_ctr(ctx->enc_key, ctr, input, output, blocks, width);
+		input += blocks * BLOCK_LEN;
+		output += blocks * BLOCK_LEN;
+	} else {
+		for (size_t i = 0; i < blocks; i++) {
+			encrypt_block(ctx->enc_key, ctr, stream);
+			ctr_increment(ctr, width);
+
+			for (size_t j = 0; j < BLOCK_LEN; j++)
+				output[j] = input[j] ^ stream[j];
+
+			input += BLOCK_LEN;
+			output += BLOCK_LEN;
 		}
 	}
+
+	size_t rest = size % BLOCK_LEN;
+	if (rest > 0) {
+		aes_encrypt_blocks(ctx, ctr, stream, 1);
+		ctr_increment(ctr, width);
+
+		for (size_t j = 0; j < rest; j++)
+			output[j] = input[j] ^ stream[j];
+	}
 }
 
-/** Perform substitution transformation on given word.
+/** AES-128 in counter mode.
  *
- * @param byte Input word.
+ * Encryption and decryption are the same operation. The whole counter
+ * block is incremented as a 128-bit big-endian number. If @a size is
+ * not a multiple of AES_CIPHER_LENGTH, the rest of the key stream of
+ * the last block is discarded and the counter already points past it.
  *
- * @return Substituted word.
+ * @param ctx    AES context.
+ * @param ctr    Counter block (AES_CIPHER_LENGTH bytes), updated to
+ *               the next unused value.
+ * @param input  Input data.
+ * @param output Output data (may be the same as @a input).
+ * @param size   Size of data.
  *
  */
-static uint32_t sub_word(uint32_t word)
+void aes_ctr(aes_ctx_t *ctx, uint8_t *ctr, const uint8_t *input,
+    uint8_t *output, size_t size)
 {
-	uint32_t temp = word;
-	uint8_t *start = (uint8_t *) &temp;
+	ctr_crypt(ctx, ctr, input, output, size, CTR_WIDTH_FULL);
+}
 
-	for (size_t i = 0; i < 4; i++)
-		*(start + i) = sub_byte(*(start + i), false);
+/** Precompute multiples of the hash subkey for GHASH.
+ *
+ * @param ctx GCM context.
+ * @param h   Hash subkey.
+ *
+ */
+static void ghash_set_key(aes_gcm_ctx_t *ctx, const uint8_t *h)
+{
+	uint64_t vh = ((uint64_t) load_be32(h) << 32) | load_be32(h + 4);
+	uint64_t vl = ((uint64_t) load_be32(h + 8) << 32) | load_be32(h + 12);
 
-	return temp;
+	/* Index 8 (bit pattern 1000) corresponds to 1 in GF(2^128). */
+	ctx->hh[8] = vh;
+	ctx->hl[8] = vl;
+	ctx->hh[0] = 0;
+	ctx->hl[0] = 0;
+
+	for (size_t i = 4; i > 0; i >>= 1) {
+		uint64_t reduce = (vl & 1) * 0xe100000000000000ULL;
+		vl = (vh << 63) | (vl >> 1);
+		vh = (vh >> 1) ^ reduce;
+		ctx->hh[i] = vh;
+		ctx->hl[i] = vl;
+	}
+
+	for (size_t i = 2; i <= 8; i *= 2) {
+		for (size_t j = 1; j < i; j++) {
+			ctx->hh[i + j] = ctx->hh[i] ^ ctx->hh[j];
+			ctx->hl[i + j] = ctx->hl[i] ^ ctx->hl[j];
+		}
+	}
+
+	if (ghash_accel_available())
+		ghash_accel_set_key(h, ctx->h);
 }
 
-/** Perform left rotation by one byte on given word.
+/** Multiply GHASH state by the hash subkey.
  *
- * @param byte Input word.
- *
- * @return Rotated word.
+ * @param ctx GCM context.
+ * @param x   GHASH state.
  *
  */
-static uint32_t rot_word(uint32_t word)
+static void ghash_mult(aes_gcm_ctx_t *ctx, uint8_t *x)
 {
-	return (word << 8 | word >> 24);
+	uint8_t lo = x[15] & 0xf;
+	uint64_t zh = ctx->hh[lo];
+	uint64_t zl = ctx->hl[lo];
+	uint8_t rem;
+
+	for (int i = 15; i >= 0; i--) {
+		lo = x[i] & 0xf;
+		uint8_t hi = x[i] >> 4;
+
+		if (i != 15) {
+			rem = zl & 0xf;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ (ghash_last4[rem] << 48);
+			zh ^= ctx->hh[lo];
+			zl ^= ctx->hl[lo];
+		}
+
+		rem = zl & 0xf;
+		zl = (zh << 60) | (zl >> 4);
+		zh = (zh >> 4) ^ (ghash_last4[rem] << 48);
+		zh ^= ctx->hh[hi];
+		zl ^= ctx->hl[hi];
+	}
+
+	store_be32(x, zh >> 32);
+	store_be32(x + 4, zh & 0xffffffff);
+	store_be32(x + 8, zl >> 32);
+	store_be32(x + 12, zl & 0xffffffff);
 }
 
-/** Key expansion procedure for AES algorithm.
+/** Absorb data into GHASH state.
  *
- * @param key     Input key.
- * @param key_exp Result key expansion.
+ * Incomplete trailing block is padded with zeros.
+ *
+ * @param ctx  GCM context.
+ * @param x    GHASH state.
+ * @param data Data to absorb.
+ * @param size Size of data.
  *
  */
-static void key_expansion(uint8_t *key, uint32_t *key_exp)
+static void ghash_update(aes_gcm_ctx_t *ctx, uint8_t *x, const uint8_t *data,
+    size_t size)
 {
-	uint32_t temp;
+	size_t blocks = size / BLOCK_LEN;
+	size_t rest = size % BLOCK_LEN;
+
+	if (ghash_accel_available()) {
+		ghash_accel(ctx->h, x, data, blocks);
+		data += blocks * BLOCK_LEN;
+	} else {
+		for (size_t i = 0; i < blocks; i++) {
+			for (size_t j = 0; j < BLOCK_LEN; j++)
+				x[j] ^= data[j];
 
-	for (size_t i = 0; i < CIPHER_ELEMS; i++) {
-		key_exp[i] =
-		    (key[4 * i] << 24) +
-		    (key[4 * i + 1] << 16) +
-		    (key[4 * i + 2] << 8) +
-		    (key[4 * i + 3]);
+			ghash_mult(ctx, x);
+			data += BLOCK_LEN;
+		}
 	}
 
-	for (size_t i = CIPHER_ELEMS; i < ELEMS * (ROUNDS + 1); i++) {
-		temp = key_exp[i - 1];
+	if (rest > 0) {
+		uint8_t last[BLOCK_LEN];
+		memset(last, 0, BLOCK_LEN);
+		memcpy(last, data, rest);
+		ghash_update(ctx, x, last, BLOCK_LEN);
+	}
+}
 
-		if ((i % CIPHER_ELEMS) == 0) {
-			temp = sub_word(rot_word(temp)) ^
-			    r_con_array[i / CIPHER_ELEMS - 1];
-		}
+/** Absorb GCM length block into GHASH state.
+ *
+ * @param ctx      GCM context.
+ * @param x        GHASH state.
+ * @param aad_size Size of additional authenticated data.
+ * @param size     Size of cipher text.
+ *
+ */
+static void ghash_lengths(aes_gcm_ctx_t *ctx, uint8_t *x, size_t aad_size,
+    size_t size)
+{
+	uint8_t block[BLOCK_LEN];
+	uint64_t aad_bits = (uint64_t) aad_size * 8;
+	uint64_t bits = (uint64_t) size * 8;
 
-		key_exp[i] = key_exp[i - CIPHER_ELEMS] ^ temp;
+	store_be32(block, aad_bits >> 32);
+	store_be32(block + 4, aad_bits & 0xffffffff);
+	store_be32(block + 8, bits >> 32);
+	store_be32(block + 12, bits & 0xffffffff);
+
+	ghash_update(ctx, x, block, BLOCK_LEN);
+}
+
+/** Prepare AES-128-GCM key.
+ *
+ * @param ctx GCM context to initialize.
+ * @param key Input key (AES_KEY_LENGTH bytes).
+ *
+ * @return EINVAL when key or context not specified, otherwise EOK.
+ *
+ */
+errno_t aes_gcm_set_key(aes_gcm_ctx_t *ctx, const uint8_t *key)
+{
+	if (!ctx)
+		return EINVAL;
+
+	errno_t rc = aes_set_key(&ctx->aes, key);
+	if (rc != EOK)
+		return rc;
+
+	uint8_t h[BLOCK_LEN];
+	memset(h, 0, BLOCK_LEN);
+	aes_encrypt_blocks(&ctx->aes, h, h, 1);
+	ghash_set_key(ctx, h);
+
+	return EOK;
+}
+
+/** Compute GCM pre-counter block J0.
+ *
+ * @param ctx     GCM context.
+ * @param iv      Initialization vector.
+ * @param iv_size Size of initialization vector.
+ * @param j0      Output pre-counter block.
+ *
+ */
+static void gcm_j0(aes_gcm_ctx_t *ctx, const uint8_t *iv, size_t iv_size,
+    uint8_t *j0)
+{
+	if (iv_size == 12) {
+		memcpy(j0, iv, 12);
+		store_be32(j0 + 12, 1);
+		return;
 	}
+
+	memset(j0, 0, BLOCK_LEN);
+	ghash_update(ctx, j0, iv, iv_size);
+	ghash_lengths(ctx, j0, 0, iv_size);
+}
+
+/** Compute GCM authentication tag.
+ *
+ * @param ctx      GCM context.
+ * @param j0       Pre-counter block.
+ * @param aad      Additional authenticated data.
+ * @param aad_size Size of additional authenticated data.
+ * @param data     Cipher text.
+ * @param size     Size of cipher text.
+ * @param tag      Output tag (AES_GCM_TAG_LENGTH bytes).
+ *
+ */
+static void gcm_tag(aes_gcm_ctx_t *ctx, const uint8_t *j0, const uint8_t *aad,
+    size_t aad_size, const uint8_t *data, size_t size, uint8_t *tag)
+{
+	uint8_t x[BLOCK_LEN];
+	uint8_t ej0[BLOCK_LEN];
+
+	memset(x, 0, BLOCK_LEN);
+	ghash_update(ctx, x, aad, aad_size);
+	ghash_update(ctx, x, data, size);
+	ghash_lengths(ctx, x, aad_size, size);
+
+	aes_encrypt_blocks(&ctx->aes, j0, ej0, 1);
+	for (size_t i = 0; i < AES_GCM_TAG_LENGTH; i++)
+		tag[i] = x[i] ^ ej0[i];
+}
+
+/** AES-128-GCM authenticated encryption.
+ *
+ * @param ctx      GCM context.
+ * @param iv       Initialization vector (12 bytes recommended).
+ * @param iv_size  Size of initialization vector.
+ * @param aad      Additional authenticated data (may be NULL if empty).
+ * @param aad_size Size of additional authenticated data.
+ * @param input    Plain text.
+ * @param output   Cipher text (may be the same as @a input).
+ * @param size     Size of plain text.
+ * @param tag      Output authentication tag (AES_GCM_TAG_LENGTH bytes).
+ *
+ * @return EINVAL when context, initialization vector or input
+ *         not specified, ENOMEM when pointer for output or tag
+ *         is not allocated, otherwise EOK.
+ *
+ */
+errno_t aes_gcm_encrypt(aes_gcm_ctx_t *ctx, const uint8_t *iv, size_t iv_size,
+    const uint8_t *aad, size_t aad_size, const uint8_t *input, uint8_t *output,
+    size_t size, uint8_t *tag)
+{
+	if ((!ctx) || (!iv) || (iv_size == 0) || ((!aad) && (aad_size > 0)) ||
+	    ((!input) && (size > 0)))
+		return EINVAL;
+
+	if (((!output) && (size > 0)) || (!tag))
+		return ENOMEM;
+
+	uint8_t j0[BLOCK_LEN];
+	uint8_t ctr[BLOCK_LEN];
+	gcm_j0(ctx, iv, iv_size, j0);
+
+	memcpy(ctr, j0, BLOCK_LEN);
+	ctr_increment(ctr, CTR_WIDTH_GCM);
+	ctr_crypt(&ctx->aes, ctr, input, output, size, CTR_WIDTH_GCM);
+
+	gcm_tag(ctx, j0, aad, aad_size, output, size, tag);
+	return EOK;
+}
+
+/** AES-128-GCM authenticated decryption.
+ *
+ * The authentication tag is verified before any plain text is produced.
+ *
+ * @param ctx      GCM context.
+ * @param iv       Initialization vector.
+ * @param iv_size  Size of initialization vector.
+ * @param aad      Additional authenticated data (may be NULL if empty).
+ * @param aad_size Size of additional authenticated data.
+ * @param input    Cipher text.
+ * @param output   Plain text (may be the same as @a input).
+ * @param size     Size of cipher text.
+ * @param tag      Expected authentication tag (AES_GCM_TAG_LENGTH bytes).
+ *
+ * @return EINVAL when context, initialization vector, input or tag
+ *         not specified, ENOMEM when pointer for output is not
+ *         allocated, EBADMSG when authentication fails, otherwise EOK.
+ *
+ */
+errno_t aes_gcm_decrypt(aes_gcm_ctx_t *ctx, const uint8_t *iv, size_t iv_size,
+    const uint8_t *aad, size_t aad_size, const uint8_t *input, uint8_t *output,
+    size_t size, const uint8_t *tag)
+{
+	if ((!ctx) || (!iv) || (iv_size == 0) || ((!aad) && (aad_size > 0)) ||
+	    ((!input) && (size > 0)) || (!tag))
+		return EINVAL;
+
+	if ((!output) && (size > 0))
+		return ENOMEM;
+
+	uint8_t j0[BLOCK_LEN];
+	uint8_t ctr[BLOCK_LEN];
+	uint8_t computed[AES_GCM_TAG_LENGTH];
+	gcm_j0(ctx, iv, iv_size, j0);
+
+	gcm_tag(ctx, j0, aad, aad_size, input, size, computed);
+
+	/* Compare in constant time. */
+	uint8_t diff = 0;
+	for (size_t i = 0; i < AES_GCM_TAG_LENGTH; i++)
+		diff |= computed[i] ^ tag[i];
+
+	if (diff != 0)
+		return EBADMSG;
+
+	memcpy(ctr, j0, BLOCK_LEN);
+	ctr_increment(ctr, CTR_WIDTH_GCM);
+	ctr_crypt(&ctx->aes, ctr, input, output, size, CTR_WIDTH_GCM);
+
+	return EOK;
 }
 
 /** AES-128 encryption algorithm.
@@ -466,35 +1038,9 @@ errno_t aes_encrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
-
-	/* Copy input into state array. */
-	uint8_t state[ELEMS][ELEMS];
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			state[i][j] = input[i + ELEMS * j];
-	}
-
-	/* Processing loop. */
-	add_round_key(state, key_exp);
-
-	for (size_t k = 1; k <= ROUNDS; k++) {
-		sub_bytes(state, false);
-		shift_rows(state);
-
-		if (k < ROUNDS)
-			mix_columns(state);
-
-		add_round_key(state, key_exp + k * ELEMS);
-	}
-
-	/* Copy state array into output. */
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			output[i + j * ELEMS] = state[i][j];
-	}
+	aes_ctx_t ctx;
+	aes_set_key(&ctx, key);
+	aes_encrypt_blocks(&ctx, input, output, 1);
 
 	return EOK;
 }
@@ -518,34 +1064,9 @@ errno_t aes_decrypt(uint8_t *key, uint8_t *input, uint8_t *output)
 	if (!output)
 		return ENOMEM;
 
-	/* Create key expansion. */
-	uint32_t key_exp[ELEMS * (ROUNDS + 1)];
-	key_expansion(key, key_exp);
-
-	/* Copy input into state array. */
-	uint8_t state[ELEMS][ELEMS];
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			state[i][j] = input[i + ELEMS * j];
-	}
-
-	/* Processing loop. */
-	add_round_key(state, key_exp + ROUNDS * ELEMS);
-
-	for (int k = ROUNDS - 1; k >= 0; k--) {
-		inv_shift_rows(state);
-		sub_bytes(state, true);
-		add_round_key(state, key_exp + k * ELEMS);
-
-		if (k > 0)
-			inv_mix_columns(state);
-	}
-
-	/* Copy state array into output. */
-	for (size_t i = 0; i < ELEMS; i++) {
-		for (size_t j = 0; j < ELEMS; j++)
-			output[i + j * ELEMS] = state[i][j];
-	}
+	aes_ctx_t ctx;
+	aes_set_key(&ctx, key);
+	aes_decrypt_blocks(&ctx, input, output, 1);
 
 	return EOK;
 }
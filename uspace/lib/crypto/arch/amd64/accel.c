@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file arch/amd64/accel.c
+ *
+ * AES-NI, PCLMULQDQ and SHA extensions implementation of the accelerated
+ * primitives.
+ *
+ * The instructions are issued using inline assembly so that the library
+ * does not need to be compiled for a CPU that has them. Their presence
+ * is detected at runtime using CPUID.
+ */
+
+#include <mem.h>
+#include <stdatomic.h>
+#include "../../crypto.h"
+#include "../../accel.h"
+
+#define CPUID_1_ECX_PCLMULQDQ  (1U << 1)
+#define CPUID_1_ECX_SSSE3      (1U << 9)
+#define CPUID_1_ECX_SSE4_1     (1U << 19)
+#define CPUID_1_ECX_AES        (1U << 25)
+#define CPUID_7_EBX_SHA        (1U << 29)
+
+enum {
+	FEATURE_PROBED = 1 << 0,
+	FEATURE_AES = 1 << 1,
+	FEATURE_GHASH = 1 << 2,
+	FEATURE_SHA256 = 1 << 3
+};
+
+typedef long long xmm_t __attribute__((vector_size(16)));
+typedef uint32_t xmm_u32_t __attribute__((vector_size(16)));
+
+/** Detected features, zero until probed. */
+static atomic_uint features;
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+    uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+	    : "a" (leaf), "c" (subleaf)
+	);
+}
+
+static unsigned int get_features(void)
+{
+	unsigned int feat = atomic_load_explicit(&features,
+	    memory_order_relaxed);
+	if (feat != 0)
+		return feat;
+
+	uint32_t max_leaf, ebx, ecx, edx;
+	cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+	feat = FEATURE_PROBED;
+
+	uint32_t eax;
+	cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+	if (ecx & CPUID_1_ECX_AES)
+		feat |= FEATURE_AES;
+
+	if ((ecx & CPUID_1_ECX_PCLMULQDQ) && (ecx & CPUID_1_ECX_SSSE3))
+		feat |= FEATURE_GHASH;
+
+	if ((max_leaf >= 7) && (ecx & CPUID_1_ECX_SSSE3) &&
+	    (ecx & CPUID_1_ECX_SSE4_1)) {
+		cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+		if (ebx & CPUID_7_EBX_SHA)
+			feat |= FEATURE_SHA256;
+	}
+
+	atomic_store_explicit(&features, feat, memory_order_relaxed);
+	return feat;
+}
+
+static inline xmm_t xmm_load(const void *src)
+{
+	xmm_t val;
+	memcpy(&val, src, sizeof(val));
+	return val;
+}
+
+static inline void xmm_store(void *dest, xmm_t val)
+{
+	memcpy(dest, &val, sizeof(val));
+}
+
+#define XMM_BINARY_OP(name, insn) \
+	static inline xmm_t name(xmm_t a, xmm_t b) \
+	{ \
+		asm (insn " %1, %0\n" : "+x" (a) : "x" (b)); \
+		return a; \
+	}
+
+XMM_BINARY_OP(aesenc, "aesenc");
+XMM_BINARY_OP(aesenclast, "aesenclast");
+XMM_BINARY_OP(aesdec, "aesdec");
+XMM_BINARY_OP(aesdeclast, "aesdeclast");
+XMM_BINARY_OP(pshufb, "pshufb");
+XMM_BINARY_OP(sha256msg1, "sha256msg1");
+XMM_BINARY_OP(sha256msg2, "sha256msg2");
+
+static inline xmm_t aesimc(xmm_t a)
+{
+	xmm_t res;
+	asm ("aesimc %1, %0\n" : "=x" (res) : "x" (a));
+	return res;
+}
+
+/** Two SHA-256 rounds, the message and constants are taken from @a wk. */
+static inline xmm_t sha256rnds2(xmm_t state, xmm_t other, xmm_t wk)
+{
+	asm ("sha256rnds2 %2, %1, %0\n" : "+x" (state) : "x" (other), "Yz" (wk));
+	return state;
+}
+
+/* Instructions with an immediate operand. */
+
+#define PCLMULQDQ(a, b, imm) ({ \
+	xmm_t _res = (a); \
+	asm ("pclmulqdq %2, %1, %0\n" : "+x" (_res) : "x" (b), "i" (imm)); \
+	_res; \
+})
+
+#define PSHUFD(a, imm) ({ \
+	xmm_t _res; \
+	asm ("pshufd %2, %1, %0\n" : "=x" (_res) : "x" (a), "i" (imm)); \
+	_res; \
+})
+
+#define PALIGNR(a, b, imm) ({ \
+	xmm_t _res = (a); \
+	asm ("palignr %2, %1, %0\n" : "+x" (_res) : "x" (b), "i" (imm)); \
+	_res; \
+})
+
+#define PBLENDW(a, b, imm) ({ \
+	xmm_t _res = (a); \
+	asm ("pblendw %2, %1, %0\n" : "+x" (_res) : "x" (b), "i" (imm)); \
+	_res; \
+})
+
+#define PSLLDQ(a, imm) ({ \
+	xmm_t _res = (a); \
+	asm ("pslldq %1, %0\n" : "+x" (_res) : "i" (imm)); \
+	_res; \
+})
+
+#define PSRLDQ(a, imm) ({ \
+	xmm_t _res = (a); \
+	asm ("psrldq %1, %0\n" : "+x" (_res) : "i" (imm)); \
+	_res; \
+})
+
+static inline xmm_t add_u32(xmm_t a, xmm_t b)
+{
+	return (xmm_t) ((xmm_u32_t) a + (xmm_u32_t) b);
+}
+
+static inline xmm_t shl_u32(xmm_t a, int bits)
+{
+	return (xmm_t) ((xmm_u32_t) a << bits);
+}
+
+static inline xmm_t shr_u32(xmm_t a, int bits)
+{
+	return (xmm_t) ((xmm_u32_t) a >> bits);
+}
+
+/** Reverse the order of bytes in the register. */
+static inline xmm_t byte_reverse(xmm_t a)
+{
+	const xmm_t mask = {
+		0x08090a0b0c0d0e0fLL, 0x0001020304050607LL
+	};
+
+	return pshufb(a, mask);
+}
+
+bool aes_accel_available(void)
+{
+	return (get_features() & FEATURE_AES) != 0;
+}
+
+/** Convert the generic key schedule to the AES-NI one.
+ *
+ * @param key_exp Key expansion in big-endian words.
+ * @param enc_key Output round keys for encryption.
+ * @param dec_key Output round keys for the equivalent inverse cipher.
+ */
+void aes_accel_set_key(const uint32_t *key_exp, uint32_t *enc_key,
+    uint32_t *dec_key)
+{
+	uint8_t *enc = (uint8_t *) enc_key;
+	uint8_t *dec = (uint8_t *) dec_key;
+
+	for (size_t i = 0; i < AES_KEY_EXP_WORDS; i++) {
+		enc[4 * i] = key_exp[i] >> 24;
+		enc[4 * i + 1] = (key_exp[i] >> 16) & 0xff;
+		enc[4 * i + 2] = (key_exp[i] >> 8) & 0xff;
+		enc[4 * i + 3] = key_exp[i] & 0xff;
+	}
+
+	memcpy(dec, enc + AES_ROUNDS * 16, 16);
+	for (size_t k = 1; k < AES_ROUNDS; k++)
+		xmm_store(dec + k * 16, aesimc(xmm_load(enc + (AES_ROUNDS - k) * 16)));
+	memcpy(dec + AES_ROUNDS * 16, enc, 16);
+}
+
+static inline void load_round_keys(const uint32_t *key, xmm_t *rk)
+{
+	for (size_t k = 0; k <= AES_ROUNDS; k++)
+		rk[k] = xmm_load(key + 4 * k);
+}
+
+/** Encrypt four blocks with interleaved rounds to hide the latency. */
+static inline void encrypt4(const xmm_t *rk, xmm_t *b)
+{
+	for (size_t i = 0; i < 4; i++)
+		b[i] ^= rk[0];
+
+	for (size_t k = 1; k < AES_ROUNDS; k++) {
+		for (size_t i = 0; i < 4; i++)
+			b[i] = aesenc(b[i], rk[k]);
+	}
+
+	for (size_t i = 0; i < 4; i++)
+		b[i] = aesenclast(b[i], rk[AES_ROUNDS]);
+}
+
+static inline xmm_t encrypt1(const xmm_t *rk, xmm_t b)
+{
+	b ^= rk[0];
+	for (size_t k = 1; k < AES_ROUNDS; k++)
+		b = aesenc(b, rk[k]);
+
+	return aesenclast(b, rk[AES_ROUNDS]);
+}
+
+void aes_accel_encrypt(const uint32_t *enc_key, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	xmm_t rk[AES_ROUNDS + 1];
+	xmm_t b[4];
+
+	load_round_keys(enc_key, rk);
+
+	for (; blocks >= 4; blocks -= 4) {
+		for (size_t i = 0; i < 4; i++)
+			b[i] = xmm_load(input + 16 * i);
+
+		encrypt4(rk, b);
+
+		for (size_t i = 0; i < 4; i++)
+			xmm_store(output + 16 * i, b[i]);
+
+		input += 64;
+		output += 64;
+	}
+
+	for (; blocks > 0; blocks--) {
+		xmm_store(output, encrypt1(rk, xmm_load(input)));
+		input += 16;
+		output += 16;
+	}
+}
+
+void aes_accel_decrypt(const uint32_t *dec_key, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	xmm_t rk[AES_ROUNDS + 1];
+	xmm_t b[4];
+
+	load_round_keys(dec_key, rk);
+
+	for (; blocks >= 4; blocks -= 4) {
+		for (size_t i = 0; i < 4; i++)
+			b[i] = xmm_load(input + 16 * i) ^ rk[0];
+
+		for (size_t k = 1; k < AES_ROUNDS; k++) {
+			for (size_t i = 0; i < 4; i++)
+				b[i] = aesdec(b[i], rk[k]);
+		}
+
+		for (size_t i = 0; i < 4; i++)
+			xmm_store(output + 16 * i, aesdeclast(b[i], rk[AES_ROUNDS]));
+
+		input += 64;
+		output += 64;
+	}
+
+	for (; blocks > 0; blocks--) {
+		xmm_t block = xmm_load(input) ^ rk[0];
+		for (size_t k = 1; k < AES_ROUNDS; k++)
+			block = aesdec(block, rk[k]);
+
+		xmm_store(output, aesdeclast(block, rk[AES_ROUNDS]));
+		input += 16;
+		output += 16;
+	}
+}
+
+void aes_accel_ctr(const uint32_t *enc_key, uint8_t *ctr,
+    const uint8_t *input, uint8_t *output, size_t blocks, size_t width)
+{
+	xmm_t rk[AES_ROUNDS + 1];
+	xmm_t b[4];
+
+	load_round_keys(enc_key, rk);
+
+	for (; blocks >= 4; blocks -= 4) {
+		for (size_t i = 0; i < 4; i++) {
+			b[i] = xmm_load(ctr);
+			ctr_increment(ctr, width);
+		}
+
+		encrypt4(rk, b);
+
+		for (size_t i = 0; i < 4; i++)
+			xmm_store(output + 16 * i, xmm_load(input + 16 * i) ^ b[i]);
+
+		input += 64;
+		output += 64;
+	}
+
+	for (; blocks > 0; blocks--) {
+		xmm_t stream = encrypt1(rk, xmm_load(ctr));
+		ctr_increment(ctr, width);
+
+		xmm_store(output, xmm_load(input) ^ stream);
+		input += 16;
+		output += 16;
+	}
+}
+
+bool ghash_accel_available(void)
+{
+	return (get_features() & FEATURE_GHASH) != 0;
+}
+
+void ghash_accel_set_key(const uint8_t *h, uint8_t *key)
+{
+	xmm_store(key, byte_reverse(xmm_load(h)));
+}
+
+/** Multiply in GF(2^128) as defined by GCM.
+ *
+ * Both operands are byte-reversed. The carry-less product of bit-reflected
+ * values is shifted left by one bit and then reduced modulo
+ * x^128 + x^7 + x^2 + x + 1 (see Intel's Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode white paper).
+ */
+static inline xmm_t gfmul(xmm_t a, xmm_t b)
+{
+	xmm_t lo = PCLMULQDQ(a, b, 0x00);
+	xmm_t mid = PCLMULQDQ(a, b, 0x10) ^ PCLMULQDQ(a, b, 0x01);
+	xmm_t hi = PCLMULQDQ(a, b, 0x11);
+
+	lo ^= PSLLDQ(mid, 8);
+	hi ^= PSRLDQ(mid, 8);
+
+	/* Shift the 256-bit product left by one bit. */
+	xmm_t lo_carry = shr_u32(lo, 31);
+	xmm_t hi_carry = shr_u32(hi, 31);
+	lo = shl_u32(lo, 1) | PSLLDQ(lo_carry, 4);
+	hi = shl_u32(hi, 1) | PSLLDQ(hi_carry, 4) | PSRLDQ(lo_carry, 12);
+
+	/* Reduce. */
+	xmm_t t = shl_u32(lo, 31) ^ shl_u32(lo, 30) ^ shl_u32(lo, 25);
+	xmm_t t_hi = PSRLDQ(t, 4);
+	lo ^= PSLLDQ(t, 12);
+
+	xmm_t u = shr_u32(lo, 1) ^ shr_u32(lo, 2) ^ shr_u32(lo, 7) ^ t_hi;
+	return hi ^ lo ^ u;
+}
+
+void ghash_accel(const uint8_t *key, uint8_t *x, const uint8_t *data,
+    size_t blocks)
+{
+	xmm_t h = xmm_load(key);
+	xmm_t state = byte_reverse(xmm_load(x));
+
+	for (size_t i = 0; i < blocks; i++) {
+		state ^= byte_reverse(xmm_load(data));
+		state = gfmul(state, h);
+		data += 16;
+	}
+
+	xmm_store(x, byte_reverse(state));
+}
+
+bool sha256_accel_available(void)
+{
+	return (get_features() & FEATURE_SHA256) != 0;
+}
+
+/** SHA-256 block function using the SHA extensions.
+ *
+ * The sixteen quad-rounds share one pattern: the message schedule for the
+ * quad-round i + 1 is finished (sha256msg2) while the quad-round i is being
+ * computed and the one for i + 3 is started (sha256msg1).
+ *
+ * @param h      Hash state.
+ * @param data   Input blocks.
+ * @param blocks Number of HASH_BLOCK_LENGTH blocks.
+ */
+void sha256_accel(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	const xmm_t bswap_mask = {
+		0x0405060700010203LL, 0x0c0d0e0f08090a0bLL
+	};
+
+	/* Rearrange the state into the ABEF/CDGH form. */
+	xmm_t tmp = PSHUFD(xmm_load(h), 0xb1);
+	xmm_t state1 = PSHUFD(xmm_load(h + 4), 0x1b);
+	xmm_t state0 = PALIGNR(tmp, state1, 8);
+	state1 = PBLENDW(state1, tmp, 0xf0);
+
+	for (; blocks > 0; blocks--) {
+		xmm_t save0 = state0;
+		xmm_t save1 = state1;
+		xmm_t msg[4];
+
+		for (size_t i = 0; i < 4; i++)
+			msg[i] = pshufb(xmm_load(data + 16 * i), bswap_mask);
+
+		for (size_t i = 0; i < 16; i++) {
+			xmm_t wk = add_u32(msg[i % 4], xmm_load(&sha256_k[4 * i]));
+			state1 = sha256rnds2(state1, state0, wk);
+
+			if ((i >= 3) && (i <= 14)) {
+				xmm_t *next = &msg[(i + 1) % 4];
+				*next = add_u32(*next,
+				    PALIGNR(msg[i % 4], msg[(i + 3) % 4], 4));
+				*next = sha256msg2(*next, msg[i % 4]);
+			}
+
+			wk = PSHUFD(wk, 0x0e);
+			state0 = sha256rnds2(state0, state1, wk);
+
+			if ((i >= 1) && (i <= 12)) {
+				xmm_t *prev = &msg[(i + 3) % 4];
+				*prev = sha256msg1(*prev, msg[i % 4]);
+			}
+		}
+
+		state0 = add_u32(state0, save0);
+		state1 = add_u32(state1, save1);
+		data += HASH_BLOCK_LENGTH;
+	}
+
+	/* Back to the ABCD/EFGH form. */
+	tmp = PSHUFD(state0, 0x1b);
+	state1 = PSHUFD(state1, 0xb1);
+	xmm_store(h, PBLENDW(tmp, state1, 0xf0));
+	xmm_store(h + 4, PALIGNR(state1, tmp, 8));
+}
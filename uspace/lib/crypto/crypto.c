@@ -25,45 +25,62 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 /** @file crypto.c
  *
  * Cryptographic functions library.
  */
 
-#include <assert.h>
 #include <str.h>
 #include <macros.h>
 #include <errno.h>
 #include <byteorder.h>
-#include <limits.h>
 #include "crypto.h"
+#include "accel.h"
 
-/** Hash function procedure definition. */
-typedef void (*hash_fnc_t)(uint32_t *, uint32_t *);
+/** Hash function procedure definition.
+ *
+ * Processes the given number of HASH_BLOCK_LENGTH blocks of input.
+ */
+typedef void (*hash_fnc_t)(uint32_t *, const uint8_t *, size_t);
 
 /** Length of HMAC block. */
-#define HMAC_BLOCK_LENGTH  64
-
-/** Ceiling for uint32_t. */
-#define ceil_uint32(val) \
-	(((val) - (uint32_t) (val)) > 0 ? \
-	(uint32_t) ((val) + 1) : (uint32_t) (val))
-
-/** Floor for uint32_t. */
-#define floor_uint32(val) \
-	(((val) - (uint32_t) (val)) < 0 ? \
-	(uint32_t) ((val) - 1) : (uint32_t) (val))
+#define HMAC_BLOCK_LENGTH  HASH_BLOCK_LENGTH
 
-/** Pick value at specified index from array or zero if out of bounds. */
-#define get_at(input, size, i) \
-	((i) < (size) ? (input[i]) : 0)
+/** Number of PBKDF2 iterations used for WPA/WPA2. */
+#define PBKDF2_ITERATIONS  4096
 
 /** Init values used in SHA1 and MD5 functions. */
 static const uint32_t hash_init[] = {
 	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
 };
 
+/** Init values used in SHA-256 function. */
+static const uint32_t sha256_init[] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/** Round constants for SHA-256 algorithm. */
+const uint32_t sha256_k[] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
 /** Shift amount array for MD5 algorithm. */
 static const uint32_t md5_shift[] = {
 	7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
@@ -92,95 +109,318 @@ static const uint32_t md5_sbox[] = {
 	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
 };
 
+/** Read big-endian 32-bit word from byte sequence. */
+static inline uint32_t load_be32(const uint8_t *src)
+{
+	return ((uint32_t) src[0] << 24) | ((uint32_t) src[1] << 16) |
+	    ((uint32_t) src[2] << 8) | (uint32_t) src[3];
+}
+
+/** Read little-endian 32-bit word from byte sequence. */
+static inline uint32_t load_le32(const uint8_t *src)
+{
+	return ((uint32_t) src[3] << 24) | ((uint32_t) src[2] << 16) |
+	    ((uint32_t) src[1] << 8) | (uint32_t) src[0];
+}
+
 /** Working procedure of MD5 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
  *
  */
-static void md5_proc(uint32_t *h, uint32_t *sched_arr)
+static void md5_proc(uint32_t *h, const uint8_t *data, size_t blocks)
 {
 	uint32_t f, g, temp;
 	uint32_t w[HASH_MD5 / 4];
+	uint32_t sched_arr[16];
 
-	memcpy(w, h, (HASH_MD5 / 4) * sizeof(uint32_t));
-
-	for (size_t k = 0; k < 64; k++) {
-		if (k < 16) {
-			f = (w[1] & w[2]) | (~w[1] & w[3]);
-			g = k;
-		} else if ((k >= 16) && (k < 32)) {
-			f = (w[1] & w[3]) | (w[2] & ~w[3]);
-			g = (5 * k + 1) % 16;
-		} else if ((k >= 32) && (k < 48)) {
-			f = w[1] ^ w[2] ^ w[3];
-			g = (3 * k + 5) % 16;
-		} else {
-			f = w[2] ^ (w[1] | ~w[3]);
-			g = 7 * k % 16;
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (size_t k = 0; k < 16; k++)
+			sched_arr[k] = load_le32(data + 4 * k);
+
+		memcpy(w, h, (HASH_MD5 / 4) * sizeof(uint32_t));
+
+		for (size_t k = 0; k < 64; k++) {
+			if (k < 16) {
+				f = (w[1] & w[2]) | (~w[1] & w[3]);
+				g = k;
+			} else if ((k >= 16) && (k < 32)) {
+				f = (w[1] & w[3]) | (w[2] & ~w[3]);
+				g = (5 * k + 1) % 16;
+			} else if ((k >= 32) && (k < 48)) {
+				f = w[1] ^ w[2] ^ w[3];
+				g = (3 * k + 5) % 16;
+			} else {
+				f = w[2] ^ (w[1] | ~w[3]);
+				g = 7 * k % 16;
+			}
+
+			temp = w[3];
+			w[3] = w[2];
+			w[2] = w[1];
+			w[1] += rotl_uint32(w[0] + f + md5_sbox[k] +
+			    sched_arr[g], md5_shift[k]);
+			w[0] = temp;
 		}
 
-		temp = w[3];
-		w[3] = w[2];
-		w[2] = w[1];
-		w[1] += rotl_uint32(w[0] + f + md5_sbox[k] +
-		    uint32_t_byteorder_swap(sched_arr[g]),
-		    md5_shift[k]);
-		w[0] = temp;
+		for (uint8_t k = 0; k < HASH_MD5 / 4; k++)
+			h[k] += w[k];
 	}
-
-	for (uint8_t k = 0; k < HASH_MD5 / 4; k++)
-		h[k] += w[k];
 }
 
 /** Working procedure of SHA-1 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
  *
  */
-static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
+static void sha1_proc(uint32_t *h, const uint8_t *data, size_t blocks)
 {
 	uint32_t f, cf, temp;
 	uint32_t w[HASH_SHA1 / 4];
+	uint32_t sched_arr[80];
 
-	for (size_t k = 16; k < 80; k++) {
-		sched_arr[k] = rotl_uint32(
-		    sched_arr[k - 3] ^
-		    sched_arr[k - 8] ^
-		    sched_arr[k - 14] ^
-		    sched_arr[k - 16],
-		    1);
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (size_t k = 0; k < 16; k++)
+			sched_arr[k] = load_be32(data + 4 * k);
+
+		for (size_t k = 16; k < 80; k++) {
+			sched_arr[k] = rotl_uint32(
+			    sched_arr[k - 3] ^
+			    sched_arr[k - 8] ^
+			    sched_arr[k - 14] ^
+			    sched_arr[k - 16],
+			    1);
+		}
+
+		memcpy(w, h, (HASH_SHA1 / 4) * sizeof(uint32_t));
+
+		for (size_t k = 0; k < 80; k++) {
+			if (k < 20) {
+				f = (w[1] & w[2]) | (~w[1] & w[3]);
+				cf = 0x5A827999;
+			} else if ((k >= 20) && (k < 40)) {
+				f = w[1] ^ w[2] ^ w[3];
+				cf = 0x6ed9eba1;
+			} else if ((k >= 40) && (k < 60)) {
+				f = (w[1] & w[2]) | (w[1] & w[3]) | (w[2] & w[3]);
+				cf = 0x8f1bbcdc;
+			} else {
+				f = w[1] ^ w[2] ^ w[3];
+				cf = 0xca62c1d6;
+			}
+
+			temp = rotl_uint32(w[0], 5) + f + w[4] + cf + sched_arr[k];
+
+			w[4] = w[3];
+			w[3] = w[2];
+			w[2] = rotl_uint32(w[1], 30);
+			w[1] = w[0];
+			w[0] = temp;
+		}
+
+		for (uint8_t k = 0; k < HASH_SHA1 / 4; k++)
+			h[k] += w[k];
 	}
+}
+
+/** Working procedure of SHA-256 cryptographic hash function.
+ *
+ * @param h      Working array with interim hash parts values.
+ * @param data   Input blocks.
+ * @param blocks Number of input blocks.
+ *
+ */
+static void sha256_proc(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+	uint32_t w[HASH_SHA256 / 4];
+	uint32_t sched_arr[64];
+
+	for (; blocks > 0; blocks--, data += HASH_BLOCK_LENGTH) {
+		for (size_t k = 0; k < 16; k++)
+			sched_arr[k] = load_be32(data + 4 * k);
+
+		for (size_t k = 16; k < 64; k++) {
+			uint32_t s0 = rotr_uint32(sched_arr[k - 15], 7) ^
+			    rotr_uint32(sched_arr[k - 15], 18) ^
+			    (sched_arr[k - 15] >> 3);
+			uint32_t s1 = rotr_uint32(sched_arr[k - 2], 17) ^
+			    rotr_uint32(sched_arr[k - 2], 19) ^
+			    (sched_arr[k - 2] >> 10);
+
+			sched_arr[k] = sched_arr[k - 16] + s0 +
+			    sched_arr[k - 7] + s1;
+		}
 
-	memcpy(w, h, (HASH_SHA1 / 4) * sizeof(uint32_t));
-
-	for (size_t k = 0; k < 80; k++) {
-		if (k < 20) {
-			f = (w[1] & w[2]) | (~w[1] & w[3]);
-			cf = 0x5A827999;
-		} else if ((k >= 20) && (k < 40)) {
-			f = w[1] ^ w[2] ^ w[3];
-			cf = 0x6ed9eba1;
-		} else if ((k >= 40) && (k < 60)) {
-			f = (w[1] & w[2]) | (w[1] & w[3]) | (w[2] & w[3]);
-			cf = 0x8f1bbcdc;
-		} else {
-			f = w[1] ^ w[2] ^ w[3];
-			cf = 0xca62c1d6;
+		memcpy(w, h, (HASH_SHA256 / 4) * sizeof(uint32_t));
+
+		for (size_t k = 0; k < 64; k++) {
+			uint32_t s1 = rotr_uint32(w[4], 6) ^
+			    rotr_uint32(w[4], 11) ^ rotr_uint32(w[4], 25);
+			uint32_t ch = (w[4] & w[5]) ^ (~w[4] & w[6]);
+			uint32_t temp1 = w[7] + s1 + ch + sha256_k[k] +
+			    sched_arr[k];
+			uint32_t s0 = rotr_uint32(w[0], 2) ^
+			    rotr_uint32(w[0], 13) ^ rotr_uint32(w[0], 22);
+			uint32_t maj = (w[0] & w[1]) ^ (w[0] & w[2]) ^
+			    (w[1] & w[2]);
+			uint32_t temp2 = s0 + maj;
+
+			w[7] = w[6];
+			w[6] = w[5];
+			w[5] = w[4];
+			w[4] = w[3] + temp1;
+			w[3] = w[2];
+			w[2] = w[1];
+			w[1] = w[0];
+			w[0] = temp1 + temp2;
 		}
 
-		temp = rotl_uint32(w[0], 5) + f + w[4] + cf + sched_arr[k];
+		for (uint8_t k = 0; k < HASH_SHA256 / 4; k++)
+			h[k] += w[k];
+	}
+}
+
+/** Select block procedure for given hash function.
+ *
+ * @param hash_sel Hash function selector.
+ *
+ * @return Block procedure.
+ *
+ */
+static hash_fnc_t hash_proc(hash_func_t hash_sel)
+{
+	switch (hash_sel) {
+	case HASH_MD5:
+		return md5_proc;
+	case HASH_SHA1:
+		return sha1_proc;
+	case HASH_SHA256:
+		if (sha256_accel_available())
+			return sha256_accel;
+		return sha256_proc;
+	}
+
+	return NULL;
+}
 
-		w[4] = w[3];
-		w[3] = w[2];
-		w[2] = rotl_uint32(w[1], 30);
-		w[1] = w[0];
-		w[0] = temp;
+/** Initialize incremental hash computation.
+ *
+ * @param ctx      Hash context.
+ * @param hash_sel Hash function selector.
+ *
+ * @return EINVAL when context not specified or hash function
+ *         not supported, otherwise EOK.
+ *
+ */
+errno_t hash_ctx_init(hash_ctx_t *ctx, hash_func_t hash_sel)
+{
+	if (!ctx)
+		return EINVAL;
+
+	switch (hash_sel) {
+	case HASH_MD5:
+	case HASH_SHA1:
+		memcpy(ctx->h, hash_init, hash_sel);
+		break;
+	case HASH_SHA256:
+		memcpy(ctx->h, sha256_init, hash_sel);
+		break;
+	default:
+		return EINVAL;
 	}
 
-	for (uint8_t k = 0; k < HASH_SHA1 / 4; k++)
-		h[k] += w[k];
+	ctx->hash_sel = hash_sel;
+	ctx->block_used = 0;
+	ctx->length = 0;
+
+	return EOK;
+}
+
+/** Add data to incremental hash computation.
+ *
+ * @param ctx  Hash context.
+ * @param data Input data.
+ * @param size Size of input data.
+ *
+ */
+void hash_ctx_update(hash_ctx_t *ctx, const void *data, size_t size)
+{
+	const uint8_t *input = data;
+	hash_fnc_t hash_func = hash_proc(ctx->hash_sel);
+
+	ctx->length += size;
+
+	if (ctx->block_used > 0) {
+		size_t fill = min(size, HASH_BLOCK_LENGTH - ctx->block_used);
+		memcpy(ctx->block + ctx->block_used, input, fill);
+		ctx->block_used += fill;
+		input += fill;
+		size -= fill;
+
+		if (ctx->block_used < HASH_BLOCK_LENGTH)
+			return;
+
+		hash_func(ctx->h, ctx->block, 1);
+		ctx->block_used = 0;
+	}
+
+	/* Process whole blocks directly from the input. */
+	size_t blocks = size / HASH_BLOCK_LENGTH;
+	if (blocks > 0) {
+		hash_func(ctx->h, input, blocks);
+		input += blocks * HASH_BLOCK_LENGTH;
+		size -= blocks * HASH_BLOCK_LENGTH;
+	}
+
+	memcpy(ctx->block, input, size);
+	ctx->block_used = size;
+}
+
+/** Finish incremental hash computation.
+ *
+ * @param ctx    Hash context.
+ * @param output Result hash byte sequence (ctx->hash_sel bytes).
+ *
+ */
+void hash_ctx_final(hash_ctx_t *ctx, uint8_t *output)
+{
+	hash_fnc_t hash_func = hash_proc(ctx->hash_sel);
+	uint64_t bits_size = ctx->length * 8;
+
+	ctx->block[ctx->block_used++] = 0x80;
+	if (ctx->block_used > HASH_BLOCK_LENGTH - 8) {
+		memset(ctx->block + ctx->block_used, 0,
+		    HASH_BLOCK_LENGTH - ctx->block_used);
+		hash_func(ctx->h, ctx->block, 1);
+		ctx->block_used = 0;
+	}
+
+	memset(ctx->block + ctx->block_used, 0,
+	    HASH_BLOCK_LENGTH - 8 - ctx->block_used);
+
+	if (ctx->hash_sel == HASH_MD5)
+		bits_size = host2uint64_t_le(bits_size);
+	else
+		bits_size = host2uint64_t_be(bits_size);
+
+	memcpy(ctx->block + HASH_BLOCK_LENGTH - 8, &bits_size, 8);
+	hash_func(ctx->h, ctx->block, 1);
+
+	/* Copy hash parts into final result. */
+	for (size_t i = 0; i < ctx->hash_sel / 4; i++) {
+		uint32_t part;
+
+		if (ctx->hash_sel == HASH_MD5)
+			part = host2uint32_t_le(ctx->h[i]);
+		else
+			part = host2uint32_t_be(ctx->h[i]);
+
+		memcpy(output + i * sizeof(uint32_t), &part, sizeof(uint32_t));
+	}
 }
 
 /** Create hash based on selected algorithm.
@@ -190,71 +430,101 @@ static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
  * @param output     Result hash byte sequence.
  * @param hash_sel   Hash function selector.
  *
- * @return EINVAL when input not specified,
- *         ENOMEM when pointer for output hash result
+ * @return EINVAL when input not specified or hash function
+ *         not supported, ENOMEM when pointer for output hash result
  *         is not allocated, otherwise EOK.
  *
  */
 errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
     hash_func_t hash_sel)
 {
-	assert(input_size < SSIZE_MAX);
-
 	if (!input)
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	hash_fnc_t hash_func = (hash_sel == HASH_MD5) ? md5_proc : sha1_proc;
-
-	/* Prepare scheduled input. */
-	uint8_t work_input[input_size + 1];
-	memcpy(work_input, input, input_size);
-	work_input[input_size] = 0x80;
-
-	// FIXME: double?
-	size_t blocks = ceil_uint32((((double) input_size + 1) / 4 + 2) / 16);
-	uint32_t work_arr[blocks * 16];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t j = 0; j < 16; j++) {
-			work_arr[i * 16 + j] =
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4) << 24) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 1) << 16) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 2) << 8) |
-			    get_at(work_input, input_size + 1, i * 64 + j * 4 + 3);
-		}
-	}
+	hash_ctx_t ctx;
+	errno_t rc = hash_ctx_init(&ctx, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	uint64_t bits_size = (uint64_t) (input_size * 8);
-	if (hash_sel == HASH_MD5)
-		bits_size = uint64_t_byteorder_swap(bits_size);
+	hash_ctx_update(&ctx, input, input_size);
+	hash_ctx_final(&ctx, output);
 
-	work_arr[(blocks - 1) * 16 + 14] = bits_size >> 32;
-	work_arr[(blocks - 1) * 16 + 15] = bits_size & 0xffffffff;
+	return EOK;
+}
 
-	/* Hash computation. */
-	uint32_t h[hash_sel / 4];
-	memcpy(h, hash_init, (hash_sel / 4) * sizeof(uint32_t));
-	uint32_t sched_arr[80];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t k = 0; k < 16; k++)
-			sched_arr[k] = work_arr[i * 16 + k];
+/** Prepare inner and outer HMAC hash states for given key.
+ *
+ * @param inner    Output inner hash context.
+ * @param outer    Output outer hash context.
+ * @param key      Cryptographic key sequence.
+ * @param key_size Size of key sequence.
+ * @param hash_sel Hash function selector.
+ *
+ * @return EINVAL when hash function not supported, otherwise EOK.
+ *
+ */
+static errno_t hmac_init(hash_ctx_t *inner, hash_ctx_t *outer,
+    const uint8_t *key, size_t key_size, hash_func_t hash_sel)
+{
+	uint8_t work_key[HMAC_BLOCK_LENGTH];
+	uint8_t o_key_pad[HMAC_BLOCK_LENGTH];
+	uint8_t i_key_pad[HMAC_BLOCK_LENGTH];
+	memset(work_key, 0, HMAC_BLOCK_LENGTH);
 
-		hash_func(h, sched_arr);
-	}
+	errno_t rc = hash_ctx_init(inner, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	/* Copy hash parts into final result. */
-	for (size_t i = 0; i < hash_sel / 4; i++) {
-		if (hash_sel == HASH_SHA1)
-			h[i] = uint32_t_byteorder_swap(h[i]);
+	if (key_size > HMAC_BLOCK_LENGTH) {
+		hash_ctx_update(inner, key, key_size);
+		hash_ctx_final(inner, work_key);
+		hash_ctx_init(inner, hash_sel);
+	} else {
+		memcpy(work_key, key, key_size);
+	}
 
-		memcpy(output + i * sizeof(uint32_t), &h[i], sizeof(uint32_t));
+	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++) {
+		o_key_pad[i] = work_key[i] ^ 0x5c;
+		i_key_pad[i] = work_key[i] ^ 0x36;
 	}
 
+	hash_ctx_update(inner, i_key_pad, HMAC_BLOCK_LENGTH);
+
+	hash_ctx_init(outer, hash_sel);
+	hash_ctx_update(outer, o_key_pad, HMAC_BLOCK_LENGTH);
+
 	return EOK;
 }
 
+/** Compute HMAC of a message using prepared hash states.
+ *
+ * The prepared states are left intact so that they can be reused.
+ *
+ * @param inner    Inner hash context prepared by hmac_init().
+ * @param outer    Outer hash context prepared by hmac_init().
+ * @param msg      Message sequence.
+ * @param msg_size Size of message sequence.
+ * @param hash     Output parameter for result hash.
+ *
+ */
+static void hmac_compute(const hash_ctx_t *inner, const hash_ctx_t *outer,
+    const uint8_t *msg, size_t msg_size, uint8_t *hash)
+{
+	hash_ctx_t ctx;
+	uint8_t temp_hash[HASH_SHA256];
+
+	ctx = *inner;
+	hash_ctx_update(&ctx, msg, msg_size);
+	hash_ctx_final(&ctx, temp_hash);
+
+	ctx = *outer;
+	hash_ctx_update(&ctx, temp_hash, outer->hash_sel);
+	hash_ctx_final(&ctx, hash);
+}
+
 /** Hash-based message authentication code.
  *
  * @param key      Cryptographic key sequence.
@@ -264,8 +534,8 @@ errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
  * @param hash     Output parameter for result hash.
  * @param hash_sel Hash function selector.
  *
- * @return EINVAL when key or message not specified,
- *         ENOMEM when pointer for output hash result
+ * @return EINVAL when key or message not specified or hash function
+ *         not supported, ENOMEM when pointer for output hash result
  *         is not allocated, otherwise EOK.
  *
  */
@@ -278,34 +548,13 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_key[HMAC_BLOCK_LENGTH];
-	uint8_t o_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t i_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t temp_hash[hash_sel];
-	memset(work_key, 0, HMAC_BLOCK_LENGTH);
-
-	if (key_size > HMAC_BLOCK_LENGTH)
-		create_hash(key, key_size, work_key, hash_sel);
-	else
-		memcpy(work_key, key, key_size);
-
-	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++) {
-		o_key_pad[i] = work_key[i] ^ 0x5c;
-		i_key_pad[i] = work_key[i] ^ 0x36;
-	}
-
-	uint8_t temp_work[HMAC_BLOCK_LENGTH + max(msg_size, hash_sel)];
-	memcpy(temp_work, i_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, msg, msg_size);
-
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + msg_size, temp_hash,
-	    hash_sel);
-
-	memcpy(temp_work, o_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, temp_hash, hash_sel);
-
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + hash_sel, hash, hash_sel);
+	hash_ctx_t inner;
+	hash_ctx_t outer;
+	errno_t rc = hmac_init(&inner, &outer, key, key_size, hash_sel);
+	if (rc != EOK)
+		return rc;
 
+	hmac_compute(&inner, &outer, msg, msg_size, hash);
 	return EOK;
 }
 
@@ -314,6 +563,9 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
  * As defined in RFC 2898, using HMAC-SHA1 with 4096 iterations
  * and 32 bytes key result used for WPA/WPA2.
  *
+ * The inner and outer HMAC states depend only on the password, so they
+ * are computed once and each iteration costs just two compressions.
+ *
  * @param pass      Password sequence.
  * @param pass_size Password sequence length.
  * @param salt      Salt sequence to be used with password.
@@ -334,25 +586,31 @@ errno_t pbkdf2(uint8_t *pass, size_t pass_size, uint8_t *salt, size_t salt_size,
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_salt[salt_size + 4];
-	memcpy(work_salt, salt, salt_size);
+	hash_ctx_t inner;
+	hash_ctx_t outer;
+	hmac_init(&inner, &outer, pass, pass_size, HASH_SHA1);
+
 	uint8_t work_hmac[HASH_SHA1];
-	uint8_t temp_hmac[HASH_SHA1];
 	uint8_t xor_hmac[HASH_SHA1];
 	uint8_t temp_hash[HASH_SHA1 * 2];
 
 	for (size_t i = 0; i < 2; i++) {
 		uint32_t be_i = host2uint32_t_be(i + 1);
+		hash_ctx_t ctx = inner;
+
+		/* The first iteration hashes salt || INT(i). */
+		hash_ctx_update(&ctx, salt, salt_size);
+		hash_ctx_update(&ctx, &be_i, 4);
+		hash_ctx_final(&ctx, work_hmac);
 
-		memcpy(work_salt + salt_size, &be_i, 4);
-		hmac(pass, pass_size, work_salt, salt_size + 4,
-		    work_hmac, HASH_SHA1);
+		ctx = outer;
+		hash_ctx_update(&ctx, work_hmac, HASH_SHA1);
+		hash_ctx_final(&ctx, work_hmac);
 		memcpy(xor_hmac, work_hmac, HASH_SHA1);
 
-		for (size_t k = 1; k < 4096; k++) {
-			memcpy(temp_hmac, work_hmac, HASH_SHA1);
-			hmac(pass, pass_size, temp_hmac, HASH_SHA1,
-			    work_hmac, HASH_SHA1);
+		for (size_t k = 1; k < PBKDF2_ITERATIONS; k++) {
+			hmac_compute(&inner, &outer, work_hmac, HASH_SHA1,
+			    work_hmac);
 
 			for (size_t t = 0; t < HASH_SHA1; t++)
 				xor_hmac[t] ^= work_hmac[t];
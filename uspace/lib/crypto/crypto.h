@@ -30,12 +30,24 @@
 #define LIBCRYPTO_H
 
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #define AES_CIPHER_LENGTH  16
+#define AES_KEY_LENGTH     16
+#define AES_GCM_TAG_LENGTH 16
 #define PBKDF2_KEY_LENGTH  32
 
+/* Number of rounds of AES-128. */
+#define AES_ROUNDS  10
+
+/* Number of words in the expanded AES-128 key. */
+#define AES_KEY_EXP_WORDS  (4 * (AES_ROUNDS + 1))
+
+/* Length of block processed by all supported hash functions. */
+#define HASH_BLOCK_LENGTH  64
+
 /* Left rotation for uint32_t. */
 #define rotl_uint32(val, shift) \
 	(((val) << shift) | ((val) >> (32 - shift)))
@@ -47,12 +59,57 @@
 /** Hash function selector and also result hash length indicator. */
 typedef enum {
 	HASH_MD5 =  16,
-	HASH_SHA1 = 20
+	HASH_SHA1 = 20,
+	HASH_SHA256 = 32
 } hash_func_t;
 
+/** AES-128 key schedule.
+ *
+ * The layout of the round keys depends on the implementation selected
+ * for the running CPU and should be treated as opaque.
+ */
+typedef struct {
+	uint32_t enc_key[AES_KEY_EXP_WORDS];
+	uint32_t dec_key[AES_KEY_EXP_WORDS];
+	/** Round keys are laid out for the hardware implementation. */
+	bool accel;
+} aes_ctx_t;
+
+/** AES-128 in Galois/Counter Mode. */
+typedef struct {
+	aes_ctx_t aes;
+	/** Hash subkey H in the form used by the hardware implementation. */
+	uint8_t h[16];
+	/** Multiples of H used by the table-driven GHASH. */
+	uint64_t hl[16];
+	uint64_t hh[16];
+} aes_gcm_ctx_t;
+
+/** Incremental hash computation state. */
+typedef struct {
+	hash_func_t hash_sel;
+	uint32_t h[HASH_SHA256 / 4];
+	uint8_t block[HASH_BLOCK_LENGTH];
+	size_t block_used;
+	uint64_t length;
+} hash_ctx_t;
+
 extern errno_t rc4(uint8_t *, size_t, uint8_t *, size_t, size_t, uint8_t *);
 extern errno_t aes_encrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t aes_decrypt(uint8_t *, uint8_t *, uint8_t *);
+extern errno_t aes_set_key(aes_ctx_t *, const uint8_t *);
+extern void aes_encrypt_blocks(aes_ctx_t *, const uint8_t *, uint8_t *, size_t);
+extern void aes_decrypt_blocks(aes_ctx_t *, const uint8_t *, uint8_t *, size_t);
+extern void aes_ctr(aes_ctx_t *, uint8_t *, const uint8_t *, uint8_t *, size_t);
+extern errno_t aes_gcm_set_key(aes_gcm_ctx_t *, const uint8_t *);
+extern errno_t aes_gcm_encrypt(aes_gcm_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t, uint8_t *);
+extern errno_t aes_gcm_decrypt(aes_gcm_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t,
+    const uint8_t *);
+extern errno_t hash_ctx_init(hash_ctx_t *, hash_func_t);
+extern void hash_ctx_update(hash_ctx_t *, const void *, size_t);
+extern void hash_ctx_final(hash_ctx_t *, uint8_t *);
 extern errno_t create_hash(uint8_t *, size_t, uint8_t *, hash_func_t);
 extern errno_t hmac(uint8_t *, size_t, uint8_t *, size_t, uint8_t *, hash_func_t);
 extern errno_t pbkdf2(uint8_t *, size_t, uint8_t *, size_t, uint8_t *);
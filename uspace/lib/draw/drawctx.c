@@ -35,10 +35,14 @@
 
 #include <assert.h>
 #include <adt/list.h>
+#include <macros.h>
 #include <stdlib.h>
 
 #include "drawctx.h"
 
+/** Number of pixels composed at once by drawctx_transfer(). */
+#define DRAWCTX_SPAN_SIZE  256
+
 void drawctx_init(drawctx_t *context, surface_t *surface)
 {
 	assert(surface);
@@ -133,6 +137,8 @@ void drawctx_transfer(drawctx_t *context,
 	    (context->mask == NULL) &&
 	    (context->compose == compose_src || context->compose == compose_over);
 
+	compose_span_t compose_span = compose_get_span(context->compose);
+
 	if (transfer_fast) {
 
 		for (sysarg_t _y = y; _y < y + height; ++_y) {
@@ -147,6 +153,31 @@ void drawctx_transfer(drawctx_t *context,
 		}
 		surface_add_damaged_region(context->surface, x, y, width, height);
 
+	} else if (compose_span && !context->shall_clip && !context->mask) {
+
+		/* Clip the area to the surface. */
+		sysarg_t surface_width, surface_height;
+		surface_get_resolution(context->surface, &surface_width,
+		    &surface_height);
+		if (x >= surface_width || y >= surface_height)
+			return;
+		width = min(width, surface_width - x);
+		height = min(height, surface_height - y);
+
+		pixel_t span[DRAWCTX_SPAN_SIZE];
+		for (sysarg_t _y = y; _y < y + height; ++_y) {
+			pixel_t *dst = pixelmap_pixel_at(
+			    surface_pixmap_access(context->surface), x, _y);
+			for (sysarg_t done = 0; done < width; ) {
+				size_t count = min(width - done, DRAWCTX_SPAN_SIZE);
+				source_determine_span(context->source, x + done, _y,
+				    span, count);
+				compose_span(dst + done, span, count);
+				done += count;
+			}
+		}
+		surface_add_damaged_region(context->surface, x, y, width, height);
+
 	} else {
 
 		bool clipped = false;
@@ -35,6 +35,7 @@
  */
 
 #include <errno.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <str.h>
 
@@ -83,6 +84,80 @@ errno_t font_render_glyph(font_t *font, drawctx_t *context, source_t *source,
 	    x, y, glyph_id);
 }
 
+errno_t font_get_glyph_mask(font_t *font, glyph_id_t glyph_id,
+    glyph_mask_t *mask)
+{
+	if (font->backend->get_glyph_mask == NULL)
+		return ENOTSUP;
+
+	return font->backend->get_glyph_mask(font->backend_data, glyph_id,
+	    mask);
+}
+
+/** Whether text can be blitted directly instead of through drawctx_transfer.
+ *
+ * This is the case for text drawn in a solid color without any clipping or
+ * masking.
+ */
+static bool font_can_blit(drawctx_t *context, source_t *source)
+{
+	return (context->mask == NULL) && (!context->shall_clip) &&
+	    (source->texture == NULL) && (source->mask == NULL) &&
+	    (source->alpha == (pixel_t) PIXEL(255, 0, 0, 0));
+}
+
+/** Blend glyph coverage in a solid color over the surface.
+ *
+ * Runs of fully covered pixels are filled with the color directly, partially
+ * covered pixels are composed over the surface.
+ */
+static void font_blit_glyph(surface_t *surface, const glyph_mask_t *mask,
+    native_t x, native_t y, sysarg_t width, sysarg_t height, pixel_t color)
+{
+	sysarg_t surface_width, surface_height;
+	surface_get_resolution(surface, &surface_width, &surface_height);
+
+	native_t x0 = max(x, 0);
+	native_t y0 = max(y, 0);
+	native_t x1 = min(x + (native_t) min(width, mask->width),
+	    (native_t) surface_width);
+	native_t y1 = min(y + (native_t) min(height, mask->height),
+	    (native_t) surface_height);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	pixelmap_t *pixmap = surface_pixmap_access(surface);
+	bool opaque = (ALPHA(color) == 255);
+
+	for (native_t row = y0; row < y1; ++row) {
+		const uint8_t *cov = mask->data + (row - y) * mask->stride +
+		    (x0 - x);
+		pixel_t *dst = pixelmap_pixel_at(pixmap, x0, row);
+		native_t count = x1 - x0;
+
+		for (native_t i = 0; i < count; ++i) {
+			if (cov[i] == 0)
+				continue;
+
+			if (cov[i] == 255 && opaque) {
+				native_t run = i + 1;
+				while (run < count && cov[run] == 255)
+					++run;
+				while (i < run)
+					dst[i++] = color;
+				--i;
+				continue;
+			}
+
+			pixel_t fg = PIXEL(cov[i] * ALPHA(color) / 255,
+			    RED(color), GREEN(color), BLUE(color));
+			dst[i] = compose_over(fg, dst[i]);
+		}
+	}
+
+	surface_add_damaged_region(surface, x0, y0, x1 - x0, y1 - y0);
+}
+
 /* TODO this is bad interface */
 errno_t font_get_box(font_t *font, char *text, sysarg_t *width, sysarg_t *height)
 {
@@ -135,6 +210,7 @@ errno_t font_draw_text(font_t *font, drawctx_t *context, source_t *source,
 
 	native_t baseline = sy + fm.ascender;
 	native_t x = sx;
+	bool blit = font_can_blit(context, source);
 
 	size_t off = 0;
 	while (true) {
@@ -156,10 +232,19 @@ errno_t font_draw_text(font_t *font, drawctx_t *context, source_t *source,
 		if (rc != EOK)
 			return rc;
 
-		rc = font_render_glyph(font, context, source, x, baseline,
-		    glyph_id);
-		if (rc != EOK)
-			return rc;
+		glyph_mask_t mask;
+		if (blit && font_get_glyph_mask(font, glyph_id, &mask) == EOK) {
+			font_blit_glyph(context->surface, &mask,
+			    x + glyph_metrics.left_side_bearing,
+			    baseline - glyph_metrics.ascender,
+			    glyph_metrics.width, glyph_metrics.height,
+			    source->color);
+		} else {
+			rc = font_render_glyph(font, context, source, x,
+			    baseline, glyph_id);
+			if (rc != EOK)
+				return rc;
+		}
 
 		x += glyph_metrics_get_advancement(&glyph_metrics);
 
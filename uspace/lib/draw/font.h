@@ -93,12 +93,27 @@ typedef struct {
 
 typedef uint32_t glyph_id_t;
 
+/** Coverage mask of a rendered glyph */
+typedef struct {
+	/* Coverage of the glyph pixels (0 to 255), row by row */
+	const uint8_t *data;
+
+	/* Distance between the beginnings of two rows */
+	size_t stride;
+
+	/* Size of the mask in pixels */
+	sysarg_t width;
+	sysarg_t height;
+} glyph_mask_t;
+
 typedef struct {
 	errno_t (*get_font_metrics)(void *, font_metrics_t *);
 	errno_t (*resolve_glyph)(void *, wchar_t, glyph_id_t *);
 	errno_t (*get_glyph_metrics)(void *, glyph_id_t, glyph_metrics_t *);
 	errno_t (*render_glyph)(void *, drawctx_t *, source_t *, sysarg_t,
 	    sysarg_t, glyph_id_t);
+	/* Optional, the mask stays valid until the next call */
+	errno_t (*get_glyph_mask)(void *, glyph_id_t, glyph_mask_t *);
 	void (*release)(void *);
 } font_backend_t;
 
@@ -113,6 +128,7 @@ extern errno_t font_resolve_glyph(font_t *, wchar_t, glyph_id_t *);
 extern errno_t font_get_glyph_metrics(font_t *, glyph_id_t, glyph_metrics_t *);
 extern errno_t font_render_glyph(font_t *, drawctx_t *, source_t *,
     sysarg_t, sysarg_t, glyph_id_t);
+extern errno_t font_get_glyph_mask(font_t *, glyph_id_t, glyph_mask_t *);
 extern void font_release(font_t *);
 
 extern errno_t font_get_box(font_t *, char *, sysarg_t *, sysarg_t *);
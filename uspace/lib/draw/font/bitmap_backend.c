@@ -35,18 +35,43 @@
  */
 
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "../font.h"
 #include "../drawctx.h"
 #include "bitmap_backend.h"
 
+/** Width of the glyph atlas in pixels */
+#define ATLAS_WIDTH  512
+
+/** Initial height of the glyph atlas in pixels */
+#define ATLAS_MIN_HEIGHT  64
+
+/** Number of entries in the character to glyph mapping cache */
+#define RESOLVE_CACHE_SIZE  256
+
 typedef struct {
 	surface_t *surface;
 	glyph_metrics_t metrics;
 	bool metrics_loaded;
+
+	/* Coverage of the glyph is stored in the atlas */
+	bool in_atlas;
+	sysarg_t atlas_x;
+	sysarg_t atlas_y;
+	sysarg_t atlas_width;
+	sysarg_t atlas_height;
 } glyph_cache_item_t;
 
+typedef struct {
+	bool valid;
+	wchar_t chr;
+	errno_t rc;
+	glyph_id_t glyph_id;
+} resolve_cache_item_t;
+
 typedef struct {
 	uint16_t points;
 	uint32_t glyph_count;
@@ -56,6 +81,19 @@ typedef struct {
 	void *decoder_data;
 	bool scale;
 	double scale_ratio;
+
+	/*
+	 * Coverage of rendered glyphs packed into rows of shelves. There is
+	 * one atlas per font instance, so it is keyed by the font and its size
+	 * implicitly and by the glyph ID explicitly.
+	 */
+	uint8_t *atlas;
+	sysarg_t atlas_height;
+	sysarg_t shelf_x;
+	sysarg_t shelf_y;
+	sysarg_t shelf_height;
+
+	resolve_cache_item_t resolve_cache[RESOLVE_CACHE_SIZE];
 } bitmap_backend_data_t;
 
 static errno_t bb_get_font_metrics(void *backend_data, font_metrics_t *font_metrics)
@@ -70,7 +108,28 @@ static errno_t bb_get_font_metrics(void *backend_data, font_metrics_t *font_metr
 static errno_t bb_resolve_glyph(void *backend_data, wchar_t c, glyph_id_t *glyph_id)
 {
 	bitmap_backend_data_t *data = (bitmap_backend_data_t *) backend_data;
-	return data->decoder->resolve_glyph(data->decoder_data, c, glyph_id);
+
+	/* Decoders may need to consult the font file, remember the result. */
+	resolve_cache_item_t *item =
+	    &data->resolve_cache[c % RESOLVE_CACHE_SIZE];
+	if (item->valid && item->chr == c) {
+		if (item->rc == EOK)
+			*glyph_id = item->glyph_id;
+		return item->rc;
+	}
+
+	glyph_id_t id = 0;
+	errno_t rc = data->decoder->resolve_glyph(data->decoder_data, c, &id);
+	if (rc == EOK || rc == ENOENT) {
+		item->valid = true;
+		item->chr = c;
+		item->rc = rc;
+		item->glyph_id = id;
+	}
+
+	if (rc == EOK)
+		*glyph_id = id;
+	return rc;
 }
 
 static errno_t bb_get_glyph_metrics(void *backend_data, glyph_id_t glyph_id,
@@ -134,6 +193,7 @@ static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_i
 	surface_get_resolution(raw_surface, &w, &h);
 
 	if (!data->scale) {
+		data->glyph_cache[glyph_id].surface = raw_surface;
 		*result = raw_surface;
 		return EOK;
 	}
@@ -170,6 +230,83 @@ static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_i
 	return EOK;
 }
 
+/** Store coverage of a glyph in the atlas. */
+static errno_t atlas_add(bitmap_backend_data_t *data, glyph_cache_item_t *item)
+{
+	sysarg_t width;
+	sysarg_t height;
+	surface_get_resolution(item->surface, &width, &height);
+
+	if (width > ATLAS_WIDTH)
+		return ENOTSUP;
+
+	/* Start a new shelf if the glyph does not fit into the current one. */
+	if (data->shelf_x + width > ATLAS_WIDTH) {
+		data->shelf_y += data->shelf_height;
+		data->shelf_x = 0;
+		data->shelf_height = 0;
+	}
+
+	if (data->shelf_y + height > data->atlas_height) {
+		sysarg_t new_height = max(data->atlas_height * 2,
+		    ATLAS_MIN_HEIGHT);
+		new_height = max(new_height, data->shelf_y + height);
+
+		uint8_t *atlas = realloc(data->atlas,
+		    new_height * ATLAS_WIDTH);
+		if (atlas == NULL)
+			return ENOMEM;
+
+		memset(atlas + data->atlas_height * ATLAS_WIDTH, 0,
+		    (new_height - data->atlas_height) * ATLAS_WIDTH);
+		data->atlas = atlas;
+		data->atlas_height = new_height;
+	}
+
+	pixelmap_t *pixmap = surface_pixmap_access(item->surface);
+	for (sysarg_t y = 0; y < height; ++y) {
+		uint8_t *dst = data->atlas + (data->shelf_y + y) * ATLAS_WIDTH +
+		    data->shelf_x;
+		pixel_t *src = pixelmap_pixel_at(pixmap, 0, y);
+		for (sysarg_t x = 0; x < width; ++x)
+			dst[x] = ALPHA(src[x]);
+	}
+
+	item->in_atlas = true;
+	item->atlas_x = data->shelf_x;
+	item->atlas_y = data->shelf_y;
+	item->atlas_width = width;
+	item->atlas_height = height;
+
+	data->shelf_x += width;
+	data->shelf_height = max(data->shelf_height, height);
+	return EOK;
+}
+
+static errno_t bb_get_glyph_mask(void *backend_data, glyph_id_t glyph_id,
+    glyph_mask_t *mask)
+{
+	bitmap_backend_data_t *data = (bitmap_backend_data_t *) backend_data;
+
+	surface_t *glyph_surface;
+	errno_t rc = get_glyph_surface(data, glyph_id, &glyph_surface);
+	if (rc != EOK)
+		return rc;
+
+	glyph_cache_item_t *item = &data->glyph_cache[glyph_id];
+	if (!item->in_atlas) {
+		rc = atlas_add(data, item);
+		if (rc != EOK)
+			return rc;
+	}
+
+	mask->data = data->atlas + item->atlas_y * ATLAS_WIDTH + item->atlas_x;
+	mask->stride = ATLAS_WIDTH;
+	mask->width = item->atlas_width;
+	mask->height = item->atlas_height;
+	return EOK;
+}
+
 static errno_t bb_render_glyph(void *backend_data, drawctx_t *context,
     source_t *source, sysarg_t ox, sysarg_t oy, glyph_id_t glyph_id)
 {
@@ -209,6 +346,7 @@ static void bb_release(void *backend_data)
 		}
 	}
 	free(data->glyph_cache);
+	free(data->atlas);
 
 	data->decoder->release(data->decoder_data);
 	free(data);
@@ -219,6 +357,7 @@ font_backend_t bitmap_backend = {
 	.resolve_glyph = bb_resolve_glyph,
 	.get_glyph_metrics = bb_get_glyph_metrics,
 	.render_glyph = bb_render_glyph,
+	.get_glyph_mask = bb_get_glyph_mask,
 	.release = bb_release
 };
 
@@ -264,8 +403,18 @@ errno_t bitmap_font_create(bitmap_font_decoder_t *decoder, void *decoder_data,
 	for (size_t i = 0; i < data->glyph_count; ++i) {
 		data->glyph_cache[i].surface = NULL;
 		data->glyph_cache[i].metrics_loaded = false;
+		data->glyph_cache[i].in_atlas = false;
 	}
 
+	data->atlas = NULL;
+	data->atlas_height = 0;
+	data->shelf_x = 0;
+	data->shelf_y = 0;
+	data->shelf_height = 0;
+
+	for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i)
+		data->resolve_cache[i].valid = false;
+
 	font_t *font = font_create(&bitmap_backend, data);
 	if (font == NULL) {
 		free(data->glyph_cache);
@@ -34,6 +34,7 @@
  */
 
 #include <assert.h>
+#include <mem.h>
 
 #include "source.h"
 
@@ -148,5 +149,54 @@ pixel_t source_determine_pixel(source_t *source, double x, double y)
 	}
 }
 
+/** Determine a row of source pixels.
+ *
+ * Equivalent to calling source_determine_pixel() for (x + i, y), but the
+ * texture is sampled by the span variant of the filter if there is one.
+ *
+ * @param source Source to sample.
+ * @param x Horizontal coordinate of the first pixel.
+ * @param y Vertical coordinate of the row.
+ * @param dst Buffer to store the pixels to.
+ * @param count Number of pixels.
+ */
+void source_determine_span(source_t *source, double x, double y,
+    pixel_t *dst, size_t count)
+{
+	filter_span_t filter_span = filter_get_span(source->filter);
+
+	if (source->mask || (source->texture && !filter_span)) {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = source_determine_pixel(source, x + i, y);
+		return;
+	}
+
+	if (!ALPHA(source->alpha)) {
+		memset(dst, 0, count * sizeof(pixel_t));
+		return;
+	}
+
+	if (source->texture) {
+		double dx = 1;
+		double dy = 0;
+		transform_apply_affine(&source->transform, &x, &y);
+		transform_apply_linear(&source->transform, &dx, &dy);
+		filter_span(surface_pixmap_access(source->texture), x, y, dx, dy,
+		    dst, count, source->texture_extend);
+	} else {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = source->color;
+	}
+
+	if (ALPHA(source->alpha) < 255) {
+		double ratio = ((double) ALPHA(source->alpha)) / 255.0;
+		for (size_t i = 0; i < count; i++) {
+			double res_a = ratio * ((double) ALPHA(dst[i]));
+			dst[i] = PIXEL((unsigned) res_a,
+			    RED(dst[i]), GREEN(dst[i]), BLUE(dst[i]));
+		}
+	}
+}
+
 /** @}
  */
@@ -42,9 +42,18 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RECEIVED_BATCH
 } nic_event_t;
 
+/** Alignment of frame records in a NIC_EV_RECEIVED_BATCH buffer.
+ *
+ * The buffer is a sequence of records, each consisting of the frame size
+ * as uint32_t in host byte order followed by the frame data. Each record
+ * is padded to a multiple of NIC_BATCH_ALIGN bytes.
+ */
+#define NIC_BATCH_ALIGN  sizeof(uint32_t)
+
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
@@ -1180,6 +1180,77 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 	}
 }
 
+/** Report a batch of directory entries.
+ *
+ * @param service_id Service ID of the device
+ * @param index      Index of the directory i-node
+ * @param pos        Position to start reading from
+ * @param cb         Callback invoked for each entry
+ * @param arg        Argument for the callback
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_cb_t cb, void *arg)
+{
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	ext4_inode_ref_t *inode_ref;
+	rc = ext4_filesystem_get_inode_ref(inst->filesystem, index, &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	ext4_superblock_t *sb = inst->filesystem->superblock;
+	if (!ext4_inode_is_type(sb, inode_ref->inode,
+	    EXT4_INODE_MODE_DIRECTORY)) {
+		rc = ENOTDIR;
+		goto out;
+	}
+
+	ext4_directory_iterator_t it;
+	rc = ext4_directory_iterator_init(&it, inode_ref, pos);
+	if (rc != EOK)
+		goto out;
+
+	/* The on-disk entry name is not null-terminated */
+	char name[EXT4_DIRECTORY_FILENAME_LEN + 1];
+
+	while (it.current != NULL) {
+		bool found = false;
+
+		/* Skip unused entries as well as . and .. */
+		if (it.current->inode != 0) {
+			uint16_t name_size =
+			    ext4_directory_entry_ll_get_name_length(sb,
+			    it.current);
+			if (!ext4_is_dots(it.current->name, name_size)) {
+				memcpy(name, it.current->name, name_size);
+				name[name_size] = 0;
+				found = true;
+			}
+		}
+
+		rc = ext4_directory_iterator_next(&it);
+		if (rc != EOK)
+			break;
+
+		if (found && !cb(arg, name, it.current_offset))
+			break;
+	}
+
+	errno_t rc2 = ext4_directory_iterator_fini(&it);
+	if (rc == EOK)
+		rc = rc2;
+
+out:
+	rc2 = ext4_filesystem_put_inode_ref(inode_ref);
+	return rc == EOK ? rc2 : rc;
+}
+
 /** Read data from file.
  *
  * @param call      IPC call
@@ -1493,6 +1564,7 @@ vfs_out_ops_t ext4_ops = {
 	.mounted = ext4_mounted,
 	.unmounted = ext4_unmounted,
 	.read = ext4_read,
+	.readdir = ext4_readdir,
 	.write = ext4_write,
 	.truncate = ext4_truncate,
 	.close = ext4_close,
@@ -35,6 +35,7 @@
  */
 
 #include "libfs.h"
+#include <align.h>
 #include <macros.h>
 #include <errno.h>
 #include <async.h>
@@ -43,6 +44,7 @@
 #include <dirent.h>
 #include <mem.h>
 #include <str.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <fibril_synch.h>
 #include <ipc/vfs.h>
@@ -63,6 +65,9 @@
 		return; \
 	} while (0)
 
+/** Upper bound on the size of a batch of directory entries. */
+#define LIBFS_READDIR_MAX  (64 * 1024)
+
 static fs_reg_t reg;
 
 static vfs_out_ops_t *vfs_out_ops = NULL;
@@ -75,6 +80,8 @@ static void libfs_lookup(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_stat(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_open_node(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_statfs(libfs_ops_t *, fs_handle_t, ipc_call_t *);
+static void libfs_stat_fill(libfs_ops_t *, fs_handle_t, service_id_t,
+    fs_node_t *, vfs_stat_t *);
 
 static void vfs_out_fsprobe(ipc_call_t *req)
 {
@@ -166,6 +173,136 @@ static void vfs_out_read(ipc_call_t *req)
 		async_answer_0(req, rc);
 }
 
+/** Batch of directory entries being assembled for VFS_OUT_READDIR. */
+typedef struct {
+	char *buf;
+	size_t size;
+	size_t used;
+	size_t count;
+	/** Directory position following the last entry in @c buf */
+	aoff64_t pos;
+	/** Set when an entry did not fit into @c buf */
+	bool full;
+} libfs_readdir_t;
+
+static bool libfs_readdir_entry(void *arg, const char *name, aoff64_t npos)
+{
+	libfs_readdir_t *rd = (libfs_readdir_t *) arg;
+	size_t name_size = str_size(name) + 1;
+	size_t reclen = ALIGN_UP(offsetof(vfs_dirent_t, name) + name_size,
+	    _Alignof(vfs_dirent_t));
+
+	if (rd->used + reclen > rd->size) {
+		rd->full = true;
+		return false;
+	}
+
+	vfs_dirent_t *d = (vfs_dirent_t *) (rd->buf + rd->used);
+	memset(d, 0, reclen);
+	d->reclen = reclen;
+	memcpy(d->name, name, name_size);
+
+	rd->used += reclen;
+	rd->count++;
+	rd->pos = npos;
+	return true;
+}
+
+/** Fill in attributes of the entries gathered in @a rd.
+ *
+ * This is done only after the file system has finished enumerating the
+ * directory so that looking up the entries cannot interfere with any state
+ * the enumeration holds. Entries that disappear in the meantime are left with
+ * zeroed attributes.
+ */
+static errno_t libfs_readdir_stat(service_id_t service_id, fs_index_t index,
+    libfs_readdir_t *rd)
+{
+	fs_node_t *parent;
+	errno_t rc = libfs_ops->node_get(&parent, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (parent == NULL)
+		return ENOENT;
+
+	size_t offs = 0;
+	for (size_t i = 0; i < rd->count; i++) {
+		vfs_dirent_t *d = (vfs_dirent_t *) (rd->buf + offs);
+		offs += d->reclen;
+
+		fs_node_t *fn;
+		rc = libfs_ops->match(&fn, parent, d->name);
+		if (rc != EOK)
+			break;
+		if (fn == NULL)
+			continue;
+
+		libfs_stat_fill(libfs_ops, reg.fs_handle, service_id, fn,
+		    &d->stat);
+		rc = libfs_ops->node_put(fn);
+		if (rc != EOK)
+			break;
+	}
+
+	errno_t rc2 = libfs_ops->node_put(parent);
+	return rc != EOK ? rc : rc2;
+}
+
+static void vfs_out_readdir(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t index = (fs_index_t) ipc_get_arg2(req);
+	aoff64_t pos = (aoff64_t) MERGE_LOUP32(ipc_get_arg3(req),
+	    ipc_get_arg4(req));
+	unsigned int flags = ipc_get_arg5(req);
+	errno_t rc;
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (vfs_out_ops->readdir == NULL) {
+		async_answer_0(&call, ENOTSUP);
+		async_answer_0(req, ENOTSUP);
+		return;
+	}
+
+	libfs_readdir_t rd;
+	rd.size = min(size, LIBFS_READDIR_MAX);
+	rd.buf = malloc(rd.size);
+	if (rd.buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(req, ENOMEM);
+		return;
+	}
+	rd.used = 0;
+	rd.count = 0;
+	rd.pos = pos;
+	rd.full = false;
+
+	rc = vfs_out_ops->readdir(service_id, index, pos, libfs_readdir_entry,
+	    &rd);
+	if (rc == EOK && rd.count == 0 && rd.full)
+		rc = EOVERFLOW;
+	if (rc == EOK && (flags & VFS_READDIR_STAT))
+		rc = libfs_readdir_stat(service_id, index, &rd);
+
+	if (rc != EOK) {
+		free(rd.buf);
+		async_answer_0(&call, rc);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	async_data_read_finalize(&call, rd.buf, rd.used);
+	free(rd.buf);
+	async_answer_3(req, EOK, LOWER32(rd.pos), UPPER32(rd.pos), rd.count);
+}
+
 static void vfs_out_write(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -185,6 +322,47 @@ static void vfs_out_write(ipc_call_t *req)
 		async_answer_0(req, rc);
 }
 
+static void vfs_out_copy_range(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t src = (fs_index_t) ipc_get_arg2(req);
+	fs_index_t dst = (fs_index_t) ipc_get_arg3(req);
+	vfs_copy_range_t range;
+	errno_t rc;
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_write_receive(&call, &size) ||
+	    size != sizeof(range)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	if (vfs_out_ops->copy_range == NULL) {
+		async_answer_0(&call, ENOTSUP);
+		async_answer_0(req, ENOTSUP);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, &range, sizeof(range));
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	aoff64_t copied;
+	aoff64_t nsize;
+	rc = vfs_out_ops->copy_range(service_id, src, range.src_pos, dst,
+	    range.dst_pos, range.size, &copied, &nsize);
+
+	if (rc == EOK) {
+		async_answer_4(req, EOK, LOWER32(copied), UPPER32(copied),
+		    LOWER32(nsize), UPPER32(nsize));
+	} else
+		async_answer_0(req, rc);
+}
+
 static void vfs_out_truncate(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -313,9 +491,15 @@ static void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_OUT_READ:
 			vfs_out_read(&call);
 			break;
+		case VFS_OUT_READDIR:
+			vfs_out_readdir(&call);
+			break;
 		case VFS_OUT_WRITE:
 			vfs_out_write(&call);
 			break;
+		case VFS_OUT_COPY_RANGE:
+			vfs_out_copy_range(&call);
+			break;
 		case VFS_OUT_TRUNCATE:
 			vfs_out_truncate(&call);
 			break;
@@ -713,6 +897,21 @@ out:
 		(void) ops->node_put(tmp);
 }
 
+static void libfs_stat_fill(libfs_ops_t *ops, fs_handle_t fs_handle,
+    service_id_t service_id, fs_node_t *fn, vfs_stat_t *stat)
+{
+	memset(stat, 0, sizeof(vfs_stat_t));
+
+	stat->fs_handle = fs_handle;
+	stat->service_id = service_id;
+	stat->index = ops->index_get(fn);
+	stat->lnkcnt = ops->lnkcnt_get(fn);
+	stat->is_file = ops->is_file(fn);
+	stat->is_directory = ops->is_directory(fn);
+	stat->size = ops->size_get(fn);
+	stat->service = ops->service_get(fn);
+}
+
 void libfs_stat(libfs_ops_t *ops, fs_handle_t fs_handle, ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -733,16 +932,7 @@ void libfs_stat(libfs_ops_t *ops, fs_handle_t fs_handle, ipc_call_t *req)
 	}
 
 	vfs_stat_t stat;
-	memset(&stat, 0, sizeof(vfs_stat_t));
-
-	stat.fs_handle = fs_handle;
-	stat.service_id = service_id;
-	stat.index = index;
-	stat.lnkcnt = ops->lnkcnt_get(fn);
-	stat.is_file = ops->is_file(fn);
-	stat.is_directory = ops->is_directory(fn);
-	stat.size = ops->size_get(fn);
-	stat.service = ops->service_get(fn);
+	libfs_stat_fill(ops, fs_handle, service_id, fn, &stat);
 
 	ops->node_put(fn);
 
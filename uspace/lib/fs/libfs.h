@@ -41,13 +41,37 @@
 #include <async.h>
 #include <loc.h>
 
+/** Callback invoked by vfs_out_ops_t::readdir for each directory entry.
+ *
+ * @param arg   Argument passed to the readdir operation
+ * @param name  Name of the entry
+ * @param npos  Directory position just past the entry
+ *
+ * @return      True to continue with the next entry, false to stop
+ */
+typedef bool (*libfs_readdir_cb_t)(void *, const char *, aoff64_t);
+
 typedef struct {
 	errno_t (*fsprobe)(service_id_t, vfs_fs_probe_info_t *);
 	errno_t (*mounted)(service_id_t, const char *, fs_index_t *, aoff64_t *);
 	errno_t (*unmounted)(service_id_t);
 	errno_t (*read)(service_id_t, fs_index_t, aoff64_t, size_t *);
+	/*
+	 * Optional. Report directory entries starting at the given position
+	 * until the callback returns false or there are no more entries.
+	 */
+	errno_t (*readdir)(service_id_t, fs_index_t, aoff64_t,
+	    libfs_readdir_cb_t, void *);
 	errno_t (*write)(service_id_t, fs_index_t, aoff64_t, size_t *,
 	    aoff64_t *);
+	/*
+	 * Optional. Copy a range of data from the first node to the second
+	 * one and return the number of bytes copied and the new size of the
+	 * second node. Less than requested is copied only at the end of the
+	 * first node.
+	 */
+	errno_t (*copy_range)(service_id_t, fs_index_t, aoff64_t, fs_index_t,
+	    aoff64_t, aoff64_t, aoff64_t *, aoff64_t *);
 	errno_t (*truncate)(service_id_t, fs_index_t, aoff64_t);
 	errno_t (*close)(service_id_t, fs_index_t);
 	errno_t (*destroy)(service_id_t, fs_index_t);
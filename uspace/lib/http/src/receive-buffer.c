@@ -148,6 +148,10 @@ errno_t recv_cut_str(receive_buffer_t *rb, receive_buffer_mark_t *a, receive_buf
 errno_t recv_char(receive_buffer_t *rb, char *c, bool consume)
 {
 	if (rb->out == rb->in) {
+		/* Nothing buffered and nothing marked, start from the beginning */
+		if (list_empty(&rb->marks))
+			rb->out = rb->in = 0;
+
 		size_t free = rb->size - rb->in;
 		if (free == 0) {
 			size_t min_mark = rb->size;
@@ -172,7 +176,11 @@ errno_t recv_char(receive_buffer_t *rb, char *c, bool consume)
 		if (rc != EOK)
 			return rc;
 
-		rb->in = nrecv;
+		/* The peer closed the connection */
+		if (nrecv == 0)
+			return EIO;
+
+		rb->in += nrecv;
 	}
 
 	*c = rb->buffer[rb->out];
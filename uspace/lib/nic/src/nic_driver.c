@@ -46,6 +46,9 @@
 #include <ddf/interrupt.h>
 #include <ops/nic.h>
 #include <errno.h>
+#include <align.h>
+#include <mem.h>
+#include <nic_iface.h>
 
 #include "nic_driver.h"
 #include "nic_ev.h"
@@ -53,6 +56,9 @@
 
 #define NIC_GLOBALS_MAX_CACHE_SIZE 16
 
+/** Maximum size of frame records passed to the client in one message */
+#define NIC_RX_BATCH_SIZE (64 * 1024)
+
 nic_globals_t nic_globals;
 
 /**
@@ -507,20 +513,14 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
-/**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+/** Check received frame against filters and update statistics.
  *
  * @param nic_data
  * @param frame		The received frame
+ * @return		@c true if the frame should be passed to the client
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_rx_accept(nic_t *nic_data, nic_frame_t *frame)
 {
-	/*
-	 * Note: this function must not lock main lock, because loopback driver
-	 * 		 calls it inside send_frame handler (with locked main lock)
-	 */
 	fibril_rwlock_read_lock(&nic_data->rxc_lock);
 	nic_frame_type_t frame_type;
 	bool check = nic_rxc_check(&nic_data->rx_control, frame->data,
@@ -543,45 +543,149 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+		return true;
+	}
+
+	switch (frame_type) {
+	case NIC_FRAME_UNICAST:
+		nic_data->stats.receive_filtered_unicast++;
+		break;
+	case NIC_FRAME_MULTICAST:
+		nic_data->stats.receive_filtered_multicast++;
+		break;
+	case NIC_FRAME_BROADCAST:
+		nic_data->stats.receive_filtered_broadcast++;
+		break;
+	}
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	return false;
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	/*
+	 * Note: this function must not lock main lock, because loopback driver
+	 * 		 calls it inside send_frame handler (with locked main lock)
+	 */
+	if (nic_rx_accept(nic_data, frame)) {
 		nic_ev_received(nic_data->client_session, frame->data,
 		    frame->size);
-	} else {
-		switch (frame_type) {
-		case NIC_FRAME_UNICAST:
-			nic_data->stats.receive_filtered_unicast++;
-			break;
-		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_filtered_multicast++;
-			break;
-		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_filtered_broadcast++;
-			break;
-		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
 	}
 	nic_release_frame(nic_data, frame);
 }
 
+/** Size of frame record in a batch buffer */
+static size_t nic_batch_record_size(nic_frame_t *frame)
+{
+	return ALIGN_UP(sizeof(uint32_t) + frame->size, NIC_BATCH_ALIGN);
+}
+
+/** Deliver frames to the client using a single batch message.
+ *
+ * Falls back to delivering frames one by one if the client does not
+ * understand batches or if the batch buffer cannot be allocated.
+ *
+ * @param nic_data
+ * @param frames	Frames to deliver, released by this function
+ * @param size		Total size of batch records of @a frames
+ */
+static void nic_deliver_batch(nic_t *nic_data, list_t *frames, size_t size)
+{
+	uint8_t *buf = NULL;
+	link_t *link;
+
+	if (!nic_data->rx_batch_unsupported && list_count(frames) > 1)
+		buf = malloc(size);
+
+	if (buf != NULL) {
+		size_t offs = 0;
+
+		list_foreach(*frames, link, nic_frame_t, frame) {
+			uint32_t fsize = frame->size;
+			memcpy(buf + offs, &fsize, sizeof(uint32_t));
+			memcpy(buf + offs + sizeof(uint32_t), frame->data,
+			    frame->size);
+			offs += nic_batch_record_size(frame);
+		}
+
+		errno_t rc = nic_ev_received_batch(nic_data->client_session,
+		    buf, size);
+		free(buf);
+
+		if (rc == ENOTSUP) {
+			/* Client does not support batches, do not try again */
+			nic_data->rx_batch_unsupported = true;
+		} else {
+			while ((link = list_first(frames)) != NULL) {
+				list_remove(link);
+				nic_release_frame(nic_data,
+				    list_get_instance(link, nic_frame_t, link));
+			}
+			return;
+		}
+	}
+
+	while ((link = list_first(frames)) != NULL) {
+		nic_frame_t *frame = list_get_instance(link, nic_frame_t, link);
+
+		list_remove(link);
+		nic_ev_received(nic_data->client_session, frame->data,
+		    frame->size);
+		nic_release_frame(nic_data, frame);
+	}
+}
+
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
  * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * the frames are checked by filters and passed to the client in as few
+ * messages as possible (see NIC_RX_BATCH_SIZE). The list is deallocated.
  *
  * @param nic_data
  * @param frames		List of received frames
  */
 void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
+	list_t batch;
+	size_t batch_size;
+
 	if (frames == NULL)
 		return;
+
+	list_initialize(&batch);
+	batch_size = 0;
+
 	while (!list_empty(frames)) {
 		nic_frame_t *frame =
 		    list_get_instance(list_first(frames), nic_frame_t, link);
 
 		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
+		if (!nic_rx_accept(nic_data, frame)) {
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		size_t rsize = nic_batch_record_size(frame);
+		if (batch_size > 0 && batch_size + rsize > NIC_RX_BATCH_SIZE) {
+			nic_deliver_batch(nic_data, &batch, batch_size);
+			batch_size = 0;
+		}
+
+		list_append(&frame->link, &batch);
+		batch_size += rsize;
 	}
+
+	if (batch_size > 0)
+		nic_deliver_batch(nic_data, &batch, batch_size);
+
 	nic_driver_release_frame_list(frames);
 }
 
@@ -609,6 +713,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->fun = NULL;
 	nic_data->state = NIC_STATE_STOPPED;
 	nic_data->client_session = NULL;
+	nic_data->rx_batch_unsupported = false;
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
@@ -203,6 +203,9 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 		return ENOMEM;
 	}
 
+	/* New client, find out again whether it supports batches */
+	nic->rx_batch_unsupported = false;
+
 	fibril_rwlock_write_unlock(&nic->main_lock);
 	return EOK;
 }
@@ -37,9 +37,14 @@
 #define PCM_FORMAT_H_
 
 #include <assert.h>
+#include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <pcm/sample_format.h>
 
+/** Maximal number of channels supported by the sample rate converter. */
+#define PCM_RESAMPLER_MAX_CHANNELS  8
+
 /** Linear PCM audio parameters */
 typedef struct {
 	unsigned channels;
@@ -47,6 +52,25 @@ typedef struct {
 	pcm_sample_format_t sample_format;
 } pcm_format_t;
 
+/** Sample rate converter state.
+ *
+ * Uses linear interpolation between neighbouring source frames. The state
+ * carries over between calls so that a stream split into buffers of
+ * arbitrary sizes is converted without discontinuities.
+ */
+typedef struct {
+	/** Source sampling rate */
+	unsigned src_rate;
+	/** Destination sampling rate */
+	unsigned dst_rate;
+	/** Source frames per destination frame (32.32 fixed point) */
+	uint64_t step;
+	/** Position of the next output frame relative to @c last */
+	uint64_t pos;
+	/** Last consumed source frame */
+	int32_t last[PCM_RESAMPLER_MAX_CHANNELS];
+} pcm_resampler_t;
+
 extern const pcm_format_t AUDIO_FORMAT_DEFAULT;
 extern const pcm_format_t AUDIO_FORMAT_ANY;
 
@@ -103,6 +127,12 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
 errno_t pcm_format_convert(pcm_format_t a, void *srca, size_t sizea,
     pcm_format_t b, void *srcb, size_t *sizeb);
 
+void pcm_resampler_init(pcm_resampler_t *r, unsigned src_rate,
+    unsigned dst_rate);
+errno_t pcm_resampler_mix(pcm_resampler_t *r, void *dst, size_t dst_size,
+    const pcm_format_t *df, const void *src, size_t src_size,
+    const pcm_format_t *sf, size_t *dst_used, size_t *src_used);
+
 #endif
 
 /**
@@ -34,24 +34,12 @@
  */
 
 #include <assert.h>
-#include <byteorder.h>
 #include <errno.h>
 #include <macros.h>
-#include <stdio.h>
-#include <inttypes.h>
-#include <limits.h>
+#include <mem.h>
 
 #include "format.h"
-
-// TODO float endian?
-#define float_le2host(x) (x)
-#define float_be2host(x) (x)
-
-#define host2float_le(x) (x)
-#define host2float_be(x) (x)
-
-#define from(x, type, endian) (float)(type ## _ ## endian ## 2host(x))
-#define to(x, type, endian) (float)(host2 ## type ## _ ## endian(x))
+#include "kernels.h"
 
 /** Default linear PCM format */
 const pcm_format_t AUDIO_FORMAT_DEFAULT = {
@@ -69,9 +57,6 @@ const pcm_format_t AUDIO_FORMAT_ANY = {
 	.sample_format = 0,
 };
 
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f);
-
 /**
  * Compare PCM format attribtues.
  * @param a Format description.
@@ -96,59 +81,28 @@ bool pcm_format_same(const pcm_format_t *a, const pcm_format_t *b)
  */
 void pcm_format_silence(void *dst, size_t size, const pcm_format_t *f)
 {
-#define SET_NULL(type, endian, nullv) \
-do { \
-	type *buffer = dst; \
-	const size_t sample_count = size / sizeof(type); \
-	for (unsigned i = 0; i < sample_count; ++i) { \
-		buffer[i] = to((type)nullv, type, endian); \
-	} \
-} while (0)
+	const size_t sample_size = pcm_sample_format_size(f->sample_format);
+	if (sample_size == 0)
+		return;
+
+	/* Zero is represented by all bits clear in signed formats. */
+	if (pcm_sample_format_is_signed(f->sample_format) ||
+	    f->sample_format == PCM_SAMPLE_FLOAT32) {
+		memset(dst, 0, size);
+		return;
+	}
 
-	switch (f->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		SET_NULL(uint8_t, le, INT8_MIN);
-		break;
-	case PCM_SAMPLE_SINT8:
-		SET_NULL(int8_t, le, 0);
-		break;
-	case PCM_SAMPLE_UINT16_LE:
-		SET_NULL(uint16_t, le, INT16_MIN);
-		break;
-	case PCM_SAMPLE_SINT16_LE:
-		SET_NULL(int16_t, le, 0);
-		break;
-	case PCM_SAMPLE_UINT16_BE:
-		SET_NULL(uint16_t, be, INT16_MIN);
-		break;
-	case PCM_SAMPLE_SINT16_BE:
-		SET_NULL(int16_t, be, 0);
-		break;
-	case PCM_SAMPLE_UINT32_LE:
-		SET_NULL(uint32_t, le, INT32_MIN);
-		break;
-	case PCM_SAMPLE_SINT32_LE:
-		SET_NULL(int32_t, le, 0);
-		break;
-	case PCM_SAMPLE_UINT32_BE:
-		SET_NULL(uint32_t, be, INT32_MIN);
-		break;
-	case PCM_SAMPLE_SINT32_BE:
-		SET_NULL(int32_t, le, 0);
-		break;
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
-		break;
+	uint8_t sample[sizeof(uint32_t)];
+	pcm_encode_sample(sample, f->sample_format, 0);
+
+	if (sample_size == 1) {
+		memset(dst, sample[0], size);
+		return;
 	}
-#undef SET_NULL
+
+	uint8_t *buffer = dst;
+	for (size_t pos = 0; pos + sample_size <= size; pos += sample_size)
+		memcpy(buffer + pos, sample, sample_size);
 }
 
 /**
@@ -176,6 +130,8 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
  *
  * Buffers must contain entire frames. Destination buffer is always filled.
  * If there are not enough data in the source buffer silent data is assumed.
+ * Sampling rates of the formats are not considered, use pcm_resampler_mix()
+ * if they differ.
  */
 errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
     size_t src_size, const pcm_format_t *sf, const pcm_format_t *df)
@@ -183,155 +139,61 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 	if (!dst || !src || !sf || !df)
 		return EINVAL;
 	const size_t src_frame_size = pcm_format_frame_size(sf);
-	if ((src_size % src_frame_size) != 0)
+	if (src_frame_size == 0 || (src_size % src_frame_size) != 0)
 		return EINVAL;
 
 	const size_t dst_frame_size = pcm_format_frame_size(df);
-	if ((dst_size % dst_frame_size) != 0)
+	if (dst_frame_size == 0 || (dst_size % dst_frame_size) != 0)
 		return EINVAL;
 
+	/* Missing source frames are silent, i.e. there is nothing to add. */
+	const size_t frames =
+	    min(dst_size / dst_frame_size, src_size / src_frame_size);
+
+	if (sf->sample_format == df->sample_format &&
+	    sf->channels == df->channels &&
+	    pcm_mix_same(dst, src, df->sample_format, frames * df->channels))
+		return EOK;
+
+	const size_t src_sample_size = src_frame_size / sf->channels;
+	const size_t dst_sample_size = dst_frame_size / df->channels;
+	int32_t block[PCM_BLOCK_SAMPLES];
+
+	if (sf->channels == df->channels) {
+		const size_t count = frames * df->channels;
+		for (size_t done = 0; done < count; done += PCM_BLOCK_SAMPLES) {
+			const size_t n = min(count - done, PCM_BLOCK_SAMPLES);
+			pcm_decode_samples(src + done * src_sample_size,
+			    sf->sample_format, block, n);
+			pcm_mix_samples(dst + done * dst_sample_size,
+			    df->sample_format, block, n);
+		}
+		return EOK;
+	}
+
 	/*
-	 * This is so ugly it eats kittens, and puppies, and ducklings,
-	 * and all little fluffy things...
+	 * Extra source channels are dropped, channels missing in the source
+	 * are silent.
 	 */
-#define LOOP_ADD(type, endian, low, high) \
-do { \
-	const unsigned frame_count = dst_size / dst_frame_size; \
-	for (size_t i = 0; i < frame_count; ++i) { \
-		for (unsigned j = 0; j < df->channels; ++j) { \
-			const float a = \
-			    get_normalized_sample(dst, dst_size, i, j, df);\
-			const float b = \
-			    get_normalized_sample(src, src_size, i, j, sf);\
-			float c = (a + b); \
-			if (c < -1.0) c = -1.0; \
-			if (c > 1.0) c = 1.0; \
-			c += 1.0; \
-			c *= ((float)(type)high - (float)(type)low) / 2; \
-			c += (float)(type)low; \
-			type *dst_buf = dst; \
-			const unsigned pos = i * df->channels  + j; \
-			if (pos < (dst_size / sizeof(type))) \
-				dst_buf[pos] = to((type)c, type, endian); \
-		} \
-	} \
-} while (0)
-
-	switch (df->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		LOOP_ADD(uint8_t, le, UINT8_MIN, UINT8_MAX);
-		break;
-	case PCM_SAMPLE_SINT8:
-		LOOP_ADD(uint8_t, le, INT8_MIN, INT8_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_LE:
-		LOOP_ADD(uint16_t, le, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_LE:
-		LOOP_ADD(int16_t, le, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_BE:
-		LOOP_ADD(uint16_t, be, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_BE:
-		LOOP_ADD(int16_t, be, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE: // TODO this are not right for 24bit
-		LOOP_ADD(uint32_t, le, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		LOOP_ADD(int32_t, le, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		LOOP_ADD(uint32_t, be, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		LOOP_ADD(int32_t, be, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
+	const size_t block_frames = PCM_BLOCK_SAMPLES / df->channels;
+	const unsigned channels = min(sf->channels, df->channels);
+	if (block_frames == 0)
 		return ENOTSUP;
+
+	for (size_t done = 0; done < frames; done += block_frames) {
+		const size_t n = min(frames - done, block_frames);
+		memset(block, 0, sizeof(block));
+		for (size_t i = 0; i < n; ++i) {
+			pcm_decode_samples(src + (done + i) * src_frame_size,
+			    sf->sample_format, block + i * df->channels,
+			    channels);
+		}
+		pcm_mix_samples(dst + done * dst_frame_size, df->sample_format,
+		    block, n * df->channels);
 	}
 	return EOK;
-#undef LOOP_ADD
 }
 
-/**
- * Converts all sample formats to float <-1,1>
- * @param buffer Audio data
- * @param size Size of the buffer
- * @param frame Index of the frame to read
- * @param channel Channel within the frame
- * @param f Pointer to a format descriptor
- * @return Normalized sample <-1,1>, 0.0 if the data could not be read
- */
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f)
-{
-	assert(f);
-	assert(buffer);
-	if (channel >= f->channels)
-		return 0.0f;
-#define GET(type, endian, low, high) \
-do { \
-	const type *src = buffer; \
-	const size_t sample_count = size / sizeof(type); \
-	const size_t sample_pos = frame * f->channels + channel; \
-	if (sample_pos >= sample_count) {\
-		return 0.0f; \
-	} \
-	float sample = from(src[sample_pos], type, endian); \
-	/* This makes it positive */ \
-	sample -= (float)(type)low; \
-	/* This makes it <0,2> */ \
-	sample /= (((float)(type)high - (float)(type)low) / 2.0f); \
-	return sample - 1.0f; \
-} while (0)
-
-	switch (f->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		GET(uint8_t, le, UINT8_MIN, UINT8_MAX);
-	case PCM_SAMPLE_SINT8:
-		GET(int8_t, le, INT8_MIN, INT8_MAX);
-	case PCM_SAMPLE_UINT16_LE:
-		GET(uint16_t, le, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_LE:
-		GET(int16_t, le, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT16_BE:
-		GET(uint16_t, be, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_BE:
-		GET(int16_t, be, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE:
-		GET(uint32_t, le, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		GET(uint32_t, be, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
-		break;
-	}
-	return 0;
-#undef GET
-}
 /**
  * @}
  */
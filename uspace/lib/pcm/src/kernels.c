@@ -0,0 +1,550 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @{
+ */
+/** @file
+ * PCM sample conversion and mixing kernels.
+ *
+ * The format is dispatched once per buffer and every format has its own
+ * straight loop, which the compiler is able to vectorize. Saturating
+ * addition of 8 and 16-bit samples uses SSE2 explicitly on amd64, where
+ * it is always available.
+ */
+
+#include <byteorder.h>
+#include <limits.h>
+#include <mem.h>
+
+#include "kernels.h"
+
+#ifdef __BE__
+#define PCM_SAMPLE_SINT16_NATIVE  PCM_SAMPLE_SINT16_BE
+#else
+#define PCM_SAMPLE_SINT16_NATIVE  PCM_SAMPLE_SINT16_LE
+#endif
+
+/** Saturate 64-bit value to the range of int32_t. */
+static inline int32_t sat32(int64_t val)
+{
+	if (val > INT32_MAX)
+		return INT32_MAX;
+	if (val < INT32_MIN)
+		return INT32_MIN;
+	return val;
+}
+
+/*
+ * Conversions of a single sample to and from the signed 32-bit
+ * representation. Unsigned formats differ only in the inverted sign bit.
+ */
+
+static inline int32_t dec_u8(uint8_t val)
+{
+	return (int32_t) ((uint32_t) (val ^ 0x80) << 24);
+}
+
+static inline uint8_t enc_u8(int32_t val)
+{
+	return ((uint32_t) val >> 24) ^ 0x80;
+}
+
+static inline int32_t dec_s8(uint8_t val)
+{
+	return (int32_t) ((uint32_t) val << 24);
+}
+
+static inline uint8_t enc_s8(int32_t val)
+{
+	return (uint32_t) val >> 24;
+}
+
+static inline int32_t dec_s16(uint16_t val)
+{
+	return (int32_t) ((uint32_t) val << 16);
+}
+
+static inline uint16_t enc_s16(int32_t val)
+{
+	return (uint32_t) val >> 16;
+}
+
+static inline int32_t dec_s24_32(uint32_t val)
+{
+	return (int32_t) ((val & 0xffffff) << 8);
+}
+
+static inline uint32_t enc_s24_32(int32_t val)
+{
+	/* Keep the value sign-extended to the whole container. */
+	return (uint32_t) (val >> 8);
+}
+
+static inline int32_t dec_u24_32(uint32_t val)
+{
+	return dec_s24_32(val ^ 0x800000);
+}
+
+static inline uint32_t enc_u24_32(int32_t val)
+{
+	return ((uint32_t) val >> 8) ^ 0x800000;
+}
+
+static inline int32_t dec_s24le(const uint8_t *p)
+{
+	return (int32_t) (((uint32_t) p[0] << 8) | ((uint32_t) p[1] << 16) |
+	    ((uint32_t) p[2] << 24));
+}
+
+static inline void enc_s24le(uint8_t *p, int32_t val)
+{
+	p[0] = (uint32_t) val >> 8;
+	p[1] = (uint32_t) val >> 16;
+	p[2] = (uint32_t) val >> 24;
+}
+
+static inline int32_t dec_s24be(const uint8_t *p)
+{
+	return (int32_t) (((uint32_t) p[2] << 8) | ((uint32_t) p[1] << 16) |
+	    ((uint32_t) p[0] << 24));
+}
+
+static inline void enc_s24be(uint8_t *p, int32_t val)
+{
+	p[2] = (uint32_t) val >> 8;
+	p[1] = (uint32_t) val >> 16;
+	p[0] = (uint32_t) val >> 24;
+}
+
+static inline int32_t dec_float(float val)
+{
+	if (val >= 1.0f)
+		return INT32_MAX;
+	if (val <= -1.0f)
+		return INT32_MIN;
+	return val * 2147483648.0f;
+}
+
+static inline float enc_float(int32_t val)
+{
+	return val / 2147483648.0f;
+}
+
+#define SIGN32  0x80000000U
+
+/** Generate decoding loop for formats stored in a whole type. */
+#define DECODE_LOOP(type, expr) \
+do { \
+	const type *s = src; \
+	for (size_t i = 0; i < count; i++) { \
+		const type raw = s[i]; \
+		dst[i] = (expr); \
+	} \
+} while (0)
+
+/** Generate decoding loop for packed 24-bit formats. */
+#define DECODE_LOOP_24(dec, sign) \
+do { \
+	const uint8_t *s = src; \
+	for (size_t i = 0; i < count; i++) \
+		dst[i] = dec(s + 3 * i) ^ (sign); \
+} while (0)
+
+/**
+ * Convert samples to signed 32-bit representation.
+ * @param src Source samples.
+ * @param format Format of the source samples.
+ * @param dst Destination buffer.
+ * @param count Number of samples to convert.
+ */
+void pcm_decode_samples(const void *src, pcm_sample_format_t format,
+    int32_t *dst, size_t count)
+{
+	switch (format) {
+	case PCM_SAMPLE_UINT8:
+		DECODE_LOOP(uint8_t, dec_u8(raw));
+		break;
+	case PCM_SAMPLE_SINT8:
+		DECODE_LOOP(uint8_t, dec_s8(raw));
+		break;
+	case PCM_SAMPLE_UINT16_LE:
+		DECODE_LOOP(uint16_t, dec_s16(uint16_t_le2host(raw) ^ 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_LE:
+		DECODE_LOOP(uint16_t, dec_s16(uint16_t_le2host(raw)));
+		break;
+	case PCM_SAMPLE_UINT16_BE:
+		DECODE_LOOP(uint16_t, dec_s16(uint16_t_be2host(raw) ^ 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_BE:
+		DECODE_LOOP(uint16_t, dec_s16(uint16_t_be2host(raw)));
+		break;
+	case PCM_SAMPLE_UINT24_LE:
+		DECODE_LOOP_24(dec_s24le, (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_LE:
+		DECODE_LOOP_24(dec_s24le, 0);
+		break;
+	case PCM_SAMPLE_UINT24_BE:
+		DECODE_LOOP_24(dec_s24be, (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_BE:
+		DECODE_LOOP_24(dec_s24be, 0);
+		break;
+	case PCM_SAMPLE_UINT24_32_LE:
+		DECODE_LOOP(uint32_t, dec_u24_32(uint32_t_le2host(raw)));
+		break;
+	case PCM_SAMPLE_SINT24_32_LE:
+		DECODE_LOOP(uint32_t, dec_s24_32(uint32_t_le2host(raw)));
+		break;
+	case PCM_SAMPLE_UINT24_32_BE:
+		DECODE_LOOP(uint32_t, dec_u24_32(uint32_t_be2host(raw)));
+		break;
+	case PCM_SAMPLE_SINT24_32_BE:
+		DECODE_LOOP(uint32_t, dec_s24_32(uint32_t_be2host(raw)));
+		break;
+	case PCM_SAMPLE_UINT32_LE:
+		DECODE_LOOP(uint32_t, (int32_t) (uint32_t_le2host(raw) ^ SIGN32));
+		break;
+	case PCM_SAMPLE_SINT32_LE:
+		DECODE_LOOP(uint32_t, (int32_t) uint32_t_le2host(raw));
+		break;
+	case PCM_SAMPLE_UINT32_BE:
+		DECODE_LOOP(uint32_t, (int32_t) (uint32_t_be2host(raw) ^ SIGN32));
+		break;
+	case PCM_SAMPLE_SINT32_BE:
+		DECODE_LOOP(uint32_t, (int32_t) uint32_t_be2host(raw));
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		DECODE_LOOP(float, dec_float(raw));
+		break;
+	default:
+		memset(dst, 0, count * sizeof(int32_t));
+		break;
+	}
+}
+
+/** Generate mixing loop for formats stored in a whole type. */
+#define MIX_LOOP(type, dec, enc) \
+do { \
+	type *d = dst; \
+	for (size_t i = 0; i < count; i++) { \
+		const type raw = d[i]; \
+		const int32_t val = sat32((int64_t) (dec) + src[i]); \
+		d[i] = (enc); \
+	} \
+} while (0)
+
+/** Generate mixing loop for packed 24-bit formats. */
+#define MIX_LOOP_24(dec, enc, sign) \
+do { \
+	uint8_t *d = dst; \
+	for (size_t i = 0; i < count; i++) { \
+		const int32_t val = \
+		    sat32((int64_t) (dec(d + 3 * i) ^ (sign)) + src[i]); \
+		enc(d + 3 * i, val ^ (sign)); \
+	} \
+} while (0)
+
+/**
+ * Add signed 32-bit samples to a buffer, saturating the result.
+ * @param dst Destination buffer.
+ * @param format Format of the destination buffer.
+ * @param src Samples to add.
+ * @param count Number of samples.
+ */
+void pcm_mix_samples(void *dst, pcm_sample_format_t format,
+    const int32_t *src, size_t count)
+{
+	switch (format) {
+	case PCM_SAMPLE_UINT8:
+		MIX_LOOP(uint8_t, dec_u8(raw), enc_u8(val));
+		break;
+	case PCM_SAMPLE_SINT8:
+		MIX_LOOP(uint8_t, dec_s8(raw), enc_s8(val));
+		break;
+	case PCM_SAMPLE_UINT16_LE:
+		MIX_LOOP(uint16_t, dec_s16(uint16_t_le2host(raw) ^ 0x8000),
+		    host2uint16_t_le(enc_s16(val) ^ 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_LE:
+		MIX_LOOP(uint16_t, dec_s16(uint16_t_le2host(raw)),
+		    host2uint16_t_le(enc_s16(val)));
+		break;
+	case PCM_SAMPLE_UINT16_BE:
+		MIX_LOOP(uint16_t, dec_s16(uint16_t_be2host(raw) ^ 0x8000),
+		    host2uint16_t_be(enc_s16(val) ^ 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_BE:
+		MIX_LOOP(uint16_t, dec_s16(uint16_t_be2host(raw)),
+		    host2uint16_t_be(enc_s16(val)));
+		break;
+	case PCM_SAMPLE_UINT24_LE:
+		MIX_LOOP_24(dec_s24le, enc_s24le, (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_LE:
+		MIX_LOOP_24(dec_s24le, enc_s24le, 0);
+		break;
+	case PCM_SAMPLE_UINT24_BE:
+		MIX_LOOP_24(dec_s24be, enc_s24be, (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_BE:
+		MIX_LOOP_24(dec_s24be, enc_s24be, 0);
+		break;
+	case PCM_SAMPLE_UINT24_32_LE:
+		MIX_LOOP(uint32_t, dec_u24_32(uint32_t_le2host(raw)),
+		    host2uint32_t_le(enc_u24_32(val)));
+		break;
+	case PCM_SAMPLE_SINT24_32_LE:
+		MIX_LOOP(uint32_t, dec_s24_32(uint32_t_le2host(raw)),
+		    host2uint32_t_le(enc_s24_32(val)));
+		break;
+	case PCM_SAMPLE_UINT24_32_BE:
+		MIX_LOOP(uint32_t, dec_u24_32(uint32_t_be2host(raw)),
+		    host2uint32_t_be(enc_u24_32(val)));
+		break;
+	case PCM_SAMPLE_SINT24_32_BE:
+		MIX_LOOP(uint32_t, dec_s24_32(uint32_t_be2host(raw)),
+		    host2uint32_t_be(enc_s24_32(val)));
+		break;
+	case PCM_SAMPLE_UINT32_LE:
+		MIX_LOOP(uint32_t, (int32_t) (uint32_t_le2host(raw) ^ SIGN32),
+		    host2uint32_t_le((uint32_t) val ^ SIGN32));
+		break;
+	case PCM_SAMPLE_SINT32_LE:
+		MIX_LOOP(uint32_t, (int32_t) uint32_t_le2host(raw),
+		    host2uint32_t_le((uint32_t) val));
+		break;
+	case PCM_SAMPLE_UINT32_BE:
+		MIX_LOOP(uint32_t, (int32_t) (uint32_t_be2host(raw) ^ SIGN32),
+		    host2uint32_t_be((uint32_t) val ^ SIGN32));
+		break;
+	case PCM_SAMPLE_SINT32_BE:
+		MIX_LOOP(uint32_t, (int32_t) uint32_t_be2host(raw),
+		    host2uint32_t_be((uint32_t) val));
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		MIX_LOOP(float, dec_float(raw), enc_float(val));
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Store one sample in the given format.
+ * @param dst Destination of the sample.
+ * @param format Format of the destination.
+ * @param val Sample value in signed 32-bit representation.
+ */
+void pcm_encode_sample(void *dst, pcm_sample_format_t format, int32_t val)
+{
+	uint8_t *b = dst;
+	uint16_t v16;
+	uint32_t v32;
+	float f;
+
+	switch (format) {
+	case PCM_SAMPLE_UINT8:
+		*b = enc_u8(val);
+		break;
+	case PCM_SAMPLE_SINT8:
+		*b = enc_s8(val);
+		break;
+	case PCM_SAMPLE_UINT16_LE:
+		v16 = host2uint16_t_le(enc_s16(val) ^ 0x8000);
+		memcpy(dst, &v16, sizeof(v16));
+		break;
+	case PCM_SAMPLE_SINT16_LE:
+		v16 = host2uint16_t_le(enc_s16(val));
+		memcpy(dst, &v16, sizeof(v16));
+		break;
+	case PCM_SAMPLE_UINT16_BE:
+		v16 = host2uint16_t_be(enc_s16(val) ^ 0x8000);
+		memcpy(dst, &v16, sizeof(v16));
+		break;
+	case PCM_SAMPLE_SINT16_BE:
+		v16 = host2uint16_t_be(enc_s16(val));
+		memcpy(dst, &v16, sizeof(v16));
+		break;
+	case PCM_SAMPLE_UINT24_LE:
+		enc_s24le(b, val ^ (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_LE:
+		enc_s24le(b, val);
+		break;
+	case PCM_SAMPLE_UINT24_BE:
+		enc_s24be(b, val ^ (int32_t) SIGN32);
+		break;
+	case PCM_SAMPLE_SINT24_BE:
+		enc_s24be(b, val);
+		break;
+	case PCM_SAMPLE_UINT24_32_LE:
+		v32 = host2uint32_t_le(enc_u24_32(val));
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_SINT24_32_LE:
+		v32 = host2uint32_t_le(enc_s24_32(val));
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_UINT24_32_BE:
+		v32 = host2uint32_t_be(enc_u24_32(val));
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_SINT24_32_BE:
+		v32 = host2uint32_t_be(enc_s24_32(val));
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_UINT32_LE:
+		v32 = host2uint32_t_le((uint32_t) val ^ SIGN32);
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_SINT32_LE:
+		v32 = host2uint32_t_le((uint32_t) val);
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_UINT32_BE:
+		v32 = host2uint32_t_be((uint32_t) val ^ SIGN32);
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_SINT32_BE:
+		v32 = host2uint32_t_be((uint32_t) val);
+		memcpy(dst, &v32, sizeof(v32));
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		f = enc_float(val);
+		memcpy(dst, &f, sizeof(f));
+		break;
+	default:
+		break;
+	}
+}
+
+#ifdef __x86_64__
+
+typedef int16_t v8i16_t __attribute__((vector_size(16)));
+typedef int8_t v16i8_t __attribute__((vector_size(16)));
+
+static inline v8i16_t paddsw(v8i16_t a, v8i16_t b)
+{
+	asm ("paddsw %1, %0\n" : "+x" (a) : "x" (b));
+	return a;
+}
+
+static inline v16i8_t paddsb(v16i8_t a, v16i8_t b)
+{
+	asm ("paddsb %1, %0\n" : "+x" (a) : "x" (b));
+	return a;
+}
+
+#endif
+
+/** Saturating addition of native-endian signed 16-bit samples. */
+static void mix_s16(int16_t *dst, const int16_t *src, size_t count)
+{
+	size_t i = 0;
+
+#ifdef __x86_64__
+	for (; i + 8 <= count; i += 8) {
+		v8i16_t a, b;
+		memcpy(&a, dst + i, sizeof(a));
+		memcpy(&b, src + i, sizeof(b));
+		a = paddsw(a, b);
+		memcpy(dst + i, &a, sizeof(a));
+	}
+#endif
+
+	for (; i < count; i++) {
+		const int32_t val = (int32_t) dst[i] + src[i];
+		dst[i] = (val > INT16_MAX) ? INT16_MAX :
+		    ((val < INT16_MIN) ? INT16_MIN : val);
+	}
+}
+
+/** Saturating addition of signed 8-bit samples. */
+static void mix_s8(int8_t *dst, const int8_t *src, size_t count)
+{
+	size_t i = 0;
+
+#ifdef __x86_64__
+	for (; i + 16 <= count; i += 16) {
+		v16i8_t a, b;
+		memcpy(&a, dst + i, sizeof(a));
+		memcpy(&b, src + i, sizeof(b));
+		a = paddsb(a, b);
+		memcpy(dst + i, &a, sizeof(a));
+	}
+#endif
+
+	for (; i < count; i++) {
+		const int val = dst[i] + src[i];
+		dst[i] = (val > INT8_MAX) ? INT8_MAX :
+		    ((val < INT8_MIN) ? INT8_MIN : val);
+	}
+}
+
+/** Saturating addition of unsigned 8-bit samples (bias 128). */
+static void mix_u8(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		const int val = (int) dst[i] + src[i] - 128;
+		dst[i] = (val > UINT8_MAX) ? UINT8_MAX : ((val < 0) ? 0 : val);
+	}
+}
+
+/**
+ * Mix samples of the same format without conversion.
+ * @param dst Destination buffer.
+ * @param src Source buffer.
+ * @param format Format of both buffers.
+ * @param count Number of samples.
+ * @return True if there is a specialized kernel for the format and
+ * the samples were mixed, false otherwise.
+ */
+bool pcm_mix_same(void *dst, const void *src, pcm_sample_format_t format,
+    size_t count)
+{
+	switch (format) {
+	case PCM_SAMPLE_SINT16_NATIVE:
+		mix_s16(dst, src, count);
+		return true;
+	case PCM_SAMPLE_SINT8:
+		mix_s8(dst, src, count);
+		return true;
+	case PCM_SAMPLE_UINT8:
+		mix_u8(dst, src, count);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @{
+ */
+/** @file
+ * PCM sample conversion and mixing kernels.
+ *
+ * All sample formats are converted to and from signed 32-bit samples
+ * that use the full range of the type. Mixing of a format with itself
+ * is done directly with saturating integer arithmetic.
+ */
+
+#ifndef PCM_KERNELS_H_
+#define PCM_KERNELS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pcm/sample_format.h>
+
+/** Number of samples converted at once by the generic kernels. */
+#define PCM_BLOCK_SAMPLES  256
+
+extern void pcm_decode_samples(const void *, pcm_sample_format_t, int32_t *,
+    size_t);
+extern void pcm_mix_samples(void *, pcm_sample_format_t, const int32_t *,
+    size_t);
+extern void pcm_encode_sample(void *, pcm_sample_format_t, int32_t);
+extern bool pcm_mix_same(void *, const void *, pcm_sample_format_t, size_t);
+
+#endif
+
+/**
+ * @}
+ */
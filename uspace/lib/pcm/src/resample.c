@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @{
+ */
+/** @file
+ * Sample rate conversion.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+
+#include "format.h"
+#include "kernels.h"
+
+/** One in 32.32 fixed point. */
+#define POS_ONE  ((uint64_t) 1 << 32)
+
+/**
+ * Initialize sample rate converter.
+ * @param r Converter state.
+ * @param src_rate Source sampling rate.
+ * @param dst_rate Destination sampling rate.
+ *
+ * The first destination frame corresponds to the first source frame.
+ */
+void pcm_resampler_init(pcm_resampler_t *r, unsigned src_rate,
+    unsigned dst_rate)
+{
+	assert(r);
+	r->src_rate = src_rate;
+	r->dst_rate = dst_rate;
+	r->step = dst_rate ? ((uint64_t) src_rate << 32) / dst_rate : 0;
+	r->pos = POS_ONE;
+	memset(r->last, 0, sizeof(r->last));
+}
+
+/**
+ * Convert sampling rate and add the result to the destination buffer.
+ * @param r Converter state initialized for the rates of both formats.
+ * @param dst Destination audio buffer.
+ * @param dst_size Size of the destination buffer.
+ * @param df Destination format.
+ * @param src Source audio buffer.
+ * @param src_size Size of the source buffer.
+ * @param sf Source format.
+ * @param[out] dst_used Size of the destination buffer filled.
+ * @param[out] src_used Size of the source buffer consumed.
+ * @return Error code.
+ *
+ * Conversion stops when either the destination is full or all source
+ * frames are consumed. Channels are matched the same way as in
+ * pcm_format_convert_and_mix().
+ */
+errno_t pcm_resampler_mix(pcm_resampler_t *r, void *dst, size_t dst_size,
+    const pcm_format_t *df, const void *src, size_t src_size,
+    const pcm_format_t *sf, size_t *dst_used, size_t *src_used)
+{
+	if (!r || !dst || !src || !sf || !df || !dst_used || !src_used)
+		return EINVAL;
+	if (r->step == 0)
+		return EINVAL;
+	if (sf->channels > PCM_RESAMPLER_MAX_CHANNELS ||
+	    df->channels > PCM_RESAMPLER_MAX_CHANNELS)
+		return ENOTSUP;
+
+	const size_t src_frame_size = pcm_format_frame_size(sf);
+	const size_t dst_frame_size = pcm_format_frame_size(df);
+	if (src_frame_size == 0 || dst_frame_size == 0)
+		return EINVAL;
+
+	const size_t src_frames = src_size / src_frame_size;
+	const size_t dst_frames = dst_size / dst_frame_size;
+	const unsigned channels = min(sf->channels, df->channels);
+
+	/* Source frames decoded in advance. */
+	int32_t in[PCM_BLOCK_SAMPLES];
+	const size_t in_block = PCM_BLOCK_SAMPLES / sf->channels;
+	size_t in_start = 0;
+	size_t in_count = 0;
+
+	/* Converted frames waiting to be mixed into the destination. */
+	int32_t out[PCM_BLOCK_SAMPLES];
+	const size_t out_block = PCM_BLOCK_SAMPLES / df->channels;
+	size_t out_count = 0;
+
+	size_t si = 0;
+	size_t di = 0;
+
+	memset(out, 0, sizeof(out));
+
+	while (di < dst_frames) {
+		/* Refill the decoded source frames if needed. */
+		if (si >= in_start + in_count) {
+			if (si >= src_frames)
+				break;
+			in_start = si;
+			in_count = min(src_frames - si, in_block);
+			pcm_decode_samples(src + si * src_frame_size,
+			    sf->sample_format, in, in_count * sf->channels);
+		}
+
+		const int32_t *next = in + (si - in_start) * sf->channels;
+
+		/* Consume source frames the output position has passed. */
+		if (r->pos >= POS_ONE) {
+			memcpy(r->last, next, sf->channels * sizeof(int32_t));
+			r->pos -= POS_ONE;
+			++si;
+			continue;
+		}
+
+		const int64_t frac = r->pos >> 16;
+		int32_t *o = out + out_count * df->channels;
+		for (unsigned c = 0; c < channels; ++c) {
+			o[c] = r->last[c] +
+			    ((((int64_t) next[c] - r->last[c]) * frac) >> 16);
+		}
+
+		r->pos += r->step;
+		++di;
+
+		if (++out_count == out_block) {
+			pcm_mix_samples(dst + (di - out_count) * dst_frame_size,
+			    df->sample_format, out, out_count * df->channels);
+			out_count = 0;
+		}
+	}
+
+	if (out_count > 0) {
+		pcm_mix_samples(dst + (di - out_count) * dst_frame_size,
+		    df->sample_format, out, out_count * df->channels);
+	}
+
+	*dst_used = di * dst_frame_size;
+	*src_used = si * src_frame_size;
+	return EOK;
+}
+
+/**
+ * @}
+ */
@@ -332,7 +332,7 @@ void funlockfile(FILE *file)
  */
 int getc_unlocked(FILE *stream)
 {
-	return getc(stream);
+	return fgetc_unlocked(stream);
 }
 
 /**
@@ -342,7 +342,7 @@ int getc_unlocked(FILE *stream)
  */
 int getchar_unlocked(void)
 {
-	return getchar();
+	return fgetc_unlocked(stdin);
 }
 
 /**
@@ -354,7 +354,7 @@ int getchar_unlocked(void)
  */
 int putc_unlocked(int c, FILE *stream)
 {
-	return putc(c, stream);
+	return fputc_unlocked(c, stream);
 }
 
 /**
@@ -365,7 +365,7 @@ int putc_unlocked(int c, FILE *stream)
  */
 int putchar_unlocked(int c)
 {
-	return putchar(c);
+	return fputc_unlocked(c, stdout);
 }
 
 /** Determine if directory is an 'appropriate' temporary directory.
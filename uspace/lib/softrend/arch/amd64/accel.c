@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup softrend
+ * @{
+ */
+/**
+ * @file
+ *
+ * SSE2 and AVX2 implementation of the accelerated span kernels.
+ *
+ * SSE2 is part of the amd64 baseline and is always used. The AVX2 variant
+ * is compiled for that instruction set using a function attribute only and
+ * is selected at runtime if CPUID reports it and the OS saves the YMM state.
+ */
+
+#include <mem.h>
+#include <stdatomic.h>
+#include "../../accel.h"
+#include "../../compose.h"
+
+#define CPUID_1_ECX_OSXSAVE  (1U << 27)
+#define CPUID_1_ECX_AVX      (1U << 28)
+#define CPUID_7_EBX_AVX2     (1U << 5)
+
+#define XCR0_SSE  (1U << 1)
+#define XCR0_AVX  (1U << 2)
+
+enum {
+	FEATURE_PROBED = 1 << 0,
+	FEATURE_AVX2 = 1 << 1
+};
+
+typedef uint32_t vec4_t __attribute__((vector_size(16)));
+typedef uint32_t vec8_t __attribute__((vector_size(32)));
+
+/** Detected features, zero until probed. */
+static atomic_uint features;
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+    uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+	    : "a" (leaf), "c" (subleaf)
+	);
+}
+
+static uint32_t xgetbv(uint32_t index)
+{
+	uint32_t eax, edx;
+	asm volatile (
+	    "xgetbv\n"
+	    : "=a" (eax), "=d" (edx)
+	    : "c" (index)
+	);
+	return eax;
+}
+
+static unsigned int get_features(void)
+{
+	unsigned int feat = atomic_load_explicit(&features,
+	    memory_order_relaxed);
+	if (feat != 0)
+		return feat;
+
+	uint32_t max_leaf, eax, ebx, ecx, edx;
+	cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+	feat = FEATURE_PROBED;
+
+	cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+	if ((max_leaf >= 7) && (ecx & CPUID_1_ECX_OSXSAVE) &&
+	    (ecx & CPUID_1_ECX_AVX) &&
+	    ((xgetbv(0) & (XCR0_SSE | XCR0_AVX)) == (XCR0_SSE | XCR0_AVX))) {
+		cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+		if (ebx & CPUID_7_EBX_AVX2)
+			feat |= FEATURE_AVX2;
+	}
+
+	atomic_store_explicit(&features, feat, memory_order_relaxed);
+	return feat;
+}
+
+#define VEC  vec4_t
+#define KERNEL(name)  name##_sse2
+#define TARGET
+#include "kernels.h"
+#undef VEC
+#undef KERNEL
+#undef TARGET
+
+#define VEC  vec8_t
+#define KERNEL(name)  name##_avx2
+#define TARGET  __attribute__((target("avx2")))
+#include "kernels.h"
+#undef VEC
+#undef KERNEL
+#undef TARGET
+
+bool span_accel_available(void)
+{
+	return true;
+}
+
+void compose_over_accel(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	if (get_features() & FEATURE_AVX2)
+		compose_over_avx2(dst, src, count);
+	else
+		compose_over_sse2(dst, src, count);
+}
+
+void filter_blend_accel(pixel_t *dst, const pixel_t *c00, const pixel_t *c10,
+    const pixel_t *c01, const pixel_t *c11, const uint32_t *wx,
+    const uint32_t *wy, size_t count)
+{
+	if (get_features() & FEATURE_AVX2)
+		filter_blend_avx2(dst, c00, c10, c01, c11, wx, wy, count);
+	else
+		filter_blend_sse2(dst, c00, c10, c01, c11, wx, wy, count);
+}
+
+/** @}
+ */
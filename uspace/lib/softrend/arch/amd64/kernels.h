@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup softrend
+ * @{
+ */
+/**
+ * @file
+ *
+ * Span kernels written with GCC vector extensions.
+ *
+ * This file is included once for each vector width by accel.c, which defines
+ * VEC (vector of uint32_t lanes), KERNEL(name) (name with a width suffix)
+ * and TARGET (attributes selecting the instruction set). Each lane holds one
+ * pixel, channels are extracted with shifts and masks.
+ */
+
+#define LANES  (sizeof(VEC) / sizeof(uint32_t))
+
+/** Exact division by 255 of values up to 255 * 255 * 255. */
+static inline TARGET VEC KERNEL(div255)(VEC x)
+{
+	VEC q = ((x + 1) * 257) >> 16;
+	return q - (VEC) ((x - q * 255) > 254);
+}
+
+static inline TARGET VEC KERNEL(over)(VEC fg, VEC bg)
+{
+	VEC af = fg >> 24;
+	VEC inv = (bg >> 24) * (255 - af);
+	VEC res = (af + KERNEL(div255)(inv)) << 24;
+
+	for (unsigned shift = 0; shift < 24; shift += 8) {
+		VEC cf = (fg >> shift) & 0xff;
+		VEC cb = (bg >> shift) & 0xff;
+		res |= (KERNEL(div255)(cf * af) +
+		    KERNEL(div255)(KERNEL(div255)(cb * inv))) << shift;
+	}
+
+	return res;
+}
+
+static TARGET void KERNEL(compose_over)(pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	size_t i;
+	for (i = 0; i + LANES <= count; i += LANES) {
+		VEC fg, bg;
+		memcpy(&fg, src + i, sizeof(VEC));
+		memcpy(&bg, dst + i, sizeof(VEC));
+
+		VEC res = KERNEL(over)(fg, bg);
+		memcpy(dst + i, &res, sizeof(VEC));
+	}
+
+	for (; i < count; i++)
+		dst[i] = compose_over(src[i], dst[i]);
+}
+
+static inline TARGET VEC KERNEL(blend)(VEC p00, VEC p10, VEC p01, VEC p11,
+    VEC wx, VEC wy)
+{
+	VEC ix = 256 - wx;
+	VEC iy = 256 - wy;
+	VEC res = { 0 };
+
+	for (unsigned shift = 0; shift < 32; shift += 8) {
+		VEC top = ((p00 >> shift) & 0xff) * ix +
+		    ((p10 >> shift) & 0xff) * wx;
+		VEC bottom = ((p01 >> shift) & 0xff) * ix +
+		    ((p11 >> shift) & 0xff) * wx;
+		res |= ((top * iy + bottom * wy) >> 16) << shift;
+	}
+
+	return res;
+}
+
+static TARGET void KERNEL(filter_blend)(pixel_t *dst, const pixel_t *c00,
+    const pixel_t *c10, const pixel_t *c01, const pixel_t *c11,
+    const uint32_t *wx, const uint32_t *wy, size_t count)
+{
+	VEC p00, p10, p01, p11, vx, vy, res;
+
+	size_t i;
+	for (i = 0; i + LANES <= count; i += LANES) {
+		memcpy(&p00, c00 + i, sizeof(VEC));
+		memcpy(&p10, c10 + i, sizeof(VEC));
+		memcpy(&p01, c01 + i, sizeof(VEC));
+		memcpy(&p11, c11 + i, sizeof(VEC));
+		memcpy(&vx, wx + i, sizeof(VEC));
+		memcpy(&vy, wy + i, sizeof(VEC));
+
+		res = KERNEL(blend)(p00, p10, p01, p11, vx, vy);
+		memcpy(dst + i, &res, sizeof(VEC));
+	}
+
+	if (i == count)
+		return;
+
+	/* Process the remainder in a partially filled vector. */
+	size_t rest = (count - i) * sizeof(uint32_t);
+	p00 = p10 = p01 = p11 = vx = vy = (VEC) { 0 };
+	memcpy(&p00, c00 + i, rest);
+	memcpy(&p10, c10 + i, rest);
+	memcpy(&p01, c01 + i, rest);
+	memcpy(&p11, c11 + i, rest);
+	memcpy(&vx, wx + i, rest);
+	memcpy(&vy, wy + i, rest);
+
+	res = KERNEL(blend)(p00, p10, p01, p11, vx, vy);
+	memcpy(dst + i, &res, rest);
+}
+
+#undef LANES
+
+/** @}
+ */
@@ -33,6 +33,8 @@
  * @file
  */
 
+#include <mem.h>
+#include "accel.h"
 #include "compose.h"
 
 pixel_t compose_clr(pixel_t fg, pixel_t bg)
@@ -98,5 +100,100 @@ pixel_t compose_add(pixel_t fg, pixel_t bg)
 	return 0;
 }
 
+/*
+ * Span variants compose whole rows at once: dst[i] = op(src[i], dst[i]).
+ */
+
+void compose_clr_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	memset(dst, 0, count * sizeof(pixel_t));
+}
+
+void compose_src_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	memcpy(dst, src, count * sizeof(pixel_t));
+}
+
+void compose_dst_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+}
+
+void compose_over_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	if (span_accel_available()) {
+		compose_over_accel(dst, src, count);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		pixel_t fg = src[i];
+
+		/* Fully opaque and fully transparent pixels are common. */
+		if (ALPHA(fg) == 255)
+			dst[i] = fg;
+		else if (ALPHA(fg) != 0 || ALPHA(dst[i]) != 255)
+			dst[i] = compose_over(fg, dst[i]);
+	}
+}
+
+void compose_in_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_in(src[i], dst[i]);
+}
+
+void compose_out_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_out(src[i], dst[i]);
+}
+
+void compose_atop_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_atop(src[i], dst[i]);
+}
+
+void compose_xor_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_xor(src[i], dst[i]);
+}
+
+void compose_add_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_add(src[i], dst[i]);
+}
+
+/** Find span variant of a compositing operator.
+ *
+ * @param compose Per-pixel compositing operator.
+ * @return Span variant of the operator, NULL if there is none.
+ */
+compose_span_t compose_get_span(compose_t compose)
+{
+	if (compose == compose_clr)
+		return compose_clr_span;
+	if (compose == compose_src)
+		return compose_src_span;
+	if (compose == compose_dst)
+		return compose_dst_span;
+	if (compose == compose_over)
+		return compose_over_span;
+	if (compose == compose_in)
+		return compose_in_span;
+	if (compose == compose_out)
+		return compose_out_span;
+	if (compose == compose_atop)
+		return compose_atop_span;
+	if (compose == compose_xor)
+		return compose_xor_span;
+	if (compose == compose_add)
+		return compose_add_span;
+
+	return NULL;
+}
+
 /** @}
  */
@@ -34,9 +34,14 @@
  * @file
  */
 
+#include <stdint.h>
+#include "accel.h"
 #include "filter.h"
 #include <io/pixel.h>
 
+/** Number of pixels sampled before they are blended at once. */
+#define SPAN_BLOCK  64
+
 static long _round(double val)
 {
 	return val > 0 ? (long) (val + 0.5) : (long) (val - 0.5);
@@ -117,5 +122,141 @@ pixel_t filter_bicubic(pixelmap_t *pixmap, double x, double y,
 	return 0;
 }
 
+void filter_nearest_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixel_t *dst, size_t count,
+    pixelmap_extend_t extend)
+{
+	for (size_t i = 0; i < count; i++) {
+		dst[i] = pixelmap_get_extended_pixel(pixmap,
+		    _round(x + i * dx), _round(y + i * dy), extend);
+	}
+}
+
+/** Convert coordinate to 16.16 fixed point, rounding down. */
+static int64_t _fixed(double val)
+{
+	double scaled = val * 65536.0;
+	int64_t fixed = (int64_t) scaled;
+	if (scaled < 0 && fixed != scaled)
+		return fixed - 1;
+	return fixed;
+}
+
+/** Blend four neighbouring pixels with 8-bit weights.
+ *
+ * @param wx Weight of the right pixels (0 to 255).
+ * @param wy Weight of the bottom pixels (0 to 255).
+ */
+static inline pixel_t blend_fixed(pixel_t c00, pixel_t c10, pixel_t c01,
+    pixel_t c11, uint32_t wx, uint32_t wy)
+{
+	pixel_t res = 0;
+	for (unsigned shift = 0; shift < 32; shift += 8) {
+		uint32_t top = ((c00 >> shift) & 0xff) * (256 - wx) +
+		    ((c10 >> shift) & 0xff) * wx;
+		uint32_t bottom = ((c01 >> shift) & 0xff) * (256 - wx) +
+		    ((c11 >> shift) & 0xff) * wx;
+		res |= ((top * (256 - wy) + bottom * wy) >> 16) << shift;
+	}
+
+	return res;
+}
+
+/** Bilinear filtering of a row of pixels.
+ *
+ * Unlike filter_bilinear(), the coordinates are stepped in fixed point and
+ * the pixels are weighted with 8-bit precision, which allows blending
+ * several pixels at once.
+ */
+void filter_bilinear_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixel_t *dst, size_t count,
+    pixelmap_extend_t extend)
+{
+	pixel_t c00[SPAN_BLOCK];
+	pixel_t c10[SPAN_BLOCK];
+	pixel_t c01[SPAN_BLOCK];
+	pixel_t c11[SPAN_BLOCK];
+	uint32_t wx[SPAN_BLOCK];
+	uint32_t wy[SPAN_BLOCK];
+
+	const int64_t width = pixmap->width;
+	const int64_t height = pixmap->height;
+	const int64_t fdx = _fixed(dx);
+	const int64_t fdy = _fixed(dy);
+	int64_t fx = _fixed(x);
+	int64_t fy = _fixed(y);
+
+	while (count > 0) {
+		size_t block = count < SPAN_BLOCK ? count : SPAN_BLOCK;
+
+		/* Gather neighbouring pixels. */
+		for (size_t i = 0; i < block; i++) {
+			int64_t x1 = fx >> 16;
+			int64_t y1 = fy >> 16;
+			wx[i] = (fx >> 8) & 0xff;
+			wy[i] = (fy >> 8) & 0xff;
+
+			if (x1 >= 0 && y1 >= 0 && x1 + 1 < width &&
+			    y1 + 1 < height) {
+				pixel_t *p = pixmap->data + y1 * width + x1;
+				c00[i] = p[0];
+				c10[i] = p[1];
+				c01[i] = p[width];
+				c11[i] = p[width + 1];
+			} else {
+				c00[i] = pixelmap_get_extended_pixel(pixmap,
+				    x1, y1, extend);
+				c10[i] = pixelmap_get_extended_pixel(pixmap,
+				    x1 + 1, y1, extend);
+				c01[i] = pixelmap_get_extended_pixel(pixmap,
+				    x1, y1 + 1, extend);
+				c11[i] = pixelmap_get_extended_pixel(pixmap,
+				    x1 + 1, y1 + 1, extend);
+			}
+
+			fx += fdx;
+			fy += fdy;
+		}
+
+		if (span_accel_available()) {
+			filter_blend_accel(dst, c00, c10, c01, c11, wx, wy,
+			    block);
+		} else {
+			for (size_t i = 0; i < block; i++) {
+				dst[i] = blend_fixed(c00[i], c10[i], c01[i],
+				    c11[i], wx[i], wy[i]);
+			}
+		}
+
+		dst += block;
+		count -= block;
+	}
+}
+
+void filter_bicubic_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixel_t *dst, size_t count,
+    pixelmap_extend_t extend)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = filter_bicubic(pixmap, x + i * dx, y + i * dy, extend);
+}
+
+/** Find span variant of a filter.
+ *
+ * @param filter Per-pixel filter.
+ * @return Span variant of the filter, NULL if there is none.
+ */
+filter_span_t filter_get_span(filter_t filter)
+{
+	if (filter == filter_nearest)
+		return filter_nearest_span;
+	if (filter == filter_bilinear)
+		return filter_bilinear_span;
+	if (filter == filter_bicubic)
+		return filter_bicubic_span;
+
+	return NULL;
+}
+
 /** @}
  */
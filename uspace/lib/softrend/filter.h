@@ -36,14 +36,28 @@
 #ifndef SOFTREND_FILTER_H_
 #define SOFTREND_FILTER_H_
 
+#include <stddef.h>
 #include <io/pixelmap.h>
 
 typedef pixel_t (*filter_t)(pixelmap_t *, double, double, pixelmap_extend_t);
 
+/** Sample a row of pixels along a line starting at (x, y) with step (dx, dy). */
+typedef void (*filter_span_t)(pixelmap_t *, double, double, double, double,
+    pixel_t *, size_t, pixelmap_extend_t);
+
 extern pixel_t filter_nearest(pixelmap_t *, double, double, pixelmap_extend_t);
 extern pixel_t filter_bilinear(pixelmap_t *, double, double, pixelmap_extend_t);
 extern pixel_t filter_bicubic(pixelmap_t *, double, double, pixelmap_extend_t);
 
+extern void filter_nearest_span(pixelmap_t *, double, double, double, double,
+    pixel_t *, size_t, pixelmap_extend_t);
+extern void filter_bilinear_span(pixelmap_t *, double, double, double, double,
+    pixel_t *, size_t, pixelmap_extend_t);
+extern void filter_bicubic_span(pixelmap_t *, double, double, double, double,
+    pixel_t *, size_t, pixelmap_extend_t);
+
+extern filter_span_t filter_get_span(filter_t);
+
 #endif
 
 /** @}
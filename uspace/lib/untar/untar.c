@@ -32,6 +32,8 @@
 /** @file
  */
 
+#include <async.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -40,6 +42,9 @@
 #include "private/tar.h"
 #include "untar.h"
 
+/** Size of the chunks in which file contents are extracted */
+#define TAR_CHUNK_SIZE (32 * TAR_BLOCK_SIZE)
+
 static size_t get_block_count(size_t bytes)
 {
 	return (bytes + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
@@ -86,49 +91,121 @@ static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
 	return EOK;
 }
 
+/** Finish a pending write of a file chunk.
+ *
+ * Waits for the write request and completes a short write synchronously.
+ */
+static errno_t tar_write_finish(int fd, aoff64_t *pos, const uint8_t *buf,
+    size_t size, aid_t req, ipc_call_t *answer)
+{
+	errno_t rc;
+	size_t nwritten;
+
+	async_wait_for(req, &rc);
+	if (rc != EOK)
+		return rc;
+
+	nwritten = ipc_get_arg1(answer);
+	*pos += nwritten;
+	if (nwritten < size)
+		rc = vfs_write(fd, pos, buf + nwritten, size - nwritten, &nwritten);
+
+	return rc;
+}
+
 static errno_t tar_handle_normal_file(tar_file_t *tar,
     const tar_header_t *header)
 {
 	// FIXME: create the directory first
 
-	FILE *file = fopen(header->filename, "wb");
-	if (file == NULL) {
+	int fd;
+	errno_t rc = vfs_lookup_open(header->filename,
+	    WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE, &fd);
+	if (rc == EOK) {
+		rc = vfs_resize(fd, 0);
+		if (rc != EOK)
+			vfs_put(fd);
+	}
+	if (rc != EOK) {
 		tar_report(tar, "Failed to create %s: %s.\n", header->filename,
-		    str_error(errno));
-		return errno;
+		    str_error(rc));
+		return rc;
+	}
+
+	/*
+	 * The next chunk is read from the archive while the previous one
+	 * is being written.
+	 */
+	uint8_t *buf[2];
+	buf[0] = malloc(TAR_CHUNK_SIZE);
+	buf[1] = malloc(TAR_CHUNK_SIZE);
+	if (buf[0] == NULL || buf[1] == NULL) {
+		free(buf[0]);
+		free(buf[1]);
+		vfs_put(fd);
+		return ENOMEM;
 	}
 
-	errno_t rc = EOK;
 	size_t bytes_remaining = header->size;
 	size_t blocks = get_block_count(bytes_remaining);
+	aoff64_t pos = 0;
+	ipc_call_t answer;
+	aid_t req;
+	size_t pending = 0;
+	unsigned int cur = 0;
 
 	while (blocks > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE) {
+		size_t to_read = min(blocks, TAR_CHUNK_SIZE / TAR_BLOCK_SIZE) *
+		    TAR_BLOCK_SIZE;
+		size_t actually_read = tar_read(tar, buf[cur], to_read);
+		if (actually_read != to_read) {
 			rc = errno;
 			tar_report(tar, "Failed to read block for %s: %s.\n",
 			    header->filename, str_error(rc));
 			break;
 		}
 
-		size_t to_write = TAR_BLOCK_SIZE;
-		if (bytes_remaining < TAR_BLOCK_SIZE)
-			to_write = bytes_remaining;
+		if (pending > 0) {
+			rc = tar_write_finish(fd, &pos, buf[1 - cur], pending,
+			    req, &answer);
+			pending = 0;
+			if (rc != EOK) {
+				tar_report(tar, "Failed to write to %s: %s.\n",
+				    header->filename, str_error(rc));
+				break;
+			}
+		}
 
-		size_t actually_written = fwrite(block, 1, to_write, file);
-		if (actually_written != to_write) {
-			rc = errno;
+		size_t to_write = min(bytes_remaining, to_read);
+		if (to_write > 0) {
+			rc = vfs_write_send(fd, pos, buf[cur], to_write, &answer,
+			    &req);
+			if (rc != EOK) {
+				tar_report(tar, "Failed to write to %s: %s.\n",
+				    header->filename, str_error(rc));
+				break;
+			}
+			pending = to_write;
+		}
+
+		blocks -= to_read / TAR_BLOCK_SIZE;
+		bytes_remaining -= to_write;
+		cur = 1 - cur;
+	}
+
+	if (pending > 0) {
+		errno_t wrc = tar_write_finish(fd, &pos, buf[1 - cur], pending,
+		    req, &answer);
+		if (rc == EOK && wrc != EOK) {
+			rc = wrc;
 			tar_report(tar, "Failed to write to %s: %s.\n",
 			    header->filename, str_error(rc));
-			break;
 		}
-
-		blocks--;
-		bytes_remaining -= TAR_BLOCK_SIZE;
 	}
 
-	fclose(file);
+	free(buf[0]);
+	free(buf[1]);
+	vfs_put(fd);
 	return rc;
 }
 
@@ -184,6 +184,61 @@ void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
 	fibril_mutex_unlock(&q->lock);
 }
 
+/** Put several descriptors into the available ring at once
+ *
+ * Unlike calling virtio_virtq_produce_available() for each descriptor, the
+ * device is notified only once for the whole batch.
+ *
+ * @param vdev[in]    VIRTIO device.
+ * @param num[in]     Index of the virtqueue.
+ * @param descno[in]  Array of descriptors to make available.
+ * @param count[in]   Number of descriptors in \a descno.
+ */
+void virtio_virtq_produce_available_batch(virtio_dev_t *vdev, uint16_t num,
+    const uint16_t *descno, size_t count)
+{
+	virtq_t *q = &vdev->queues[num];
+
+	if (count == 0)
+		return;
+
+	fibril_mutex_lock(&q->lock);
+	uint16_t idx = pio_read_le16(&q->avail->idx);
+	for (size_t i = 0; i < count; i++) {
+		pio_write_le16(&q->avail->ring[(uint16_t) (idx + i) %
+		    q->queue_size], descno[i]);
+	}
+	write_barrier();
+	pio_write_le16(&q->avail->idx, idx + count);
+	write_barrier();
+	pio_write_le16(q->notify, num);
+	fibril_mutex_unlock(&q->lock);
+}
+
+/** Enable or disable interrupts for a virtqueue
+ *
+ * Disabling interrupts is only a hint for the device, the driver still
+ * needs to cope with spurious interrupts.
+ *
+ * @param vdev[in]    VIRTIO device.
+ * @param num[in]     Index of the virtqueue.
+ * @param enable[in]  True if the device should interrupt the driver when
+ *                    it uses buffers from this virtqueue.
+ */
+void virtio_virtq_set_interrupt(virtio_dev_t *vdev, uint16_t num, bool enable)
+{
+	virtq_t *q = &vdev->queues[num];
+
+	fibril_mutex_lock(&q->lock);
+	uint16_t flags = pio_read_le16(&q->avail->flags);
+	if (enable)
+		flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+	else
+		flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+	pio_write_le16(&q->avail->flags, flags);
+	fibril_mutex_unlock(&q->lock);
+}
+
 bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
     uint16_t *descno, uint32_t *len)
 {
@@ -300,6 +355,22 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
  * specification, steps 1 - 6.
  */
 errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
+{
+	return virtio_device_setup_start_optional(vdev, features, 0, NULL);
+}
+
+/**
+ * Perform device initialization as described in section 3.1.1 of the
+ * specification, steps 1 - 6, with some of the features being optional.
+ *
+ * @param vdev[in]       VIRTIO device.
+ * @param features[in]   Features which the device must offer.
+ * @param optional[in]   Features which are accepted if offered by the device.
+ * @param accepted[out]  If not NULL, the accepted features will be stored
+ *                       here.
+ */
+errno_t virtio_device_setup_start_optional(virtio_dev_t *vdev,
+    uint32_t features, uint32_t optional, uint32_t *accepted)
 {
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
@@ -328,6 +399,7 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
+	features |= optional;
 	features &= device_features;
 
 	if (reserved_features != (reserved_features & device_reserved_features))
@@ -352,6 +424,9 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 	if (!(status & VIRTIO_DEV_STATUS_FEATURES_OK))
 		return ENOTSUP;
 
+	if (accepted != NULL)
+		*accepted = features;
+
 	return EOK;
 }
 
@@ -186,6 +186,7 @@ void audio_pipe_init(audio_pipe_t *pipe)
 	fibril_mutex_initialize(&pipe->guard);
 	pipe->frames = 0;
 	pipe->bytes = 0;
+	pcm_resampler_init(&pipe->resampler, 0, 0);
 }
 
 /**
@@ -270,6 +271,38 @@ size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *data,
 		link_t *l = list_first(&pipe->list);
 		audio_data_link_t *alink = audio_data_link_list_instance(l);
 
+		/* Convert sampling rate if the chunk does not match */
+		const unsigned rate = alink->adata->format.sampling_rate;
+		if (rate != f->sampling_rate) {
+			pcm_resampler_t *r = &pipe->resampler;
+			if (r->src_rate != rate ||
+			    r->dst_rate != f->sampling_rate)
+				pcm_resampler_init(r, rate, f->sampling_rate);
+
+			size_t dst_used = 0;
+			size_t src_used = 0;
+			const errno_t ret = pcm_resampler_mix(r, data,
+			    needed_frames * dst_frame_size, f,
+			    audio_data_link_start(alink),
+			    audio_data_link_remain_size(alink),
+			    &alink->adata->format, &dst_used, &src_used);
+			if (ret == EOK && (dst_used > 0 || src_used > 0)) {
+				needed_frames -= dst_used / dst_frame_size;
+				copied_size += dst_used;
+				data += dst_used;
+				alink->position += src_used;
+				pipe->bytes -= src_used;
+				pipe->frames -= pcm_format_size_to_frames(
+				    src_used, &alink->adata->format);
+				if (audio_data_link_remain_size(alink) == 0) {
+					list_remove(&alink->link);
+					audio_data_link_destroy(alink);
+				}
+				continue;
+			}
+			/* Fall back to mixing without rate conversion */
+		}
+
 		/* Get audio chunk metadata */
 		const size_t src_frame_size =
 		    pcm_format_frame_size(&alink->adata->format);
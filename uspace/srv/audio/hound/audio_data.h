@@ -64,6 +64,8 @@ typedef struct {
 	size_t frames;
 	/** List access synchronization */
 	fibril_mutex_t guard;
+	/** Sample rate converter for data not matching the target rate */
+	pcm_resampler_t resampler;
 } audio_pipe_t;
 
 audio_data_t *audio_data_create(void *data, size_t size,
@@ -1322,6 +1322,41 @@ static errno_t cdfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 	return EOK;
 }
 
+static errno_t cdfs_read_entries(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_cb_t cb, void *arg)
+{
+	ht_key_t key = {
+		.index = index,
+		.service_id = service_id
+	};
+
+	ht_link_t *link = hash_table_find(&nodes, &key);
+	if (link == NULL)
+		return ENOENT;
+
+	cdfs_node_t *node =
+	    hash_table_get_inst(link, cdfs_node_t, nh_link);
+	if (node->type != CDFS_DIRECTORY)
+		return ENOTDIR;
+
+	if (!node->processed) {
+		errno_t rc = cdfs_readdir(node->fs, FS_NODE(node));
+		if (rc != EOK)
+			return rc;
+	}
+
+	link_t *dlink = list_nth(&node->cs_list, pos);
+	while (dlink != NULL) {
+		cdfs_dentry_t *dentry =
+		    list_get_instance(dlink, cdfs_dentry_t, link);
+		if (!cb(arg, dentry->name, ++pos))
+			break;
+		dlink = list_next(dlink, &node->cs_list);
+	}
+
+	return EOK;
+}
+
 static errno_t cdfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
 {
@@ -1425,6 +1460,7 @@ vfs_out_ops_t cdfs_ops = {
 	.mounted = cdfs_mounted,
 	.unmounted = cdfs_unmounted,
 	.read = cdfs_read,
+	.readdir = cdfs_read_entries,
 	.write = cdfs_write,
 	.truncate = cdfs_truncate,
 	.close = cdfs_close,
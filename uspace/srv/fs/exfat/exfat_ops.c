@@ -1436,6 +1436,58 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	return rc;
 }
 
+static errno_t
+exfat_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_cb_t cb, void *arg)
+{
+	fs_node_t *fn;
+	exfat_node_t *nodep;
+	char name[EXFAT_FILENAME_LEN + 1];
+	exfat_file_dentry_t df;
+	exfat_stream_dentry_t ds;
+	errno_t rc;
+
+	rc = exfat_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (!fn)
+		return ENOENT;
+	nodep = EXFAT_NODE(fn);
+
+	if (nodep->type != EXFAT_DIRECTORY) {
+		(void) exfat_node_put(fn);
+		return ENOTDIR;
+	}
+
+	exfat_directory_t di;
+	rc = exfat_directory_open(nodep, &di);
+	if (rc != EOK) {
+		(void) exfat_node_put(fn);
+		return rc;
+	}
+
+	rc = exfat_directory_seek(&di, pos);
+	while (rc == EOK) {
+		rc = exfat_directory_read_file(&di, name, EXFAT_FILENAME_LEN,
+		    &df, &ds);
+		if (rc != EOK)
+			break;
+		if (!cb(arg, name, di.pos + 1))
+			break;
+		rc = exfat_directory_next(&di);
+	}
+
+	/* Running past the last entry is not an error. */
+	if (rc == ENOENT)
+		rc = EOK;
+
+	errno_t rc2 = exfat_directory_close(&di);
+	if (rc == EOK)
+		rc = rc2;
+	rc2 = exfat_node_put(fn);
+	return rc != EOK ? rc : rc2;
+}
+
 static errno_t exfat_close(service_id_t service_id, fs_index_t index)
 {
 	return EOK;
@@ -1617,6 +1669,7 @@ vfs_out_ops_t exfat_ops = {
 	.mounted = exfat_mounted,
 	.unmounted = exfat_unmounted,
 	.read = exfat_read,
+	.readdir = exfat_readdir,
 	.write = exfat_write,
 	.truncate = exfat_truncate,
 	.close = exfat_close,
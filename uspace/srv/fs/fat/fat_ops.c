@@ -1316,6 +1316,60 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	return rc;
 }
 
+static errno_t
+fat_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_cb_t cb, void *arg)
+{
+	fs_node_t *fn;
+	fat_node_t *nodep;
+	char name[FAT_LFN_NAME_SIZE];
+	fat_dentry_t *d;
+	errno_t rc;
+
+	rc = fat_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (!fn)
+		return ENOENT;
+	nodep = FAT_NODE(fn);
+
+	if (nodep->type != FAT_DIRECTORY) {
+		(void) fat_node_put(fn);
+		return ENOTDIR;
+	}
+
+	fat_directory_t di;
+	rc = fat_directory_open(nodep, &di);
+	if (rc != EOK) {
+		(void) fat_node_put(fn);
+		return rc;
+	}
+
+	/*
+	 * Keep the directory open for the whole batch; the position of each
+	 * entry is the same as fat_read() would report.
+	 */
+	rc = fat_directory_seek(&di, pos);
+	while (rc == EOK) {
+		rc = fat_directory_read(&di, name, &d);
+		if (rc != EOK)
+			break;
+		if (!cb(arg, name, di.pos + 1))
+			break;
+		rc = fat_directory_next(&di);
+	}
+
+	/* Running past the last entry is not an error. */
+	if (rc == ENOENT)
+		rc = EOK;
+
+	errno_t rc2 = fat_directory_close(&di);
+	if (rc == EOK)
+		rc = rc2;
+	rc2 = fat_node_put(fn);
+	return rc != EOK ? rc : rc2;
+}
+
 static errno_t
 fat_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -1563,6 +1617,7 @@ vfs_out_ops_t fat_ops = {
 	.mounted = fat_mounted,
 	.unmounted = fat_unmounted,
 	.read = fat_read,
+	.readdir = fat_readdir,
 	.write = fat_write,
 	.truncate = fat_truncate,
 	.close = fat_close,
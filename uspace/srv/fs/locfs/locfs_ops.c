@@ -605,6 +605,70 @@ locfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	return ENOENT;
 }
 
+static errno_t
+locfs_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_cb_t cb, void *arg)
+{
+	loc_sdesc_t *desc;
+	size_t count;
+
+	if (index == 0) {
+		/*
+		 * Namespaces other than the root namespace come first, followed
+		 * by services of the root namespace, in the same order as
+		 * locfs_read() reports them.
+		 */
+		count = loc_get_namespaces(&desc);
+
+		aoff64_t cur = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (str_cmp(desc[i].name, "") == 0)
+				continue;
+
+			if (cur++ < pos)
+				continue;
+
+			if (!cb(arg, desc[i].name, cur)) {
+				free(desc);
+				return EOK;
+			}
+		}
+
+		free(desc);
+
+		service_id_t namespace;
+		if (loc_namespace_get_id("", &namespace, 0) == EOK) {
+			count = loc_get_services(namespace, &desc);
+
+			for (size_t i = 0; i < count; i++) {
+				if (cur++ < pos)
+					continue;
+
+				if (!cb(arg, desc[i].name, cur))
+					break;
+			}
+
+			free(desc);
+		}
+
+		return EOK;
+	}
+
+	if (loc_id_probe(index) == LOC_OBJECT_NAMESPACE) {
+		count = loc_get_services(index, &desc);
+
+		for (aoff64_t i = pos; i < count; i++) {
+			if (!cb(arg, desc[i].name, i + 1))
+				break;
+		}
+
+		free(desc);
+		return EOK;
+	}
+
+	return ENOTDIR;
+}
+
 static errno_t
 locfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -772,6 +836,7 @@ vfs_out_ops_t locfs_ops = {
 	.mounted = locfs_mounted,
 	.unmounted = locfs_unmounted,
 	.read = locfs_read,
+	.readdir = locfs_readdir,
 	.write = locfs_write,
 	.truncate = locfs_truncate,
 	.close = locfs_close,
@@ -931,6 +931,48 @@ out_error:
 	return tmp != EOK ? tmp : rc;
 }
 
+static errno_t
+mfs_readdir(service_id_t service_id, fs_index_t index, aoff64_t pos,
+    libfs_readdir_cb_t cb, void *arg)
+{
+	errno_t rc;
+	errno_t tmp;
+	fs_node_t *fn = NULL;
+
+	rc = mfs_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+	if (!fn)
+		return ENOENT;
+
+	struct mfs_node *mnode = fn->data;
+	struct mfs_sb_info *sbi = mnode->instance->sbi;
+	struct mfs_dentry_info d_info;
+
+	if (!S_ISDIR(mnode->ino_i->i_mode)) {
+		rc = ENOTDIR;
+		goto out;
+	}
+
+	if (pos < 2) {
+		/* Skip the first two dentries ('.' and '..') */
+		pos = 2;
+	}
+
+	for (; pos < mnode->ino_i->i_size / sbi->dirsize; ++pos) {
+		rc = mfs_read_dentry(mnode, &d_info, pos);
+		if (rc != EOK)
+			break;
+
+		if (d_info.d_inum && !cb(arg, d_info.d_name, pos + 1))
+			break;
+	}
+
+out:
+	tmp = mfs_node_put(fn);
+	return rc != EOK ? rc : tmp;
+}
+
 static errno_t
 mfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -1262,6 +1304,7 @@ vfs_out_ops_t mfs_ops = {
 	.mounted = mfs_mounted,
 	.unmounted = mfs_unmounted,
 	.read = mfs_read,
+	.readdir = mfs_readdir,
 	.write = mfs_write,
 	.truncate = mfs_truncate,
 	.close = mfs_close,
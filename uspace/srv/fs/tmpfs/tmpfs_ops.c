@@ -523,6 +523,35 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 	return EOK;
 }
 
+static errno_t tmpfs_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_cb_t cb, void *arg)
+{
+	node_key_t key = {
+		.service_id = service_id,
+		.index = index
+	};
+
+	ht_link_t *hlp = hash_table_find(&nodes, &key);
+	if (!hlp)
+		return ENOENT;
+
+	tmpfs_node_t *nodep = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
+	if (nodep->type != TMPFS_DIRECTORY)
+		return ENOTDIR;
+
+	/* Unlike tmpfs_read(), walk the list only once per batch. */
+	link_t *lnk = list_nth(&nodep->cs_list, pos);
+	while (lnk != NULL) {
+		tmpfs_dentry_t *dentryp = list_get_instance(lnk,
+		    tmpfs_dentry_t, link);
+		if (!cb(arg, dentryp->name, ++pos))
+			break;
+		lnk = list_next(lnk, &nodep->cs_list);
+	}
+
+	return EOK;
+}
+
 static errno_t
 tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -587,6 +616,59 @@ out:
 	return EOK;
 }
 
+static errno_t tmpfs_copy_range(service_id_t service_id, fs_index_t src,
+    aoff64_t spos, fs_index_t dst, aoff64_t dpos, aoff64_t size,
+    aoff64_t *copied, aoff64_t *nsize)
+{
+	node_key_t skey = {
+		.service_id = service_id,
+		.index = src
+	};
+	node_key_t dkey = {
+		.service_id = service_id,
+		.index = dst
+	};
+
+	ht_link_t *shlp = hash_table_find(&nodes, &skey);
+	ht_link_t *dhlp = hash_table_find(&nodes, &dkey);
+	if (!shlp || !dhlp)
+		return ENOENT;
+
+	tmpfs_node_t *snodep = hash_table_get_inst(shlp, tmpfs_node_t, nh_link);
+	tmpfs_node_t *dnodep = hash_table_get_inst(dhlp, tmpfs_node_t, nh_link);
+	if (snodep->type != TMPFS_FILE || dnodep->type != TMPFS_FILE)
+		return EINVAL;
+
+	size_t bytes = 0;
+	if (spos < snodep->size)
+		bytes = min(snodep->size - spos, size);
+
+	if (bytes > 0 && dpos > SIZE_MAX - bytes)
+		return ENOMEM;
+
+	/* Grow the destination the same way tmpfs_write() does. */
+	if (bytes > 0 && dpos + bytes > dnodep->size) {
+		size_t nsz = dpos + bytes;
+		void *newdata = realloc(dnodep->data, nsz);
+		if (!newdata)
+			return ENOMEM;
+		memset(newdata + dnodep->size, 0, nsz - dnodep->size);
+		dnodep->size = nsz;
+		dnodep->data = newdata;
+	}
+
+	/*
+	 * The source and the destination may be the same node, possibly
+	 * with overlapping ranges.
+	 */
+	if (bytes > 0)
+		memmove(dnodep->data + dpos, snodep->data + spos, bytes);
+
+	*copied = bytes;
+	*nsize = dnodep->size;
+	return EOK;
+}
+
 static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
     aoff64_t size)
 {
@@ -657,7 +739,9 @@ vfs_out_ops_t tmpfs_ops = {
 	.mounted = tmpfs_mounted,
 	.unmounted = tmpfs_unmounted,
 	.read = tmpfs_read,
+	.readdir = tmpfs_readdir,
 	.write = tmpfs_write,
+	.copy_range = tmpfs_copy_range,
 	.truncate = tmpfs_truncate,
 	.close = tmpfs_close,
 	.destroy = tmpfs_destroy,
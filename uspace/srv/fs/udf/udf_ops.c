@@ -519,6 +519,51 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 }
 
+static errno_t udf_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, libfs_readdir_cb_t cb, void *arg)
+{
+	fs_node_t *rfn;
+	errno_t rc = udf_node_get(&rfn, service_id, index);
+	if (rc != EOK)
+		return rc;
+
+	udf_node_t *node = UDF_NODE(rfn);
+	if (node->type == NODE_FILE) {
+		udf_node_put(rfn);
+		return ENOTDIR;
+	}
+
+	char *name = malloc(MAX_FILE_NAME_LEN + 1);
+	if (name == NULL) {
+		udf_node_put(rfn);
+		return ENOMEM;
+	}
+
+	while (true) {
+		block_t *block = NULL;
+		udf_file_identifier_descriptor_t *fid = NULL;
+		if (udf_get_fid(&fid, &block, node, pos) != EOK)
+			break;
+
+		udf_to_unix_name(name, MAX_FILE_NAME_LEN,
+		    (char *) fid->implementation_use + FLE16(fid->length_iu),
+		    fid->length_file_id, &node->instance->charset);
+
+		if (block != NULL) {
+			rc = block_put(block);
+			if (rc != EOK)
+				break;
+		}
+
+		if (!cb(arg, name, ++pos))
+			break;
+	}
+
+	free(name);
+	errno_t rc2 = udf_node_put(rfn);
+	return rc != EOK ? rc : rc2;
+}
+
 static errno_t udf_close(service_id_t service_id, fs_index_t index)
 {
 	return EOK;
@@ -551,6 +596,7 @@ vfs_out_ops_t udf_ops = {
 	.mounted = udf_mounted,
 	.unmounted = udf_unmounted,
 	.read = udf_read,
+	.readdir = udf_readdir,
 	.write = udf_write,
 	.truncate = udf_truncate,
 	.close = udf_close,
@@ -45,6 +45,7 @@
 #include <align.h>
 #include <as.h>
 #include <stdlib.h>
+#include <mem.h>
 
 #include <refcount.h>
 #include <fibril_synch.h>
@@ -73,6 +74,7 @@
 #include <codec/tga.h>
 
 #include "compositor.h"
+#include "region.h"
 
 #define NAME       "compositor"
 #define NAMESPACE  "comp"
@@ -106,6 +108,8 @@ typedef struct {
 	double angle;
 	uint8_t opacity;
 	surface_t *surface;
+	/** Scratch region of the window visible in the area being painted */
+	region_t visible;
 } window_t;
 
 static service_id_t winreg_id;
@@ -149,6 +153,11 @@ static LIST_INITIALIZE(viewport_list);
 
 static FIBRIL_MUTEX_INITIALIZE(discovery_mtx);
 
+/** Damage accumulated since the last repaint, in global coordinates */
+static region_t damage_region;
+static FIBRIL_MUTEX_INITIALIZE(damage_mtx);
+static FIBRIL_CONDVAR_INITIALIZE(damage_cv);
+
 /** Input server proxy */
 static input_t *input;
 static bool active = false;
@@ -385,208 +394,277 @@ static void comp_restrict_pointers(void)
 	fibril_mutex_unlock(&pointer_list_mtx);
 }
 
-static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
-    sysarg_t w_dmg_glob, sysarg_t h_dmg_glob)
+/** Whether the window hides everything below its bounding rectangle.
+ *
+ * Untransformed windows without additional translucency are copied onto the
+ * viewport as they are, so nothing below them ever shows through.
+ */
+static bool comp_window_is_opaque(window_t *win)
 {
-	fibril_mutex_lock(&viewport_list_mtx);
-	fibril_mutex_lock(&window_list_mtx);
-	fibril_mutex_lock(&pointer_list_mtx);
+	return (win->opacity == 255) && transform_is_fast(&win->transform);
+}
 
-	list_foreach(viewport_list, link, viewport_t, vp) {
-		/* Determine what part of the viewport must be updated. */
-		sysarg_t x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp;
-		surface_get_resolution(vp->surface, &w_dmg_vp, &h_dmg_vp);
-		bool isec_vp = rectangle_intersect(
-		    x_dmg_glob, y_dmg_glob, w_dmg_glob, h_dmg_glob,
-		    vp->pos.x, vp->pos.y, w_dmg_vp, h_dmg_vp,
-		    &x_dmg_vp, &y_dmg_vp, &w_dmg_vp, &h_dmg_vp);
-
-		if (isec_vp) {
-
-			/* Paint background color. */
-			for (sysarg_t y = y_dmg_vp - vp->pos.y; y <  y_dmg_vp - vp->pos.y + h_dmg_vp; ++y) {
-				pixel_t *dst = pixelmap_pixel_at(
-				    surface_pixmap_access(vp->surface), x_dmg_vp - vp->pos.x, y);
-				sysarg_t count = w_dmg_vp;
-				while (count-- != 0) {
-					*dst++ = bg_color;
-				}
+/** Copy part of an untransformed window directly to the viewport. */
+static void comp_blit_window(viewport_t *vp, window_t *win,
+    const region_rect_t *rect)
+{
+	pixelmap_t *src_map = surface_pixmap_access(win->surface);
+	pixelmap_t *dst_map = surface_pixmap_access(vp->surface);
+	sysarg_t x_win = (sysarg_t) (long) win->transform.matrix[0][2];
+	sysarg_t y_win = (sysarg_t) (long) win->transform.matrix[1][2];
+	size_t len = (rect->x1 - rect->x0) * sizeof(pixel_t);
+
+	for (sysarg_t y = rect->y0; y < rect->y1; ++y) {
+		pixel_t *src = pixelmap_pixel_at(src_map,
+		    rect->x0 - x_win, y - y_win);
+		pixel_t *dst = pixelmap_pixel_at(dst_map,
+		    rect->x0 - vp->pos.x, y - vp->pos.y);
+		if (src && dst)
+			memcpy(dst, src, len);
+	}
+}
+
+/** Repaint part of a viewport.
+ *
+ * Windows are first walked from the top to determine which of their parts
+ * are not hidden by opaque windows in front of them, then only those parts
+ * are painted from the bottom up.
+ *
+ * @param vp Viewport to paint.
+ * @param dmg Area to repaint in global coordinates, within the viewport.
+ */
+static void comp_paint_rect(viewport_t *vp, const region_rect_t *dmg)
+{
+	sysarg_t x_dmg_vp = dmg->x0;
+	sysarg_t y_dmg_vp = dmg->y0;
+	sysarg_t w_dmg_vp = dmg->x1 - dmg->x0;
+	sysarg_t h_dmg_vp = dmg->y1 - dmg->y0;
+
+	/* Determine visible parts of windows, from top to bottom. */
+	region_t uncovered;
+	region_set_rect(&uncovered, dmg);
+
+	list_foreach(window_list, link, window_t, win) {
+		region_init(&win->visible);
+		if (!win->surface || region_empty(&uncovered))
+			continue;
+
+		sysarg_t x_win, y_win, w_win, h_win;
+		surface_get_resolution(win->surface, &w_win, &h_win);
+		comp_coord_bounding_rect(0, 0, w_win, h_win, win->transform,
+		    &x_win, &y_win, &w_win, &h_win);
+
+		region_rect_t bound;
+		region_rect_init(&bound, x_win, y_win, w_win, h_win);
+		region_intersect_rect(&win->visible, &uncovered, &bound);
+
+		/*
+		 * If the region gets too fragmented, the area is simply painted
+		 * more than once.
+		 */
+		if (!region_empty(&win->visible) && comp_window_is_opaque(win))
+			(void) region_subtract_rect(&uncovered, &bound);
+	}
+
+	/* Paint background color where no opaque window covers it. */
+	for (size_t i = 0; i < uncovered.count; ++i) {
+		const region_rect_t *rect = &uncovered.rects[i];
+		for (sysarg_t y = rect->y0; y < rect->y1; ++y) {
+			pixel_t *dst = pixelmap_pixel_at(
+			    surface_pixmap_access(vp->surface),
+			    rect->x0 - vp->pos.x, y - vp->pos.y);
+			sysarg_t count = rect->x1 - rect->x0;
+			while (count-- != 0) {
+				*dst++ = bg_color;
 			}
-			surface_add_damaged_region(vp->surface,
-			    x_dmg_vp - vp->pos.x, y_dmg_vp - vp->pos.y, w_dmg_vp, h_dmg_vp);
+		}
+	}
 
-			transform_t transform;
-			source_t source;
-			drawctx_t context;
+	transform_t transform;
+	source_t source;
+	drawctx_t context;
+
+	source_init(&source);
+	source_set_filter(&source, filter);
+	drawctx_init(&context, vp->surface);
+	drawctx_set_compose(&context, compose_over);
+	drawctx_set_source(&context, &source);
+
+	/* Paint visible parts of windows, from bottom to top. */
+	for (link_t *link = window_list.head.prev;
+	    link != &window_list.head; link = link->prev) {
+		window_t *win = list_get_instance(link, window_t, link);
+		if (region_empty(&win->visible))
+			continue;
 
-			source_init(&source);
-			source_set_filter(&source, filter);
-			drawctx_init(&context, vp->surface);
-			drawctx_set_compose(&context, compose_over);
-			drawctx_set_source(&context, &source);
+		if (comp_window_is_opaque(win)) {
+			for (size_t i = 0; i < win->visible.count; ++i)
+				comp_blit_window(vp, win, &win->visible.rects[i]);
+			continue;
+		}
 
-			/* For each window. */
-			for (link_t *link = window_list.head.prev;
-			    link != &window_list.head; link = link->prev) {
+		/*
+		 * Prepare conversion from global coordinates to viewport
+		 * coordinates.
+		 */
+		transform = win->transform;
+		double_point_t pos;
+		pos.x = vp->pos.x;
+		pos.y = vp->pos.y;
+		transform_translate(&transform, -pos.x, -pos.y);
+
+		source_set_transform(&source, transform);
+		source_set_texture(&source, win->surface,
+		    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+		source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
+
+		for (size_t i = 0; i < win->visible.count; ++i) {
+			const region_rect_t *rect = &win->visible.rects[i];
+			drawctx_transfer(&context,
+			    rect->x0 - vp->pos.x, rect->y0 - vp->pos.y,
+			    rect->x1 - rect->x0, rect->y1 - rect->y0);
+		}
+	}
 
+	list_foreach(pointer_list, link, pointer_t, ptr) {
+		if (ptr->ghost.surface) {
+
+			sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
+			sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
+			surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
+			comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
+			    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
+			bool isec_ghost = rectangle_intersect(
+			    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
+			    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
+			    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
+
+			if (isec_ghost) {
 				/*
-				 * Determine what part of the window intersects with the
-				 * updated area of the current viewport.
+				 * FIXME: Ghost is currently drawn based on the bounding
+				 * rectangle of the window, which is sufficient as long
+				 * as the windows can be rotated only by 90 degrees.
+				 * For ghost to be compatible with arbitrary-angle
+				 * rotation, it should be drawn as four lines adjusted
+				 * by the transformation matrix. That would however
+				 * require to equip libdraw with line drawing functionality.
 				 */
-				window_t *win = list_get_instance(link, window_t, link);
-				if (!win->surface) {
-					continue;
+
+				transform_t transform = ptr->ghost.transform;
+				double_point_t pos;
+				pos.x = vp->pos.x;
+				pos.y = vp->pos.y;
+				transform_translate(&transform, -pos.x, -pos.y);
+
+				pixel_t ghost_color;
+
+				if (y_bnd_ghost == y_dmg_ghost) {
+					for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+					    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y);
+						surface_put_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
+					}
 				}
-				sysarg_t x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win;
-				surface_get_resolution(win->surface, &w_dmg_win, &h_dmg_win);
-				comp_coord_bounding_rect(0, 0, w_dmg_win, h_dmg_win, win->transform,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-				bool isec_win = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-
-				if (isec_win) {
-					/*
-					 * Prepare conversion from global coordinates to viewport
-					 * coordinates.
-					 */
-					transform = win->transform;
-					double_point_t pos;
-					pos.x = vp->pos.x;
-					pos.y = vp->pos.y;
-					transform_translate(&transform, -pos.x, -pos.y);
-
-					source_set_transform(&source, transform);
-					source_set_texture(&source, win->surface,
-					    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
-					source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
-
-					drawctx_transfer(&context,
-					    x_dmg_win - vp->pos.x, y_dmg_win - vp->pos.y, w_dmg_win, h_dmg_win);
+
+				if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
+					for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+					    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
+						surface_put_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
+					}
 				}
-			}
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
-				if (ptr->ghost.surface) {
-
-					sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
-					sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
-					surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
-					comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
-					    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
-					bool isec_ghost = rectangle_intersect(
-					    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-					    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
-					    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
-
-					if (isec_ghost) {
-						/*
-						 * FIXME: Ghost is currently drawn based on the bounding
-						 * rectangle of the window, which is sufficient as long
-						 * as the windows can be rotated only by 90 degrees.
-						 * For ghost to be compatible with arbitrary-angle
-						 * rotation, it should be drawn as four lines adjusted
-						 * by the transformation matrix. That would however
-						 * require to equip libdraw with line drawing functionality.
-						 */
-
-						transform_t transform = ptr->ghost.transform;
-						double_point_t pos;
-						pos.x = vp->pos.x;
-						pos.y = vp->pos.y;
-						transform_translate(&transform, -pos.x, -pos.y);
-
-						pixel_t ghost_color;
-
-						if (y_bnd_ghost == y_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
-							}
-						}
-
-						if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost == x_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
-							}
-						}
+				if (x_bnd_ghost == x_dmg_ghost) {
+					for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+					    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x, y);
+						surface_put_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
 					}
+				}
 
+				if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
+					for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+					    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
+						surface_put_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
+					}
 				}
 			}
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
+		}
+	}
 
-				/*
-				 * Determine what part of the pointer intersects with the
-				 * updated area of the current viewport.
-				 */
-				sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
-				surface_t *sf_ptr = ptr->cursor.states[ptr->state];
-				surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
-				bool isec_ptr = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
-				    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
-
-				if (isec_ptr) {
-					/*
-					 * Pointer is currently painted directly by copying pixels.
-					 * However, it is possible to draw the pointer similarly
-					 * as window by using drawctx_transfer. It would allow
-					 * more sophisticated control over drawing, but would also
-					 * cost more regarding the performance.
-					 */
-
-					sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
-					sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
-					sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
-					sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
-
-					for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
-						pixel_t *src = pixelmap_pixel_at(
-						    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
-						pixel_t *dst = pixelmap_pixel_at(
-						    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
-						sysarg_t count = w_dmg_ptr;
-						while (count-- != 0) {
-							*dst = (*src & 0xff000000) ? *src : *dst;
-							++dst;
-							++src;
-						}
-					}
-					surface_add_damaged_region(vp->surface, x_vp, y_vp, w_dmg_ptr, h_dmg_ptr);
-				}
+	list_foreach(pointer_list, link, pointer_t, ptr) {
 
+		/*
+		 * Determine what part of the pointer intersects with the
+		 * updated area of the current viewport.
+		 */
+		sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
+		surface_t *sf_ptr = ptr->cursor.states[ptr->state];
+		surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
+		bool isec_ptr = rectangle_intersect(
+		    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
+		    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
+		    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
+
+		if (isec_ptr) {
+			/*
+			 * Pointer is currently painted directly by copying pixels.
+			 * However, it is possible to draw the pointer similarly
+			 * as window by using drawctx_transfer. It would allow
+			 * more sophisticated control over drawing, but would also
+			 * cost more regarding the performance.
+			 */
+
+			sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
+			sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
+			sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
+			sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
+
+			for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
+				pixel_t *src = pixelmap_pixel_at(
+				    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
+				pixel_t *dst = pixelmap_pixel_at(
+				    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
+				sysarg_t count = w_dmg_ptr;
+				while (count-- != 0) {
+					*dst = (*src & 0xff000000) ? *src : *dst;
+					++dst;
+					++src;
+				}
 			}
+			surface_add_damaged_region(vp->surface, x_vp, y_vp, w_dmg_ptr, h_dmg_ptr);
+		}
+
+	}
+}
+
+/** Repaint damaged areas of all viewports and notify visualizers. */
+static void comp_repaint(const region_t *damage)
+{
+	fibril_mutex_lock(&viewport_list_mtx);
+	fibril_mutex_lock(&window_list_mtx);
+	fibril_mutex_lock(&pointer_list_mtx);
+
+	list_foreach(viewport_list, link, viewport_t, vp) {
+		sysarg_t w_vp, h_vp;
+		surface_get_resolution(vp->surface, &w_vp, &h_vp);
+		region_rect_t vp_rect;
+		region_rect_init(&vp_rect, vp->pos.x, vp->pos.y, w_vp, h_vp);
+
+		for (size_t i = 0; i < damage->count; ++i) {
+			region_rect_t dmg;
+			if (region_rect_intersect(&damage->rects[i], &vp_rect, &dmg))
+				comp_paint_rect(vp, &dmg);
 		}
 	}
 
@@ -596,17 +674,65 @@ static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
 	/* Notify visualizers about updated regions. */
 	if (active) {
 		list_foreach(viewport_list, link, viewport_t, vp) {
-			sysarg_t x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp;
-			surface_get_damaged_region(vp->surface, &x_dmg_vp, &y_dmg_vp, &w_dmg_vp, &h_dmg_vp);
+			sysarg_t w_vp, h_vp;
+			surface_get_resolution(vp->surface, &w_vp, &h_vp);
+			region_rect_t vp_rect;
+			region_rect_init(&vp_rect, vp->pos.x, vp->pos.y, w_vp, h_vp);
+
 			surface_reset_damaged_region(vp->surface);
-			visualizer_update_damaged_region(vp->sess,
-			    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp, 0, 0);
+			for (size_t i = 0; i < damage->count; ++i) {
+				region_rect_t dmg;
+				if (!region_rect_intersect(&damage->rects[i],
+				    &vp_rect, &dmg))
+					continue;
+
+				visualizer_update_damaged_region(vp->sess,
+				    dmg.x0 - vp->pos.x, dmg.y0 - vp->pos.y,
+				    dmg.x1 - dmg.x0, dmg.y1 - dmg.y0, 0, 0);
+			}
 		}
 	}
 
 	fibril_mutex_unlock(&viewport_list_mtx);
 }
 
+/** Repaint fibril.
+ *
+ * Damage reported while a frame is being painted is accumulated and painted
+ * at once in the next frame, so that a burst of client updates results in a
+ * single repaint.
+ */
+static errno_t comp_repaint_fibril(void *arg)
+{
+	region_t damage;
+
+	while (true) {
+		fibril_mutex_lock(&damage_mtx);
+		while (region_empty(&damage_region))
+			fibril_condvar_wait(&damage_cv, &damage_mtx);
+		damage = damage_region;
+		region_init(&damage_region);
+		fibril_mutex_unlock(&damage_mtx);
+
+		comp_repaint(&damage);
+	}
+
+	return EOK;
+}
+
+/** Schedule repaint of an area given in global coordinates. */
+static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
+    sysarg_t w_dmg_glob, sysarg_t h_dmg_glob)
+{
+	region_rect_t rect;
+	region_rect_init(&rect, x_dmg_glob, y_dmg_glob, w_dmg_glob, h_dmg_glob);
+
+	fibril_mutex_lock(&damage_mtx);
+	region_add_rect(&damage_region, &rect);
+	fibril_condvar_signal(&damage_cv);
+	fibril_mutex_unlock(&damage_mtx);
+}
+
 static void comp_window_get_event(window_t *win, ipc_call_t *icall)
 {
 	window_event_t *event = (window_event_t *) prodcons_consume(&win->queue);
@@ -2326,6 +2452,14 @@ static errno_t compositor_srv_init(char *input_svc, char *name)
 		return rc;
 	}
 
+	fid_t fid = fibril_create(comp_repaint_fibril, NULL);
+	if (fid == 0) {
+		printf("%s: Failed to create repaint fibril\n", NAME);
+		input_disconnect();
+		return ENOMEM;
+	}
+	fibril_add_ready(fid);
+
 	discover_viewports();
 
 	comp_restrict_pointers();
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup compositor
+ * @{
+ */
+/** @file
+ *
+ * Simple rectangle region algebra.
+ *
+ * Regions are kept as short lists of rectangles. Regions built by
+ * region_set_rect(), region_intersect_rect() and region_subtract_rect()
+ * consist of disjoint rectangles, so every point is painted at most once when
+ * the rectangles are processed one by one. Regions built by region_add_rect()
+ * might overlap, which is harmless for accumulating damage.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include "region.h"
+
+/** Initialize rectangle from position and size.
+ *
+ * The far edges saturate, so that the whole screen can be described as
+ * (0, 0, UINT32_MAX, UINT32_MAX) as is customary in the compositor.
+ */
+void region_rect_init(region_rect_t *rect, sysarg_t x, sysarg_t y,
+    sysarg_t w, sysarg_t h)
+{
+	rect->x0 = x;
+	rect->y0 = y;
+	rect->x1 = (w > UINTPTR_MAX - x) ? UINTPTR_MAX : x + w;
+	rect->y1 = (h > UINTPTR_MAX - y) ? UINTPTR_MAX : y + h;
+}
+
+static bool rect_empty(const region_rect_t *rect)
+{
+	return (rect->x0 >= rect->x1) || (rect->y0 >= rect->y1);
+}
+
+static uint64_t rect_area(const region_rect_t *rect)
+{
+	return (uint64_t) (rect->x1 - rect->x0) * (rect->y1 - rect->y0);
+}
+
+static bool rect_contains(const region_rect_t *outer,
+    const region_rect_t *inner)
+{
+	return (outer->x0 <= inner->x0) && (outer->y0 <= inner->y0) &&
+	    (outer->x1 >= inner->x1) && (outer->y1 >= inner->y1);
+}
+
+static void rect_bound(const region_rect_t *a, const region_rect_t *b,
+    region_rect_t *out)
+{
+	out->x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+	out->y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+	out->x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+	out->y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+}
+
+/** Intersect two rectangles.
+ *
+ * @return True if the intersection is not empty.
+ */
+bool region_rect_intersect(const region_rect_t *a, const region_rect_t *b,
+    region_rect_t *out)
+{
+	region_rect_t isec;
+	isec.x0 = (a->x0 > b->x0) ? a->x0 : b->x0;
+	isec.y0 = (a->y0 > b->y0) ? a->y0 : b->y0;
+	isec.x1 = (a->x1 < b->x1) ? a->x1 : b->x1;
+	isec.y1 = (a->y1 < b->y1) ? a->y1 : b->y1;
+
+	if (rect_empty(&isec))
+		return false;
+
+	*out = isec;
+	return true;
+}
+
+void region_init(region_t *region)
+{
+	region->count = 0;
+}
+
+void region_set_rect(region_t *region, const region_rect_t *rect)
+{
+	region->count = 0;
+	if (!rect_empty(rect))
+		region->rects[region->count++] = *rect;
+}
+
+static void region_remove(region_t *region, size_t i)
+{
+	assert(i < region->count);
+	region->rects[i] = region->rects[--region->count];
+}
+
+/** Add rectangle to the region.
+ *
+ * Rectangles which can be joined with the new one without covering any
+ * extra area are merged. If the region is full, the new rectangle is merged
+ * with the one whose bounding box grows the least.
+ */
+void region_add_rect(region_t *region, const region_rect_t *rect)
+{
+	if (rect_empty(rect))
+		return;
+
+	region_rect_t add = *rect;
+
+	bool merged;
+	do {
+		merged = false;
+		for (size_t i = 0; i < region->count; i++) {
+			region_rect_t *cur = &region->rects[i];
+			if (rect_contains(cur, &add))
+				return;
+
+			region_rect_t bound;
+			rect_bound(cur, &add, &bound);
+
+			region_rect_t isec;
+			uint64_t overlap = region_rect_intersect(cur, &add, &isec) ?
+			    rect_area(&isec) : 0;
+
+			if (rect_area(&bound) + overlap <=
+			    rect_area(cur) + rect_area(&add)) {
+				add = bound;
+				region_remove(region, i);
+				merged = true;
+				break;
+			}
+		}
+	} while (merged);
+
+	if (region->count == REGION_MAX_RECTS) {
+		size_t best = 0;
+		uint64_t best_growth = UINT64_MAX;
+		for (size_t i = 0; i < region->count; i++) {
+			region_rect_t bound;
+			rect_bound(&region->rects[i], &add, &bound);
+			uint64_t growth = rect_area(&bound) -
+			    rect_area(&region->rects[i]);
+			if (growth < best_growth) {
+				best = i;
+				best_growth = growth;
+			}
+		}
+
+		rect_bound(&region->rects[best], &add, &add);
+		region_remove(region, best);
+
+		/* The bigger rectangle may have swallowed others. */
+		region_add_rect(region, &add);
+		return;
+	}
+
+	region->rects[region->count++] = add;
+}
+
+/** Intersect region with a rectangle.
+ *
+ * @param dst Region to store the result to.
+ * @param src Source region.
+ * @param rect Rectangle to intersect the source region with.
+ */
+void region_intersect_rect(region_t *dst, const region_t *src,
+    const region_rect_t *rect)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < src->count; i++) {
+		if (region_rect_intersect(&src->rects[i], rect,
+		    &dst->rects[count]))
+			count++;
+	}
+
+	dst->count = count;
+}
+
+/** Subtract rectangle from the region.
+ *
+ * Each rectangle partially covered by @a rect is split into up to four
+ * disjoint pieces.
+ *
+ * @return False if the result would not fit into the region, in which case
+ *         the region is left unchanged.
+ */
+bool region_subtract_rect(region_t *region, const region_rect_t *rect)
+{
+	region_rect_t res[REGION_MAX_RECTS];
+	size_t count = 0;
+
+	for (size_t i = 0; i < region->count; i++) {
+		const region_rect_t *cur = &region->rects[i];
+		region_rect_t isec;
+
+		if (!region_rect_intersect(cur, rect, &isec)) {
+			if (count == REGION_MAX_RECTS)
+				return false;
+			res[count++] = *cur;
+			continue;
+		}
+
+		region_rect_t pieces[4];
+		size_t npieces = 0;
+
+		/* Band above the intersection. */
+		if (cur->y0 < isec.y0) {
+			region_rect_init(&pieces[npieces++], cur->x0, cur->y0,
+			    cur->x1 - cur->x0, isec.y0 - cur->y0);
+		}
+
+		/* Band below the intersection. */
+		if (isec.y1 < cur->y1) {
+			region_rect_init(&pieces[npieces++], cur->x0, isec.y1,
+			    cur->x1 - cur->x0, cur->y1 - isec.y1);
+		}
+
+		/* Left and right of the intersection. */
+		if (cur->x0 < isec.x0) {
+			region_rect_init(&pieces[npieces++], cur->x0, isec.y0,
+			    isec.x0 - cur->x0, isec.y1 - isec.y0);
+		}
+
+		if (isec.x1 < cur->x1) {
+			region_rect_init(&pieces[npieces++], isec.x1, isec.y0,
+			    cur->x1 - isec.x1, isec.y1 - isec.y0);
+		}
+
+		if (count + npieces > REGION_MAX_RECTS)
+			return false;
+
+		for (size_t j = 0; j < npieces; j++)
+			res[count++] = pieces[j];
+	}
+
+	for (size_t i = 0; i < count; i++)
+		region->rects[i] = res[i];
+	region->count = count;
+	return true;
+}
+
+/** @}
+ */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup compositor
+ * @{
+ */
+/** @file
+ */
+
+#ifndef COMPOSITOR_REGION_H_
+#define COMPOSITOR_REGION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <types/common.h>
+
+/** Maximal number of rectangles forming a region. */
+#define REGION_MAX_RECTS  32
+
+/** Rectangle spanning [x0, x1) x [y0, y1). */
+typedef struct {
+	sysarg_t x0;
+	sysarg_t y0;
+	sysarg_t x1;
+	sysarg_t y1;
+} region_rect_t;
+
+/** Set of screen areas described by a list of rectangles. */
+typedef struct {
+	size_t count;
+	region_rect_t rects[REGION_MAX_RECTS];
+} region_t;
+
+extern void region_rect_init(region_rect_t *, sysarg_t, sysarg_t, sysarg_t,
+    sysarg_t);
+extern bool region_rect_intersect(const region_rect_t *, const region_rect_t *,
+    region_rect_t *);
+
+extern void region_init(region_t *);
+extern void region_set_rect(region_t *, const region_rect_t *);
+extern void region_add_rect(region_t *, const region_rect_t *);
+extern void region_intersect_rect(region_t *, const region_t *,
+    const region_rect_t *);
+extern bool region_subtract_rect(region_t *, const region_rect_t *);
+
+/** Test whether the region covers no area. */
+static inline bool region_empty(const region_t *region)
+{
+	return region->count == 0;
+}
+
+#endif
+
+/** @}
+ */
@@ -46,9 +46,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -93,8 +90,17 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
-errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
-    addr48_t mac_addr)
+/** Translate IPv4 address to MAC address.
+ *
+ * Does not block. If the address is not resolved yet, the caller should
+ * queue the frame using arp_enqueue().
+ *
+ * @param nic NIC
+ * @param ip_addr IPv4 address to translate
+ * @param mac_addr Place to store MAC address
+ * @return EOK on success, ENOENT if the address is not resolved
+ */
+errno_t arp_translate(ethip_nic_t *nic, addr32_t ip_addr, addr48_t mac_addr)
 {
 	/* Broadcast address */
 	if (ip_addr == addr32_broadcast_all_hosts) {
@@ -102,10 +108,44 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 		return EOK;
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return atrans_lookup(ip_addr, mac_addr);
+}
 
+/** Queue frame until the destination address is resolved.
+ *
+ * Sends an ARP request if no resolution is in progress for the address.
+ *
+ * @param nic NIC to send the frame through
+ * @param src_addr Source IPv4 address
+ * @param ip_addr Destination IPv4 address
+ * @param data Encoded Ethernet frame, consumed by this function
+ * @param size Frame size
+ * @return EOK on success or an error code
+ */
+errno_t arp_enqueue(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size)
+{
+	bool query;
+
+	errno_t rc = atrans_enqueue(nic, src_addr, ip_addr, data, size, &query);
+	if (rc != EOK)
+		return rc;
+
+	if (query)
+		return arp_request(nic, src_addr, ip_addr);
+
+	return EOK;
+}
+
+/** Send ARP request.
+ *
+ * @param nic NIC
+ * @param src_addr Source IPv4 address
+ * @param ip_addr IPv4 address to resolve
+ * @return EOK on success or an error code
+ */
+errno_t arp_request(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr)
+{
 	arp_eth_packet_t packet;
 
 	packet.opcode = aop_request;
@@ -114,11 +154,7 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 	addr48(addr48_broadcast, packet.target_hw_addr);
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
-
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	return arp_send_packet(nic, &packet);
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
@@ -34,53 +34,198 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
 #include <stdlib.h>
 
+#include "arp.h"
 #include "atrans.h"
 #include "ethip.h"
+#include "ethip_nic.h"
+#include "std.h"
 
-/** Address translation list (of ethip_atrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+/** Interval between address translation table maintenance runs (usec) */
+#define ATRANS_GC_INTERVAL (1000 * 1000)
+/** Time after which a reachable entry becomes stale (nsec) */
+#define ATRANS_REACHABLE_TIME (SEC2NSEC(30))
+/** Time after which an unused stale entry is discarded (nsec) */
+#define ATRANS_STALE_TIME (SEC2NSEC(120))
+/** Maximum number of ARP requests sent for an unresolved address */
+#define ATRANS_MAX_PROBES 3
+/** Maximum number of frames queued on an unresolved entry */
+#define ATRANS_MAX_PENDING 16
 
-static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+/** Address translation table (of ethip_atrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(atrans_table_lock);
+static hash_table_t atrans_table;
+/** Maintenance timer */
+static fibril_timer_t *atrans_gc_timer;
+
+static size_t atrans_key_hash(const void *key)
+{
+	const addr32_t *ip_addr = key;
+	return hash_mix(*ip_addr);
+}
+
+static size_t atrans_hash(const ht_link_t *item)
+{
+	ethip_atrans_t *atrans =
+	    hash_table_get_inst(item, ethip_atrans_t, atrans_link);
+
+	return hash_mix(atrans->ip_addr);
+}
+
+static bool atrans_key_equal(const void *key, const ht_link_t *item)
+{
+	const addr32_t *ip_addr = key;
+	ethip_atrans_t *atrans =
+	    hash_table_get_inst(item, ethip_atrans_t, atrans_link);
+
+	return atrans->ip_addr == *ip_addr;
+}
+
+/** Operations for address translation table. */
+static hash_table_ops_t atrans_table_ops = {
+	.hash = atrans_hash,
+	.key_hash = atrans_key_hash,
+	.key_equal = atrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static void atrans_gc(void *);
+
+/** Initialize address translation table.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_init(void)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
+	if (!hash_table_create(&atrans_table, 0, 0, &atrans_table_ops))
+		return ENOMEM;
+
+	atrans_gc_timer = fibril_timer_create(NULL);
+	if (atrans_gc_timer == NULL) {
+		hash_table_destroy(&atrans_table);
+		return ENOMEM;
 	}
 
-	return NULL;
+	fibril_timer_set(atrans_gc_timer, ATRANS_GC_INTERVAL, atrans_gc, NULL);
+	return EOK;
 }
 
-errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+{
+	ht_link_t *link = hash_table_find(&atrans_table, &ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ethip_atrans_t, atrans_link);
+}
+
+/** Create new incomplete entry and insert it into the table. */
+static ethip_atrans_t *atrans_create(ethip_nic_t *nic, addr32_t src_addr,
+    addr32_t ip_addr)
 {
 	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
 
 	atrans = calloc(1, sizeof(ethip_atrans_t));
 	if (atrans == NULL)
-		return ENOMEM;
+		return NULL;
 
 	atrans->ip_addr = ip_addr;
-	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = ats_incomplete;
+	getuptime(&atrans->changed);
+	atrans->nic = nic;
+	atrans->src_addr = src_addr;
+	list_initialize(&atrans->pending);
+
+	hash_table_insert(&atrans_table, &atrans->atrans_link);
+	return atrans;
+}
+
+/** Discard all frames in a pending list. */
+static void atrans_pending_discard(list_t *pending)
+{
+	link_t *link;
+
+	while ((link = list_first(pending)) != NULL) {
+		ethip_atrans_pending_t *pkt = list_get_instance(link,
+		    ethip_atrans_pending_t, link);
+
+		list_remove(&pkt->link);
+		free(pkt->data);
+		free(pkt);
+	}
+}
+
+/** Fill in destination address and send all frames in a pending list. */
+static void atrans_pending_flush(list_t *pending, addr48_t mac_addr)
+{
+	link_t *link;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+	while ((link = list_first(pending)) != NULL) {
+		ethip_atrans_pending_t *pkt = list_get_instance(link,
+		    ethip_atrans_pending_t, link);
+		eth_header_t *hdr = (eth_header_t *) pkt->data;
+
+		list_remove(&pkt->link);
+		addr48(mac_addr, hdr->dest);
+		(void) ethip_nic_send(pkt->nic, pkt->data, pkt->size);
+		free(pkt->data);
+		free(pkt);
 	}
+}
+
+/** Remove entry from table and destroy it. */
+static void atrans_destroy(ethip_atrans_t *atrans)
+{
+	hash_table_remove_item(&atrans_table, &atrans->atrans_link);
+	atrans_pending_discard(&atrans->pending);
+	free(atrans);
+}
+
+/** Add or confirm address translation.
+ *
+ * Frames queued while waiting for the translation are sent.
+ *
+ * @param ip_addr IPv4 address
+ * @param mac_addr MAC address
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+{
+	ethip_atrans_t *atrans;
+	list_t pending;
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+	list_initialize(&pending);
 
+	fibril_mutex_lock(&atrans_table_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		atrans = atrans_create(NULL, 0, ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_table_lock);
+			return ENOMEM;
+		}
+	}
+
+	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = ats_reachable;
+	getuptime(&atrans->changed);
+	atrans->used = false;
+	atrans->probes = 0;
+
+	list_concat(&pending, &atrans->pending);
+	atrans->npending = 0;
+	fibril_mutex_unlock(&atrans_table_lock);
+
+	atrans_pending_flush(&pending, mac_addr);
 	return EOK;
 }
 
@@ -88,77 +233,191 @@ errno_t atrans_remove(addr32_t ip_addr)
 {
 	ethip_atrans_t *atrans;
 
-	fibril_mutex_lock(&atrans_list_lock);
+	fibril_mutex_lock(&atrans_table_lock);
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
+		fibril_mutex_unlock(&atrans_table_lock);
 		return ENOENT;
 	}
 
-	list_remove(&atrans->atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+	atrans_destroy(atrans);
+	fibril_mutex_unlock(&atrans_table_lock);
 
 	return EOK;
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, addr48_t mac_addr)
+/** Look up address translation.
+ *
+ * @param ip_addr IPv4 address
+ * @param mac_addr Place to store MAC address
+ * @return EOK on success, ENOENT if the address is not resolved
+ */
+errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+
+	fibril_mutex_lock(&atrans_table_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL || atrans->state == ats_incomplete) {
+		fibril_mutex_unlock(&atrans_table_lock);
 		return ENOENT;
+	}
+
+	if (atrans->state == ats_stale)
+		atrans->used = true;
 
 	addr48(atrans->mac_addr, mac_addr);
+	fibril_mutex_unlock(&atrans_table_lock);
+
 	return EOK;
 }
 
-errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
+/** Queue frame until its destination address is resolved.
+ *
+ * If the address has been resolved in the meantime, the frame is sent
+ * right away. The frame data is consumed in any case.
+ *
+ * @param nic NIC to send the frame through
+ * @param src_addr Source IPv4 address to use in ARP requests
+ * @param ip_addr IPv4 address to resolve
+ * @param data Encoded Ethernet frame (allocated with malloc())
+ * @param size Frame size
+ * @param query Place to store @c true iff an ARP request should be sent
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_enqueue(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size, bool *query)
 {
-	errno_t rc;
+	ethip_atrans_t *atrans;
+	ethip_atrans_pending_t *pkt;
+	addr48_t mac_addr;
+	list_t pending;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
+	*query = false;
+	list_initialize(&pending);
 
-	return rc;
-}
+	pkt = calloc(1, sizeof(ethip_atrans_pending_t));
+	if (pkt == NULL) {
+		free(data);
+		return ENOMEM;
+	}
 
-static void atrans_lookup_timeout_handler(void *arg)
-{
-	bool *timedout = (bool *)arg;
+	link_initialize(&pkt->link);
+	pkt->nic = nic;
+	pkt->data = data;
+	pkt->size = size;
+
+	fibril_mutex_lock(&atrans_table_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		atrans = atrans_create(nic, src_addr, ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_table_lock);
+			free(data);
+			free(pkt);
+			return ENOMEM;
+		}
+
+		atrans->probes = 1;
+		*query = true;
+	}
+
+	if (atrans->state != ats_incomplete) {
+		/* Resolved while the frame was being prepared */
+		addr48(atrans->mac_addr, mac_addr);
+		fibril_mutex_unlock(&atrans_table_lock);
+
+		list_append(&pkt->link, &pending);
+		atrans_pending_flush(&pending, mac_addr);
+		return EOK;
+	}
+
+	if (atrans->npending >= ATRANS_MAX_PENDING) {
+		/* Drop oldest frame */
+		link_t *link = list_first(&atrans->pending);
+		list_remove(link);
+		list_append(link, &pending);
+		--atrans->npending;
+	}
+
+	list_append(&pkt->link, &atrans->pending);
+	++atrans->npending;
+	fibril_mutex_unlock(&atrans_table_lock);
 
-	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+	atrans_pending_discard(&pending);
+	return EOK;
 }
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    addr48_t mac_addr)
+/** Age a single address translation table entry.
+ *
+ * @return @c true to continue walking the table
+ */
+static bool atrans_gc_entry(ht_link_t *item, void *arg)
 {
-	fibril_timer_t *t;
-	bool timedout;
-	errno_t rc;
+	ethip_atrans_t *atrans =
+	    hash_table_get_inst(item, ethip_atrans_t, atrans_link);
+	struct timespec *now = (struct timespec *) arg;
+	nsec_t age = ts_sub_diff(now, &atrans->changed);
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
-		return ENOMEM;
-
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+	switch (atrans->state) {
+	case ats_incomplete:
+		if (atrans->probes >= ATRANS_MAX_PROBES) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed to resolve "
+			    "IPv4 address 0x%" PRIx32, atrans->ip_addr);
+			atrans_destroy(atrans);
+			break;
+		}
 
-	fibril_mutex_lock(&atrans_list_lock);
+		++atrans->probes;
+		(void) arp_request(atrans->nic, atrans->src_addr,
+		    atrans->ip_addr);
+		break;
+	case ats_reachable:
+		if (age >= ATRANS_REACHABLE_TIME) {
+			atrans->state = ats_stale;
+			atrans->changed = *now;
+			atrans->used = false;
+		}
+		break;
+	case ats_stale:
+		if (atrans->used && atrans->nic != NULL) {
+			/* Entry still in use, try to confirm it */
+			if (atrans->probes >= ATRANS_MAX_PROBES) {
+				atrans_destroy(atrans);
+				break;
+			}
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+			++atrans->probes;
+			atrans->used = false;
+			(void) arp_request(atrans->nic, atrans->src_addr,
+			    atrans->ip_addr);
+		} else if (age >= ATRANS_STALE_TIME) {
+			atrans_destroy(atrans);
+		}
+		break;
 	}
 
-	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	return true;
+}
+
+/** Address translation table maintenance.
+ *
+ * Retransmits ARP requests for unresolved entries, ages resolved entries
+ * and discards entries that have not been used or confirmed for a long
+ * time.
+ */
+static void atrans_gc(void *arg)
+{
+	struct timespec now;
+
+	getuptime(&now);
+
+	fibril_mutex_lock(&atrans_table_lock);
+	hash_table_apply(&atrans_table, atrans_gc_entry, &now);
+	fibril_mutex_unlock(&atrans_table_lock);
 
-	return rc;
+	fibril_timer_set(atrans_gc_timer, ATRANS_GC_INTERVAL, atrans_gc, NULL);
 }
 
 /** @}
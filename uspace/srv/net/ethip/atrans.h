@@ -39,12 +39,15 @@
 
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <stdbool.h>
 #include "ethip.h"
 
+extern errno_t atrans_init(void);
 extern errno_t atrans_add(addr32_t, addr48_t);
 extern errno_t atrans_remove(addr32_t);
 extern errno_t atrans_lookup(addr32_t, addr48_t);
-extern errno_t atrans_lookup_timeout(addr32_t, usec_t, addr48_t);
+extern errno_t atrans_enqueue(ethip_nic_t *, addr32_t, addr32_t, void *,
+    size_t, bool *);
 
 #endif
 
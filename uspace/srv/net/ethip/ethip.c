@@ -41,10 +41,12 @@
 #include <inet/iplink_srv.h>
 #include <io/log.h>
 #include <loc.h>
+#include <mem.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <task.h>
 #include "arp.h"
+#include "atrans.h"
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
@@ -80,7 +82,14 @@ static errno_t ethip_init(void)
 {
 	async_set_fallback_port_handler(ethip_client_conn, NULL);
 
-	errno_t rc = loc_server_register(NAME);
+	errno_t rc = atrans_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing address "
+		    "translation table.");
+		return rc;
+	}
+
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed registering server.");
 		return rc;
@@ -176,12 +185,9 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	eth_frame_t frame;
 
-	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, frame.dest);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to look up IPv4 address 0x%"
-		    PRIx32, sdu->dest);
-		return rc;
-	}
+	bool resolved = arp_translate(nic, sdu->dest, frame.dest) == EOK;
+	if (!resolved)
+		memset(frame.dest, 0, sizeof(frame.dest));
 
 	addr48(nic->mac_addr, frame.src);
 	frame.etype_len = ETYPE_IP;
@@ -190,10 +196,15 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 	void *data;
 	size_t size;
-	rc = eth_pdu_encode(&frame, &data, &size);
+	errno_t rc = eth_pdu_encode(&frame, &data, &size);
 	if (rc != EOK)
 		return rc;
 
+	if (!resolved) {
+		/* Frame is sent once the destination address is resolved */
+		return arp_enqueue(nic, sdu->src, sdu->dest, data, size);
+	}
+
 	rc = ethip_nic_send(nic, data, size);
 	free(data);
 
@@ -37,6 +37,7 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
 #include <inet/iplink_srv.h>
@@ -44,6 +45,7 @@
 #include <loc.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct {
 	link_t link;
@@ -108,13 +110,52 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
+/** Address translation entry state */
+typedef enum {
+	/** Address resolution in progress */
+	ats_incomplete,
+	/** Translation recently confirmed */
+	ats_reachable,
+	/** Translation not confirmed recently, but still usable */
+	ats_stale
+} ethip_atrans_state_t;
+
 /** Address translation table element */
 typedef struct {
-	link_t atrans_list;
+	/** Link to address translation table */
+	ht_link_t atrans_link;
 	addr32_t ip_addr;
 	addr48_t mac_addr;
+	/** Entry state */
+	ethip_atrans_state_t state;
+	/** Time of last state change */
+	struct timespec changed;
+	/** Entry has been used since it became stale */
+	bool used;
+	/** NIC to send ARP requests through */
+	ethip_nic_t *nic;
+	/** Source address for ARP requests */
+	addr32_t src_addr;
+	/** Number of ARP requests sent without reply */
+	unsigned probes;
+	/** Frames awaiting resolution (of ethip_atrans_pending_t) */
+	list_t pending;
+	/** Number of entries in @c pending */
+	size_t npending;
 } ethip_atrans_t;
 
+/** Frame awaiting address resolution */
+typedef struct {
+	/** Link to ethip_atrans_t.pending */
+	link_t link;
+	/** NIC to send the frame through */
+	ethip_nic_t *nic;
+	/** Encoded Ethernet frame, destination address to be filled in */
+	void *data;
+	/** Frame size */
+	size_t size;
+} ethip_atrans_pending_t;
+
 extern errno_t ethip_iplink_init(ethip_nic_t *);
 extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
 
@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <align.h>
 #include <async.h>
 #include <stdbool.h>
 #include <errno.h>
@@ -282,6 +283,43 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_received_batch(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	uint8_t *data;
+	size_t size;
+	size_t offs;
+	uint32_t fsize;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() nic=%p", nic);
+
+	rc = async_data_write_accept((void **) &data, false, 0, 0, 0, &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		return;
+	}
+
+	offs = 0;
+	while (offs < size && size - offs >= sizeof(uint32_t)) {
+		memcpy(&fsize, data + offs, sizeof(uint32_t));
+		if (fsize > size - offs - sizeof(uint32_t)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Truncated frame batch");
+			rc = EINVAL;
+			break;
+		}
+
+		(void) ethip_received(&nic->iplink, data + offs +
+		    sizeof(uint32_t), fsize);
+		offs += ALIGN_UP(sizeof(uint32_t) + fsize, NIC_BATCH_ALIGN);
+	}
+
+	free(data);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() done, rc=%s",
+	    str_error_name(rc));
+	async_answer_0(call, rc);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -313,6 +351,9 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RECEIVED_BATCH:
+			ethip_nic_received_batch(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
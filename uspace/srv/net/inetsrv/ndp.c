@@ -44,9 +44,6 @@
 #include "inet_link.h"
 #include "ndp.h"
 
-/** Time to wait for NDP reply in microseconds */
-#define NDP_REQUEST_TIMEOUT  (3 * 1000 * 1000)
-
 static addr128_t solicited_node_ip =
     { 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0, 0, 0 };
 
@@ -141,17 +138,18 @@ errno_t ndp_received(inet_dgram_t *dgram)
 
 /** Translate IPv6 to MAC address
  *
- * @param src  Source IPv6 address
- * @param dest Destination IPv6 address
- * @param mac  Target MAC address to be assigned
- * @param link Network interface
+ * Does not block. If the address is not resolved yet, the datagram
+ * should be queued using ndp_enqueue().
+ *
+ * @param ip_addr  Destination IPv6 address
+ * @param mac_addr Target MAC address to be assigned
+ * @param ilink    Network interface
  *
  * @return EOK on success
- * @return ENOENT when NDP translation failed
+ * @return ENOENT when the address is not resolved
  *
  */
-errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
-    inet_link_t *ilink)
+errno_t ndp_translate(addr128_t ip_addr, addr48_t mac_addr, inet_link_t *ilink)
 {
 	if (!ilink->mac_valid) {
 		/* The link does not support NDP */
@@ -159,10 +157,52 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
 		return EOK;
 	}
 
-	errno_t rc = ntrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return ntrans_lookup(ip_addr, mac_addr);
+}
+
+/** Queue datagram until the destination address is resolved
+ *
+ * Sends a neighbour solicitation if no resolution is in progress
+ * for the address.
+ *
+ * @param src_addr Source IPv6 address
+ * @param ip_addr  Destination IPv6 address
+ * @param ilink    Network interface
+ * @param dgram    Datagram
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment flag
+ *
+ * @return EOK on success or an error code
+ *
+ */
+errno_t ndp_enqueue(addr128_t src_addr, addr128_t ip_addr, inet_link_t *ilink,
+    inet_dgram_t *dgram, uint8_t proto, uint8_t ttl, int df)
+{
+	bool query;
+
+	errno_t rc = ntrans_enqueue(ilink, src_addr, ip_addr, dgram, proto, ttl,
+	    df, &query);
+	if (rc != EOK)
+		return rc;
 
+	if (query)
+		return ndp_solicit(ilink, src_addr, ip_addr);
+
+	return EOK;
+}
+
+/** Send neighbour solicitation
+ *
+ * @param ilink    Network interface
+ * @param src_addr Source IPv6 address
+ * @param ip_addr  IPv6 address to resolve
+ *
+ * @return EOK on success or an error code
+ *
+ */
+errno_t ndp_solicit(inet_link_t *ilink, addr128_t src_addr, addr128_t ip_addr)
+{
 	ndp_packet_t packet;
 
 	packet.opcode = ICMPV6_NEIGHBOUR_SOLICITATION;
@@ -172,11 +212,5 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
 	addr48_solicited_node(ip_addr, packet.target_hw_addr);
 	ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
 
-	rc = ndp_send_packet(ilink, &packet);
-	if (rc != EOK)
-		return rc;
-
-	(void) ntrans_wait_timeout(NDP_REQUEST_TIMEOUT);
-
-	return ntrans_lookup(ip_addr, mac_addr);
+	return ndp_send_packet(ilink, &packet);
 }
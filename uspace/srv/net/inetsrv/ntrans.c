@@ -34,17 +34,101 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
+#include "inet_link.h"
+#include "ndp.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
-static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+/** Interval between translation table maintenance runs (usec) */
+#define NTRANS_GC_INTERVAL (1000 * 1000)
+/** Time after which a reachable entry becomes stale (nsec) */
+#define NTRANS_REACHABLE_TIME (SEC2NSEC(30))
+/** Time after which an unused stale entry is discarded (nsec) */
+#define NTRANS_STALE_TIME (SEC2NSEC(120))
+/** Maximum number of solicitations sent for an unresolved address */
+#define NTRANS_MAX_PROBES 3
+/** Maximum number of datagrams queued on an unresolved entry */
+#define NTRANS_MAX_PENDING 16
+
+/** Address translation table (of inet_ntrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(ntrans_table_lock);
+static hash_table_t ntrans_table;
+/** Maintenance timer */
+static fibril_timer_t *ntrans_gc_timer;
+
+static size_t ntrans_addr_hash(const addr128_t addr)
+{
+	size_t hash = 0;
+	uint32_t word;
+
+	for (size_t i = 0; i < sizeof(addr128_t); i += sizeof(word)) {
+		memcpy(&word, addr + i, sizeof(word));
+		hash = hash_combine(hash, word);
+	}
+
+	return hash;
+}
+
+static size_t ntrans_key_hash(const void *key)
+{
+	return ntrans_addr_hash(key);
+}
+
+static size_t ntrans_hash(const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans =
+	    hash_table_get_inst(item, inet_ntrans_t, ntrans_link);
+
+	return ntrans_addr_hash(ntrans->ip_addr);
+}
+
+static bool ntrans_key_equal(const void *key, const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans =
+	    hash_table_get_inst(item, inet_ntrans_t, ntrans_link);
+
+	return addr128_compare(ntrans->ip_addr, key);
+}
+
+/** Operations for neighbour translation table. */
+static hash_table_ops_t ntrans_table_ops = {
+	.hash = ntrans_hash,
+	.key_hash = ntrans_key_hash,
+	.key_equal = ntrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static void ntrans_gc(void *);
+
+/** Initialize neighbour translation table.
+ *
+ * @return EOK on success
+ * @return ENOMEM if not enough memory
+ *
+ */
+errno_t ntrans_init(void)
+{
+	if (!hash_table_create(&ntrans_table, 0, 0, &ntrans_table_ops))
+		return ENOMEM;
+
+	ntrans_gc_timer = fibril_timer_create(NULL);
+	if (ntrans_gc_timer == NULL) {
+		hash_table_destroy(&ntrans_table);
+		return ENOMEM;
+	}
+
+	fibril_timer_set(ntrans_gc_timer, NTRANS_GC_INTERVAL, ntrans_gc, NULL);
+	return EOK;
+}
 
 /** Look for address in translation table
  *
@@ -55,15 +139,86 @@ static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
  */
 static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	ht_link_t *link = hash_table_find(&ntrans_table, ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_ntrans_t, ntrans_link);
+}
+
+/** Create new incomplete entry and insert it into translation table
+ *
+ * @param ilink    Link to send solicitations through or @c NULL
+ * @param src_addr Source address for solicitations
+ * @param ip_addr  IPv6 address of the new entry
+ *
+ * @return New entry or @c NULL if not enough memory
+ *
+ */
+static inet_ntrans_t *ntrans_create(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr)
+{
+	inet_ntrans_t *ntrans;
+
+	ntrans = calloc(1, sizeof(inet_ntrans_t));
+	if (ntrans == NULL)
+		return NULL;
+
+	addr128(ip_addr, ntrans->ip_addr);
+	ntrans->state = nts_incomplete;
+	getuptime(&ntrans->changed);
+	ntrans->ilink = ilink;
+	if (src_addr != NULL)
+		addr128(src_addr, ntrans->src_addr);
+	list_initialize(&ntrans->pending);
+
+	hash_table_insert(&ntrans_table, &ntrans->ntrans_link);
+	return ntrans;
+}
+
+/** Discard all datagrams in a pending list */
+static void ntrans_pending_discard(list_t *pending)
+{
+	link_t *link;
+
+	while ((link = list_first(pending)) != NULL) {
+		inet_ntrans_pending_t *pdg = list_get_instance(link,
+		    inet_ntrans_pending_t, link);
+
+		list_remove(&pdg->link);
+		free(pdg->dgram.data);
+		free(pdg);
 	}
+}
 
-	return NULL;
+/** Send all datagrams in a pending list to a resolved address */
+static void ntrans_pending_flush(list_t *pending, addr48_t mac_addr)
+{
+	link_t *link;
+
+	while ((link = list_first(pending)) != NULL) {
+		inet_ntrans_pending_t *pdg = list_get_instance(link,
+		    inet_ntrans_pending_t, link);
+
+		list_remove(&pdg->link);
+		(void) inet_link_send_dgram6(pdg->ilink, mac_addr,
+		    &pdg->dgram, pdg->proto, pdg->ttl, pdg->df);
+		free(pdg->dgram.data);
+		free(pdg);
+	}
 }
 
-/** Add entry to translation table
+/** Remove entry from translation table and destroy it */
+static void ntrans_destroy(inet_ntrans_t *ntrans)
+{
+	hash_table_remove_item(&ntrans_table, &ntrans->ntrans_link);
+	ntrans_pending_discard(&ntrans->pending);
+	free(ntrans);
+}
+
+/** Add or confirm entry in translation table
+ *
+ * Datagrams queued while waiting for the translation are sent.
  *
  * @param ip_addr  IPv6 address of the new entry
  * @param mac_addr MAC address of the new entry
@@ -75,26 +230,31 @@ static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
 {
 	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
-
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
-		return ENOMEM;
+	list_t pending;
 
-	addr128(ip_addr, ntrans->ip_addr);
-	addr48(mac_addr, ntrans->mac_addr);
+	list_initialize(&pending);
 
-	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
+	fibril_mutex_lock(&ntrans_table_lock);
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(NULL, NULL, ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_table_lock);
+			return ENOMEM;
+		}
 	}
 
-	list_append(&ntrans->ntrans_list, &ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
+	addr48(mac_addr, ntrans->mac_addr);
+	ntrans->state = nts_reachable;
+	getuptime(&ntrans->changed);
+	ntrans->used = false;
+	ntrans->probes = 0;
+
+	list_concat(&pending, &ntrans->pending);
+	ntrans->npending = 0;
+	fibril_mutex_unlock(&ntrans_table_lock);
 
+	ntrans_pending_flush(&pending, mac_addr);
 	return EOK;
 }
 
@@ -110,16 +270,15 @@ errno_t ntrans_remove(addr128_t ip_addr)
 {
 	inet_ntrans_t *ntrans;
 
-	fibril_mutex_lock(&ntrans_list_lock);
+	fibril_mutex_lock(&ntrans_table_lock);
 	ntrans = ntrans_find(ip_addr);
 	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
+		fibril_mutex_unlock(&ntrans_table_lock);
 		return ENOENT;
 	}
 
-	list_remove(&ntrans->ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
+	ntrans_destroy(ntrans);
+	fibril_mutex_unlock(&ntrans_table_lock);
 
 	return EOK;
 }
@@ -130,39 +289,192 @@ errno_t ntrans_remove(addr128_t ip_addr)
  * @param mac_addr MAC address to be assigned
  *
  * @return EOK on success
- * @return ENOENT when no such address found
+ * @return ENOENT when no such address found or it is not resolved yet
  *
  */
 errno_t ntrans_lookup(addr128_t ip_addr, addr48_t mac_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
+	fibril_mutex_lock(&ntrans_table_lock);
 	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
+	if (ntrans == NULL || ntrans->state == nts_incomplete) {
+		fibril_mutex_unlock(&ntrans_table_lock);
 		return ENOENT;
 	}
 
-	fibril_mutex_unlock(&ntrans_list_lock);
+	if (ntrans->state == nts_stale)
+		ntrans->used = true;
+
 	addr48(ntrans->mac_addr, mac_addr);
+	fibril_mutex_unlock(&ntrans_table_lock);
+	return EOK;
+}
+
+/** Queue datagram until its next hop address is resolved
+ *
+ * If the address has been resolved in the meantime, the datagram
+ * is sent right away.
+ *
+ * @param ilink    Link to send the datagram through
+ * @param src_addr Source address for neighbour solicitations
+ * @param ip_addr  Next hop IPv6 address
+ * @param dgram    Datagram (its data is copied)
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment flag
+ * @param query    Place to store @c true iff a solicitation should be sent
+ *
+ * @return EOK on success
+ * @return ENOMEM if not enough memory
+ *
+ */
+errno_t ntrans_enqueue(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr, inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
+    int df, bool *query)
+{
+	inet_ntrans_t *ntrans;
+	inet_ntrans_pending_t *pdg;
+	addr48_t mac_addr;
+	list_t pending;
+
+	*query = false;
+	list_initialize(&pending);
+
+	pdg = calloc(1, sizeof(inet_ntrans_pending_t));
+	if (pdg == NULL)
+		return ENOMEM;
+
+	link_initialize(&pdg->link);
+	pdg->ilink = ilink;
+	pdg->dgram = *dgram;
+	pdg->proto = proto;
+	pdg->ttl = ttl;
+	pdg->df = df;
+
+	pdg->dgram.data = malloc(dgram->size);
+	if (pdg->dgram.data == NULL) {
+		free(pdg);
+		return ENOMEM;
+	}
+
+	memcpy(pdg->dgram.data, dgram->data, dgram->size);
+
+	fibril_mutex_lock(&ntrans_table_lock);
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ilink, src_addr, ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_table_lock);
+			free(pdg->dgram.data);
+			free(pdg);
+			return ENOMEM;
+		}
+
+		ntrans->probes = 1;
+		*query = true;
+	}
+
+	if (ntrans->state != nts_incomplete) {
+		/* Resolved while the datagram was being prepared */
+		addr48(ntrans->mac_addr, mac_addr);
+		fibril_mutex_unlock(&ntrans_table_lock);
+
+		list_append(&pdg->link, &pending);
+		ntrans_pending_flush(&pending, mac_addr);
+		return EOK;
+	}
+
+	if (ntrans->npending >= NTRANS_MAX_PENDING) {
+		/* Drop oldest datagram */
+		link_t *link = list_first(&ntrans->pending);
+		list_remove(link);
+		list_append(link, &pending);
+		--ntrans->npending;
+	}
+
+	list_append(&pdg->link, &ntrans->pending);
+	++ntrans->npending;
+	fibril_mutex_unlock(&ntrans_table_lock);
+
+	ntrans_pending_discard(&pending);
 	return EOK;
 }
 
-/** Wait on translation table CV for some time
+/** Age a single translation table entry
  *
- * @param timeout Timeout in microseconds
+ * @param item Hash table item
+ * @param arg  Current time
  *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * @return Always @c true to continue walking the table
  *
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+static bool ntrans_gc_entry(ht_link_t *item, void *arg)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
-	fibril_mutex_unlock(&ntrans_list_lock);
+	inet_ntrans_t *ntrans =
+	    hash_table_get_inst(item, inet_ntrans_t, ntrans_link);
+	struct timespec *now = (struct timespec *) arg;
+	nsec_t age = ts_sub_diff(now, &ntrans->changed);
+
+	switch (ntrans->state) {
+	case nts_incomplete:
+		if (ntrans->probes >= NTRANS_MAX_PROBES) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed to resolve "
+			    "IPv6 address");
+			ntrans_destroy(ntrans);
+			break;
+		}
+
+		++ntrans->probes;
+		(void) ndp_solicit(ntrans->ilink, ntrans->src_addr,
+		    ntrans->ip_addr);
+		break;
+	case nts_reachable:
+		if (age >= NTRANS_REACHABLE_TIME) {
+			ntrans->state = nts_stale;
+			ntrans->changed = *now;
+			ntrans->used = false;
+		}
+		break;
+	case nts_stale:
+		if (ntrans->used && ntrans->ilink != NULL) {
+			/* Entry still in use, try to confirm it */
+			if (ntrans->probes >= NTRANS_MAX_PROBES) {
+				ntrans_destroy(ntrans);
+				break;
+			}
+
+			++ntrans->probes;
+			ntrans->used = false;
+			(void) ndp_solicit(ntrans->ilink, ntrans->src_addr,
+			    ntrans->ip_addr);
+		} else if (age >= NTRANS_STALE_TIME) {
+			ntrans_destroy(ntrans);
+		}
+		break;
+	}
+
+	return true;
+}
+
+/** Translation table maintenance
+ *
+ * Retransmits solicitations for unresolved entries, ages resolved
+ * entries and discards entries that have not been used or confirmed
+ * for a long time.
+ *
+ * @param arg Not used
+ *
+ */
+static void ntrans_gc(void *arg)
+{
+	struct timespec now;
+
+	getuptime(&now);
+
+	fibril_mutex_lock(&ntrans_table_lock);
+	hash_table_apply(&ntrans_table, ntrans_gc_entry, &now);
+	fibril_mutex_unlock(&ntrans_table_lock);
 
-	return rc;
+	fibril_timer_set(ntrans_gc_timer, NTRANS_GC_INTERVAL, ntrans_gc, NULL);
 }
 
 /** @}
@@ -37,20 +37,67 @@
 #ifndef NTRANS_H_
 #define NTRANS_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <stdbool.h>
+#include <time.h>
+#include "inetsrv.h"
+
+/** Neighbour translation entry state */
+typedef enum {
+	/** Address resolution in progress */
+	nts_incomplete,
+	/** Translation recently confirmed */
+	nts_reachable,
+	/** Translation not confirmed recently, but still usable */
+	nts_stale
+} inet_ntrans_state_t;
 
 /** Address translation table element */
 typedef struct {
-	link_t ntrans_list;
+	/** Link to neighbour translation table */
+	ht_link_t ntrans_link;
 	addr128_t ip_addr;
 	addr48_t mac_addr;
+	/** Entry state */
+	inet_ntrans_state_t state;
+	/** Time of last state change */
+	struct timespec changed;
+	/** Entry has been used since it became stale */
+	bool used;
+	/** Link to send neighbour solicitations through */
+	inet_link_t *ilink;
+	/** Source address for neighbour solicitations */
+	addr128_t src_addr;
+	/** Number of solicitations sent without reply */
+	unsigned probes;
+	/** Datagrams awaiting resolution (of inet_ntrans_pending_t) */
+	list_t pending;
+	/** Number of entries in @c pending */
+	size_t npending;
 } inet_ntrans_t;
 
+/** Datagram awaiting neighbour resolution */
+typedef struct {
+	/** Link to inet_ntrans_t.pending */
+	link_t link;
+	/** Link to send the datagram through */
+	inet_link_t *ilink;
+	/** Datagram (with its own copy of data) */
+	inet_dgram_t dgram;
+	uint8_t proto;
+	uint8_t ttl;
+	int df;
+} inet_ntrans_pending_t;
+
+extern errno_t ntrans_init(void);
 extern errno_t ntrans_add(addr128_t, addr48_t);
 extern errno_t ntrans_remove(addr128_t);
 extern errno_t ntrans_lookup(addr128_t, addr48_t);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_enqueue(inet_link_t *, addr128_t, addr128_t,
+    inet_dgram_t *, uint8_t, uint8_t, int, bool *);
 
 #endif
 
@@ -34,46 +34,198 @@
  * @brief Datagram reassembly.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <adt/odict.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
-/** Datagram being reassembled.
+/** Time after which an incomplete datagram is discarded (nsec) */
+#define REASS_TIMEOUT (SEC2NSEC(30))
+
+/** Maximum amount of memory used by all datagrams being reassembled */
+#define REASS_MEM_MAX (1024 * 1024)
+
+/** Datagram identification.
  *
- * Uniquely identified by (source address, destination address, protocol,
- * identification) per RFC 791 sec. 2.3 / Fragmentation.
+ * Uniquely identifies a datagram per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
-	/** List of fragments, @c reass_frag_t */
-	list_t frags;
+	inet_addr_t src;
+	inet_addr_t dest;
+	uint8_t proto;
+	uint32_t ident;
+} reass_key_t;
+
+/** Datagram being reassembled. */
+typedef struct {
+	/** Link to @c reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to @c reass_dgram_age */
+	link_t age_link;
+	/** Datagram identification */
+	reass_key_t key;
+	/** Time when the first fragment was received */
+	struct timespec created;
+	/** Fragments, @c reass_frag_t, ordered by offset, never overlapping */
+	odict_t frags;
+	/** Number of data bytes covered by fragments */
+	size_t covered;
+	/** Total datagram size, valid if @c have_last is @c true */
+	size_t size;
+	/** Fragment without the MF flag has been received */
+	bool have_last;
+	/** Memory charged to the datagram */
+	size_t mem;
 } reass_dgram_t;
 
 /** One datagram fragment */
 typedef struct {
-	link_t dgram_link;
+	/** Link to reass_dgram_t.frags */
+	odlink_t dgram_link;
+	/** Fragment data trimmed not to overlap other fragments */
 	inet_packet_t packet;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
-/** Protects access to @c reass_dgram_map */
+/** Datagram map, hash table of reass_dgram_t */
+static hash_table_t reass_dgram_map;
+/** Datagrams ordered by creation time, oldest first */
+static LIST_INITIALIZE(reass_dgram_age);
+/** Memory used by all datagrams being reassembled */
+static size_t reass_mem;
+/** Drop statistics */
+static inet_reass_stats_t reass_stats;
+/** Protects access to @c reass_dgram_map and related data */
 static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
 
-static reass_dgram_t *reass_dgram_new(void);
+static reass_dgram_t *reass_dgram_new(reass_key_t *);
 static reass_dgram_t *reass_dgram_get(inet_packet_t *);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
 static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
+static void reass_expire(void);
+static bool reass_mem_reserve(reass_dgram_t *, size_t);
+
+static size_t reass_addr_hash(size_t hash, inet_addr_t *addr)
+{
+	uint32_t word;
+
+	hash = hash_combine(hash, addr->version);
+
+	switch (addr->version) {
+	case ip_v4:
+		hash = hash_combine(hash, addr->addr);
+		break;
+	case ip_v6:
+		for (size_t i = 0; i < sizeof(addr128_t); i += sizeof(word)) {
+			memcpy(&word, addr->addr6 + i, sizeof(word));
+			hash = hash_combine(hash, word);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return hash;
+}
+
+static size_t reass_key_hash_fn(reass_key_t *key)
+{
+	size_t hash;
+
+	hash = hash_combine(key->ident, key->proto);
+	hash = reass_addr_hash(hash, &key->src);
+	hash = reass_addr_hash(hash, &key->dest);
+	return hash;
+}
+
+static size_t reass_key_hash(const void *key)
+{
+	return reass_key_hash_fn((reass_key_t *) key);
+}
+
+static size_t reass_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return reass_key_hash_fn(&rdg->key);
+}
+
+static bool reass_key_equal(const void *key, const ht_link_t *item)
+{
+	const reass_key_t *rkey = key;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return rdg->key.ident == rkey->ident &&
+	    rdg->key.proto == rkey->proto &&
+	    inet_addr_compare(&rdg->key.src, &rkey->src) &&
+	    inet_addr_compare(&rdg->key.dest, &rkey->dest);
+}
+
+/** Operations for datagram map. */
+static hash_table_ops_t reass_dgram_map_ops = {
+	.hash = reass_hash,
+	.key_hash = reass_key_hash,
+	.key_equal = reass_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Get key of fragment in reass_dgram_t.frags. */
+static void *reass_frag_getkey(odlink_t *odlink)
+{
+	return &odict_get_instance(odlink, reass_frag_t, dgram_link)->packet.offs;
+}
+
+/** Compare fragment offsets. */
+static int reass_frag_cmp(void *a, void *b)
+{
+	size_t oa = *(size_t *)a;
+	size_t ob = *(size_t *)b;
+
+	if (oa < ob)
+		return -1;
+	if (oa > ob)
+		return 1;
+	return 0;
+}
+
+/** Initialize datagram reassembly.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+errno_t inet_reass_init(void)
+{
+	if (!hash_table_create(&reass_dgram_map, 0, 0, &reass_dgram_map_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Get datagram reassembly statistics.
+ *
+ * @param stats		Place to store statistics
+ */
+void inet_reass_get_stats(inet_reass_stats_t *stats)
+{
+	fibril_mutex_lock(&reass_dgram_map_lock);
+	*stats = reass_stats;
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
 
 /** Queue packet for datagram reassembly.
  *
@@ -89,10 +241,14 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	fibril_mutex_lock(&reass_dgram_map_lock);
 
+	/* Discard datagrams that took too long to reassemble */
+	reass_expire();
+
 	/* Get existing or new datagram */
 	rdg = reass_dgram_get(packet);
 	if (rdg == NULL) {
 		/* Only happens when we are out of memory */
+		++reass_stats.nomem;
 		fibril_mutex_unlock(&reass_dgram_map_lock);
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Allocation failed, packet dropped.");
 		return ENOMEM;
@@ -100,8 +256,19 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
-		return ENOMEM;
+	if (rc != EOK) {
+		if (rc == EINVAL) {
+			/* Inconsistent datagram, discard it entirely */
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+		} else if (odict_empty(&rdg->frags)) {
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+		}
+
+		fibril_mutex_unlock(&reass_dgram_map_lock);
+		return rc;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
@@ -111,7 +278,10 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 		/* Deliver complete datagram */
 		rc = reass_dgram_deliver(rdg);
+
+		fibril_mutex_lock(&reass_dgram_map_lock);
 		reass_dgram_destroy(rdg);
+		fibril_mutex_unlock(&reass_dgram_map_lock);
 		return rc;
 	}
 
@@ -119,6 +289,71 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 	return EOK;
 }
 
+/** Discard datagrams whose reassembly timed out. */
+static void reass_expire(void)
+{
+	struct timespec now;
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	getuptime(&now);
+
+	while ((link = list_first(&reass_dgram_age)) != NULL) {
+		reass_dgram_t *rdg = list_get_instance(link, reass_dgram_t,
+		    age_link);
+
+		if (ts_sub_diff(&now, &rdg->created) < REASS_TIMEOUT)
+			break;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out, "
+		    "datagram dropped.");
+		++reass_stats.timeout;
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+	}
+}
+
+/** Reserve reassembly memory, evicting oldest datagrams if needed.
+ *
+ * @param cur		Datagram the memory is reserved for (never evicted)
+ * @param size		Number of bytes to reserve
+ * @return		@c true on success, @c false if the limit cannot
+ *			be satisfied
+ */
+static bool reass_mem_reserve(reass_dgram_t *cur, size_t size)
+{
+	link_t *link;
+
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	if (size > REASS_MEM_MAX)
+		return false;
+
+	link = list_first(&reass_dgram_age);
+	while (reass_mem + size > REASS_MEM_MAX && link != NULL) {
+		reass_dgram_t *rdg = list_get_instance(link, reass_dgram_t,
+		    age_link);
+
+		link = list_next(link, &reass_dgram_age);
+		if (rdg == cur)
+			continue;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly memory exhausted, "
+		    "evicting oldest datagram.");
+		++reass_stats.evicted;
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+	}
+
+	if (reass_mem + size > REASS_MEM_MAX)
+		return false;
+
+	reass_mem += size;
+	cur->mem += size;
+	return true;
+}
+
 /** Get datagram reassembly structure for packet.
  *
  * @param packet	Packet
@@ -126,33 +361,30 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
  */
 static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	reass_key_t key;
+	ht_link_t *link;
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
+	key.src = packet->src;
+	key.dest = packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
-	}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(&key);
 }
 
 /** Create new datagram reassembly structure.
  *
+ * @param key		Datagram identification
  * @return New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(reass_key_t *key)
 {
 	reass_dgram_t *rdg;
 
@@ -160,8 +392,12 @@ static reass_dgram_t *reass_dgram_new(void)
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
-	list_initialize(&rdg->frags);
+	rdg->key = *key;
+	getuptime(&rdg->created);
+	odict_initialize(&rdg->frags, reass_frag_getkey, reass_frag_cmp);
+
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+	list_append(&rdg->age_link, &reass_dgram_age);
 
 	return rdg;
 }
@@ -174,60 +410,148 @@ static reass_frag_t *reass_frag_new(void)
 	if (frag == NULL)
 		return NULL;
 
-	link_initialize(&frag->dgram_link);
+	odlink_initialize(&frag->dgram_link);
 
 	return frag;
 }
 
+/** Remove fragment from datagram and free it.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param frag		Fragment
+ */
+static void reass_frag_destroy(reass_dgram_t *rdg, reass_frag_t *frag)
+{
+	size_t mem = sizeof(reass_frag_t) + frag->packet.size;
+
+	odict_remove(&frag->dgram_link);
+	rdg->covered -= frag->packet.size;
+	rdg->mem -= mem;
+	reass_mem -= mem;
+
+	free(frag->packet.data);
+	free(frag);
+}
+
+/** Insert fragment into datagram.
+ *
+ * Data already present in the datagram takes precedence, so the new
+ * fragment is trimmed not to overlap existing fragments. Existing fragments
+ * completely covered by the new one are replaced by it.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @return		EOK on success (including duplicates which are
+ *			ignored), EINVAL if the fragment is inconsistent with
+ *			the datagram, ENOMEM if out of memory.
+ */
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
 	reass_frag_t *frag;
-	void *data_copy;
-	link_t *link;
+	odlink_t *olink;
+	size_t fragoff_limit;
+	size_t b, e;
 
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	frag = reass_frag_new();
+	b = packet->offs;
+	e = packet->offs + packet->size;
 
-	/* Clone the packet */
+	/* Upper bound for fragment offset field */
+	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
 
-	data_copy = malloc(packet->size);
-	if (data_copy == NULL) {
-		free(frag);
-		return ENOMEM;
+	/* Verify that total size of datagram is within reasonable bounds */
+	if (e > FRAG_OFFS_UNIT * fragoff_limit) {
+		++reass_stats.invalid;
+		return EINVAL;
 	}
 
-	memcpy(data_copy, packet->data, packet->size);
+	if (!packet->mf) {
+		/* Last fragment determines datagram size */
+		if (rdg->have_last && rdg->size != e) {
+			++reass_stats.invalid;
+			return EINVAL;
+		}
 
-	frag->packet = *packet;
-	frag->packet.data = data_copy;
+		olink = odict_last(&rdg->frags);
+		if (olink != NULL) {
+			frag = odict_get_instance(olink, reass_frag_t,
+			    dgram_link);
+			if (frag->packet.offs + frag->packet.size > e) {
+				++reass_stats.invalid;
+				return EINVAL;
+			}
+		}
 
-	/*
-	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
-	 * data immediately. Possibly eliminate redundant packet headers.
-	 */
+		rdg->have_last = true;
+		rdg->size = e;
+	} else if (rdg->have_last && e > rdg->size) {
+		++reass_stats.invalid;
+		return EINVAL;
+	}
 
-	/*
-	 * Insert into the list, which is sorted by offs member ascending.
-	 */
+	/* Trim head against the preceding fragment */
+	olink = odict_find_leq(&rdg->frags, &b, NULL);
+	if (olink != NULL) {
+		frag = odict_get_instance(olink, reass_frag_t, dgram_link);
+		b = max(b, frag->packet.offs + frag->packet.size);
+	}
 
-	link = list_first(&rdg->frags);
-	while (link != NULL) {
-		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
-		    dgram_link);
+	/* Drop fragments covered by the new one, trim tail against the next */
+	olink = odict_find_geq(&rdg->frags, &b, NULL);
+	while (olink != NULL && b < e) {
+		frag = odict_get_instance(olink, reass_frag_t, dgram_link);
+		if (frag->packet.offs >= e)
+			break;
 
-		if (qf->packet.offs >= packet->offs)
+		olink = odict_next(olink, &rdg->frags);
+
+		if (frag->packet.offs + frag->packet.size <= e) {
+			reass_frag_destroy(rdg, frag);
+		} else {
+			e = frag->packet.offs;
 			break;
+		}
+	}
 
-		link = list_next(link, &rdg->frags);
+	if (b >= e) {
+		/* Nothing new, no need to store the fragment */
+		if (packet->size > 0)
+			++reass_stats.dup;
+		return EOK;
 	}
 
-	if (link != NULL)
-		list_insert_after(&frag->dgram_link, link);
-	else
-		list_append(&frag->dgram_link, &rdg->frags);
+	if (!reass_mem_reserve(rdg, sizeof(reass_frag_t) + (e - b))) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly memory limit "
+		    "reached, packet dropped.");
+		++reass_stats.nomem;
+		return ENOMEM;
+	}
+
+	frag = reass_frag_new();
+	if (frag == NULL)
+		goto error;
+
+	/* Clone the non-overlapping part of the packet */
+	frag->packet = *packet;
+	frag->packet.offs = b;
+	frag->packet.size = e - b;
+	frag->packet.data = malloc(e - b);
+	if (frag->packet.data == NULL) {
+		free(frag);
+		goto error;
+	}
 
+	memcpy(frag->packet.data, packet->data + (b - packet->offs), e - b);
+
+	odict_insert(&frag->dgram_link, &rdg->frags, NULL);
+	rdg->covered += e - b;
 	return EOK;
+error:
+	rdg->mem -= sizeof(reass_frag_t) + (e - b);
+	reass_mem -= sizeof(reass_frag_t) + (e - b);
+	++reass_stats.nomem;
+	return ENOMEM;
 }
 
 /** Check if datagram is complete.
@@ -237,42 +561,10 @@ static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet
  */
 static bool reass_dgram_complete(reass_dgram_t *rdg)
 {
-	reass_frag_t *frag, *prev;
-	link_t *link;
-
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	assert(!list_empty(&rdg->frags));
-
-	link = list_first(&rdg->frags);
-	assert(link != NULL);
-
-	frag = list_get_instance(link, reass_frag_t,
-	    dgram_link);
 
-	/* First fragment must be at offset zero */
-	if (frag->packet.offs != 0)
-		return false;
-
-	prev = frag;
-
-	while (true) {
-		link = list_next(link, &rdg->frags);
-		if (link == NULL)
-			break;
-
-		/* Each next fragment must follow immediately or overlap */
-		frag = list_get_instance(link, reass_frag_t, dgram_link);
-		if (frag->packet.offs > prev->packet.offs + prev->packet.size)
-			return false;
-
-		/* No more fragments - datagram is complete */
-		if (!frag->packet.mf)
-			return true;
-
-		prev = frag;
-	}
-
-	return false;
+	/* Fragments never overlap, so coverage equals size iff complete */
+	return rdg->have_last && rdg->covered == rdg->size;
 }
 
 /** Remove datagram from reassembly map.
@@ -282,7 +574,8 @@ static bool reass_dgram_complete(reass_dgram_t *rdg)
 static void reass_dgram_remove(reass_dgram_t *rdg)
 {
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->age_link);
 }
 
 /** Deliver complete datagram.
@@ -291,67 +584,35 @@ static void reass_dgram_remove(reass_dgram_t *rdg)
  */
 static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 {
-	size_t dgram_size;
-	size_t fragoff_limit;
 	inet_dgram_t dgram;
 	uint8_t proto;
 	reass_frag_t *frag;
+	odlink_t *olink;
 	errno_t rc;
 
-	/*
-	 * Potentially there could be something beyond the first packet
-	 * that has !MF. Make sure we ignore that.
-	 */
-	frag = NULL;
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		if (!cfrag->packet.mf) {
-			frag = cfrag;
-			break;
-		}
-	}
-
-	assert(frag != NULL);
-	assert(!frag->packet.mf);
+	olink = odict_first(&rdg->frags);
+	assert(olink != NULL);
+	frag = odict_get_instance(olink, reass_frag_t, dgram_link);
+	assert(frag->packet.offs == 0);
 
-	dgram_size = frag->packet.offs + frag->packet.size;
-
-	/* Upper bound for fragment offset field */
-	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
-
-	/* Verify that total size of datagram is within reasonable bounds */
-	if (dgram_size > FRAG_OFFS_UNIT * fragoff_limit)
-		return ELIMIT;
-
-	dgram.data = calloc(dgram_size, 1);
+	dgram.data = malloc(rdg->size);
 	if (dgram.data == NULL)
 		return ENOMEM;
 
 	/* XXX What if different fragments came from different link? */
 	dgram.iplink = frag->packet.link_id;
-	dgram.size = dgram_size;
+	dgram.size = rdg->size;
 	dgram.src = frag->packet.src;
 	dgram.dest = frag->packet.dest;
 	dgram.tos = frag->packet.tos;
 	proto = frag->packet.proto;
 
 	/* Pull together data from individual fragments */
-
-	size_t doffs = 0;
-
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		size_t cb, ce;
-
-		cb = max(doffs, cfrag->packet.offs);
-		ce = min(dgram_size, cfrag->packet.offs + cfrag->packet.size);
-
-		if (ce > cb) {
-			memcpy(dgram.data + cb,
-			    cfrag->packet.data + cb - cfrag->packet.offs,
-			    ce - cb);
-		}
-
-		if (!cfrag->packet.mf)
-			break;
+	while (olink != NULL) {
+		frag = odict_get_instance(olink, reass_frag_t, dgram_link);
+		memcpy(dgram.data + frag->packet.offs, frag->packet.data,
+		    frag->packet.size);
+		olink = odict_next(olink, &rdg->frags);
 	}
 
 	rc = inet_recv_dgram_local(&dgram, proto);
@@ -365,16 +626,18 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
  */
 static void reass_dgram_destroy(reass_dgram_t *rdg)
 {
-	while (!list_empty(&rdg->frags)) {
-		link_t *flink = list_first(&rdg->frags);
-		reass_frag_t *frag = list_get_instance(flink, reass_frag_t,
-		    dgram_link);
+	odlink_t *olink;
 
-		list_remove(&frag->dgram_link);
-		free(frag->packet.data);
-		free(frag);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	while ((olink = odict_first(&rdg->frags)) != NULL) {
+		reass_frag_t *frag = odict_get_instance(olink, reass_frag_t,
+		    dgram_link);
+		reass_frag_destroy(rdg, frag);
 	}
 
+	assert(rdg->mem == 0);
+	odict_finalize(&rdg->frags);
 	free(rdg);
 }
 
@@ -39,7 +39,23 @@
 
 #include "inetsrv.h"
 
+/** Datagram reassembly drop statistics */
+typedef struct {
+	/** Fragments carrying only already received data */
+	size_t dup;
+	/** Datagrams discarded because reassembly timed out */
+	size_t timeout;
+	/** Datagrams evicted to stay within the memory limit */
+	size_t evicted;
+	/** Fragments dropped for lack of memory */
+	size_t nomem;
+	/** Datagrams discarded due to inconsistent or oversized fragments */
+	size_t invalid;
+} inet_reass_stats_t;
+
+extern errno_t inet_reass_init(void);
 extern errno_t inet_reass_queue_packet(inet_packet_t *);
+extern void inet_reass_get_stats(inet_reass_stats_t *);
 
 #endif
 
@@ -124,6 +124,20 @@ typedef struct _vfs_node {
 	fibril_rwlock_t contents_rwlock;
 
 	struct _vfs_node *mount;
+
+	/** Pages of the node in the pager's page cache. */
+	list_t pages;
+	/** Incremented whenever the cached pages are invalidated. */
+	unsigned pages_gen;
+
+	/*
+	 * Cached attributes of the node, protected by a mutex private to
+	 * vfs_node.c.
+	 */
+
+	vfs_stat_t stat;
+	/** Generation of the cached attributes, zero if not cached. */
+	unsigned stat_gen;
 } vfs_node_t;
 
 /**
@@ -205,15 +219,24 @@ extern errno_t vfs_fd_free(int);
 
 extern void vfs_node_addref(vfs_node_t *);
 extern void vfs_node_delref(vfs_node_t *);
+
+extern bool vfs_node_stat_get(vfs_node_t *, vfs_stat_t *, unsigned *);
+extern void vfs_node_stat_set(vfs_node_t *, const vfs_stat_t *, unsigned);
+extern void vfs_node_stat_invalidate(vfs_node_t *);
+extern void vfs_node_stat_invalidate_all(void);
 extern errno_t vfs_open_node_remote(vfs_node_t *);
 
 extern errno_t vfs_op_clone(int oldfd, int newfd, bool desc, int *);
+extern errno_t vfs_op_copy_range(int srcfd, int dstfd, vfs_copy_range_t *,
+    aoff64_t *);
 extern errno_t vfs_op_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *);
 extern errno_t vfs_op_mount(int mpfd, unsigned servid, unsigned flags, unsigned instance, const char *opts, const char *fsname, int *outfd);
 extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(int fd, int flags);
 extern errno_t vfs_op_put(int fd);
 extern errno_t vfs_op_read(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_readdir(int fd, aoff64_t *, unsigned int, size_t *);
+extern errno_t vfs_op_readv(int fd, vfs_io_seg_t *, size_t, void *, size_t *);
 extern errno_t vfs_op_rename(int basefd, char *old, char *new);
 extern errno_t vfs_op_resize(int fd, int64_t size);
 extern errno_t vfs_op_stat(int fd);
@@ -224,9 +247,13 @@ extern errno_t vfs_op_unmount(int mpfd);
 extern errno_t vfs_op_wait_handle(bool high_fd, int *out_fd);
 extern errno_t vfs_op_walk(int parentfd, int flags, char *path, int *out_fd);
 extern errno_t vfs_op_write(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_writev(int fd, vfs_io_seg_t *, size_t, void *,
+    size_t *);
 
 extern void vfs_register(ipc_call_t *);
 
+extern bool vfs_pager_init(void);
+extern void vfs_pager_invalidate(vfs_node_t *);
 extern void vfs_page_in(ipc_call_t *);
 
 typedef struct {
@@ -45,6 +45,32 @@ static void vfs_in_clone(ipc_call_t *req)
 	async_answer_1(req, rc, outfd);
 }
 
+static void vfs_in_copy_range(ipc_call_t *req)
+{
+	int srcfd = ipc_get_arg1(req);
+	int dstfd = ipc_get_arg2(req);
+	vfs_copy_range_t range;
+	ipc_call_t call;
+	size_t size;
+
+	if (!async_data_write_receive(&call, &size) ||
+	    size != sizeof(range)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	errno_t rc = async_data_write_finalize(&call, &range, sizeof(range));
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	aoff64_t copied = 0;
+	rc = vfs_op_copy_range(srcfd, dstfd, &range, &copied);
+	async_answer_2(req, rc, LOWER32(copied), UPPER32(copied));
+}
+
 static void vfs_in_fsprobe(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -183,6 +209,105 @@ static void vfs_in_read(ipc_call_t *req)
 	async_answer_1(req, rc, bytes);
 }
 
+static void vfs_in_readdir(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+	unsigned int flags = ipc_get_arg4(req);
+
+	size_t count = 0;
+	errno_t rc = vfs_op_readdir(fd, &pos, flags, &count);
+	async_answer_3(req, rc, LOWER32(pos), UPPER32(pos), count);
+}
+
+/** Receive and serve a vectored read or write request.
+ *
+ * The client sends the array of file segments followed by a single data
+ * transfer covering all of them, which is staged in a buffer here. The
+ * answer carries the number of bytes transferred, also when the request
+ * fails after transferring some of the segments. Data read before the
+ * failure are delivered to the client.
+ */
+static void vfs_in_rdwrv(ipc_call_t *req, bool read)
+{
+	int fd = ipc_get_arg1(req);
+	size_t cnt = ipc_get_arg2(req);
+	vfs_io_seg_t *segs = NULL;
+	void *buf = NULL;
+	ipc_call_t call;
+	size_t size;
+	size_t total = 0;
+	size_t bytes = 0;
+	errno_t rc;
+
+	if (cnt == 0 || cnt > VFS_IO_SEG_MAX) {
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	rc = async_data_write_accept((void **) &segs, false,
+	    cnt * sizeof(vfs_io_seg_t), cnt * sizeof(vfs_io_seg_t), 0, NULL);
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		if (segs[i].size > DATA_XFER_LIMIT - total) {
+			rc = EINVAL;
+			break;
+		}
+		total += segs[i].size;
+	}
+
+	bool received = read ? async_data_read_receive(&call, &size) :
+	    async_data_write_receive(&call, &size);
+	if (!received) {
+		async_answer_0(&call, EINVAL);
+		rc = EINVAL;
+		goto out;
+	}
+
+	if (rc == EOK && (total == 0 || size != total))
+		rc = EINVAL;
+
+	if (rc == EOK) {
+		buf = malloc(total);
+		if (buf == NULL)
+			rc = ENOMEM;
+	}
+
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		goto out;
+	}
+
+	if (read) {
+		rc = vfs_op_readv(fd, segs, cnt, buf, &bytes);
+
+		/* Deliver the data read before a failure, too. */
+		if (rc == EOK || bytes > 0) {
+			errno_t frc = async_data_read_finalize(&call, buf, bytes);
+			if (frc != EOK) {
+				rc = frc;
+				bytes = 0;
+			}
+		} else {
+			async_answer_0(&call, rc);
+		}
+	} else {
+		rc = async_data_write_finalize(&call, buf, size);
+		if (rc == EOK)
+			rc = vfs_op_writev(fd, segs, cnt, buf, &bytes);
+	}
+
+out:
+	free(buf);
+	free(segs);
+	async_answer_1(req, rc, bytes);
+}
+
 static void vfs_in_rename(ipc_call_t *req)
 {
 	/* The common base directory. */
@@ -338,6 +463,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_CLONE:
 			vfs_in_clone(&call);
 			break;
+		case VFS_IN_COPY_RANGE:
+			vfs_in_copy_range(&call);
+			break;
 		case VFS_IN_FSPROBE:
 			vfs_in_fsprobe(&call);
 			break;
@@ -356,6 +484,12 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_READ:
 			vfs_in_read(&call);
 			break;
+		case VFS_IN_READDIR:
+			vfs_in_readdir(&call);
+			break;
+		case VFS_IN_READV:
+			vfs_in_rdwrv(&call, true);
+			break;
 		case VFS_IN_REGISTER:
 			vfs_register(&call);
 			cont = false;
@@ -390,6 +524,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_WRITE:
 			vfs_in_write(&call);
 			break;
+		case VFS_IN_WRITEV:
+			vfs_in_rdwrv(&call, false);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
@@ -202,6 +202,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	if (rc == EOK)
+		vfs_node_stat_invalidate_all();
+
 out:
 	return rc;
 }
@@ -387,6 +390,10 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 		vfs_node_put(parent);
 
+		/* The name may have been created or removed. */
+		if (rc == EOK)
+			vfs_node_stat_invalidate_all();
+
 	} else {
 		rc = _vfs_lookup_internal(base, path, lflag, result, len);
 	}
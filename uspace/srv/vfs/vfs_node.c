@@ -124,6 +124,8 @@ void vfs_node_delref(vfs_node_t *node)
 	fibril_mutex_unlock(&nodes_mutex);
 
 	if (free_node) {
+		vfs_pager_invalidate(node);
+
 		/*
 		 * VFS_OUT_DESTROY will free up the file's resources if there
 		 * are no more hard links.
@@ -150,6 +152,7 @@ void vfs_node_forget(vfs_node_t *node)
 	fibril_mutex_lock(&nodes_mutex);
 	hash_table_remove_item(&nodes, &node->nh_link);
 	fibril_mutex_unlock(&nodes_mutex);
+	vfs_pager_invalidate(node);
 	free(node);
 }
 
@@ -184,6 +187,7 @@ vfs_node_t *vfs_node_get(vfs_lookup_res_t *result)
 		node->size = result->size;
 		node->type = result->type;
 		fibril_rwlock_initialize(&node->contents_rwlock);
+		list_initialize(&node->pages);
 		hash_table_insert(&nodes, &node->nh_link);
 	} else {
 		node = hash_table_get_inst(tmp, vfs_node_t, nh_link);
@@ -223,6 +227,87 @@ void vfs_node_put(vfs_node_t *node)
 	vfs_node_delref(node);
 }
 
+/** Mutex protecting the cached attributes of all VFS nodes. */
+static FIBRIL_MUTEX_INITIALIZE(stat_mutex);
+
+/** Current generation of cached attributes, never zero. */
+static unsigned stat_gen = 1;
+
+/** Incremented whenever any cached attributes are invalidated. */
+static unsigned stat_seq;
+
+/** Get the cached attributes of a VFS node.
+ *
+ * @param node		VFS node.
+ * @param stat		Place to store the cached attributes.
+ * @param ticket	If the attributes are not cached, place to store a
+ *			ticket for vfs_node_stat_set().
+ *
+ * @return		True if the attributes were cached.
+ */
+bool vfs_node_stat_get(vfs_node_t *node, vfs_stat_t *stat, unsigned *ticket)
+{
+	bool cached;
+
+	fibril_mutex_lock(&stat_mutex);
+	cached = (node->stat_gen == stat_gen);
+	if (cached)
+		*stat = node->stat;
+	else
+		*ticket = stat_seq;
+	fibril_mutex_unlock(&stat_mutex);
+
+	return cached;
+}
+
+/** Cache the attributes of a VFS node.
+ *
+ * Nothing is cached if any attributes were invalidated since the ticket was
+ * obtained, because the attributes could have been fetched from the file
+ * system before the change.
+ *
+ * @param node		VFS node.
+ * @param stat		Attributes fetched from the file system.
+ * @param ticket	Ticket obtained from vfs_node_stat_get() before
+ *			fetching the attributes.
+ */
+void vfs_node_stat_set(vfs_node_t *node, const vfs_stat_t *stat,
+    unsigned ticket)
+{
+	fibril_mutex_lock(&stat_mutex);
+	if (stat_seq == ticket) {
+		node->stat = *stat;
+		node->stat_gen = stat_gen;
+	}
+	fibril_mutex_unlock(&stat_mutex);
+}
+
+/** Invalidate the cached attributes of a VFS node.
+ *
+ * @param node		VFS node whose attributes have changed.
+ */
+void vfs_node_stat_invalidate(vfs_node_t *node)
+{
+	fibril_mutex_lock(&stat_mutex);
+	node->stat_gen = 0;
+	stat_seq++;
+	fibril_mutex_unlock(&stat_mutex);
+}
+
+/** Invalidate the cached attributes of all VFS nodes.
+ *
+ * Used when the namespace changes, which may affect the attributes of nodes
+ * VFS cannot easily identify, such as the size of the parent directory.
+ */
+void vfs_node_stat_invalidate_all(void)
+{
+	fibril_mutex_lock(&stat_mutex);
+	if (++stat_gen == 0)
+		stat_gen = 1;
+	stat_seq++;
+	fibril_mutex_unlock(&stat_mutex);
+}
+
 struct refcnt_data {
 	/** Sum of all reference counts for this file system instance. */
 	unsigned refcnt;
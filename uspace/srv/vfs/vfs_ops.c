@@ -122,6 +122,198 @@ errno_t vfs_op_clone(int oldfd, int newfd, bool desc, int *out_fd)
 	return rc;
 }
 
+/** Let the file system copy a range of data between two of its nodes.
+ *
+ * The caller holds the contents locks of both nodes.
+ */
+static errno_t vfs_copy_range_remote(vfs_node_t *src, vfs_node_t *dst,
+    vfs_copy_range_t *range, aoff64_t *copied)
+{
+	async_exch_t *exch = vfs_exchange_grab(dst->fs_handle);
+
+	ipc_call_t answer;
+	aid_t msg = async_send_3(exch, VFS_OUT_COPY_RANGE, dst->service_id,
+	    src->index, dst->index, &answer);
+	errno_t rc = async_data_write_start(exch, range, sizeof(*range));
+
+	vfs_exchange_release(exch);
+
+	if (rc != EOK) {
+		async_forget(msg);
+		return rc;
+	}
+
+	async_wait_for(msg, &rc);
+	if (rc != EOK)
+		return rc;
+
+	*copied = MERGE_LOUP32(ipc_get_arg1(&answer), ipc_get_arg2(&answer));
+	dst->size = MERGE_LOUP32(ipc_get_arg3(&answer), ipc_get_arg4(&answer));
+	return EOK;
+}
+
+/** Copy a range of data by reading and writing it chunk by chunk.
+ *
+ * This works across file systems. The data pass through VFS only, the
+ * client is not involved.
+ */
+static errno_t vfs_copy_range_stream(int srcfd, int dstfd,
+    vfs_copy_range_t *range, aoff64_t *copied)
+{
+	uint8_t *buf = malloc(DATA_XFER_LIMIT);
+	if (buf == NULL)
+		return ENOMEM;
+
+	aoff64_t done = 0;
+	errno_t rc = EOK;
+
+	while (done < range->size) {
+		rdwr_io_chunk_t chunk = {
+			.buffer = buf,
+			.size = min(range->size - done, DATA_XFER_LIMIT)
+		};
+
+		rc = vfs_rdwr_internal(srcfd, range->src_pos + done, true,
+		    &chunk);
+		if (rc != EOK || chunk.size == 0)
+			break;
+
+		size_t nread = chunk.size;
+		size_t nwritten = 0;
+
+		while (nwritten < nread) {
+			chunk.buffer = buf + nwritten;
+			chunk.size = nread - nwritten;
+
+			rc = vfs_rdwr_internal(dstfd,
+			    range->dst_pos + done + nwritten, false, &chunk);
+			if (rc == EOK && chunk.size == 0)
+				rc = EIO;
+			if (rc != EOK)
+				break;
+
+			nwritten += chunk.size;
+		}
+
+		done += nwritten;
+		if (rc != EOK)
+			break;
+	}
+
+	free(buf);
+	*copied = done;
+	return rc;
+}
+
+static void vfs_copy_range_put(vfs_file_t *src, vfs_file_t *dst)
+{
+	if (dst != NULL && dst != src)
+		vfs_file_put(dst);
+	if (src != NULL)
+		vfs_file_put(src);
+}
+
+/** Copy a range of data from one file to another.
+ *
+ * If both files live on the same file system instance, the file system is
+ * first asked to do the copy on its own, which lets it use large block
+ * transfers or share the data. If it cannot, or the files live on different
+ * file systems, VFS streams the data between the file systems itself.
+ *
+ * Within a single file, the destination may precede the source even if the
+ * ranges overlap, but it may not start inside the source range.
+ */
+errno_t vfs_op_copy_range(int srcfd, int dstfd, vfs_copy_range_t *range,
+    aoff64_t *copied)
+{
+	vfs_file_t *src = NULL;
+	vfs_file_t *dst = NULL;
+
+	*copied = 0;
+
+	/* Acquire the file structures in a fixed order to avoid deadlocks. */
+	if (srcfd <= dstfd) {
+		src = vfs_file_get(srcfd);
+		if (src != NULL)
+			dst = (srcfd == dstfd) ? src : vfs_file_get(dstfd);
+	} else {
+		dst = vfs_file_get(dstfd);
+		if (dst != NULL)
+			src = vfs_file_get(srcfd);
+	}
+
+	if (src == NULL || dst == NULL) {
+		vfs_copy_range_put(src, dst);
+		return EBADF;
+	}
+
+	if (!src->open_read || !dst->open_write ||
+	    src->node->type != VFS_NODE_FILE ||
+	    dst->node->type != VFS_NODE_FILE) {
+		vfs_copy_range_put(src, dst);
+		return EINVAL;
+	}
+
+	if (range->size == 0) {
+		vfs_copy_range_put(src, dst);
+		return EOK;
+	}
+
+	vfs_node_t *snode = src->node;
+	vfs_node_t *dnode = dst->node;
+	errno_t rc = ENOTSUP;
+
+	if (snode->fs_handle == dnode->fs_handle &&
+	    snode->service_id == dnode->service_id) {
+		/* Lock the nodes in a fixed order as well. */
+		if (snode == dnode) {
+			fibril_rwlock_write_lock(&dnode->contents_rwlock);
+		} else if ((uintptr_t) snode < (uintptr_t) dnode) {
+			fibril_rwlock_read_lock(&snode->contents_rwlock);
+			fibril_rwlock_write_lock(&dnode->contents_rwlock);
+		} else {
+			fibril_rwlock_write_lock(&dnode->contents_rwlock);
+			fibril_rwlock_read_lock(&snode->contents_rwlock);
+		}
+
+		if (dst->append)
+			range->dst_pos = dnode->size;
+
+		/*
+		 * A destination starting inside the source range of the same
+		 * node would make the streaming copy read back data it has
+		 * already overwritten. Reject it rather than let the result
+		 * depend on the file system.
+		 */
+		if (snode == dnode && range->dst_pos > range->src_pos &&
+		    range->dst_pos - range->src_pos < range->size) {
+			rc = EINVAL;
+		} else {
+			rc = vfs_copy_range_remote(snode, dnode, range, copied);
+			if (rc != ENOTSUP) {
+				/* Even a failed copy may have modified the node. */
+				vfs_pager_invalidate(dnode);
+				vfs_node_stat_invalidate(dnode);
+			}
+		}
+
+		if (snode != dnode)
+			fibril_rwlock_read_unlock(&snode->contents_rwlock);
+		fibril_rwlock_write_unlock(&dnode->contents_rwlock);
+	}
+
+	/*
+	 * The streaming fallback acquires the files and locks the nodes
+	 * chunk by chunk on its own.
+	 */
+	vfs_copy_range_put(src, dst);
+
+	if (rc == ENOTSUP)
+		rc = vfs_copy_range_stream(srcfd, dstfd, range, copied);
+
+	return rc;
+}
+
 errno_t vfs_op_put(int fd)
 {
 	return vfs_fd_free(fd);
@@ -393,7 +585,11 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	if (msg == 0)
 		return EINVAL;
 
-	errno_t retval = async_data_read_start(exch, chunk->buffer, chunk->size);
+	errno_t retval;
+	if (read)
+		retval = async_data_read_start(exch, chunk->buffer, chunk->size);
+	else
+		retval = async_data_write_start(exch, chunk->buffer, chunk->size);
 	if (retval != EOK) {
 		async_forget(msg);
 		return retval;
@@ -407,6 +603,90 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
+/** Segments and staging buffer of a vectored read or write */
+typedef struct {
+	vfs_io_seg_t *segs;
+	size_t cnt;
+	uint8_t *buf;
+	size_t *bytes;
+} rdwr_vector_t;
+
+static errno_t rdwr_ipc_vector(async_exch_t *exch, vfs_file_t *file,
+    aoff64_t pos, ipc_call_t *answer, bool read, void *data)
+{
+	rdwr_vector_t *vec = (rdwr_vector_t *) data;
+	size_t done = 0;
+	errno_t rc = EOK;
+
+	if (exch == NULL)
+		return ENOENT;
+
+	if (file->node->type == VFS_NODE_DIRECTORY)
+		return EINVAL;
+
+	/*
+	 * All segments are transferred under a single acquisition of the
+	 * node's contents lock. The file system may transfer less than
+	 * requested in one go, so each segment is finished in a loop. The
+	 * transfer ends at the first segment which cannot be finished, e.g.
+	 * because of the end of file.
+	 */
+	for (size_t i = 0; i < vec->cnt; i++) {
+		aoff64_t spos = vec->segs[i].pos;
+		size_t size = vec->segs[i].size;
+		size_t sdone = 0;
+
+		/* Appending writes ignore the positions. */
+		if (!read && file->append)
+			spos = pos + done;
+
+		while (sdone < size) {
+			aoff64_t p = spos + sdone;
+			ipc_call_t ans;
+			aid_t msg = async_send_4(exch,
+			    read ? VFS_OUT_READ : VFS_OUT_WRITE,
+			    file->node->service_id, file->node->index,
+			    LOWER32(p), UPPER32(p), &ans);
+			if (msg == 0) {
+				rc = ENOMEM;
+				break;
+			}
+
+			if (read) {
+				rc = async_data_read_start(exch,
+				    vec->buf + done + sdone, size - sdone);
+			} else {
+				rc = async_data_write_start(exch,
+				    vec->buf + done + sdone, size - sdone);
+			}
+
+			if (rc != EOK) {
+				async_forget(msg);
+				break;
+			}
+
+			async_wait_for(msg, &rc);
+			if (rc != EOK)
+				break;
+
+			/* Keep the answer of the last successful transfer. */
+			*answer = ans;
+
+			size_t n = ipc_get_arg1(answer);
+			if (n == 0)
+				break;
+			sdone += n;
+		}
+
+		done += sdone;
+		if (rc != EOK || sdone < size)
+			break;
+	}
+
+	*vec->bytes = done;
+	return rc;
+}
+
 static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
     void *ipc_cb_data)
 {
@@ -473,22 +753,43 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 		pos = file->node->size;
 
 	/*
-	 * Handle communication with the endpoint FS.
+	 * Handle communication with the endpoint FS. The answer initially
+	 * records no transfer and the current size of the node, so that it
+	 * stays valid if the callback fails before getting any answer.
 	 */
 	ipc_call_t answer;
+	ipc_set_arg1(&answer, 0);
+	ipc_set_arg2(&answer, LOWER32(file->node->size));
+	ipc_set_arg3(&answer, UPPER32(file->node->size));
 	errno_t rc = ipc_cb(fs_exch, file, pos, &answer, read, ipc_cb_data);
 
+	/*
+	 * A failed request may still have transferred some data, e.g. the
+	 * leading segments of a vectored write. File systems answer failed
+	 * transfers without any arguments, so a non-zero byte count means the
+	 * answer comes from a successful one.
+	 */
+	bool transferred = (rc == EOK) || (ipc_get_arg1(&answer) > 0);
+
 	vfs_exchange_release(fs_exch);
 
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
+	/* Cached pages of the node are stale now. */
+	if (!read && transferred)
+		vfs_pager_invalidate(file->node);
+
+	/* Even a failed write may have changed the node's attributes. */
+	if (!read)
+		vfs_node_stat_invalidate(file->node);
+
 	/* Unlock the VFS node. */
 	if (rlock) {
 		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
 	} else {
 		/* Update the cached version of node's size. */
-		if (rc == EOK) {
+		if (transferred) {
 			file->node->size = MERGE_LOUP32(ipc_get_arg2(&answer),
 			    ipc_get_arg3(&answer));
 		}
@@ -510,6 +811,85 @@ errno_t vfs_op_read(int fd, aoff64_t pos, size_t *out_bytes)
 	return vfs_rdwr(fd, pos, true, rdwr_ipc_client, out_bytes);
 }
 
+/** Read multiple file segments into a contiguous buffer. */
+errno_t vfs_op_readv(int fd, vfs_io_seg_t *segs, size_t cnt, void *buf,
+    size_t *out_bytes)
+{
+	rdwr_vector_t vec = {
+		.segs = segs,
+		.cnt = cnt,
+		.buf = buf,
+		.bytes = out_bytes
+	};
+
+	return vfs_rdwr(fd, 0, true, rdwr_ipc_vector, &vec);
+}
+
+/** Read a batch of directory entries.
+ *
+ * The client's IPC_M_DATA_READ request is forwarded to the file system, which
+ * fills it with as many entries as fit. Unlike vfs_op_read(), this does not
+ * use or update the file position; the client passes the position and gets
+ * back the one following the last returned entry.
+ */
+errno_t vfs_op_readdir(int fd, aoff64_t *pos, unsigned int flags,
+    size_t *count)
+{
+	ipc_call_t call;
+	if (!async_data_read_receive(&call, NULL)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		async_answer_0(&call, EBADF);
+		return EBADF;
+	}
+
+	if (!file->open_read || file->node->type != VFS_NODE_DIRECTORY) {
+		vfs_file_put(file);
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	/*
+	 * Make sure that no one is modifying the namespace while we are
+	 * reading the directory.
+	 */
+	fibril_rwlock_read_lock(&file->node->contents_rwlock);
+	fibril_rwlock_read_lock(&namespace_rwlock);
+
+	async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
+
+	ipc_call_t answer;
+	aid_t msg = async_send_5(exch, VFS_OUT_READDIR, file->node->service_id,
+	    file->node->index, LOWER32(*pos), UPPER32(*pos), flags, &answer);
+
+	errno_t rc = async_forward_0(&call, exch, 0, IPC_FF_ROUTE_FROM_ME);
+	if (rc != EOK) {
+		async_forget(msg);
+		async_answer_0(&call, rc);
+	} else {
+		async_wait_for(msg, &rc);
+	}
+
+	vfs_exchange_release(exch);
+
+	fibril_rwlock_read_unlock(&namespace_rwlock);
+	fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+
+	vfs_file_put(file);
+
+	if (rc == EOK) {
+		*pos = MERGE_LOUP32(ipc_get_arg1(&answer),
+		    ipc_get_arg2(&answer));
+		*count = ipc_get_arg3(&answer);
+	}
+
+	return rc;
+}
+
 errno_t vfs_op_rename(int basefd, char *old, char *new)
 {
 	vfs_file_t *base_file = vfs_file_get(basefd);
@@ -626,14 +1006,37 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
 		file->node->size = size;
+		vfs_pager_invalidate(file->node);
+	}
+	vfs_node_stat_invalidate(file->node);
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
 	return rc;
 }
 
+/** Fetch the attributes of a node from its file system. */
+static errno_t vfs_stat_fetch(vfs_node_t *node, vfs_stat_t *stat)
+{
+	async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+
+	aid_t msg = async_send_2(exch, VFS_OUT_STAT, node->service_id,
+	    node->index, NULL);
+	errno_t rc = async_data_read_start(exch, stat, sizeof(vfs_stat_t));
+
+	vfs_exchange_release(exch);
+
+	if (rc != EOK) {
+		async_forget(msg);
+		return rc;
+	}
+
+	async_wait_for(msg, &rc);
+	return rc;
+}
+
 errno_t vfs_op_stat(int fd)
 {
 	vfs_file_t *file = vfs_file_get(fd);
@@ -641,11 +1044,46 @@ errno_t vfs_op_stat(int fd)
 		return EBADF;
 
 	vfs_node_t *node = file->node;
+	vfs_info_t *fs_info = fs_handle_to_info(node->fs_handle);
+	assert(fs_info);
 
-	async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
-	errno_t rc = async_data_read_forward_3_0(exch, VFS_OUT_STAT,
-	    node->service_id, node->index, true);
-	vfs_exchange_release(exch);
+	if (fs_info->volatile_stat) {
+		async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+		errno_t rc = async_data_read_forward_3_0(exch, VFS_OUT_STAT,
+		    node->service_id, node->index, true);
+		vfs_exchange_release(exch);
+
+		vfs_file_put(file);
+		return rc;
+	}
+
+	/*
+	 * Serve the attributes from the node's cache if possible. The cache
+	 * is invalidated by all changes made through VFS.
+	 */
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size) ||
+	    size != sizeof(vfs_stat_t)) {
+		async_answer_0(&call, EINVAL);
+		vfs_file_put(file);
+		return EINVAL;
+	}
+
+	vfs_stat_t stat;
+	unsigned ticket;
+	errno_t rc = EOK;
+
+	if (!vfs_node_stat_get(node, &stat, &ticket)) {
+		rc = vfs_stat_fetch(node, &stat);
+		if (rc == EOK)
+			vfs_node_stat_set(node, &stat, ticket);
+	}
+
+	if (rc == EOK)
+		rc = async_data_read_finalize(&call, &stat, sizeof(vfs_stat_t));
+	else
+		async_answer_0(&call, rc);
 
 	vfs_file_put(file);
 	return rc;
@@ -923,6 +1361,20 @@ errno_t vfs_op_write(int fd, aoff64_t pos, size_t *out_bytes)
 	return vfs_rdwr(fd, pos, false, rdwr_ipc_client, out_bytes);
 }
 
+/** Write a contiguous buffer to multiple file segments. */
+errno_t vfs_op_writev(int fd, vfs_io_seg_t *segs, size_t cnt, void *buf,
+    size_t *out_bytes)
+{
+	rdwr_vector_t vec = {
+		.segs = segs,
+		.cnt = cnt,
+		.buf = buf,
+		.bytes = out_bytes
+	};
+
+	return vfs_rdwr(fd, 0, false, rdwr_ipc_vector, &vec);
+}
+
 /**
  * @}
  */
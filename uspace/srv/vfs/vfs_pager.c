@@ -36,16 +36,144 @@
  */
 
 #include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <async.h>
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <stdlib.h>
 
-void vfs_page_in(ipc_call_t *req)
+/** Maximum number of pages kept in the page cache */
+#define VFS_PAGER_CACHE_MAX	2048
+
+/** Page shared by all areas mapping the same part of a file */
+typedef struct {
+	/** Link in the page cache hash table */
+	ht_link_t ht_link;
+	/** Link in the LRU list */
+	link_t lru_link;
+	/** Link in the list of cached pages of the node */
+	link_t node_link;
+	/** Node to which the page belongs */
+	vfs_node_t *node;
+	/** File offset of the page */
+	aoff64_t offset;
+	/** Page with the file data */
+	void *page;
+} vfs_page_t;
+
+typedef struct {
+	vfs_node_t *node;
+	aoff64_t offset;
+} vfs_page_key_t;
+
+/** Mutex protecting the page cache */
+static FIBRIL_MUTEX_INITIALIZE(pages_mutex);
+
+/** Page cache, indexed by node and file offset */
+static hash_table_t pages;
+
+/** Cached pages, most recently used first */
+static LIST_INITIALIZE(pages_lru);
+static size_t pages_count;
+
+static size_t pages_key_hash(const void *key)
+{
+	const vfs_page_key_t *pkey = key;
+
+	size_t hash = hash_mix((uintptr_t) pkey->node);
+	return hash_combine(hash, hash_mix(pkey->offset));
+}
+
+static size_t pages_hash(const ht_link_t *item)
+{
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, ht_link);
+	vfs_page_key_t key = {
+		.node = page->node,
+		.offset = page->offset
+	};
+
+	return pages_key_hash(&key);
+}
+
+static bool pages_key_equal(const void *key, const ht_link_t *item)
+{
+	const vfs_page_key_t *pkey = key;
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, ht_link);
+
+	return page->node == pkey->node && page->offset == pkey->offset;
+}
+
+static hash_table_ops_t pages_ops = {
+	.hash = pages_hash,
+	.key_hash = pages_key_hash,
+	.key_equal = pages_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the VFS pager page cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_pager_init(void)
+{
+	return hash_table_create(&pages, 0, 0, &pages_ops);
+}
+
+/** Remove page from the page cache.
+ *
+ * The physical frame stays alive for as long as any address space area
+ * maps it.
+ */
+static void vfs_page_remove(vfs_page_t *page)
+{
+	assert(fibril_mutex_is_locked(&pages_mutex));
+
+	hash_table_remove_item(&pages, &page->ht_link);
+	list_remove(&page->lru_link);
+	list_remove(&page->node_link);
+	pages_count--;
+
+	as_area_destroy(page->page);
+	free(page);
+}
+
+/** Drop all cached pages of a node.
+ *
+ * This must be called whenever the contents of the node change and before
+ * the node is destroyed. Pages which are already mapped keep the old
+ * contents.
+ *
+ * @param node		VFS node.
+ */
+void vfs_pager_invalidate(vfs_node_t *node)
+{
+	fibril_mutex_lock(&pages_mutex);
+
+	node->pages_gen++;
+	while (!list_empty(&node->pages)) {
+		vfs_page_remove(list_get_instance(list_first(&node->pages),
+		    vfs_page_t, node_link));
+	}
+
+	fibril_mutex_unlock(&pages_mutex);
+}
+
+/** Read one page of a file.
+ *
+ * @param fd		File descriptor of the client.
+ * @param offset	File offset of the page.
+ * @param page_size	Size of the page.
+ * @param rpage		Place to store the new page.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t vfs_page_read(int fd, aoff64_t offset, size_t page_size,
+    void **rpage)
 {
-	aoff64_t offset = ipc_get_arg1(req);
-	size_t page_size = ipc_get_arg2(req);
-	int fd = ipc_get_arg3(req);
 	void *page;
 	errno_t rc;
 
@@ -53,10 +181,8 @@ void vfs_page_in(ipc_call_t *req)
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 
-	if (page == AS_MAP_FAILED) {
-		async_answer_0(req, ENOMEM);
-		return;
-	}
+	if (page == AS_MAP_FAILED)
+		return ENOMEM;
 
 	rdwr_io_chunk_t chunk = {
 		.buffer = page,
@@ -77,15 +203,119 @@ void vfs_page_in(ipc_call_t *req)
 		chunk.size = page_size - total;
 	} while (total < page_size);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	if (rc != EOK) {
+		as_area_destroy(page);
+		return rc;
+	}
+
+	*rpage = page;
+	return EOK;
+}
+
+/** Answer a page-in request using the page cache.
+ *
+ * The request is answered while the page cache is locked so that the page
+ * cannot be evicted before the kernel takes a reference to its frame.
+ *
+ * @param req		Page-in request.
+ * @param fd		File descriptor of the client.
+ * @param offset	File offset of the page.
+ * @param page_size	Size of the page.
+ */
+static void vfs_page_in_cached(ipc_call_t *req, int fd, aoff64_t offset,
+    size_t page_size)
+{
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		async_answer_0(req, EBADF);
+		return;
+	}
+
+	vfs_node_t *node = file->node;
+	vfs_node_addref(node);
+	vfs_file_put(file);
+
+	vfs_page_key_t key = {
+		.node = node,
+		.offset = offset
+	};
+
+	fibril_mutex_lock(&pages_mutex);
+
+	ht_link_t *link = hash_table_find(&pages, &key);
+	if (link != NULL) {
+		vfs_page_t *page = hash_table_get_inst(link, vfs_page_t,
+		    ht_link);
+		list_remove(&page->lru_link);
+		list_prepend(&page->lru_link, &pages_lru);
+		async_answer_1(req, EOK, (sysarg_t) page->page);
+		fibril_mutex_unlock(&pages_mutex);
+		vfs_node_put(node);
+		return;
+	}
+
+	unsigned gen = node->pages_gen;
+	fibril_mutex_unlock(&pages_mutex);
+
+	void *data;
+	errno_t rc = vfs_page_read(fd, offset, page_size, &data);
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		vfs_node_put(node);
+		return;
+	}
+
+	vfs_page_t *page = malloc(sizeof(vfs_page_t));
+
+	fibril_mutex_lock(&pages_mutex);
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * Do not cache the page if the node changed while reading it or if
+	 * another fibril has cached the same page in the meantime.
 	 */
-	as_area_destroy(page);
+	if (page == NULL || gen != node->pages_gen ||
+	    hash_table_find(&pages, &key) != NULL) {
+		fibril_mutex_unlock(&pages_mutex);
+		async_answer_1(req, EOK, (sysarg_t) data);
+		as_area_destroy(data);
+		free(page);
+		vfs_node_put(node);
+		return;
+	}
+
+	if (pages_count >= VFS_PAGER_CACHE_MAX) {
+		vfs_page_remove(list_get_instance(list_last(&pages_lru),
+		    vfs_page_t, lru_link));
+	}
+
+	page->node = node;
+	page->offset = offset;
+	page->page = data;
+	hash_table_insert(&pages, &page->ht_link);
+	list_prepend(&page->lru_link, &pages_lru);
+	list_append(&page->node_link, &node->pages);
+	pages_count++;
+
+	async_answer_1(req, EOK, (sysarg_t) data);
+	fibril_mutex_unlock(&pages_mutex);
+
+	vfs_node_put(node);
+}
+
+/** Handle a page-in request from the kernel.
+ *
+ * All pages are served from the page cache. The pager arguments are set by
+ * the client and cannot be trusted to tell whether the area is writable.
+ * Instead, the kernel itself gives writable areas private copies of the
+ * frames, so the cached frames are only ever mapped read-only.
+ */
+void vfs_page_in(ipc_call_t *req)
+{
+	aoff64_t offset = ipc_get_arg1(req) + ipc_get_arg4(req);
+	size_t page_size = ipc_get_arg2(req);
+	int fd = ipc_get_arg3(req);
+
+	vfs_page_in_cached(req, fd, offset, page_size);
 }
 
 /**